@@ -1,111 +1,466 @@
-/*
-Part of S3TConv, a library for converting S3TC textures to other formats.
-https://github.com/Triang3l/S3TConv
-
-Copyright (c) 2017 Triang3l.
-Contains portions of Compressonator:
-Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
-Copyright (c) 2004-2006 ATI Technologies Inc.
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in
-all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-THE SOFTWARE.
-*/
-
-#include "s3tconv_internal.h"
-
-void S3TConv_Utility_Color565To888(uint16_t color565, uint8_t color888[3]) {
-	// From Compressonator.
-	color888[0] = (uint8_t) (((color565 & 0xF800) >> 8) | ((color565 & 0xE000) >> 13));
-	color888[1] = (uint8_t) (((color565 & 0x07E0) >> 3) | ((color565 & 0x0600) >> 9));
-	color888[2] = (uint8_t) (((color565 & 0x001F) << 3) | ((color565 & 0x001C) >> 2));
-}
-
-int S3TConv_DXT1_BlockHasPunchthroughPixels(const uint8_t rgbBlock[8],
-		unsigned int remainingWidth, unsigned int remainingHeight) {
-	uint32_t indices;
-	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) >
-			((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
-		return 0;
-	}
-	indices = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
-			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
-	if (remainingWidth < 4) {
-		const uint32_t remainingWidthMask[] = { 0, 0x03030303, 0x0F0F0F0F, 0x3F3F3F3F };
-		indices &= remainingWidthMask[remainingWidth];
-	}
-	if (remainingHeight < 4) {
-		indices &= (1 << (remainingHeight << 3)) - 1;
-	}
-	return (indices & 0x55555555 & ((indices >> 1) & 0x55555555)) != 0;
-}
-
-void S3TConv_DXT1_PunchthroughToExplicitAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
-	uint32_t colorIndexMask;
-	unsigned int alphaByteIndex;
-
-	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) >
-			((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
-		alphaBlock[0] = alphaBlock[1] = alphaBlock[2] = alphaBlock[3] =
-				alphaBlock[4] = alphaBlock[5] = alphaBlock[6] = alphaBlock[7] = 0;
-		return;
-	}
-
-	colorIndexMask = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
-			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
-	colorIndexMask = colorIndexMask & 0x55555555 & ((colorIndexMask & 0xAAAAAAAA) >> 1);
-	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
-
-	for (alphaByteIndex = 0; alphaByteIndex < 8; ++alphaByteIndex) {
-		alphaBlock[alphaByteIndex] = (uint8_t) ((colorIndexMask & 0x3) | ((colorIndexMask & 0x3) << 2) |
-				((colorIndexMask & 0xC) << 2) | ((colorIndexMask & 0xC) << 4));
-		colorIndexMask >>= 4;
-	}
-}
-
-void S3TConv_DXT1_PunchthroughToInterpolatedAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
-	uint32_t blackIndexBits;
-	uint32_t alphaCodesLow, alphaCodesHigh;
-	unsigned int pixelIndex;
-
-	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) >
-			((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
-		alphaBlock[0] = alphaBlock[1] = 0xFF;
-		alphaBlock[2] = alphaBlock[3] = alphaBlock[4] =
-				alphaBlock[5] = alphaBlock[6] = alphaBlock[7] = 0;
-		return;
-	}
-
-	blackIndexBits = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
-			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
-	blackIndexBits = blackIndexBits & 0x55555555 & ((blackIndexBits & 0xAAAAAAAA) >> 1);
-	alphaCodesLow = alphaCodesHigh = 0;
-	for (pixelIndex = 0; pixelIndex < 8; ++pixelIndex) {
-		unsigned int alphaCodeShift = pixelIndex * 3;
-		alphaCodesLow |= ((blackIndexBits >> (pixelIndex << 1)) & 1) << alphaCodeShift;
-		alphaCodesHigh |= ((blackIndexBits >> (16 + (pixelIndex << 1))) & 1) << alphaCodeShift;
-	}
-
-	alphaBlock[0] = 0xFF;
-	alphaBlock[1] = 0;
-	alphaBlock[2] = (uint8_t) alphaCodesLow;
-	alphaBlock[3] = (uint8_t) (alphaCodesLow >> 8);
-	alphaBlock[4] = (uint8_t) (alphaCodesLow >> 16);
-	alphaBlock[5] = (uint8_t) alphaCodesHigh;
-	alphaBlock[6] = (uint8_t) (alphaCodesHigh >> 8);
-	alphaBlock[7] = (uint8_t) (alphaCodesHigh >> 16);
-}
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+Contains portions of Compressonator:
+Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+Copyright (c) 2004-2006 ATI Technologies Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "s3tconv_internal.h"
+#if defined(S3TCONV_SSE2)
+#include <emmintrin.h>
+#elif defined(S3TCONV_NEON)
+#include <arm_neon.h>
+#endif
+
+#if S3TCONV_LOOKUP_TABLES == 1
+const uint8_t S3TConv_Utility_Expand5To8[32] = {
+	0x00, 0x08, 0x10, 0x18, 0x21, 0x29, 0x31, 0x39, 0x42, 0x4A, 0x52, 0x5A, 0x63, 0x6B, 0x73, 0x7B,
+	0x84, 0x8C, 0x94, 0x9C, 0xA5, 0xAD, 0xB5, 0xBD, 0xC6, 0xCE, 0xD6, 0xDE, 0xE7, 0xEF, 0xF7, 0xFF
+};
+
+const uint8_t S3TConv_Utility_Expand6To8[64] = {
+	0x00, 0x04, 0x08, 0x0C, 0x10, 0x14, 0x18, 0x1C, 0x20, 0x24, 0x28, 0x2C, 0x30, 0x34, 0x38, 0x3C,
+	0x41, 0x45, 0x49, 0x4D, 0x51, 0x55, 0x59, 0x5D, 0x61, 0x65, 0x69, 0x6D, 0x71, 0x75, 0x79, 0x7D,
+	0x82, 0x86, 0x8A, 0x8E, 0x92, 0x96, 0x9A, 0x9E, 0xA2, 0xA6, 0xAA, 0xAE, 0xB2, 0xB6, 0xBA, 0xBE,
+	0xC3, 0xC7, 0xCB, 0xCF, 0xD3, 0xD7, 0xDB, 0xDF, 0xE3, 0xE7, 0xEB, 0xEF, 0xF3, 0xF7, 0xFB, 0xFF
+};
+#elif S3TCONV_LOOKUP_TABLES == 2
+uint8_t S3TConv_Utility_Color565To888Table[65536][4];
+#endif
+
+void S3TConv_InitLookupTables(void) {
+#if S3TCONV_LOOKUP_TABLES == 2
+	unsigned int color565;
+	for (color565 = 0; color565 < 65536; ++color565) {
+		uint8_t *tableColor888 = S3TConv_Utility_Color565To888Table[color565];
+		// From Compressonator.
+		tableColor888[0] = (uint8_t) (((color565 & 0xF800) >> 8) | ((color565 & 0xE000) >> 13));
+		tableColor888[1] = (uint8_t) (((color565 & 0x07E0) >> 3) | ((color565 & 0x0600) >> 9));
+		tableColor888[2] = (uint8_t) (((color565 & 0x001F) << 3) | ((color565 & 0x001C) >> 2));
+		tableColor888[3] = 0;
+	}
+	S3TConv_ATITC_InitLookupTables();
+#endif
+}
+
+unsigned int S3TConv_Format_GetBlockSize(S3TConv_Format format) {
+	switch (format) {
+	case S3TCONV_FORMAT_DXT1:
+	case S3TCONV_FORMAT_ATITC_RGB:
+	case S3TCONV_FORMAT_ETC2_RGB:
+	case S3TCONV_FORMAT_ETC2_RGB8A1:
+		return 8;
+	case S3TCONV_FORMAT_DXT3:
+	case S3TCONV_FORMAT_DXT5:
+	case S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT:
+	case S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED:
+	case S3TCONV_FORMAT_ETC2_RGBA:
+	case S3TCONV_FORMAT_ASTC_4X4:
+		return 16;
+	}
+	return 0;
+}
+
+int S3TConv_IsConversionSupported(S3TConv_Format sourceFormat, S3TConv_Format targetFormat) {
+	return S3TConv_ATITC_IsConversionFromDXTSupported(sourceFormat, targetFormat) ||
+			S3TConv_ETC2_IsConversionFromDXTSupported(sourceFormat, targetFormat) ||
+			S3TConv_ASTC_IsConversionFromDXTSupported(sourceFormat, targetFormat);
+}
+
+static void S3TConv_Surface_GetRowPitches(const S3TConv_Surface *surface, size_t *sourceRowPitch, size_t *targetRowPitch) {
+	unsigned int widthInBlocks = (surface->width + 3) >> 2;
+	*sourceRowPitch = surface->sourceRowPitch;
+	if (*sourceRowPitch == 0) {
+		*sourceRowPitch = (size_t) widthInBlocks * S3TConv_Format_GetBlockSize(surface->sourceFormat);
+	}
+	*targetRowPitch = surface->targetRowPitch;
+	if (*targetRowPitch == 0) {
+		*targetRowPitch = (size_t) widthInBlocks * S3TConv_Format_GetBlockSize(surface->targetFormat);
+	}
+}
+
+void S3TConv_Stats_Add(S3TConv_Stats *stats, const S3TConv_Stats *addedStats) {
+	unsigned int path;
+	stats->blockCount += addedStats->blockCount;
+	stats->cacheLookups += addedStats->cacheLookups;
+	stats->cacheHits += addedStats->cacheHits;
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		stats->pathBlockCounts[path] += addedStats->pathBlockCounts[path];
+		stats->pathTicks[path] += addedStats->pathTicks[path];
+	}
+}
+
+// snprintf appending to the buffer, keeping the total length like snprintf does.
+static void S3TConv_Stats_Append(char *buffer, size_t bufferSize, size_t *length, const char *format, ...) {
+	va_list arguments;
+	int appendedLength;
+	va_start(arguments, format);
+	appendedLength = vsnprintf(*length < bufferSize ? buffer + *length : NULL,
+			*length < bufferSize ? bufferSize - *length : 0, format, arguments);
+	va_end(arguments);
+	if (appendedLength > 0) {
+		*length += (size_t) appendedLength;
+	}
+}
+
+size_t S3TConv_Stats_Format(const S3TConv_Stats *stats, char *buffer, size_t bufferSize) {
+	size_t length = 0;
+#ifdef S3TCONV_STATS
+	double blockCount = (double) (stats->blockCount != 0 ? stats->blockCount : 1);
+	unsigned int path;
+#endif
+
+	if (bufferSize != 0) {
+		buffer[0] = '\0';
+	}
+	S3TConv_Stats_Append(buffer, bufferSize, &length, "Blocks: %llu\n", (unsigned long long) stats->blockCount);
+	if (stats->cacheLookups != 0) {
+		S3TConv_Stats_Append(buffer, bufferSize, &length, "Block cache: %llu lookups, %llu hits (%.1f%%)\n",
+				(unsigned long long) stats->cacheLookups, (unsigned long long) stats->cacheHits,
+				100.0 * (double) stats->cacheHits / (double) stats->cacheLookups);
+	}
+#ifdef S3TCONV_STATS
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		S3TConv_Stats_Append(buffer, bufferSize, &length, "%-52s %10llu blocks (%5.1f%%)",
+				S3TConv_ATITC_GetPathName((S3TConv_ATITC_Path) path), (unsigned long long) stats->pathBlockCounts[path],
+				100.0 * (double) stats->pathBlockCounts[path] / blockCount);
+#ifdef S3TCONV_STATS_TIMING
+		if (stats->pathBlockCounts[path] != 0) {
+			S3TConv_Stats_Append(buffer, bufferSize, &length, " %8.1f ticks/block",
+					(double) stats->pathTicks[path] / (double) stats->pathBlockCounts[path]);
+		}
+#endif
+		S3TConv_Stats_Append(buffer, bufferSize, &length, "\n");
+	}
+#else
+	S3TConv_Stats_Append(buffer, bufferSize, &length, "Conversion paths: not counted (build with S3TCONV_STATS)\n");
+#endif
+	return length;
+}
+
+static void S3TConv_Surface_AddCacheStats(S3TConv_Stats *stats, const S3TConv_BlockCache *cache) {
+	if (stats != NULL && cache != NULL) {
+		stats->cacheLookups += cache->lookups;
+		stats->cacheHits += cache->hits;
+	}
+}
+
+static void S3TConv_Surface_ConvertBlocks(const S3TConv_Surface *surface, const uint8_t *sourceRow, uint8_t *targetRow,
+		unsigned int blockCount, unsigned int remainingWidth, unsigned int remainingHeight,
+		S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	int asDXT1 = (surface->sourceFormat == S3TCONV_FORMAT_DXT1 || surface->asDXT1);
+	switch (surface->targetFormat) {
+	case S3TCONV_FORMAT_ETC2_RGB:
+	case S3TCONV_FORMAT_ETC2_RGB8A1:
+	case S3TCONV_FORMAT_ETC2_RGBA:
+		S3TConv_ETC2_BlockRowFromDXT(sourceRow, surface->sourceFormat, asDXT1, surface->quality, targetRow, surface->targetFormat,
+				blockCount, remainingWidth, remainingHeight, cache);
+		break;
+	case S3TCONV_FORMAT_ASTC_4X4:
+		S3TConv_ASTC_BlockRowFromDXT(sourceRow, surface->sourceFormat, asDXT1, targetRow,
+				blockCount, remainingWidth, remainingHeight);
+		break;
+	default:
+		S3TConv_ATITC_BlockRowFromDXT(sourceRow, surface->sourceFormat, asDXT1, surface->quality, targetRow, surface->targetFormat,
+				blockCount, remainingWidth, remainingHeight, cache, stats);
+		break;
+	}
+}
+
+void S3TConv_Surface_ConvertBlockRows(const S3TConv_Surface *surface, unsigned int firstBlockRow, unsigned int blockRowCount,
+		S3TConv_Stats *stats) {
+	unsigned int widthInBlocks = (surface->width + 3) >> 2;
+	size_t sourceRowPitch, targetRowPitch;
+	S3TConv_BlockCache cacheStorage, *cache = NULL;
+	unsigned int blockRow;
+
+	if (stats == NULL) {
+		stats = surface->stats;
+	}
+	if (surface->useBlockCache) {
+		cache = &cacheStorage;
+		S3TConv_BlockCache_Init(cache);
+	}
+	S3TConv_Surface_GetRowPitches(surface, &sourceRowPitch, &targetRowPitch);
+	for (blockRow = firstBlockRow; blockRow < firstBlockRow + blockRowCount; ++blockRow) {
+		S3TConv_Surface_ConvertBlocks(surface, surface->sourceData + blockRow * sourceRowPitch,
+				surface->targetData + blockRow * targetRowPitch, widthInBlocks,
+				surface->width, surface->height - (blockRow << 2), cache, stats);
+	}
+
+	if (stats != NULL) {
+		stats->blockCount += (uint64_t) widthInBlocks * blockRowCount;
+	}
+	S3TConv_Surface_AddCacheStats(stats, cache);
+}
+
+void S3TConv_Surface_ConvertBlockRowPart(const S3TConv_Surface *surface, unsigned int blockRow,
+		unsigned int firstBlock, unsigned int blockCount, S3TConv_BlockCache *cache) {
+	size_t sourceRowPitch, targetRowPitch;
+
+	if (surface->useBlockCache) {
+		cache->lookups = 0;
+		cache->hits = 0;
+	} else {
+		cache = NULL;
+	}
+	S3TConv_Surface_GetRowPitches(surface, &sourceRowPitch, &targetRowPitch);
+	S3TConv_Surface_ConvertBlocks(surface,
+			surface->sourceData + blockRow * sourceRowPitch + firstBlock * S3TConv_Format_GetBlockSize(surface->sourceFormat),
+			surface->targetData + blockRow * targetRowPitch + firstBlock * S3TConv_Format_GetBlockSize(surface->targetFormat),
+			blockCount, surface->width - (firstBlock << 2), surface->height - (blockRow << 2), cache, surface->stats);
+
+	if (surface->stats != NULL) {
+		surface->stats->blockCount += blockCount;
+	}
+	S3TConv_Surface_AddCacheStats(surface->stats, cache);
+}
+
+int S3TConv_ConvertSurface(const S3TConv_Surface *surface) {
+	if (!S3TConv_IsConversionSupported(surface->sourceFormat, surface->targetFormat)) {
+		return 0;
+	}
+	S3TConv_Surface_ConvertBlockRows(surface, 0, (surface->height + 3) >> 2, NULL);
+	return 1;
+}
+
+// Block of the surface that a block of the rectangle with the border is taken from.
+static unsigned int S3TConv_Rect_GetSourceBlock(int block, unsigned int surfaceBlockCount, int wrapBorder) {
+	if (block >= 0 && block < (int) surfaceBlockCount) {
+		return (unsigned int) block;
+	}
+	if (wrapBorder) {
+		block %= (int) surfaceBlockCount;
+		return (unsigned int) (block < 0 ? block + (int) surfaceBlockCount : block);
+	}
+	return (block < 0 ? 0 : surfaceBlockCount - 1);
+}
+
+int S3TConv_ConvertSurfaceRect(const S3TConv_Surface *surface, const S3TConv_Rect *rect) {
+	unsigned int widthInBlocks = (surface->width + 3) >> 2, heightInBlocks = (surface->height + 3) >> 2;
+	unsigned int sourceBlockSize = S3TConv_Format_GetBlockSize(surface->sourceFormat);
+	unsigned int targetBlockSize = S3TConv_Format_GetBlockSize(surface->targetFormat);
+	unsigned int borderBlocks = rect->border >> 2;
+	unsigned int rectWidthInBlocks = (rect->width + 3) >> 2, rectHeightInBlocks = (rect->height + 3) >> 2;
+	unsigned int targetWidthInBlocks, targetHeightInBlocks, targetBlockRow;
+	size_t sourceRowPitch, targetRowPitch;
+	S3TConv_BlockCache cacheStorage, *cache = NULL;
+
+	if (!S3TConv_IsConversionSupported(surface->sourceFormat, surface->targetFormat)) {
+		return 0;
+	}
+	if (((rect->x | rect->y | rect->border) & 3) != 0 || rectWidthInBlocks == 0 || rectHeightInBlocks == 0 ||
+			(rect->x >> 2) >= widthInBlocks || rectWidthInBlocks > widthInBlocks - (rect->x >> 2) ||
+			(rect->y >> 2) >= heightInBlocks || rectHeightInBlocks > heightInBlocks - (rect->y >> 2)) {
+		return 0;
+	}
+
+	targetWidthInBlocks = rectWidthInBlocks + 2 * borderBlocks;
+	targetHeightInBlocks = rectHeightInBlocks + 2 * borderBlocks;
+	sourceRowPitch = surface->sourceRowPitch;
+	if (sourceRowPitch == 0) {
+		sourceRowPitch = (size_t) widthInBlocks * sourceBlockSize;
+	}
+	targetRowPitch = surface->targetRowPitch;
+	if (targetRowPitch == 0) {
+		targetRowPitch = (size_t) targetWidthInBlocks * targetBlockSize;
+	}
+	if (surface->useBlockCache) {
+		cache = &cacheStorage;
+		S3TConv_BlockCache_Init(cache);
+	}
+
+	for (targetBlockRow = 0; targetBlockRow < targetHeightInBlocks; ++targetBlockRow) {
+		unsigned int sourceBlockRow = S3TConv_Rect_GetSourceBlock(
+				(int) (rect->y >> 2) - (int) borderBlocks + (int) targetBlockRow, heightInBlocks, rect->wrapBorder);
+		const uint8_t *sourceRow = surface->sourceData + sourceBlockRow * sourceRowPitch;
+		uint8_t *targetRow = surface->targetData + targetBlockRow * targetRowPitch;
+		unsigned int targetBlock = 0;
+		while (targetBlock < targetWidthInBlocks) {
+			int block = (int) (rect->x >> 2) - (int) borderBlocks + (int) targetBlock;
+			unsigned int sourceBlock = S3TConv_Rect_GetSourceBlock(block, widthInBlocks, rect->wrapBorder);
+			unsigned int blockCount = 1;
+			// Blocks within the surface are converted in runs up to the edge, repeated edge blocks one by one.
+			if (rect->wrapBorder || (block >= 0 && block < (int) widthInBlocks)) {
+				blockCount = widthInBlocks - sourceBlock;
+				if (blockCount > targetWidthInBlocks - targetBlock) {
+					blockCount = targetWidthInBlocks - targetBlock;
+				}
+			}
+			S3TConv_Surface_ConvertBlocks(surface, sourceRow + sourceBlock * sourceBlockSize,
+					targetRow + targetBlock * targetBlockSize, blockCount,
+					surface->width - (sourceBlock << 2), surface->height - (sourceBlockRow << 2), cache, surface->stats);
+			targetBlock += blockCount;
+		}
+	}
+
+	if (surface->stats != NULL) {
+		surface->stats->blockCount += (uint64_t) targetWidthInBlocks * targetHeightInBlocks;
+	}
+	S3TConv_Surface_AddCacheStats(surface->stats, cache);
+	return 1;
+}
+
+int S3TConv_DXT1_BlockHasPunchthroughPixels(const uint8_t rgbBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint32_t indices;
+	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) >
+			((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
+		return 0;
+	}
+	indices = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
+			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
+	if (remainingWidth < 4) {
+		const uint32_t remainingWidthMask[] = { 0, 0x03030303, 0x0F0F0F0F, 0x3F3F3F3F };
+		indices &= remainingWidthMask[remainingWidth];
+	}
+	if (remainingHeight < 4) {
+		indices &= (1 << (remainingHeight << 3)) - 1;
+	}
+	return (indices & 0x55555555 & ((indices >> 1) & 0x55555555)) != 0;
+}
+
+void S3TConv_DXT1_AnalyzeSurface(const uint8_t *data, size_t rowPitch,
+		unsigned int width, unsigned int height, S3TConv_DXT1_SurfaceInfo *info) {
+	unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2;
+	unsigned int blockRow;
+
+	info->hasPunchthroughPixels = 0;
+	info->hasThreeColorBlocks = 0;
+	info->isOpaque = 1;
+	if (rowPitch == 0) {
+		rowPitch = (size_t) widthInBlocks * 8;
+	}
+
+	for (blockRow = 0; blockRow < heightInBlocks; ++blockRow) {
+		const uint8_t *rowData = data + blockRow * rowPitch;
+		unsigned int remainingHeight = height - (blockRow << 2);
+		unsigned int blockIndex = 0;
+
+#if defined(S3TCONV_SSE2) || defined(S3TCONV_NEON)
+		// Full blocks, 4 at once.
+		unsigned int fullBlockCount = (remainingHeight >= 4 ? width >> 2 : 0);
+		for (; blockIndex + 4 <= fullBlockCount; blockIndex += 4) {
+			const uint8_t *blocks = rowData + (blockIndex << 3);
+			unsigned int threeColorBlockMask, punchthroughBlockMask;
+#if defined(S3TCONV_SSE2)
+			__m128i blocks01 = _mm_loadu_si128((const __m128i *) blocks);
+			__m128i blocks23 = _mm_loadu_si128((const __m128i *) (blocks + 16));
+			__m128i colorsIndices02 = _mm_unpacklo_epi32(blocks01, blocks23);
+			__m128i colorsIndices13 = _mm_unpackhi_epi32(blocks01, blocks23);
+			__m128i colors = _mm_unpacklo_epi32(colorsIndices02, colorsIndices13);
+			__m128i indices = _mm_unpackhi_epi32(colorsIndices02, colorsIndices13);
+			__m128i fourColorMask = _mm_cmpgt_epi32(_mm_and_si128(colors, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(colors, 16));
+			threeColorBlockMask = ~(unsigned int) _mm_movemask_ps(_mm_castsi128_ps(fourColorMask)) & 0xF;
+			punchthroughBlockMask = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+					_mm_and_si128(_mm_and_si128(indices, _mm_srli_epi32(indices, 1)), _mm_set1_epi32(0x55555555)), _mm_setzero_si128())));
+			punchthroughBlockMask = ~punchthroughBlockMask & threeColorBlockMask;
+#elif defined(S3TCONV_NEON)
+			uint32x4x2_t colorsIndices = vld2q_u32((const uint32_t *) blocks);
+			uint32x4_t threeColorMask = vcleq_u32(vandq_u32(colorsIndices.val[0], vdupq_n_u32(0xFFFF)), vshrq_n_u32(colorsIndices.val[0], 16));
+			uint32x4_t punchthroughMask = vandq_u32(threeColorMask, vtstq_u32(colorsIndices.val[1],
+					vandq_u32(vshrq_n_u32(colorsIndices.val[1], 1), vdupq_n_u32(0x55555555))));
+			threeColorBlockMask = (vgetq_lane_u32(threeColorMask, 0) & 1) | (vgetq_lane_u32(threeColorMask, 1) & 2) |
+					(vgetq_lane_u32(threeColorMask, 2) & 4) | (vgetq_lane_u32(threeColorMask, 3) & 8);
+			punchthroughBlockMask = (vgetq_lane_u32(punchthroughMask, 0) & 1) | (vgetq_lane_u32(punchthroughMask, 1) & 2) |
+					(vgetq_lane_u32(punchthroughMask, 2) & 4) | (vgetq_lane_u32(punchthroughMask, 3) & 8);
+#endif
+			if (threeColorBlockMask != 0) {
+				info->hasThreeColorBlocks = 1;
+				if (punchthroughBlockMask != 0) {
+					info->hasPunchthroughPixels = 1;
+					info->isOpaque = 0;
+					return;
+				}
+			}
+		}
+#endif
+
+		for (; blockIndex < widthInBlocks; ++blockIndex) {
+			const uint8_t *block = rowData + (blockIndex << 3);
+			if (((uint16_t) block[0] | ((uint16_t) block[1] << 8)) >
+					((uint16_t) block[2] | ((uint16_t) block[3] << 8))) {
+				continue;
+			}
+			info->hasThreeColorBlocks = 1;
+			if (S3TConv_DXT1_BlockHasPunchthroughPixels(block, width - (blockIndex << 2), remainingHeight)) {
+				info->hasPunchthroughPixels = 1;
+				info->isOpaque = 0;
+				return;
+			}
+		}
+	}
+}
+
+void S3TConv_DXT1_PunchthroughToExplicitAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
+	S3TConv_DXT1_WriteExplicitAlpha(S3TConv_DXT_GetColor0(rgbBlock), S3TConv_DXT_GetColor1(rgbBlock),
+			S3TConv_DXT_GetIndices(rgbBlock), alphaBlock);
+}
+
+void S3TConv_DXT1_PunchthroughToInterpolatedAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
+	S3TConv_DXT1_WriteInterpolatedAlpha(S3TConv_DXT_GetColor0(rgbBlock), S3TConv_DXT_GetColor1(rgbBlock),
+			S3TConv_DXT_GetIndices(rgbBlock), alphaBlock);
+}
+
+void S3TConv_DXT_GetAlphas(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int alphas[16]) {
+	unsigned int pixel;
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		uint32_t indices = (uint32_t) dxtBlock[4] | ((uint32_t) dxtBlock[5] << 8) |
+				((uint32_t) dxtBlock[6] << 16) | ((uint32_t) dxtBlock[7] << 24);
+		int isBlackMode = (((uint16_t) dxtBlock[0] | ((uint16_t) dxtBlock[1] << 8)) <=
+				((uint16_t) dxtBlock[2] | ((uint16_t) dxtBlock[3] << 8)));
+		for (pixel = 0; pixel < 16; ++pixel) {
+			alphas[pixel] = (isBlackMode && ((indices >> (pixel * 2)) & 3) == 3 ? 0 : 255);
+		}
+	} else if (dxtFormat == S3TCONV_FORMAT_DXT3) {
+		for (pixel = 0; pixel < 16; ++pixel) {
+			alphas[pixel] = ((dxtBlock[pixel >> 1] >> ((pixel & 1) << 2)) & 15) * 17;
+		}
+	} else {
+		int alphaPalette[8], alpha0 = dxtBlock[0], alpha1 = dxtBlock[1];
+		uint64_t indices = 0;
+		unsigned int paletteIndex;
+		alphaPalette[0] = alpha0;
+		alphaPalette[1] = alpha1;
+		if (alpha0 > alpha1) {
+			for (paletteIndex = 2; paletteIndex < 8; ++paletteIndex) {
+				alphaPalette[paletteIndex] = ((8 - (int) paletteIndex) * alpha0 + ((int) paletteIndex - 1) * alpha1 + 3) / 7;
+			}
+		} else {
+			for (paletteIndex = 2; paletteIndex < 6; ++paletteIndex) {
+				alphaPalette[paletteIndex] = ((6 - (int) paletteIndex) * alpha0 + ((int) paletteIndex - 1) * alpha1 + 2) / 5;
+			}
+			alphaPalette[6] = 0;
+			alphaPalette[7] = 255;
+		}
+		for (pixel = 0; pixel < 6; ++pixel) {
+			indices |= (uint64_t) dxtBlock[2 + pixel] << (pixel * 8);
+		}
+		for (pixel = 0; pixel < 16; ++pixel) {
+			alphas[pixel] = alphaPalette[(indices >> (pixel * 3)) & 7];
+		}
+	}
+}
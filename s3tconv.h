@@ -1,124 +1,1295 @@
-/*
-Part of S3TConv, a library for converting S3TC textures to other formats.
-https://github.com/Triang3l/S3TConv
-
-Copyright (c) 2017 Triang3l.
-Contains portions of Compressonator:
-Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
-Copyright (c) 2004-2006 ATI Technologies Inc.
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in
-all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-THE SOFTWARE.
-*/
-
-#ifndef S3TCONV_H
-#define S3TCONV_H
-
-#include <stdint.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-//
-// Target-independent functions.
-//
-
-/**
- * Returns whether a DXT1 block contains transparent pixels.
- *
- * This can be used to choose the right destination format if the
- * target doesn't support encoding punch-through transparency
- * directly in color blocks (such as ATITC).
- *
- * @param rgbBlock DXT1 block data.
- * @return 1 if the block contains punch-through transparency,
- *         0 if it's fully opaque.
- * @param remainingWidth How many pixels left in the row starting
- *                       from the leftmost pixel of this block,
- *                       to skip padding (4 or more for full block).
- * @param remainingHeight How many pixels left in the column starting
- *                        from the topmost pixel of this block,
- *                        to skip padding (4 or more for full block).
- */
-int S3TConv_DXT1_BlockHasPunchthroughPixels(const uint8_t rgbBlock[8],
-		unsigned int remainingWidth, unsigned int remainingHeight);
-
-/**
- * Extracts punch-through transparency from a DXT1 block to a DXT3
- * explicit alpha block, which can also be used for ATITC alpha.
- *
- * As an ATITC texture with alpha is twice as large as RGB-only one,
- * it's recommended to only use an RGBA destination format and
- * convert punch-through pixels only if there are any. This can be
- * checked using {@link S3TConv_DXT1_BlockHasPunchthroughPixels}.
- *
- * @param rgbBlock Source DXT1 block data.
- * @param alphaBlock Target DXT3 alpha block data.
- * @see S3TConv_DXT1_PunchthroughToInterpolatedAlpha
- */
-void S3TConv_DXT1_PunchthroughToExplicitAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]);
-
-/**
- * Extracts punch-through transparency from a DXT1 block to a DXT5
- * interpolated alpha block, which can also be used for ATITC alpha.
- *
- * As an ATITC texture with alpha is twice as large as RGB-only one,
- * it's recommended to only use an RGBA destination format and
- * convert punch-through pixels only if there are any. This can be
- * checked using {@link S3TConv_DXT1_BlockHasPunchthroughPixels}.
- *
- * @param rgbBlock Source DXT1 block data.
- * @param alphaBlock Target DXT5 alpha block data.
- * @see S3TConv_DXT1_PunchthroughToExplicitAlpha
- */
-void S3TConv_DXT1_PunchthroughToInterpolatedAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]);
-
-//
-// ATI Texture Compression (Qualcomm Adreno) conversion.
-//
-
-/**
- * Converts a DXT RGB block to ATITC.
- *
- * Alpha blocks can be copied directly for DXT3 (explicit alpha)
- * and DXT5 (interpolated alpha), and for RGBA DXT1, punch-through
- * transparency can be converted using either
- * {@link S3TConv_DXT1_PunchthroughToExplicitAlpha} or
- * {@link S3TConv_DXT1_PunchthroughToInterpolatedAlpha}.
- *
- * @param dxtBlock Source DXT RGB block data.
- * @param asDXT1 1 or other non-zero value if the texture is DXT1,
- *               or if it's DXT3/DXT5 targeting GeForce 6xxx/7xxx,
- *               0 if it's specification-conforming DXT3/DXT5.
- * @param atitcBlock Target ATITC RGB block data.
- * @param remainingWidth How many pixels left in the row starting
- *                       from the leftmost pixel of this block,
- *                       to skip padding (4 or more for full block).
- * @param remainingHeight How many pixels left in the column starting
- *                        from the topmost pixel of this block,
- *                        to skip padding (4 or more for full block).
- */
-void S3TConv_ATITC_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
-		unsigned int remainingWidth, unsigned int remainingHeight);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+Contains portions of Compressonator:
+Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+Copyright (c) 2004-2006 ATI Technologies Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef S3TCONV_H
+#define S3TCONV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Version of the library, incremented whenever the result of any
+ * conversion changes, so data converted by an older version can be
+ * detected as stale, for instance, by {@link S3TConv_FileCache_Open}.
+ */
+#define S3TCONV_VERSION 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Formats.
+//
+
+/**
+ * Block-compressed formats that surfaces can be converted between.
+ */
+typedef enum {
+	S3TCONV_FORMAT_DXT1,
+	S3TCONV_FORMAT_DXT3,
+	S3TCONV_FORMAT_DXT5,
+	S3TCONV_FORMAT_ATITC_RGB, // ATC_RGB_AMD.
+	S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT, // ATC_RGBA_EXPLICIT_ALPHA_AMD.
+	S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, // ATC_RGBA_INTERPOLATED_ALPHA_AMD.
+	S3TCONV_FORMAT_ETC2_RGB, // RGB8_ETC2.
+	S3TCONV_FORMAT_ETC2_RGB8A1, // RGB8_PUNCHTHROUGH_ALPHA1_ETC2.
+	S3TCONV_FORMAT_ETC2_RGBA, // RGBA8_ETC2_EAC.
+	S3TCONV_FORMAT_ASTC_4X4 // RGBA_ASTC_4x4 (LDR).
+} S3TConv_Format;
+
+/**
+ * Returns the size of a 4x4 block of a format.
+ *
+ * @param format The format.
+ * @return 8 or 16, or 0 if the format is unknown.
+ */
+unsigned int S3TConv_Format_GetBlockSize(S3TConv_Format format);
+
+//
+// Target-independent functions.
+//
+
+/**
+ * Prepares the lookup tables used for conversion.
+ *
+ * Must be called once before converting anything if the library is
+ * built with S3TCONV_LOOKUP_TABLES defined as 2 (64K-entry tables),
+ * does nothing otherwise.
+ */
+void S3TConv_InitLookupTables(void);
+
+/**
+ * Returns whether a DXT1 block contains transparent pixels.
+ *
+ * This can be used to choose the right destination format if the
+ * target doesn't support encoding punch-through transparency
+ * directly in color blocks (such as ATITC).
+ *
+ * @param rgbBlock DXT1 block data.
+ * @return 1 if the block contains punch-through transparency,
+ *         0 if it's fully opaque.
+ * @param remainingWidth How many pixels left in the row starting
+ *                       from the leftmost pixel of this block,
+ *                       to skip padding (4 or more for full block).
+ * @param remainingHeight How many pixels left in the column starting
+ *                        from the topmost pixel of this block,
+ *                        to skip padding (4 or more for full block).
+ */
+int S3TConv_DXT1_BlockHasPunchthroughPixels(const uint8_t rgbBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Summary of a DXT1 surface used to choose the target format.
+ */
+typedef struct {
+	/**
+	 * 1 if any pixel is transparent (not counting padding).
+	 */
+	int hasPunchthroughPixels;
+	/**
+	 * 1 if any block uses the RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode.
+	 */
+	int hasThreeColorBlocks;
+	/**
+	 * 1 if all pixels are opaque, so alpha doesn't need to be stored.
+	 */
+	int isOpaque;
+} S3TConv_DXT1_SurfaceInfo;
+
+/**
+ * Checks whether a whole DXT1 surface contains transparent pixels.
+ *
+ * Stops at the first transparent pixel, as this means a block in the
+ * RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode has already been found too.
+ * Full blocks are checked several at once using SIMD where available.
+ *
+ * @param data DXT1 surface data.
+ * @param rowPitch Distance in bytes between rows of blocks,
+ *                 or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @param info Summary of the surface.
+ * @see S3TConv_DXT1_BlockHasPunchthroughPixels
+ */
+void S3TConv_DXT1_AnalyzeSurface(const uint8_t *data, size_t rowPitch,
+		unsigned int width, unsigned int height, S3TConv_DXT1_SurfaceInfo *info);
+
+/**
+ * Extracts punch-through transparency from a DXT1 block to a DXT3
+ * explicit alpha block, which can also be used for ATITC alpha.
+ *
+ * As an ATITC texture with alpha is twice as large as RGB-only one,
+ * it's recommended to only use an RGBA destination format and
+ * convert punch-through pixels only if there are any. This can be
+ * checked using {@link S3TConv_DXT1_BlockHasPunchthroughPixels}.
+ * Blocks in the four-color mode have no punch-through pixels and are
+ * fully opaque.
+ *
+ * @param rgbBlock Source DXT1 block data.
+ * @param alphaBlock Target DXT3 alpha block data.
+ * @see S3TConv_DXT1_PunchthroughToInterpolatedAlpha
+ */
+void S3TConv_DXT1_PunchthroughToExplicitAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]);
+
+/**
+ * Extracts punch-through transparency from a DXT1 block to a DXT5
+ * interpolated alpha block, which can also be used for ATITC alpha.
+ *
+ * As an ATITC texture with alpha is twice as large as RGB-only one,
+ * it's recommended to only use an RGBA destination format and
+ * convert punch-through pixels only if there are any. This can be
+ * checked using {@link S3TConv_DXT1_BlockHasPunchthroughPixels}.
+ *
+ * @param rgbBlock Source DXT1 block data.
+ * @param alphaBlock Target DXT5 alpha block data.
+ * @see S3TConv_DXT1_PunchthroughToExplicitAlpha
+ */
+void S3TConv_DXT1_PunchthroughToInterpolatedAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]);
+
+//
+// ATI Texture Compression (Qualcomm Adreno) conversion.
+//
+
+/**
+ * Trade-off between the speed and the quality of the conversion of the
+ * DXT1 RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode blocks to ATITC, which
+ * can't be represented exactly in general, and of all blocks to ETC2.
+ * Blocks in the four-color mode are reordered exactly to ATITC at
+ * every level.
+ *
+ * For ETC2, the default level tries the differential or the individual
+ * mode with one subblock orientation chosen from the colors and the
+ * tables closest to them, and if the error is still large, the T or
+ * the H mode with one split of the DXT colors. The fast level tries
+ * only the first of these without refining the base colors, and the
+ * high level searches both orientations, all tables, all splits and
+ * the planar mode.
+ */
+typedef enum {
+	/**
+	 * Chooses between the approximations using heuristics: the medium
+	 * color may be replaced with 3/8 or 5/8 depending on the 2x2
+	 * corners, and the black trick is used within bounds.
+	 */
+	S3TCONV_QUALITY_DEFAULT,
+	/**
+	 * Counts the indices of the whole block and takes the cheapest
+	 * mapping that keeps the used shades, without the 2x2 corner
+	 * histogram and the bound checks, for conversion at load time.
+	 */
+	S3TCONV_QUALITY_FAST,
+	/**
+	 * Starts from the default result and searches a few candidate
+	 * endpoint pairs and their small adjustments, picking the indices
+	 * with the smallest squared RGB error against the decoded DXT
+	 * block. Several times slower on black mode blocks, for offline
+	 * conversion.
+	 */
+	S3TCONV_QUALITY_HIGH
+} S3TConv_Quality;
+
+/**
+ * Converts a DXT RGB block to ATITC.
+ *
+ * Alpha blocks can be copied directly for DXT3 (explicit alpha)
+ * and DXT5 (interpolated alpha), and for RGBA DXT1, punch-through
+ * transparency can be converted using either
+ * {@link S3TConv_DXT1_PunchthroughToExplicitAlpha} or
+ * {@link S3TConv_DXT1_PunchthroughToInterpolatedAlpha}, or both halves
+ * of an RGBA block can be converted at once using
+ * {@link S3TConv_ATITC_RGBABlockFromDXT}.
+ *
+ * @param dxtBlock Source DXT RGB block data.
+ * @param asDXT1 1 or other non-zero value if the texture is DXT1,
+ *               or if it's DXT3/DXT5 targeting GeForce 6xxx/7xxx,
+ *               0 if it's specification-conforming DXT3/DXT5.
+ * @param atitcBlock Target ATITC RGB block data, may be the same as
+ *                   dxtBlock to convert in place.
+ * @param remainingWidth How many pixels left in the row starting
+ *                       from the leftmost pixel of this block,
+ *                       to skip padding (4 or more for full block).
+ * @param remainingHeight How many pixels left in the column starting
+ *                        from the topmost pixel of this block,
+ *                        to skip padding (4 or more for full block).
+ */
+void S3TConv_ATITC_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts a DXT RGB block to ATITC in place.
+ *
+ * @param block DXT RGB block data, replaced with ATITC RGB data.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ATITC_RGBBlockFromDXTInPlace(uint8_t block[8], int asDXT1,
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts a DXT RGB block to ATITC at the specified level of quality.
+ *
+ * With S3TCONV_QUALITY_DEFAULT, the result is the same as of
+ * {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ *
+ * @param dxtBlock Source DXT RGB block data.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param quality How to convert blocks in the black mode.
+ * @param atitcBlock Target ATITC RGB block data, may be the same as
+ *                   dxtBlock to convert in place.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ATITC_RGBBlockFromDXTWithQuality(const uint8_t dxtBlock[8], int asDXT1, S3TConv_Quality quality,
+		uint8_t atitcBlock[8], unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts multiple full DXT RGB blocks to ATITC.
+ *
+ * Equivalent to calling {@link S3TConv_ATITC_RGBBlockFromDXT} with
+ * remainingWidth and remainingHeight of 4 for every block, but the
+ * blocks using the RGB0, RGB1, RGB0*2/3+RGB1/3, RGB0/3+RGB1*2/3 mode
+ * (all DXT3/DXT5 blocks if asDXT1 is 0) are converted several at once
+ * using SIMD where available.
+ *
+ * @param dxtBlocks Source DXT RGB block data.
+ * @param dxtBlockStride Distance in bytes between source RGB blocks
+ *                       (8 for DXT1, 16 for DXT3/DXT5).
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param atitcBlocks Target ATITC RGB block data, may be the same as
+ *                    dxtBlocks if the strides are the same.
+ * @param atitcBlockStride Distance in bytes between target RGB blocks
+ *                         (8 for ATC_RGB, 16 for ATC_RGBA).
+ * @param blockCount Number of blocks to convert.
+ */
+void S3TConv_ATITC_RGBBlocksFromDXT(const uint8_t *dxtBlocks, size_t dxtBlockStride, int asDXT1,
+		uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount);
+
+/**
+ * Converts a DXT block with alpha to an ATITC RGBA block, both the
+ * alpha and the color halves.
+ *
+ * Equivalent to copying the alpha block (DXT3 to ATC_RGBA_EXPLICIT,
+ * DXT5 to ATC_RGBA_INTERPOLATED) or converting DXT1 punch-through
+ * transparency to the alpha block, and then calling
+ * {@link S3TConv_ATITC_RGBBlockFromDXT} for the color block, but the
+ * fields of the DXT color block are decoded only once.
+ *
+ * @param dxtBlock Source DXT block data, 8 bytes for DXT1, 16 bytes
+ *                 for DXT3/DXT5.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 For DXT3 and DXT5, same as in
+ *               {@link S3TConv_ATITC_RGBBlockFromDXT}. Ignored for DXT1.
+ * @param atitcBlock Target ATITC RGBA block data, may be the same as
+ *                   dxtBlock to convert DXT3/DXT5 in place.
+ * @param atitcFormat S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT (for DXT1 or
+ *                    DXT3) or S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED
+ *                    (for DXT1 or DXT5). Other combinations of the
+ *                    formats are not checked and must not be used.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ATITC_RGBABlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t atitcBlock[16], S3TConv_Format atitcFormat, unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts multiple full, tightly packed DXT blocks with alpha to
+ * ATITC RGBA blocks.
+ *
+ * Equivalent to calling {@link S3TConv_ATITC_RGBABlockFromDXT} with
+ * remainingWidth and remainingHeight of 4 for every block, but the
+ * blocks using the RGB0, RGB1, RGB0*2/3+RGB1/3, RGB0/3+RGB1*2/3 mode
+ * are loaded and converted several at once using SIMD where available.
+ *
+ * @param dxtBlocks Source DXT block data.
+ * @param dxtFormat Same as in {@link S3TConv_ATITC_RGBABlockFromDXT}.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBABlockFromDXT}.
+ * @param atitcBlocks Target ATITC RGBA block data, may be the same as
+ *                    dxtBlocks to convert DXT3/DXT5 in place.
+ * @param atitcFormat Same as in {@link S3TConv_ATITC_RGBABlockFromDXT}.
+ * @param blockCount Number of blocks to convert.
+ */
+void S3TConv_ATITC_RGBABlocksFromDXT(const uint8_t *dxtBlocks, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *atitcBlocks, S3TConv_Format atitcFormat, unsigned int blockCount);
+
+/**
+ * Converts a whole DXT surface (such as a single mipmap) to ATITC.
+ *
+ * Supported conversions are:
+ * - DXT1, DXT3 and DXT5 to ATC_RGB (alpha is dropped).
+ * - DXT1 to ATC_RGBA_EXPLICIT or ATC_RGBA_INTERPOLATED (punch-through
+ *   transparency is converted to alpha).
+ * - DXT3 to ATC_RGBA_EXPLICIT and DXT5 to ATC_RGBA_INTERPOLATED
+ *   (alpha is copied).
+ *
+ * Blocks not touching the right or the bottom edge of the surface are
+ * converted without any padding checks.
+ *
+ * @param dxtData Source DXT surface data.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 For DXT3 and DXT5, same as the asDXT1 parameter of
+ *               {@link S3TConv_ATITC_RGBBlockFromDXT}. Ignored for DXT1.
+ * @param dxtRowPitch Distance in bytes between rows of blocks in the
+ *                    source, or 0 if they're tightly packed.
+ * @param atitcData Target ATITC surface data.
+ * @param atitcFormat S3TCONV_FORMAT_ATITC_RGB,
+ *                    S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT or
+ *                    S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED.
+ * @param atitcRowPitch Distance in bytes between rows of blocks in the
+ *                      target, or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @return 1 if the surface has been converted, 0 if the conversion
+ *         between the formats is not supported.
+ */
+int S3TConv_ATITC_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *atitcData, S3TConv_Format atitcFormat, size_t atitcRowPitch,
+		unsigned int width, unsigned int height);
+
+/**
+ * Converts a whole DXT surface to ATITC in place, without allocating
+ * memory for the target surface.
+ *
+ * DXT1 is converted to ATC_RGB, DXT3 to ATC_RGBA_EXPLICIT and DXT5 to
+ * ATC_RGBA_INTERPOLATED, which have the same block sizes.
+ *
+ * @param data DXT surface data, replaced with ATITC data.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_SurfaceFromDXT}.
+ * @param rowPitch Distance in bytes between rows of blocks,
+ *                 or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @return 1 if the surface has been converted, 0 if the format is not
+ *         DXT1, DXT3 or DXT5.
+ */
+int S3TConv_ATITC_SurfaceFromDXTInPlace(uint8_t *data, S3TConv_Format dxtFormat, int asDXT1, size_t rowPitch,
+		unsigned int width, unsigned int height);
+
+//
+// Ericsson Texture Compression 2 (OpenGL ES 3.0) conversion.
+//
+
+/**
+ * Converts a DXT RGB block to ETC2.
+ *
+ * Unlike ATITC, ETC2 can't represent most DXT blocks exactly, so the
+ * block is re-encoded from the 4 colors of the DXT block and their
+ * indices rather than from the decoded pixels. Solid blocks are
+ * encoded exactly where possible without searching, others are
+ * encoded like with S3TCONV_QUALITY_DEFAULT in
+ * {@link S3TConv_ETC2_RGBBlockFromDXTWithQuality}.
+ *
+ * @param dxtBlock Source DXT RGB block data.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param punchthrough 1 or other non-zero value to convert the black
+ *                     of the RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode to
+ *                     transparent pixels of ETC2 RGB8A1 (requires
+ *                     asDXT1), 0 to convert it to black for ETC2 RGB
+ *                     or the color part of ETC2 RGBA.
+ * @param etc2Block Target ETC2 RGB block data, may be the same as
+ *                  dxtBlock to convert in place.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ETC2_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, int punchthrough, uint8_t etc2Block[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts a DXT RGB block to ETC2 at the specified level of quality.
+ *
+ * With S3TCONV_QUALITY_DEFAULT, the result is the same as of
+ * {@link S3TConv_ETC2_RGBBlockFromDXT}.
+ *
+ * @param dxtBlock Source DXT RGB block data.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param punchthrough Same as in {@link S3TConv_ETC2_RGBBlockFromDXT}.
+ * @param quality How many modes, orientations and tables to try.
+ * @param etc2Block Target ETC2 RGB block data, may be the same as
+ *                  dxtBlock to convert in place.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ETC2_RGBBlockFromDXTWithQuality(const uint8_t dxtBlock[8], int asDXT1, int punchthrough,
+		S3TConv_Quality quality, uint8_t etc2Block[8], unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts DXT alpha to an EAC alpha block, the first 8 bytes of an
+ * ETC2 RGBA block.
+ *
+ * Solid alpha and punch-through transparency are encoded exactly,
+ * other blocks are re-encoded from the DXT alpha values.
+ *
+ * @param dxtBlock Source DXT block data, 8 bytes for DXT1 (punch-through
+ *                 transparency is converted), 16 bytes for DXT3/DXT5
+ *                 (only the alpha part is used).
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param eacBlock Target EAC alpha block data.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ETC2_AlphaBlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, uint8_t eacBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts a whole DXT surface (such as a single mipmap) to ETC2.
+ *
+ * Supported conversions are:
+ * - DXT1, DXT3 and DXT5 to RGB8_ETC2 (alpha is dropped).
+ * - DXT1 to RGB8_PUNCHTHROUGH_ALPHA1_ETC2 (punch-through transparency
+ *   is kept).
+ * - DXT1, DXT3 and DXT5 to RGBA8_ETC2_EAC (alpha is re-encoded).
+ *
+ * @param dxtData Source DXT surface data.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_SurfaceFromDXT}.
+ * @param dxtRowPitch Distance in bytes between rows of blocks in the
+ *                    source, or 0 if they're tightly packed.
+ * @param etc2Data Target ETC2 surface data.
+ * @param etc2Format S3TCONV_FORMAT_ETC2_RGB,
+ *                   S3TCONV_FORMAT_ETC2_RGB8A1 or
+ *                   S3TCONV_FORMAT_ETC2_RGBA.
+ * @param etc2RowPitch Distance in bytes between rows of blocks in the
+ *                     target, or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @return 1 if the surface has been converted, 0 if the conversion
+ *         between the formats is not supported.
+ */
+int S3TConv_ETC2_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *etc2Data, S3TConv_Format etc2Format, size_t etc2RowPitch,
+		unsigned int width, unsigned int height);
+
+//
+// Adaptive Scalable Texture Compression (LDR) conversion.
+//
+
+/**
+ * Converts a DXT block to a 4x4 ASTC block.
+ *
+ * No ASTC compression search is done - the colors of the DXT block
+ * become the endpoints, and its indices become the weights:
+ * - Blocks of a single color, including fully transparent ones,
+ *   are converted to void-extent blocks exactly.
+ * - The four-color mode is converted to 4 weights and the
+ *   RGB0, RGB1, (RGB0+RGB1)/2 colors of the black mode to 3
+ *   weights, with 8-bit endpoints. Blocks with constant alpha and
+ *   without transparent or opaque black pixels are converted this
+ *   way directly, with the DXT endpoints, without trying other
+ *   encodings.
+ * - Black of the black mode that is not transparent is approximated
+ *   on the line between the other colors if they're used too.
+ * - If alpha varies with a single color (or with DXT1 punch-through
+ *   transparency), alpha is interpolated with 8 weights, otherwise
+ *   alpha is interpolated in a separate plane of weights, with
+ *   less precise endpoints.
+ *
+ * @param dxtBlock Source DXT block data, 8 bytes for DXT1 (punch-
+ *                 through pixels become transparent black), 16 bytes
+ *                 for DXT3/DXT5.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 For DXT3 and DXT5, same as in
+ *               {@link S3TConv_ATITC_RGBBlockFromDXT}. Ignored for DXT1.
+ * @param astcBlock Target ASTC block data, may be the same as dxtBlock
+ *                  for DXT3 and DXT5 to convert in place.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT}.
+ */
+void S3TConv_ASTC_BlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1, uint8_t astcBlock[16],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Converts a whole DXT1, DXT3 or DXT5 surface (such as a single
+ * mipmap) to 4x4 ASTC.
+ *
+ * @param dxtData Source DXT surface data.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_SurfaceFromDXT}.
+ * @param dxtRowPitch Distance in bytes between rows of blocks in the
+ *                    source, or 0 if they're tightly packed.
+ * @param astcData Target ASTC surface data.
+ * @param astcRowPitch Distance in bytes between rows of blocks in the
+ *                     target, or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @return 1 if the surface has been converted, 0 if the source format
+ *         is not supported.
+ */
+int S3TConv_ASTC_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *astcData, size_t astcRowPitch, unsigned int width, unsigned int height);
+
+//
+// Decoding to uncompressed pixels, for devices supporting none of the targets.
+//
+
+/**
+ * Uncompressed pixel formats that DXT can be decoded to.
+ */
+typedef enum {
+	S3TCONV_PIXEL_FORMAT_RGB565, // GL_RGB, GL_UNSIGNED_SHORT_5_6_5.
+	S3TCONV_PIXEL_FORMAT_RGBA4444, // GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4.
+	S3TCONV_PIXEL_FORMAT_RGBA8 // GL_RGBA, GL_UNSIGNED_BYTE.
+} S3TConv_PixelFormat;
+
+/**
+ * Returns the size of a pixel of an uncompressed format.
+ *
+ * @param format The format.
+ * @return 2 or 4, or 0 if the format is unknown.
+ */
+unsigned int S3TConv_PixelFormat_GetPixelSize(S3TConv_PixelFormat format);
+
+/**
+ * Decodes a DXT block to uncompressed pixels.
+ *
+ * Colors are decoded from the same palette as in the other
+ * conversions and rounded to the nearest value of the format.
+ * DXT1 punch-through pixels become transparent black (black for
+ * RGB565), and the alpha of DXT3 and DXT5 is dropped for RGB565.
+ * Full blocks are stored using SIMD where available.
+ *
+ * @param dxtBlock Source DXT block data, 8 bytes for DXT1, 16 bytes
+ *                 for DXT3/DXT5.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 For DXT3 and DXT5, same as in
+ *               {@link S3TConv_ATITC_RGBBlockFromDXT}. Ignored for DXT1.
+ * @param pixels Target top-left pixel of the block.
+ * @param pixelFormat Format of the target pixels.
+ * @param pixelRowPitch Distance in bytes between rows of pixels.
+ * @param remainingWidth Same as in {@link S3TConv_ATITC_RGBBlockFromDXT},
+ *                       pixels outside the image are not written.
+ * @param remainingHeight Same as in {@link S3TConv_ATITC_RGBBlockFromDXT},
+ *                        pixels outside the image are not written.
+ */
+void S3TConv_Uncompressed_BlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch,
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+/**
+ * Decodes a whole DXT1, DXT3 or DXT5 surface (such as a single mipmap)
+ * to uncompressed pixels.
+ *
+ * @param dxtData Source DXT surface data.
+ * @param dxtFormat S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3
+ *                  or S3TCONV_FORMAT_DXT5.
+ * @param asDXT1 Same as in {@link S3TConv_ATITC_SurfaceFromDXT}.
+ * @param dxtRowPitch Distance in bytes between rows of blocks in the
+ *                    source, or 0 if they're tightly packed.
+ * @param pixels Target pixels, width x height without padding.
+ * @param pixelFormat Format of the target pixels.
+ * @param pixelRowPitch Distance in bytes between rows of pixels in the
+ *                      target, or 0 if they're tightly packed.
+ * @param width Width of the surface in pixels.
+ * @param height Height of the surface in pixels.
+ * @return 1 if the surface has been decoded, 0 if the source or the
+ *         target format is not supported.
+ */
+int S3TConv_Uncompressed_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch,
+		unsigned int width, unsigned int height);
+
+//
+// Surface conversion independent of the target.
+//
+
+/**
+ * Ways of converting a DXT RGB block to ATITC, from the exact ones to
+ * the approximations of the black mode.
+ */
+typedef enum {
+	/**
+	 * RGB0, RGB1, RGB0*2/3+RGB1/3, RGB0/3+RGB1*2/3 mode, indices
+	 * reordered. Exact, and vectorized for full blocks.
+	 */
+	S3TCONV_ATITC_PATH_FOUR_COLOR,
+	/**
+	 * Black mode, medium not used. Exact.
+	 */
+	S3TCONV_ATITC_PATH_UNUSED_MEDIUM,
+	/**
+	 * Black mode, low or high not used. Exact.
+	 */
+	S3TCONV_ATITC_PATH_UNUSED_LOW_OR_HIGH,
+	/**
+	 * Black mode, black not used, medium approximated depending on
+	 * the 2x2 corners.
+	 */
+	S3TCONV_ATITC_PATH_UNUSED_BLACK,
+	/**
+	 * Black mode, all shades used, medium represented with the black
+	 * trick.
+	 */
+	S3TCONV_ATITC_PATH_BLACK_TRICK,
+	/**
+	 * Black mode, all shades used, black trick rejected, medium
+	 * discarded.
+	 */
+	S3TCONV_ATITC_PATH_DISCARD_MEDIUM,
+	/**
+	 * Black mode, all shades used, black trick rejected, low or high
+	 * discarded.
+	 */
+	S3TCONV_ATITC_PATH_DISCARD_LOW_OR_HIGH,
+
+	S3TCONV_ATITC_PATH_COUNT
+} S3TConv_ATITC_Path;
+
+/**
+ * Returns a human-readable description of a way of converting blocks.
+ *
+ * @param path Way of conversion.
+ * @return Description, or "Unknown" if the path is not valid.
+ */
+const char *S3TConv_ATITC_GetPathName(S3TConv_ATITC_Path path);
+
+/**
+ * Statistics of surface conversion, accumulated over all surfaces
+ * referencing the structure.
+ *
+ * The ways blocks are converted are counted only if the library is
+ * built with S3TCONV_STATS defined, and timed only if it's built with
+ * S3TCONV_STATS_TIMING defined (which implies S3TCONV_STATS), since
+ * counting adds overhead to every block.
+ */
+typedef struct {
+	/**
+	 * Number of converted blocks.
+	 */
+	uint64_t blockCount;
+	/**
+	 * Number of blocks looked up in the block cache.
+	 */
+	uint64_t cacheLookups;
+	/**
+	 * Number of blocks taken from the block cache instead of being
+	 * converted again.
+	 */
+	uint64_t cacheHits;
+	/**
+	 * Number of blocks converted to ATITC in each way, including those
+	 * taken from the block cache. Only with S3TCONV_STATS.
+	 */
+	uint64_t pathBlockCounts[S3TCONV_ATITC_PATH_COUNT];
+	/**
+	 * Time spent converting blocks in each way, in CPU timestamp
+	 * counter ticks on x86, virtual counter ticks on ARM64 and clock()
+	 * ticks on other platforms. Blocks taken from the block
+	 * cache aren't timed. Only with S3TCONV_STATS_TIMING.
+	 */
+	uint64_t pathTicks[S3TCONV_ATITC_PATH_COUNT];
+} S3TConv_Stats;
+
+/**
+ * Adds the numbers from one statistics structure to another.
+ *
+ * @param stats Statistics to add to.
+ * @param addedStats Statistics to add.
+ */
+void S3TConv_Stats_Add(S3TConv_Stats *stats, const S3TConv_Stats *addedStats);
+
+/**
+ * Writes a human-readable summary of statistics, for instance, to log
+ * how a texture has been converted.
+ *
+ * @param stats Statistics to describe.
+ * @param buffer Buffer for the text, which is always null-terminated
+ *               if bufferSize is not 0. May be NULL if bufferSize is 0.
+ * @param bufferSize Size of the buffer in bytes.
+ * @return Length of the whole summary, excluding the terminating null
+ *         character, which may be larger than the buffer, like for
+ *         snprintf.
+ */
+size_t S3TConv_Stats_Format(const S3TConv_Stats *stats, char *buffer, size_t bufferSize);
+
+/**
+ * Description of the conversion of a single surface, such as one
+ * mipmap of an array layer or of a cubemap face.
+ *
+ * Optional fields are disabled when set to 0 or NULL, so it's
+ * recommended to clear the structure with memset before filling it.
+ */
+typedef struct {
+	/**
+	 * Source surface data.
+	 */
+	const uint8_t *sourceData;
+	/**
+	 * Format of the source surface.
+	 */
+	S3TConv_Format sourceFormat;
+	/**
+	 * For DXT3 and DXT5, same as the asDXT1 parameter of
+	 * {@link S3TConv_ATITC_RGBBlockFromDXT}. Ignored for DXT1.
+	 */
+	int asDXT1;
+	/**
+	 * Distance in bytes between rows of blocks in the source,
+	 * or 0 if they're tightly packed.
+	 */
+	size_t sourceRowPitch;
+	/**
+	 * Target surface data. May be the same as the source data to
+	 * convert in place if the formats have the same block size and
+	 * the row pitches are the same.
+	 */
+	uint8_t *targetData;
+	/**
+	 * Format of the target surface.
+	 */
+	S3TConv_Format targetFormat;
+	/**
+	 * Distance in bytes between rows of blocks in the target,
+	 * or 0 if they're tightly packed.
+	 */
+	size_t targetRowPitch;
+	/**
+	 * Width of the surface in pixels.
+	 */
+	unsigned int width;
+	/**
+	 * Height of the surface in pixels.
+	 */
+	unsigned int height;
+	/**
+	 * Optional. Whether to convert repeated blocks only once using a
+	 * small cache of recently converted blocks. Faster for atlases,
+	 * UI textures and other images with many identical blocks, but
+	 * slower than the regular conversion if repeats are rare. Blocks
+	 * in the four-color mode that are converted to ATITC 4 at once
+	 * with SIMD don't go through the cache since it's faster. Every
+	 * ETC2 block goes through it, as its conversion is much slower.
+	 * Not used for ASTC.
+	 */
+	int useBlockCache;
+	/**
+	 * Optional. Level of quality of the conversion of black mode
+	 * blocks to ATITC and of all blocks to ETC2,
+	 * S3TCONV_QUALITY_DEFAULT when 0. Not used for ASTC.
+	 */
+	S3TConv_Quality quality;
+	/**
+	 * Optional statistics to add the numbers for this surface to.
+	 * Surfaces converted at the same time (in parallel or by an
+	 * incremental conversion) may share the structure.
+	 */
+	S3TConv_Stats *stats;
+} S3TConv_Surface;
+
+/**
+ * Returns whether surfaces can be converted between two formats.
+ *
+ * @param sourceFormat Format of the source surface.
+ * @param targetFormat Format of the target surface.
+ * @return 1 if the conversion is supported, 0 if it's not.
+ */
+int S3TConv_IsConversionSupported(S3TConv_Format sourceFormat, S3TConv_Format targetFormat);
+
+/**
+ * Converts a surface to the target format.
+ *
+ * @param surface Description of the conversion.
+ * @return 1 if the surface has been converted, 0 if the conversion
+ *         between the formats is not supported.
+ * @see S3TConv_ATITC_SurfaceFromDXT
+ */
+int S3TConv_ConvertSurface(const S3TConv_Surface *surface);
+
+/**
+ * Block-aligned rectangle of a surface converted on its own, such as
+ * a page of a virtual texture being made resident.
+ */
+typedef struct {
+	/**
+	 * Left edge in pixels, a multiple of 4.
+	 */
+	unsigned int x;
+	/**
+	 * Top edge in pixels, a multiple of 4.
+	 */
+	unsigned int y;
+	/**
+	 * Width in pixels, not including the border. The rectangle must
+	 * be within the blocks of the surface.
+	 */
+	unsigned int width;
+	/**
+	 * Height in pixels, not including the border.
+	 */
+	unsigned int height;
+	/**
+	 * Optional. Number of pixels, a multiple of 4, added on every side
+	 * of the rectangle in the target, such as filtering borders of the
+	 * pages of a virtual texture.
+	 */
+	unsigned int border;
+	/**
+	 * Where the border is taken from beyond the edges of the surface:
+	 * 1 or other non-zero value to wrap around to the opposite edge
+	 * (for repeating textures), 0 to repeat the blocks on the edge.
+	 */
+	int wrapBorder;
+} S3TConv_Rect;
+
+/**
+ * Converts a rectangle of a surface with the border around it to a
+ * separate target buffer, without touching the rest of the surface.
+ *
+ * Blocks on the right and the bottom edges of the surface are
+ * converted with padding checks for the size of the whole surface,
+ * same as by {@link S3TConv_ConvertSurface}, and repeated border blocks
+ * beyond the edges are the same as the blocks on the edges.
+ *
+ * @param surface Description of the conversion. The source, width and
+ *                height are of the whole surface, but targetData and
+ *                targetRowPitch describe the target rectangle with the
+ *                border (the row pitch may be 0 if its rows of blocks
+ *                are tightly packed), which must not overlap the source.
+ * @param rect The rectangle to convert.
+ * @return 1 if the rectangle has been converted, 0 if the conversion
+ *         between the formats is not supported or the rectangle is not
+ *         aligned to blocks or is outside the surface.
+ */
+int S3TConv_ConvertSurfaceRect(const S3TConv_Surface *surface, const S3TConv_Rect *rect);
+
+//
+// Parallel conversion.
+//
+
+/**
+ * A piece of work submitted to a scheduler.
+ */
+typedef void (*S3TConv_JobFunction)(void *jobData);
+
+/**
+ * Interface to a job system, such as the one of the engine, that
+ * parallel conversion runs on.
+ */
+typedef struct {
+	/**
+	 * Queues a job to be executed on any thread.
+	 */
+	void (*submit)(void *schedulerData, S3TConv_JobFunction job, void *jobData);
+	/**
+	 * Waits until all jobs submitted since the last wait have finished.
+	 */
+	void (*wait)(void *schedulerData);
+	/**
+	 * Passed to submit and wait.
+	 */
+	void *schedulerData;
+} S3TConv_Scheduler;
+
+/**
+ * Converts multiple surfaces, such as all mipmaps, array layers and
+ * cubemap faces of a texture, split into ranges of block rows.
+ *
+ * Every job writes its own rows, so the result is the same as if the
+ * surfaces were converted one by one using {@link S3TConv_ConvertSurface}.
+ *
+ * @param surfaces Descriptions of the conversions.
+ * @param surfaceCount Number of surfaces.
+ * @param scheduler Job system to run the conversion on, or NULL to
+ *                  convert on the calling thread.
+ * @param blockRowsPerJob Maximum number of block rows converted by a
+ *                        single job, or 0 to choose automatically.
+ * @return 1 if the surfaces have been converted, 0 if the conversion
+ *         of any of the surfaces is not supported (in this case,
+ *         nothing is converted).
+ */
+int S3TConv_ConvertSurfacesParallel(const S3TConv_Surface *surfaces, unsigned int surfaceCount,
+		const S3TConv_Scheduler *scheduler, unsigned int blockRowsPerJob);
+
+/**
+ * Built-in pool of worker threads that can be used as a scheduler.
+ * Not available if S3TCONV_NO_THREADS is defined.
+ */
+typedef struct S3TConv_ThreadPool S3TConv_ThreadPool;
+
+/**
+ * Creates a thread pool.
+ *
+ * @param threadCount Number of threads converting in parallel,
+ *                    including the one that waits for the jobs,
+ *                    or 0 to use the number of logical processors.
+ * @return The thread pool, or NULL if it couldn't be created.
+ */
+S3TConv_ThreadPool *S3TConv_ThreadPool_Create(unsigned int threadCount);
+
+/**
+ * Stops the threads and destroys a thread pool.
+ * All submitted jobs must be waited for before destroying the pool.
+ *
+ * @param pool The thread pool.
+ */
+void S3TConv_ThreadPool_Destroy(S3TConv_ThreadPool *pool);
+
+/**
+ * Initializes a scheduler interface that runs jobs on a thread pool.
+ *
+ * @param pool The thread pool.
+ * @param scheduler The scheduler to initialize.
+ */
+void S3TConv_ThreadPool_GetScheduler(S3TConv_ThreadPool *pool, S3TConv_Scheduler *scheduler);
+
+//
+// Incremental conversion.
+//
+
+/**
+ * State of a conversion of multiple surfaces done in small steps,
+ * for instance, on the main thread within the frame time budget.
+ *
+ * All fields are read-only. Surfaces before surfaceIndex and block
+ * rows of the current surface before blockRow are fully converted
+ * and can be uploaded.
+ */
+typedef struct {
+	const S3TConv_Surface *surfaces;
+	unsigned int surfaceCount;
+	/**
+	 * Surface being converted, surfaceCount if finished.
+	 */
+	unsigned int surfaceIndex;
+	/**
+	 * Row of blocks being converted in the current surface.
+	 */
+	unsigned int blockRow;
+	/**
+	 * Next block to convert in the current row.
+	 */
+	unsigned int block;
+} S3TConv_IncrementalConversion;
+
+/**
+ * Prepares an incremental conversion.
+ *
+ * The result is the same as if the surfaces were converted using
+ * {@link S3TConv_ConvertSurface}. The surfaces must stay valid until
+ * the conversion is finished.
+ *
+ * @param conversion State to initialize.
+ * @param surfaces Descriptions of the conversions.
+ * @param surfaceCount Number of surfaces.
+ * @return 1 if initialized, 0 if the conversion of any of the
+ *         surfaces is not supported.
+ */
+int S3TConv_IncrementalConversion_Init(S3TConv_IncrementalConversion *conversion,
+		const S3TConv_Surface *surfaces, unsigned int surfaceCount);
+
+/**
+ * Converts the next part of the surfaces.
+ *
+ * At least one block is converted if there's anything remaining.
+ *
+ * @param conversion State of the conversion.
+ * @param maxBlocks Maximum number of blocks to convert, or 0 for no
+ *                  limit.
+ * @param maxMicroseconds Time after which the step should be stopped
+ *                        (checked every few hundred blocks), or 0 for
+ *                        no limit.
+ * @return 1 if there's anything remaining, 0 if finished.
+ */
+int S3TConv_IncrementalConversion_Step(S3TConv_IncrementalConversion *conversion,
+		unsigned int maxBlocks, unsigned int maxMicroseconds);
+
+/**
+ * Returns the number of fully converted block rows of a surface.
+ *
+ * @param conversion State of the conversion.
+ * @param surfaceIndex Index of the surface.
+ * @return Number of rows from the top that can be uploaded.
+ */
+unsigned int S3TConv_IncrementalConversion_GetCompletedBlockRows(const S3TConv_IncrementalConversion *conversion,
+		unsigned int surfaceIndex);
+
+//
+// Containers.
+//
+
+/**
+ * Layout of a DDS file with a DXT texture.
+ */
+typedef struct {
+	/**
+	 * S3TCONV_FORMAT_DXT1, S3TCONV_FORMAT_DXT3 or S3TCONV_FORMAT_DXT5.
+	 */
+	S3TConv_Format format;
+	/**
+	 * Size of the largest mipmap in pixels.
+	 */
+	unsigned int width, height;
+	/**
+	 * Number of mipmaps, 1 or more.
+	 */
+	unsigned int levelCount;
+	/**
+	 * Number of array layers, 1 for non-array textures.
+	 */
+	unsigned int layerCount;
+	/**
+	 * 6 for cubemaps, 1 for 2D textures.
+	 */
+	unsigned int faceCount;
+	/**
+	 * Offset of the first surface in the file.
+	 */
+	size_t dataOffset;
+} S3TConv_DDSInfo;
+
+/**
+ * Reads the layout of a DDS file, including the DX10 header extension.
+ *
+ * Supported are 2D textures, cubemaps and their arrays with DXT1,
+ * DXT2/DXT3 and DXT4/DXT5 data (or BC1, BC2 and BC3 in DX10 files).
+ * Files with more than 2048 array layers (the Direct3D 11 limit) or
+ * with dimensions above 0xFFFFFFFC are rejected.
+ *
+ * @param ddsData Contents of the DDS file.
+ * @param ddsSize Size of the DDS file in bytes.
+ * @param info Layout of the file.
+ * @return 1 if the file is valid and supported, 0 otherwise.
+ */
+int S3TConv_DDS_Parse(const uint8_t *ddsData, size_t ddsSize, S3TConv_DDSInfo *info);
+
+/**
+ * Returns the offset of a surface in a DDS file.
+ *
+ * @param info Layout of the file.
+ * @param layer Array layer index.
+ * @param face Cubemap face index.
+ * @param level Mipmap index.
+ * @return Offset of the surface from the beginning of the file.
+ */
+size_t S3TConv_DDS_GetSurfaceOffset(const S3TConv_DDSInfo *info,
+		unsigned int layer, unsigned int face, unsigned int level);
+
+/**
+ * Returns the size of a KTX file converted from a DDS file.
+ *
+ * @param info Layout of the DDS file.
+ * @param targetFormat Format of the KTX file.
+ * @return Size of the KTX file in bytes, or 0 if it's too large -
+ *         if the data of a level exceeds the 32-bit imageSize of KTX
+ *         or the file doesn't fit in size_t.
+ */
+size_t S3TConv_KTX_GetSizeForDDS(const S3TConv_DDSInfo *info, S3TConv_Format targetFormat);
+
+/**
+ * Converts a DDS file in memory to a KTX file in memory, with the
+ * GL_ATC_*_AMD internal format for ATITC targets, GL_COMPRESSED_*_ETC2*
+ * for ETC2 targets and GL_COMPRESSED_RGBA_ASTC_4x4_KHR for ASTC.
+ *
+ * @param ddsData Contents of the DDS file, may be memory-mapped.
+ * @param ddsSize Size of the DDS file in bytes.
+ * @param asDXT1 Same as in {@link S3TConv_Surface}.
+ * @param targetFormat Format of the KTX file.
+ * @param quality Same as in {@link S3TConv_Surface}.
+ * @param ktxData Buffer of {@link S3TConv_KTX_GetSizeForDDS} bytes
+ *                where the KTX file will be written.
+ * @param scheduler Job system to convert on, or NULL.
+ * @param stats Statistics to add the numbers for all surfaces of the
+ *              file to, or NULL.
+ * @return 1 if converted, 0 if the DDS file is invalid, the
+ *         conversion is not supported or the KTX file would be too
+ *         large.
+ */
+int S3TConv_DDS_ConvertToKTX(const uint8_t *ddsData, size_t ddsSize, int asDXT1,
+		S3TConv_Format targetFormat, S3TConv_Quality quality, uint8_t *ktxData,
+		const S3TConv_Scheduler *scheduler, S3TConv_Stats *stats);
+
+/**
+ * Converts a DDS file to a KTX file.
+ *
+ * The DDS file is memory-mapped, so only the KTX file is kept in
+ * memory during the conversion.
+ *
+ * @param ddsPath Path to the source DDS file.
+ * @param ktxPath Path to the target KTX file.
+ * @param asDXT1 Same as in {@link S3TConv_Surface}.
+ * @param targetFormat Format of the KTX file.
+ * @param quality Same as in {@link S3TConv_Surface}.
+ * @param scheduler Job system to convert on, or NULL.
+ * @param stats Statistics to add the numbers for all surfaces of the
+ *              file to, or NULL.
+ * @return 1 if converted, 0 in case of an error.
+ */
+int S3TConv_DDS_ConvertFileToKTX(const char *ddsPath, const char *ktxPath, int asDXT1,
+		S3TConv_Format targetFormat, S3TConv_Quality quality,
+		const S3TConv_Scheduler *scheduler, S3TConv_Stats *stats);
+
+//
+// Persistent cache of converted data.
+//
+
+/**
+ * Computes a 64-bit hash of data (the XXH64 algorithm), fast enough
+ * to identify source surfaces on every load.
+ *
+ * @param data Data to hash.
+ * @param size Size of the data in bytes.
+ * @param seed Initial value, such as the hash of the preceding data
+ *             to hash multiple pieces of data together.
+ * @return Hash of the data.
+ */
+uint64_t S3TConv_Hash64(const void *data, size_t size, uint64_t seed);
+
+/**
+ * Identifier of converted data in an {@link S3TConv_FileCache}.
+ *
+ * The version of the library is not a part of the key, as cache files
+ * written by other versions are discarded as a whole.
+ */
+typedef struct {
+	/**
+	 * {@link S3TConv_Hash64} of the source data.
+	 */
+	uint64_t sourceHash;
+	/**
+	 * Size of the source data in bytes.
+	 */
+	uint64_t sourceSize;
+	/**
+	 * Format the data has been converted to.
+	 */
+	S3TConv_Format targetFormat;
+	/**
+	 * Any other parameters affecting the result, such as the source
+	 * format, asDXT1 and the level of quality.
+	 */
+	uint32_t parameters;
+} S3TConv_FileCacheKey;
+
+/**
+ * Converted surfaces or files stored in a single memory-mapped file,
+ * so they're loaded without converting them again on later launches.
+ *
+ * The file has an index of the entries followed by their data, each
+ * aligned to 16 bytes. Found entries are used directly from the mapped
+ * file, and new ones are kept in memory until the cache is closed,
+ * which replaces the file atomically. Not thread-safe.
+ */
+typedef struct S3TConv_FileCache S3TConv_FileCache;
+
+/**
+ * Opens a cache file, or prepares an empty cache if the file doesn't
+ * exist, is corrupted or has been written by a different version of
+ * the library (in the latter cases, the file is replaced when the
+ * cache is closed with new entries).
+ *
+ * @param path Path to the cache file. A file with ".tmp" appended to
+ *             the path is used while writing the cache.
+ * @param maxSize Maximum size of the cache file in bytes. When the
+ *                file is written, the least recently used entries
+ *                that don't fit are evicted.
+ * @return The cache, or NULL if out of memory.
+ */
+S3TConv_FileCache *S3TConv_FileCache_Open(const char *path, uint64_t maxSize);
+
+/**
+ * Looks up converted data in the cache.
+ *
+ * Data of an entry is checked against its hash the first time it's
+ * found, and corrupted entries are removed from the cache.
+ *
+ * @param cache The cache.
+ * @param key Identifier of the data.
+ * @param dataSize Size of the found data in bytes.
+ * @return Pointer to the data, valid until the cache is closed, or
+ *         NULL if it's not in the cache.
+ */
+const uint8_t *S3TConv_FileCache_Find(S3TConv_FileCache *cache, const S3TConv_FileCacheKey *key, size_t *dataSize);
+
+/**
+ * Adds converted data to the cache, replacing the existing entry with
+ * the same key. The data is copied.
+ *
+ * @param cache The cache.
+ * @param key Identifier of the data.
+ * @param data Converted data.
+ * @param dataSize Size of the data in bytes.
+ * @return 1 if added, 0 if out of memory or the data is larger than
+ *         the maximum size of the cache file.
+ */
+int S3TConv_FileCache_Add(S3TConv_FileCache *cache, const S3TConv_FileCacheKey *key, const void *data, size_t dataSize);
+
+/**
+ * Builds the key for the conversion of a surface from its source data
+ * (not including the padding between rows of blocks), size and formats.
+ *
+ * @param surface Description of the conversion.
+ * @param key Identifier of the converted surface.
+ */
+void S3TConv_FileCache_GetSurfaceKey(const S3TConv_Surface *surface, S3TConv_FileCacheKey *key);
+
+/**
+ * Copies a converted surface from the cache to the target of the
+ * surface, or converts it using {@link S3TConv_ConvertSurface} and adds
+ * it to the cache if it's not there. Statistics are gathered only for
+ * the surfaces that are converted.
+ *
+ * To use the data directly from the mapped cache file instead, such as
+ * to upload it to the GPU, look it up with
+ * {@link S3TConv_FileCache_Find} using the key from
+ * {@link S3TConv_FileCache_GetSurfaceKey}. Rows of blocks of cached
+ * surfaces are tightly packed.
+ *
+ * @param cache The cache.
+ * @param surface Description of the conversion.
+ * @return 1 if the surface has been loaded or converted, 0 if the
+ *         conversion between the formats is not supported.
+ */
+int S3TConv_FileCache_ConvertSurface(S3TConv_FileCache *cache, const S3TConv_Surface *surface);
+
+/**
+ * Writes the cache file if entries have been added or removed, or if
+ * the saved last use of a found entry is a few writes of the file old
+ * (so entries in use aren't evicted in favor of newer ones even if
+ * the cache is only read), evicting the least recently used ones that
+ * exceed the maximum size, and destroys the cache. Data returned by {@link S3TConv_FileCache_Find}
+ * can't be used after this.
+ *
+ * @param cache The cache.
+ * @return 1 if the cache file is up to date, 0 if it couldn't be
+ *         written (the previous file is kept in this case).
+ */
+int S3TConv_FileCache_Close(S3TConv_FileCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,698 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <limits.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+// Integer sequence encoding of 5 trits to 8 bits by t0 + 3 * t1 + 9 * t2 + 27 * t3 + 81 * t4,
+// and of 3 quints to 7 bits by q0 + 5 * q1 + 25 * q2. Trailing zero trits and quints leave the
+// high bits zero, so incomplete groups at the end of a sequence can be written as complete ones.
+static const uint8_t S3TConv_ASTC_TritEncodings[243] = {
+	0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x08, 0x09, 0x0A, 0x10, 0x11, 0x12, 0x14, 0x15, 0x16, 0x18,
+	0x19, 0x1A, 0x03, 0x07, 0x0B, 0x13, 0x17, 0x1B, 0x0C, 0x0D, 0x0E, 0x20, 0x21, 0x22, 0x24, 0x25,
+	0x26, 0x28, 0x29, 0x2A, 0x30, 0x31, 0x32, 0x34, 0x35, 0x36, 0x38, 0x39, 0x3A, 0x23, 0x27, 0x2B,
+	0x33, 0x37, 0x3B, 0x2C, 0x2D, 0x2E, 0x40, 0x41, 0x42, 0x44, 0x45, 0x46, 0x48, 0x49, 0x4A, 0x50,
+	0x51, 0x52, 0x54, 0x55, 0x56, 0x58, 0x59, 0x5A, 0x43, 0x47, 0x4B, 0x53, 0x57, 0x5B, 0x4C, 0x4D,
+	0x4E, 0x80, 0x81, 0x82, 0x84, 0x85, 0x86, 0x88, 0x89, 0x8A, 0x90, 0x91, 0x92, 0x94, 0x95, 0x96,
+	0x98, 0x99, 0x9A, 0x83, 0x87, 0x8B, 0x93, 0x97, 0x9B, 0x8C, 0x8D, 0x8E, 0xA0, 0xA1, 0xA2, 0xA4,
+	0xA5, 0xA6, 0xA8, 0xA9, 0xAA, 0xB0, 0xB1, 0xB2, 0xB4, 0xB5, 0xB6, 0xB8, 0xB9, 0xBA, 0xA3, 0xA7,
+	0xAB, 0xB3, 0xB7, 0xBB, 0xAC, 0xAD, 0xAE, 0xC0, 0xC1, 0xC2, 0xC4, 0xC5, 0xC6, 0xC8, 0xC9, 0xCA,
+	0xD0, 0xD1, 0xD2, 0xD4, 0xD5, 0xD6, 0xD8, 0xD9, 0xDA, 0xC3, 0xC7, 0xCB, 0xD3, 0xD7, 0xDB, 0xCC,
+	0xCD, 0xCE, 0x60, 0x61, 0x62, 0x64, 0x65, 0x66, 0x68, 0x69, 0x6A, 0x70, 0x71, 0x72, 0x74, 0x75,
+	0x76, 0x78, 0x79, 0x7A, 0x63, 0x67, 0x6B, 0x73, 0x77, 0x7B, 0x6C, 0x6D, 0x6E, 0xE0, 0xE1, 0xE2,
+	0xE4, 0xE5, 0xE6, 0xE8, 0xE9, 0xEA, 0xF0, 0xF1, 0xF2, 0xF4, 0xF5, 0xF6, 0xF8, 0xF9, 0xFA, 0xE3,
+	0xE7, 0xEB, 0xF3, 0xF7, 0xFB, 0xEC, 0xED, 0xEE, 0x1C, 0x1D, 0x1E, 0x3C, 0x3D, 0x3E, 0x5C, 0x5D,
+	0x5E, 0x9C, 0x9D, 0x9E, 0xBC, 0xBD, 0xBE, 0xDC, 0xDD, 0xDE, 0x1F, 0x3F, 0x5F, 0x9F, 0xBF, 0xDF,
+	0x7C, 0x7D, 0x7E
+};
+static const uint8_t S3TConv_ASTC_QuintEncodings[125] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x10, 0x11, 0x12, 0x13, 0x14, 0x18,
+	0x19, 0x1A, 0x1B, 0x1C, 0x05, 0x0D, 0x15, 0x1D, 0x06, 0x20, 0x21, 0x22, 0x23, 0x24, 0x28, 0x29,
+	0x2A, 0x2B, 0x2C, 0x30, 0x31, 0x32, 0x33, 0x34, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x25, 0x2D, 0x35,
+	0x3D, 0x0E, 0x40, 0x41, 0x42, 0x43, 0x44, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x50, 0x51, 0x52, 0x53,
+	0x54, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x45, 0x4D, 0x55, 0x5D, 0x16, 0x60, 0x61, 0x62, 0x63, 0x64,
+	0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x70, 0x71, 0x72, 0x73, 0x74, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x65,
+	0x6D, 0x75, 0x7D, 0x1E, 0x66, 0x67, 0x46, 0x47, 0x26, 0x6E, 0x6F, 0x4E, 0x4F, 0x2E, 0x76, 0x77,
+	0x56, 0x57, 0x36, 0x7E, 0x7F, 0x5E, 0x5F, 0x3E, 0x27, 0x2F, 0x37, 0x3F, 0x07
+};
+
+// Range of integer sequence values - multiplier << bitCount values, multiplier being 3 for trits and 5 for quints.
+typedef struct {
+	uint8_t bitCount;
+	uint8_t multiplier;
+} S3TConv_ASTC_Range;
+
+// Endpoint value ranges from the smallest allowed (0..5) to 0..255, the decoder uses the largest one that fits.
+static const S3TConv_ASTC_Range S3TConv_ASTC_EndpointRanges[17] = {
+	{ 1, 3 }, { 3, 1 }, { 1, 5 }, { 2, 3 }, { 4, 1 }, { 2, 5 }, { 3, 3 }, { 5, 1 }, { 3, 5 },
+	{ 4, 3 }, { 6, 1 }, { 4, 5 }, { 5, 3 }, { 7, 1 }, { 5, 5 }, { 6, 3 }, { 8, 1 }
+};
+
+// Weight ranges that the DXT palettes map to - 0..2 for (RGB0+RGB1)/2, 0..3 for thirds, 0..7 for approximations.
+typedef enum {
+	S3TCONV_ASTC_WEIGHTS_3,
+	S3TCONV_ASTC_WEIGHTS_4,
+	S3TCONV_ASTC_WEIGHTS_8,
+
+	S3TCONV_ASTC_WEIGHTS_COUNT
+} S3TConv_ASTC_Weights;
+
+static const S3TConv_ASTC_Range S3TConv_ASTC_WeightRanges[S3TCONV_ASTC_WEIGHTS_COUNT] = { { 0, 3 }, { 2, 1 }, { 3, 1 } };
+// Unquantized weights, in 1/64.
+static const int S3TConv_ASTC_WeightValues[S3TCONV_ASTC_WEIGHTS_COUNT][8] = {
+	{ 0, 32, 64 }, { 0, 21, 43, 64 }, { 0, 9, 18, 27, 37, 46, 55, 64 }
+};
+// Block modes with a 4x4 weight grid (A = 2, B = 0) and the weight range in bits 4, 1 and 0. Bit 10 is the dual plane bit.
+static const unsigned int S3TConv_ASTC_BlockModes[S3TCONV_ASTC_WEIGHTS_COUNT] = { 0x51, 0x42, 0x53 };
+
+// Colors and alpha of a DXT block.
+typedef struct {
+	int colors[4][3];
+	int alphas[16];
+	uint32_t indices;
+	// Pixels inside the image, and the ones that are transparent black in DXT1.
+	unsigned int visibleMask, transparentMask;
+	// Colors used by the visible pixels that are not transparent.
+	unsigned int usedMask;
+	int minAlpha, maxAlpha;
+	int isFourColor;
+	// Whether the black of the black mode is used by opaque pixels (DXT3 and DXT5 decoded as DXT1).
+	int usesOpaqueBlack;
+} S3TConv_ASTC_Source;
+
+// Single-partition block with the LDR RGB direct (6 endpoint values) or RGBA direct (8 endpoint values) mode.
+typedef struct {
+	S3TConv_ASTC_Weights weights;
+	int dualPlane;
+	unsigned int endpointValueCount;
+	S3TConv_ASTC_Range endpointRange;
+	// R0, R1, G0, G1, B0, B1, A0, A1.
+	uint8_t endpointValues[8];
+	// For every pixel, interleaved for the RGB and the alpha planes if dualPlane is set.
+	uint8_t weightIndices[32];
+	unsigned int error;
+} S3TConv_ASTC_Encoding;
+
+static inline unsigned int S3TConv_ASTC_GetSequenceBitCount(S3TConv_ASTC_Range range, unsigned int valueCount) {
+	unsigned int bitCount = valueCount * range.bitCount;
+	if (range.multiplier == 3) {
+		bitCount += (valueCount * 8 + 4) / 5;
+	} else if (range.multiplier == 5) {
+		bitCount += (valueCount * 7 + 2) / 3;
+	}
+	return bitCount;
+}
+
+// Bits of a block are gathered in two 64-bit words, bits 0-63 and 64-127, and stored as bytes once.
+static inline void S3TConv_ASTC_WriteBits(uint64_t blockBits[2], unsigned int offset, unsigned int bitCount,
+		unsigned int value) {
+	// Bits past the end of the block are zeros from the end of the last group of a sequence.
+	uint64_t maskedValue = value & ((1u << bitCount) - 1);
+	if (offset >= 128) {
+		return;
+	}
+	blockBits[offset >> 6] |= maskedValue << (offset & 63);
+	if (offset < 64 && offset + bitCount > 64) {
+		blockBits[1] |= maskedValue >> (64 - offset);
+	}
+}
+
+static void S3TConv_ASTC_WriteSequence(uint64_t blockBits[2], unsigned int offset, S3TConv_ASTC_Range range,
+		const uint8_t *values, unsigned int valueCount) {
+	// Bits of the packed trits or quints written after the low bits of every value of a group.
+	static const unsigned int tritBitCounts[5] = { 2, 2, 1, 2, 1 }, quintBitCounts[3] = { 3, 2, 2 };
+	unsigned int bitCount = range.bitCount, groupSize, firstValue, valueIndex;
+	const unsigned int *packedBitCounts;
+
+	if (range.multiplier == 1) {
+		for (valueIndex = 0; valueIndex < valueCount; ++valueIndex) {
+			S3TConv_ASTC_WriteBits(blockBits, offset, bitCount, values[valueIndex]);
+			offset += bitCount;
+		}
+		return;
+	}
+
+	groupSize = (range.multiplier == 3 ? 5 : 3);
+	packedBitCounts = (range.multiplier == 3 ? tritBitCounts : quintBitCounts);
+	for (firstValue = 0; firstValue < valueCount; firstValue += groupSize) {
+		unsigned int packed = 0, scale = 1, lowBits[5];
+		for (valueIndex = 0; valueIndex < groupSize; ++valueIndex) {
+			unsigned int value = (firstValue + valueIndex < valueCount ? values[firstValue + valueIndex] : 0);
+			lowBits[valueIndex] = value & ((1u << bitCount) - 1);
+			packed += (value >> bitCount) * scale;
+			scale *= range.multiplier;
+		}
+		packed = (range.multiplier == 3 ? S3TConv_ASTC_TritEncodings[packed] : S3TConv_ASTC_QuintEncodings[packed]);
+		for (valueIndex = 0; valueIndex < groupSize; ++valueIndex) {
+			S3TConv_ASTC_WriteBits(blockBits, offset, bitCount, lowBits[valueIndex]);
+			offset += bitCount;
+			S3TConv_ASTC_WriteBits(blockBits, offset, packedBitCounts[valueIndex], packed);
+			offset += packedBitCounts[valueIndex];
+			packed >>= packedBitCounts[valueIndex];
+		}
+	}
+}
+
+static int S3TConv_ASTC_UnquantizeEndpoint(S3TConv_ASTC_Range range, unsigned int value) {
+	unsigned int bitCount = range.bitCount, highBits, a, b, c, t;
+	int shift;
+
+	if (range.multiplier == 1) {
+		// Bit replication.
+		int result = 0;
+		for (shift = 8 - (int) bitCount; shift > -(int) bitCount; shift -= (int) bitCount) {
+			result |= (int) (shift >= 0 ? value << shift : value >> -shift);
+		}
+		return result & 0xFF;
+	}
+
+	// The trit or the quint is scaled by c, the bits above the lowest are spread by b, and the lowest one inverts.
+	a = ((value & 1) ? 0x1FF : 0);
+	highBits = (value & ((1u << bitCount) - 1)) >> 1;
+	if (range.multiplier == 3) {
+		static const unsigned int scales[7] = { 0, 204, 93, 44, 22, 11, 5 };
+		c = scales[bitCount];
+		switch (bitCount) {
+		case 2:
+			b = (highBits << 8) | (highBits << 4) | (highBits << 2) | (highBits << 1);
+			break;
+		case 3:
+			b = (highBits << 7) | (highBits << 2) | highBits;
+			break;
+		case 4:
+			b = (highBits << 6) | highBits;
+			break;
+		case 5:
+			b = (highBits << 5) | (highBits >> 2);
+			break;
+		case 6:
+			b = (highBits << 4) | (highBits >> 4);
+			break;
+		default:
+			b = 0;
+			break;
+		}
+	} else {
+		static const unsigned int scales[6] = { 0, 113, 54, 26, 13, 6 };
+		c = scales[bitCount];
+		switch (bitCount) {
+		case 2:
+			b = (highBits << 8) | (highBits << 3) | (highBits << 2);
+			break;
+		case 3:
+			b = (highBits << 7) | (highBits << 1) | (highBits >> 1);
+			break;
+		case 4:
+			b = (highBits << 6) | (highBits >> 1);
+			break;
+		case 5:
+			b = (highBits << 5) | (highBits >> 3);
+			break;
+		default:
+			b = 0;
+			break;
+		}
+	}
+	t = ((value >> bitCount) * c + b) ^ a;
+	return (int) ((a & 0x80) | (t >> 2));
+}
+
+// Quantizes the endpoint components in the R0, R1, G0, G1, B0, B1, A0, A1 order to the closest values of the range.
+static void S3TConv_ASTC_QuantizeEndpoints(S3TConv_ASTC_Range range, const int *components, unsigned int componentCount,
+		uint8_t *values) {
+	unsigned int valueCount = (unsigned int) range.multiplier << range.bitCount;
+	unsigned int value, componentIndex;
+	int bestDifferences[8];
+
+	for (componentIndex = 0; componentIndex < componentCount; ++componentIndex) {
+		if (range.multiplier == 1) {
+			// Bit replication is almost linear, only the neighbors of the linearly scaled value need to be checked.
+			unsigned int firstValue, lastValue;
+			int bestDifference = INT_MAX;
+			if (range.bitCount == 8) {
+				values[componentIndex] = (uint8_t) components[componentIndex];
+				continue;
+			}
+			value = ((unsigned int) components[componentIndex] * (valueCount - 1) + 127) / 255;
+			firstValue = (value != 0 ? value - 1 : 0);
+			lastValue = (value + 1 < valueCount ? value + 1 : valueCount - 1);
+			for (value = firstValue; value <= lastValue; ++value) {
+				int difference = S3TConv_ASTC_UnquantizeEndpoint(range, value) - components[componentIndex];
+				difference = (difference >= 0 ? difference : -difference);
+				if (difference < bestDifference) {
+					bestDifference = difference;
+					values[componentIndex] = (uint8_t) value;
+				}
+			}
+		} else {
+			bestDifferences[componentIndex] = INT_MAX;
+		}
+	}
+	if (range.multiplier == 1) {
+		return;
+	}
+
+	// The order of trit and quint values is shuffled - every value is unquantized once and checked for all components.
+	for (value = 0; value < valueCount; ++value) {
+		int unquantized = S3TConv_ASTC_UnquantizeEndpoint(range, value);
+		for (componentIndex = 0; componentIndex < componentCount; ++componentIndex) {
+			int difference = unquantized - components[componentIndex];
+			difference = (difference >= 0 ? difference : -difference);
+			if (difference < bestDifferences[componentIndex]) {
+				bestDifferences[componentIndex] = difference;
+				values[componentIndex] = (uint8_t) value;
+			}
+		}
+	}
+}
+
+static inline int S3TConv_ASTC_Interpolate(int endpoint0, int endpoint1, int weight) {
+	// 8-bit endpoints are expanded to 16 bits, the top 8 bits of the result are used.
+	return ((endpoint0 * 257 * (64 - weight) + endpoint1 * 257 * weight + 32) >> 6) >> 8;
+}
+
+static void S3TConv_ASTC_GetSource(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_ASTC_Source *source) {
+	const uint8_t *colorBlock = dxtBlock + (dxtFormat == S3TCONV_FORMAT_DXT1 ? 0 : 8);
+	uint16_t colorLow565 = (uint16_t) colorBlock[0] | ((uint16_t) colorBlock[1] << 8);
+	uint16_t colorHigh565 = (uint16_t) colorBlock[2] | ((uint16_t) colorBlock[3] << 8);
+	uint8_t colorLow888[3], colorHigh888[3];
+	unsigned int width = (remainingWidth < 4 ? remainingWidth : 4), height = (remainingHeight < 4 ? remainingHeight : 4);
+	int isFourColor = (colorLow565 > colorHigh565 || !(asDXT1 || dxtFormat == S3TCONV_FORMAT_DXT1));
+	unsigned int component, x, y;
+
+	S3TConv_Utility_Color565To888(colorLow565, colorLow888);
+	S3TConv_Utility_Color565To888(colorHigh565, colorHigh888);
+	for (component = 0; component < 3; ++component) {
+		int low = colorLow888[component], high = colorHigh888[component];
+		source->colors[0][component] = low;
+		source->colors[1][component] = high;
+		if (isFourColor) {
+			source->colors[2][component] = (2 * low + high + 1) / 3;
+			source->colors[3][component] = (low + 2 * high + 1) / 3;
+		} else {
+			source->colors[2][component] = (low + high + 1) >> 1;
+			source->colors[3][component] = 0;
+		}
+	}
+	source->indices = (uint32_t) colorBlock[4] | ((uint32_t) colorBlock[5] << 8) |
+			((uint32_t) colorBlock[6] << 16) | ((uint32_t) colorBlock[7] << 24);
+	S3TConv_DXT_GetAlphas(dxtBlock, dxtFormat, source->alphas);
+
+	source->visibleMask = source->transparentMask = source->usedMask = 0;
+	source->minAlpha = 255;
+	source->maxAlpha = 0;
+	for (y = 0; y < height; ++y) {
+		for (x = 0; x < width; ++x) {
+			unsigned int pixel = y * 4 + x, index = (source->indices >> (pixel * 2)) & 3;
+			int alpha = source->alphas[pixel];
+			source->visibleMask |= 1u << pixel;
+			if (dxtFormat == S3TCONV_FORMAT_DXT1 && alpha == 0) {
+				source->transparentMask |= 1u << pixel;
+			} else {
+				source->usedMask |= 1u << index;
+			}
+			source->minAlpha = (alpha < source->minAlpha ? alpha : source->minAlpha);
+			source->maxAlpha = (alpha > source->maxAlpha ? alpha : source->maxAlpha);
+		}
+	}
+	source->isFourColor = isFourColor;
+	source->usesOpaqueBlack = (!isFourColor && (source->usedMask & 8));
+}
+
+// Returns the color of the first visible pixel if all visible pixels have the same color, or 0 otherwise. Without visible
+// pixels, returns transparent black.
+static int S3TConv_ASTC_GetSolidColor(const S3TConv_ASTC_Source *source, int color[4]) {
+	unsigned int pixel, colorCount = 0;
+	for (pixel = 0; pixel < 16; ++pixel) {
+		int pixelColor[4];
+		if (!(source->visibleMask & (1u << pixel))) {
+			continue;
+		}
+		if (source->transparentMask & (1u << pixel)) {
+			pixelColor[0] = pixelColor[1] = pixelColor[2] = pixelColor[3] = 0;
+		} else {
+			memcpy(pixelColor, source->colors[(source->indices >> (pixel * 2)) & 3], 3 * sizeof(int));
+			pixelColor[3] = source->alphas[pixel];
+		}
+		if (colorCount++ == 0) {
+			memcpy(color, pixelColor, sizeof(pixelColor));
+		} else if (memcmp(color, pixelColor, sizeof(pixelColor)) != 0) {
+			return 0;
+		}
+	}
+	if (colorCount == 0) {
+		color[0] = color[1] = color[2] = color[3] = 0;
+	}
+	return 1;
+}
+
+// Chooses the endpoint values for the endpoints and the weights for every pixel, and calculates the error.
+static void S3TConv_ASTC_Encode(const S3TConv_ASTC_Source *source, const int endpoints[2][4], int hasAlpha,
+		S3TConv_ASTC_Weights weights, int dualPlane, S3TConv_ASTC_Encoding *encoding) {
+	const int *weightValues = S3TConv_ASTC_WeightValues[weights];
+	unsigned int weightCount = (unsigned int) S3TConv_ASTC_WeightRanges[weights].multiplier <<
+			S3TConv_ASTC_WeightRanges[weights].bitCount;
+	unsigned int endpointBitCount = 128 - 17 - (dualPlane ? 2 : 0) -
+			S3TConv_ASTC_GetSequenceBitCount(S3TConv_ASTC_WeightRanges[weights], dualPlane ? 32 : 16);
+	static const int black[3] = { 0, 0, 0 };
+	int endpointComponents[8], quantizedEndpoints[2][4], decodedColors[8][4];
+	unsigned int colorErrors[5][8];
+	unsigned int rangeIndex, component, endpoint, colorIndex, weightIndex, pixel;
+
+	encoding->weights = weights;
+	encoding->dualPlane = dualPlane;
+	encoding->endpointValueCount = (hasAlpha ? 8 : 6);
+	for (rangeIndex = 16; rangeIndex != 0; --rangeIndex) {
+		if (S3TConv_ASTC_GetSequenceBitCount(S3TConv_ASTC_EndpointRanges[rangeIndex],
+				encoding->endpointValueCount) <= endpointBitCount) {
+			break;
+		}
+	}
+	encoding->endpointRange = S3TConv_ASTC_EndpointRanges[rangeIndex];
+	for (component = 0; component < encoding->endpointValueCount; ++component) {
+		endpointComponents[component] = endpoints[component & 1][component >> 1];
+	}
+	S3TConv_ASTC_QuantizeEndpoints(encoding->endpointRange, endpointComponents, encoding->endpointValueCount,
+			encoding->endpointValues);
+	for (component = 0; component < 4; ++component) {
+		for (endpoint = 0; endpoint < 2; ++endpoint) {
+			quantizedEndpoints[endpoint][component] = (component < 3 || hasAlpha ? S3TConv_ASTC_UnquantizeEndpoint(
+					encoding->endpointRange, encoding->endpointValues[component * 2 + endpoint]) : 255);
+		}
+	}
+	// If the second endpoint is darker, the decoder would apply blue contraction instead.
+	if (quantizedEndpoints[1][0] + quantizedEndpoints[1][1] + quantizedEndpoints[1][2] <
+			quantizedEndpoints[0][0] + quantizedEndpoints[0][1] + quantizedEndpoints[0][2]) {
+		for (component = 0; component < 4; ++component) {
+			int quantizedEndpoint = quantizedEndpoints[0][component];
+			quantizedEndpoints[0][component] = quantizedEndpoints[1][component];
+			quantizedEndpoints[1][component] = quantizedEndpoint;
+			if (component < 3 || hasAlpha) {
+				uint8_t value = encoding->endpointValues[component * 2];
+				encoding->endpointValues[component * 2] = encoding->endpointValues[component * 2 + 1];
+				encoding->endpointValues[component * 2 + 1] = value;
+			}
+		}
+	}
+
+	// Errors of the DXT colors (and of transparent black as the fifth one) for every weight.
+	for (weightIndex = 0; weightIndex < weightCount; ++weightIndex) {
+		for (component = 0; component < 4; ++component) {
+			decodedColors[weightIndex][component] = S3TConv_ASTC_Interpolate(quantizedEndpoints[0][component],
+					quantizedEndpoints[1][component], weightValues[weightIndex]);
+		}
+	}
+	for (colorIndex = 0; colorIndex < 5; ++colorIndex) {
+		const int *color = (colorIndex < 4 ? source->colors[colorIndex] : black);
+		if (colorIndex < 4 && !(source->usedMask & (1u << colorIndex))) {
+			continue;
+		}
+		for (weightIndex = 0; weightIndex < weightCount; ++weightIndex) {
+			unsigned int error = 0;
+			for (component = 0; component < 3; ++component) {
+				int difference = decodedColors[weightIndex][component] - color[component];
+				error += (unsigned int) (difference * difference);
+			}
+			colorErrors[colorIndex][weightIndex] = error;
+		}
+	}
+
+	encoding->error = 0;
+	memset(encoding->weightIndices, 0, sizeof(encoding->weightIndices));
+	for (pixel = 0; pixel < 16; ++pixel) {
+		unsigned int bestColorError = UINT_MAX, bestAlphaError = UINT_MAX;
+		const unsigned int *pixelColorErrors;
+		int alpha = source->alphas[pixel];
+		if (!(source->visibleMask & (1u << pixel))) {
+			continue;
+		}
+		pixelColorErrors = colorErrors[(source->transparentMask & (1u << pixel)) ? 4 : (source->indices >> (pixel * 2)) & 3];
+		for (weightIndex = 0; weightIndex < weightCount; ++weightIndex) {
+			unsigned int colorError = pixelColorErrors[weightIndex];
+			int alphaDifference = decodedColors[weightIndex][3] - alpha;
+			unsigned int alphaError = (unsigned int) (alphaDifference * alphaDifference);
+			if (!dualPlane) {
+				colorError += alphaError;
+			} else if (alphaError < bestAlphaError) {
+				bestAlphaError = alphaError;
+				encoding->weightIndices[pixel * 2 + 1] = (uint8_t) weightIndex;
+			}
+			if (colorError < bestColorError) {
+				bestColorError = colorError;
+				encoding->weightIndices[pixel << dualPlane] = (uint8_t) weightIndex;
+			}
+		}
+		if (dualPlane) {
+			// The colors of the transparent pixels of DXT1 are not visible.
+			encoding->error += ((source->transparentMask & (1u << pixel)) ? 0 : bestColorError) + bestAlphaError;
+		} else {
+			encoding->error += bestColorError;
+		}
+	}
+}
+
+static inline uint64_t S3TConv_ASTC_ReverseBits(uint64_t bits) {
+	bits = ((bits & 0x00000000FFFFFFFFull) << 32) | ((bits >> 32) & 0x00000000FFFFFFFFull);
+	bits = ((bits & 0x0000FFFF0000FFFFull) << 16) | ((bits >> 16) & 0x0000FFFF0000FFFFull);
+	bits = ((bits & 0x00FF00FF00FF00FFull) << 8) | ((bits >> 8) & 0x00FF00FF00FF00FFull);
+	bits = ((bits & 0x0F0F0F0F0F0F0F0Full) << 4) | ((bits >> 4) & 0x0F0F0F0F0F0F0F0Full);
+	bits = ((bits & 0x3333333333333333ull) << 2) | ((bits >> 2) & 0x3333333333333333ull);
+	return ((bits & 0x5555555555555555ull) << 1) | ((bits >> 1) & 0x5555555555555555ull);
+}
+
+static void S3TConv_ASTC_StoreBlock(const S3TConv_ASTC_Encoding *encoding, uint8_t astcBlock[16]) {
+	S3TConv_ASTC_Range weightRange = S3TConv_ASTC_WeightRanges[encoding->weights];
+	unsigned int weightBitCount = S3TConv_ASTC_GetSequenceBitCount(weightRange, encoding->dualPlane ? 32 : 16);
+	uint64_t blockBits[2] = { 0, 0 }, weightBits[2] = { 0, 0 };
+	unsigned int byteIndex;
+
+	S3TConv_ASTC_WriteBits(blockBits, 0, 11, S3TConv_ASTC_BlockModes[encoding->weights] | (encoding->dualPlane ? 0x400 : 0));
+	// Bits 11 and 12 are the partition count minus 1.
+	S3TConv_ASTC_WriteBits(blockBits, 13, 4, encoding->endpointValueCount == 8 ? 12 : 8);
+	S3TConv_ASTC_WriteSequence(blockBits, 17, encoding->endpointRange, encoding->endpointValues, encoding->endpointValueCount);
+	if (encoding->dualPlane) {
+		// Alpha is in the second plane.
+		S3TConv_ASTC_WriteBits(blockBits, 128 - 2 - weightBitCount, 2, 3);
+	}
+	// Weights are stored from the end of the block with the bit order reversed.
+	S3TConv_ASTC_WriteSequence(weightBits, 0, weightRange, encoding->weightIndices, encoding->dualPlane ? 32 : 16);
+	blockBits[0] |= S3TConv_ASTC_ReverseBits(weightBits[1]);
+	blockBits[1] |= S3TConv_ASTC_ReverseBits(weightBits[0]);
+	for (byteIndex = 0; byteIndex < 16; ++byteIndex) {
+		astcBlock[byteIndex] = (uint8_t) (blockBits[byteIndex >> 3] >> ((byteIndex & 7) << 3));
+	}
+}
+
+// Encodes a block with constant alpha and without transparent or opaque black pixels directly, with the DXT endpoints as
+// 8-bit endpoints and the indices as the weights of the same palette (approximating thirds with 21/64 and 43/64), without
+// trying other encodings. Returns 0 if the block needs the search.
+static int S3TConv_ASTC_EncodeDirect(const S3TConv_ASTC_Source *source, S3TConv_ASTC_Encoding *encoding) {
+	// DXT indices to weights in the order of the endpoints, 0, 3, 1, 2 of 4 in the four-color mode and 0, 2, 1 of 3
+	// otherwise (index 3 is only used by invisible pixels then).
+	static const uint8_t indexWeights[2][4] = { { 0, 2, 1, 0 }, { 0, 3, 1, 2 } };
+	const uint8_t *weights = indexWeights[source->isFourColor];
+	unsigned int maxWeight = (source->isFourColor ? 3 : 2), component, pixel;
+	int swap;
+
+	if (source->minAlpha != source->maxAlpha || source->transparentMask != 0 || source->usesOpaqueBlack) {
+		return 0;
+	}
+	// If the second endpoint is darker, the decoder would apply blue contraction instead, so the endpoints are swapped.
+	swap = (source->colors[1][0] + source->colors[1][1] + source->colors[1][2] <
+			source->colors[0][0] + source->colors[0][1] + source->colors[0][2]);
+	encoding->weights = (source->isFourColor ? S3TCONV_ASTC_WEIGHTS_4 : S3TCONV_ASTC_WEIGHTS_3);
+	encoding->dualPlane = 0;
+	encoding->endpointValueCount = (source->minAlpha != 255 ? 8 : 6);
+	// 8-bit endpoints fit in the remaining 79 bits with 4 weights and 85 bits with 3.
+	encoding->endpointRange = S3TConv_ASTC_EndpointRanges[16];
+	for (component = 0; component < 3; ++component) {
+		encoding->endpointValues[component * 2] = (uint8_t) source->colors[swap][component];
+		encoding->endpointValues[component * 2 + 1] = (uint8_t) source->colors[swap ^ 1][component];
+	}
+	encoding->endpointValues[6] = encoding->endpointValues[7] = (uint8_t) source->minAlpha;
+	memset(encoding->weightIndices, 0, sizeof(encoding->weightIndices));
+	for (pixel = 0; pixel < 16; ++pixel) {
+		unsigned int weight = weights[(source->indices >> (pixel * 2)) & 3];
+		encoding->weightIndices[pixel] = (uint8_t) (swap ? maxWeight - weight : weight);
+	}
+	encoding->error = 0;
+	return 1;
+}
+
+// Encodes a block with different colors using the colors as the endpoints, replacing the encoding if it's better.
+static void S3TConv_ASTC_EncodeColors(const S3TConv_ASTC_Source *source, const int endpoints[2][4],
+		S3TConv_ASTC_Encoding *encoding) {
+	S3TConv_ASTC_Encoding candidate;
+	S3TConv_ASTC_Weights weights;
+
+	if (source->minAlpha == source->maxAlpha) {
+		// Constant alpha - only the colors are interpolated. The midpoint of the black mode needs 3 weights, the
+		// thirds of the four-color mode are closer with 4, and the black of the black mode is approximated with 8.
+		for (weights = S3TCONV_ASTC_WEIGHTS_3; weights < S3TCONV_ASTC_WEIGHTS_COUNT && encoding->error != 0;
+				weights = (S3TConv_ASTC_Weights) (weights + 1)) {
+			S3TConv_ASTC_Encode(source, endpoints, source->minAlpha != 255, weights, 0, &candidate);
+			if (candidate.error < encoding->error) {
+				*encoding = candidate;
+			}
+		}
+	} else {
+		// Both the colors and alpha vary - alpha is interpolated separately in the second plane. The endpoints have
+		// less precision with 4 weights per plane than with 3, so both are tried.
+		for (weights = S3TCONV_ASTC_WEIGHTS_3; weights <= S3TCONV_ASTC_WEIGHTS_4 && encoding->error != 0;
+				weights = (S3TConv_ASTC_Weights) (weights + 1)) {
+			S3TConv_ASTC_Encode(source, endpoints, 1, weights, 1, &candidate);
+			if (candidate.error < encoding->error) {
+				*encoding = candidate;
+			}
+		}
+	}
+}
+
+void S3TConv_ASTC_BlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1, uint8_t astcBlock[16],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ASTC_Source source;
+	S3TConv_ASTC_Encoding encoding;
+	int endpoints[2][4], solidColor[4];
+	unsigned int colorIndex, otherColorIndex, component, endpointDistance = 0;
+
+	S3TConv_ASTC_GetSource(dxtBlock, dxtFormat, asDXT1, remainingWidth, remainingHeight, &source);
+
+	if (S3TConv_ASTC_GetSolidColor(&source, solidColor)) {
+		// Void-extent block without coordinates, with the color as UNORM16.
+		static const uint8_t voidExtentHeader[8] = { 0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+		memcpy(astcBlock, voidExtentHeader, 8);
+		for (component = 0; component < 4; ++component) {
+			astcBlock[8 + component * 2] = astcBlock[9 + component * 2] = (uint8_t) solidColor[component];
+		}
+		return;
+	}
+
+	// Most opaque blocks map to ASTC directly.
+	if (S3TConv_ASTC_EncodeDirect(&source, &encoding)) {
+		S3TConv_ASTC_StoreBlock(&encoding, astcBlock);
+		return;
+	}
+
+	// The DXT endpoints themselves may be unused, so the used colors farthest from each other are taken instead.
+	memset(endpoints, 0, sizeof(endpoints));
+	for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+		if (!(source.usedMask & (1u << colorIndex))) {
+			continue;
+		}
+		for (otherColorIndex = colorIndex; otherColorIndex < 4; ++otherColorIndex) {
+			unsigned int distance = 0;
+			if (!(source.usedMask & (1u << otherColorIndex))) {
+				continue;
+			}
+			for (component = 0; component < 3; ++component) {
+				int difference = source.colors[colorIndex][component] - source.colors[otherColorIndex][component];
+				distance += (unsigned int) (difference * difference);
+			}
+			if (distance >= endpointDistance) {
+				endpointDistance = distance;
+				memcpy(endpoints[0], source.colors[colorIndex], 3 * sizeof(int));
+				memcpy(endpoints[1], source.colors[otherColorIndex], 3 * sizeof(int));
+			}
+		}
+	}
+	endpoints[0][3] = source.minAlpha;
+	endpoints[1][3] = source.maxAlpha;
+
+	encoding.error = UINT_MAX;
+	if (endpointDistance == 0) {
+		// Constant color with varying alpha (or DXT1 punch-through with transparent black as the first endpoint),
+		// 8 weights approximating the 8 levels of DXT5 alpha. The endpoints are quantized to fewer levels with 16 3-bit
+		// weights, and ASTC interpolates in 64ths rather than 7ths, so this is not exact, but the error is measured against
+		// the decoded alpha anyway.
+		if (source.transparentMask != 0) {
+			endpoints[0][0] = endpoints[0][1] = endpoints[0][2] = 0;
+		}
+		if (dxtFormat == S3TCONV_FORMAT_DXT5 && dxtBlock[0] > dxtBlock[1]) {
+			endpoints[0][3] = dxtBlock[1];
+			endpoints[1][3] = dxtBlock[0];
+		}
+		S3TConv_ASTC_Encode(&source, (const int (*)[4]) endpoints, 1, S3TCONV_ASTC_WEIGHTS_8, 0, &encoding);
+	} else if (!source.usesOpaqueBlack) {
+		// All the used colors are on the line between the farthest ones.
+		S3TConv_ASTC_EncodeColors(&source, (const int (*)[4]) endpoints, &encoding);
+	} else {
+		// The black of the black mode is not on the line between the DXT endpoints - try every pair of the used colors.
+		for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+			for (otherColorIndex = colorIndex + 1; otherColorIndex < 4; ++otherColorIndex) {
+				if ((source.usedMask & ((1u << colorIndex) | (1u << otherColorIndex))) !=
+						((1u << colorIndex) | (1u << otherColorIndex))) {
+					continue;
+				}
+				memcpy(endpoints[0], source.colors[colorIndex], 3 * sizeof(int));
+				memcpy(endpoints[1], source.colors[otherColorIndex], 3 * sizeof(int));
+				S3TConv_ASTC_EncodeColors(&source, (const int (*)[4]) endpoints, &encoding);
+			}
+		}
+	}
+	S3TConv_ASTC_StoreBlock(&encoding, astcBlock);
+}
+
+int S3TConv_ASTC_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format astcFormat) {
+	return astcFormat == S3TCONV_FORMAT_ASTC_4X4 &&
+			(dxtFormat == S3TCONV_FORMAT_DXT1 || dxtFormat == S3TCONV_FORMAT_DXT3 || dxtFormat == S3TCONV_FORMAT_DXT5);
+}
+
+void S3TConv_ASTC_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *astcRow, unsigned int blockCount, unsigned int remainingWidth, unsigned int remainingHeight) {
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	unsigned int blockIndex;
+
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		unsigned int blockLeft = blockIndex << 2;
+		S3TConv_ASTC_BlockFromDXT(dxtRow + blockIndex * dxtBlockSize, dxtFormat, asDXT1, astcRow + blockIndex * 16,
+				remainingWidth > blockLeft ? remainingWidth - blockLeft : 0, remainingHeight);
+	}
+}
+
+int S3TConv_ASTC_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *astcData, size_t astcRowPitch, unsigned int width, unsigned int height) {
+	S3TConv_Surface surface;
+
+	if (!S3TConv_ASTC_IsConversionFromDXTSupported(dxtFormat, S3TCONV_FORMAT_ASTC_4X4)) {
+		return 0;
+	}
+
+	surface.sourceData = dxtData;
+	surface.sourceFormat = dxtFormat;
+	surface.asDXT1 = asDXT1;
+	surface.sourceRowPitch = dxtRowPitch;
+	surface.targetData = astcData;
+	surface.targetFormat = S3TCONV_FORMAT_ASTC_4X4;
+	surface.targetRowPitch = astcRowPitch;
+	surface.width = width;
+	surface.height = height;
+	surface.useBlockCache = 0;
+	surface.quality = S3TCONV_QUALITY_DEFAULT;
+	surface.stats = NULL;
+	S3TConv_Surface_ConvertBlockRows(&surface, 0, (height + 3) >> 2, NULL);
+	return 1;
+}
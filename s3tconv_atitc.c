@@ -1,265 +1,1270 @@
-/*
-Part of S3TConv, a library for converting S3TC textures to other formats.
-https://github.com/Triang3l/S3TConv
-
-Copyright (c) 2017 Triang3l.
-Contains portions of Compressonator:
-Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
-Copyright (c) 2004-2006 ATI Technologies Inc.
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in
-all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-THE SOFTWARE.
-*/
-
-#include "s3tconv_internal.h"
-
-static inline unsigned int S3TConv_ATITC_GetLuminance(const uint8_t color888[3]) {
-	// From Compressonator, matches the hardware calculation.
-	return (19 * (unsigned int) color888[0] +
-			38 * (unsigned int) color888[1] +
-			7 * (unsigned int) color888[2]) >> 6;
-}
-
-static void S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
-		uint16_t colorLow565, uint16_t colorHigh565, unsigned int lumaLow, unsigned int lumaHigh,
-		uint32_t dxtIndices, unsigned int indexCountLow, unsigned int indexCountHigh,
-		uint16_t *atitcColorLow555, uint16_t *atitcColorHigh565, uint32_t *atitcIndices) {
-	uint16_t colorMed565;
-	uint8_t colorMed888[3];
-	unsigned int lumaMed;
-	uint32_t colorIndexMask;
-
-	colorMed565 = (((colorLow565 & 0x001F) + (colorHigh565 & 0x001F)) >> 1) |
-			((((colorLow565 & 0x07E0) + (colorHigh565 & 0x07E0)) >> 1) & 0x07E0) |
-			((((colorLow565 & 0xF800) + (colorHigh565 & 0xF800)) >> 1) & 0xF800);
-	S3TConv_Utility_Color565To888(colorMed565, colorMed888);
-	lumaMed = S3TConv_ATITC_GetLuminance(colorMed888);
-
-	colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
-	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
-
-	if (indexCountLow > indexCountHigh) { // Not >= because low gets less green bits than high.
-		if (lumaMed >= lumaLow) {
-			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorLow565);
-			*atitcColorHigh565 = colorMed565;
-			// 0 1 2 3 -> 2 3 3 0.
-			*atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
-		} else {
-			// Generally shouldn't happen without hue variation.
-			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorMed565);
-			*atitcColorHigh565 = colorLow565;
-			// 0 1 2 3 -> 3 2 2 0.
-			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ ((~dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
-		}
-	} else {
-		if (lumaMed <= lumaHigh) {
-			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorMed565);
-			*atitcColorHigh565 = colorHigh565;
-			// 0 1 2 3 -> 2 3 2 0.
-			*atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
-		} else {
-			// Generally shouldn't happen without hue variation.
-			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorHigh565);
-			*atitcColorHigh565 = colorMed565;
-			// 0 1 2 3 -> 3 2 3 0.
-			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ 0x55555555) & colorIndexMask;
-		}
-	}
-}
-
-void S3TConv_ATITC_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
-		unsigned int remainingWidth, unsigned int remainingHeight) {
-	// Source block data.
-	uint16_t dxtColor0565, dxtColor1565;
-	uint8_t dxtColor0888[3], dxtColor1888[3];
-	unsigned int dxtLuma0, dxtLuma1;
-	uint32_t dxtSourceIndices;
-
-	// Resulting block data.
-	uint16_t atitcColorLow555, atitcColorHigh565;
-	uint32_t atitcIndices;
-
-	// Extracting data from the DXT block bytes.
-	dxtColor0565 = (uint16_t) dxtBlock[0] | ((uint16_t) dxtBlock[1] << 8);
-	dxtColor1565 = (uint16_t) dxtBlock[2] | ((uint16_t) dxtBlock[3] << 8);
-	dxtSourceIndices = (uint32_t) dxtBlock[4] | ((uint32_t) dxtBlock[5] << 8) |
-			((uint32_t) dxtBlock[6] << 16) | ((uint32_t) dxtBlock[7] << 24);
-	S3TConv_Utility_Color565To888(dxtColor0565, dxtColor0888);
-	dxtLuma0 = S3TConv_ATITC_GetLuminance(dxtColor0888);
-	S3TConv_Utility_Color565To888(dxtColor1565, dxtColor1888);
-	dxtLuma1 = S3TConv_ATITC_GetLuminance(dxtColor1888);
-
-	// Handling 2 main modes.
-	if (!asDXT1 || dxtColor0565 > dxtColor1565) {
-		// The RGB0, RGB1, (2*RGB0+RGB1)/3, (RGB0+2*RGB1)/3 mode.
-		// Simply reordering the indices. DXT may be implemented as 1/3 and 2/3 or 3/8 and 5/8. ATITC is 3/8 and 5/8.
-		// 0 1 2 3 -> 0 3 1 2, if color 0 is the lower one (which is unlikely though).
-		atitcIndices = dxtSourceIndices ^ ((dxtSourceIndices & 0xAAAAAAAA) >> 1);
-		atitcIndices ^= (atitcIndices & 0x55555555) << 1;
-		if (dxtLuma0 >= dxtLuma1) {
-			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColor1565);
-			atitcColorHigh565 = dxtColor0565;
-			atitcIndices = ~atitcIndices;
-		} else {
-			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColor0565);
-			atitcColorHigh565 = dxtColor1565;
-		}
-	} else {
-		// The RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode. In general, can't be represented exactly by ATITC.
-
-		uint16_t dxtColorLow565, dxtColorHigh565;
-		const uint8_t *dxtColorLow888, *dxtColorHigh888;
-		unsigned int dxtLumaLow, dxtLumaHigh;
-		uint32_t dxtIndices = dxtSourceIndices;
-
-		unsigned int dxtIndexCount[4] = { 0 }, dxtLowHighIndexCounts[4][2] = { 0 };
-		unsigned int pixelIndex;
-
-		// Sort the DXT colors by luminance, so it's easier to interpolate and to match the way ATITC sorts shades.
-		if (dxtLuma0 <= dxtLuma1) {
-			dxtColorLow565 = dxtColor0565;
-			dxtColorHigh565 = dxtColor1565;
-			dxtColorLow888 = dxtColor0888;
-			dxtColorHigh888 = dxtColor1888;
-			dxtLumaLow = dxtLuma0;
-			dxtLumaHigh = dxtLuma1;
-		} else {
-			dxtColorLow565 = dxtColor1565;
-			dxtColorHigh565 = dxtColor0565;
-			dxtColorLow888 = dxtColor1888;
-			dxtColorHigh888 = dxtColor0888;
-			dxtLumaLow = dxtLuma1;
-			dxtLumaHigh = dxtLuma0;
-			dxtIndices ^= (~dxtIndices & 0xAAAAAAAA) >> 1; // Swap RGB0 and RGB1.
-		}
-
-		// Count all indices in the whole block, and also low and high colors in 2x2 corners, so less common ones may be neglected.
-		for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
-			if ((pixelIndex & 3) >= remainingWidth || (pixelIndex >> 2) >= remainingHeight) {
-				continue;
-			}
-			unsigned int dxtIndex = (dxtIndices >> (pixelIndex << 1)) & 3;
-			++dxtIndexCount[dxtIndex];
-			// Count low and high colors in 2x2 corners in case they will be used to replace the medium color with close interpolations.
-			if ((dxtIndex & 2) == 0) {
-				++dxtLowHighIndexCounts[(pixelIndex >> 2) ^ (((pixelIndex >> 1) ^ (pixelIndex >> 2)) & 1)][dxtIndex];
-			}
-		}
-
-		// Try various conversions, from the most accurate ones in specific cases to the general ones.
-		if (dxtIndexCount[2] == 0) {
-			// If at least one shade is not used, the remaining two can be converted exactly.
-			// The medium color isn't used.
-			atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
-			atitcColorHigh565 = dxtColorHigh565;
-			// 0 1 3 -> 2 3 0.
-			atitcIndices = (dxtIndices ^ 0xAAAAAAAA) & ~((dxtIndices & 0xAAAAAAAA) >> 1);
-		} else if (dxtIndexCount[0] == 0 || dxtIndexCount[1] == 0) {
-			// Similar case, but either low or high isn't used.
-			S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
-					dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
-					dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
-					&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
-		} else if (dxtIndexCount[3] == 0) {
-			// If black isn't used, approximate 1/2 with 3/8 or 5/8, depending on whether low or high is more common in each 2x2 corner.
-			uint32_t medIndexMask;
-			int lowIsMoreCommon = (dxtIndexCount[0] > dxtIndexCount[1]); // Not >= because high has more green bits.
-			unsigned int subBlockIndex;
-			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColorLow565);
-			atitcColorHigh565 = dxtColorHigh565;
-			// 0 1 2 -> 0 3 2, or 0 2 1 -> 0 3 1 if the lower approximation is the closer one.
-			atitcIndices = dxtIndices | ((dxtIndices & 0x55555555) << 1);
-			medIndexMask = dxtIndices & 0xAAAAAAAA;
-			medIndexMask |= medIndexMask >> 1;
-			for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
-				unsigned int countLow = dxtLowHighIndexCounts[subBlockIndex][0], countHigh = dxtLowHighIndexCounts[subBlockIndex][1];
-				if (countLow > countHigh || (lowIsMoreCommon && countLow == countHigh)) {
-					atitcIndices ^= (0x00000F0F << (((subBlockIndex & 2) << 3) | ((subBlockIndex & 1) << 2))) & medIndexMask;
-				}
-			}
-		} else {
-			// 3 shades will be used if the resulting approximation is near-perfect (if medium is the most common),
-			// or if it's at least somewhere between the original colors (if low or high is more common than medium).
-			// In other cases, 2 shades will be picked, depending on which ones are the most common.
-
-			unsigned int colorBlackTrickMedHigh888[3];
-			unsigned int blackTrickBoundScaleLow, blackTrickBoundScaleHigh;
-			unsigned int blackTrickBoundLow[3], blackTrickBoundHigh[3];
-
-			colorBlackTrickMedHigh888[0] = dxtColorLow888[0] + (dxtColorHigh888[0] >> 2);
-			colorBlackTrickMedHigh888[1] = dxtColorLow888[1] + (dxtColorHigh888[1] >> 2);
-			colorBlackTrickMedHigh888[2] = dxtColorLow888[2] + (dxtColorHigh888[2] >> 2);
-
-			blackTrickBoundScaleLow = ((dxtIndexCount[2] >= dxtIndexCount[0] && dxtIndexCount[2] >= dxtIndexCount[1]) ? 3 : 0);
-			blackTrickBoundScaleHigh = 8 - blackTrickBoundScaleLow;
-
-			blackTrickBoundLow[0] = (blackTrickBoundScaleHigh * dxtColorLow888[0] + blackTrickBoundScaleLow * dxtColorHigh888[0]) >> 3;
-			blackTrickBoundLow[1] = (blackTrickBoundScaleHigh * dxtColorLow888[1] + blackTrickBoundScaleLow * dxtColorHigh888[1]) >> 3;
-			blackTrickBoundLow[2] = (blackTrickBoundScaleHigh * dxtColorLow888[2] + blackTrickBoundScaleLow * dxtColorHigh888[2]) >> 3;
-			blackTrickBoundHigh[0] = (blackTrickBoundScaleLow * dxtColorLow888[0] + blackTrickBoundScaleHigh * dxtColorHigh888[0]) >> 3;
-			blackTrickBoundHigh[1] = (blackTrickBoundScaleLow * dxtColorLow888[1] + blackTrickBoundScaleHigh * dxtColorHigh888[1]) >> 3;
-			blackTrickBoundHigh[2] = (blackTrickBoundScaleLow * dxtColorLow888[2] + blackTrickBoundScaleHigh * dxtColorHigh888[2]) >> 3;
-
-			// Will also ensure there's no overflow in each component.
-			if (colorBlackTrickMedHigh888[0] >= blackTrickBoundLow[0] && colorBlackTrickMedHigh888[0] <= blackTrickBoundHigh[0] &&
-					colorBlackTrickMedHigh888[1] >= blackTrickBoundLow[1] && colorBlackTrickMedHigh888[1] <= blackTrickBoundHigh[1] &&
-					colorBlackTrickMedHigh888[2] >= blackTrickBoundLow[2] && colorBlackTrickMedHigh888[2] <= blackTrickBoundHigh[2]) {
-				atitcColorLow555 = (uint16_t) (0x8000 | ((colorBlackTrickMedHigh888[0] >> 3) << 10) |
-						((colorBlackTrickMedHigh888[1] >> 3) << 5) | (colorBlackTrickMedHigh888[2] >> 3));
-				atitcColorHigh565 = dxtColorHigh565;
-				// 0 1 2 3 -> 1 3 2 0.
-				atitcIndices = ~dxtIndices;
-				atitcIndices ^= (atitcIndices & 0x55555555) << 1;
-				atitcIndices ^= (atitcIndices & 0xAAAAAAAA) >> 1;
-			} else {
-				// Can't use the black trick to represent all 3 shades, so discard one of them.
-				if (dxtIndexCount[2] <= dxtIndexCount[0] && dxtIndexCount[2] <= dxtIndexCount[1]) {
-					// Discard the medium shade.
-					uint32_t colorIndexMask;
-					atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
-					atitcColorHigh565 = dxtColorHigh565;
-					colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
-					colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
-					if (dxtIndexCount[0] > dxtIndexCount[1]) {
-						// 0 1 2 3 -> 2 3 2 0.
-						atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
-					} else {
-						// 0 1 2 3 -> 2 3 3 0.
-						atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
-					}
-				} else {
-					// Discard the low or the high shade.
-					S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
-							dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
-							dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
-							&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
-				}
-			}
-		}
-	}
-
-	// Writing the ATITC block.
-	atitcBlock[0] = (uint8_t) atitcColorLow555;
-	atitcBlock[1] = (uint8_t) (atitcColorLow555 >> 8);
-	atitcBlock[2] = (uint8_t) atitcColorHigh565;
-	atitcBlock[3] = (uint8_t) (atitcColorHigh565 >> 8);
-	atitcBlock[4] = (uint8_t) atitcIndices;
-	atitcBlock[5] = (uint8_t) (atitcIndices >> 8);
-	atitcBlock[6] = (uint8_t) (atitcIndices >> 16);
-	atitcBlock[7] = (uint8_t) (atitcIndices >> 24);
-}
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+Contains portions of Compressonator:
+Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+Copyright (c) 2004-2006 ATI Technologies Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <string.h>
+#include "s3tconv_internal.h"
+#if defined(S3TCONV_SSE2)
+#include <emmintrin.h>
+#elif defined(S3TCONV_NEON)
+#include <arm_neon.h>
+#endif
+
+#if S3TCONV_LOOKUP_TABLES == 1
+// 19 * red, 38 * green and 7 * blue expanded to 8 bits.
+static const uint16_t S3TConv_ATITC_LuminanceR[32] = {
+	0, 152, 304, 456, 627, 779, 931, 1083, 1254, 1406, 1558, 1710, 1881, 2033, 2185, 2337,
+	2508, 2660, 2812, 2964, 3135, 3287, 3439, 3591, 3762, 3914, 4066, 4218, 4389, 4541, 4693, 4845
+};
+
+static const uint16_t S3TConv_ATITC_LuminanceG[64] = {
+	0, 152, 304, 456, 608, 760, 912, 1064, 1216, 1368, 1520, 1672, 1824, 1976, 2128, 2280,
+	2470, 2622, 2774, 2926, 3078, 3230, 3382, 3534, 3686, 3838, 3990, 4142, 4294, 4446, 4598, 4750,
+	4940, 5092, 5244, 5396, 5548, 5700, 5852, 6004, 6156, 6308, 6460, 6612, 6764, 6916, 7068, 7220,
+	7410, 7562, 7714, 7866, 8018, 8170, 8322, 8474, 8626, 8778, 8930, 9082, 9234, 9386, 9538, 9690
+};
+
+static const uint16_t S3TConv_ATITC_LuminanceB[32] = {
+	0, 56, 112, 168, 231, 287, 343, 399, 462, 518, 574, 630, 693, 749, 805, 861,
+	924, 980, 1036, 1092, 1155, 1211, 1267, 1323, 1386, 1442, 1498, 1554, 1617, 1673, 1729, 1785
+};
+#elif S3TCONV_LOOKUP_TABLES == 2
+static uint8_t S3TConv_ATITC_LuminanceTable[65536];
+#endif
+
+static inline unsigned int S3TConv_ATITC_GetLuminance(uint16_t color565) {
+#if S3TCONV_LOOKUP_TABLES == 1
+	return ((unsigned int) S3TConv_ATITC_LuminanceR[color565 >> 11] +
+			(unsigned int) S3TConv_ATITC_LuminanceG[(color565 >> 5) & 0x3F] +
+			(unsigned int) S3TConv_ATITC_LuminanceB[color565 & 0x1F]) >> 6;
+#elif S3TCONV_LOOKUP_TABLES == 2
+	return S3TConv_ATITC_LuminanceTable[color565];
+#else
+	uint8_t color888[3];
+	S3TConv_Utility_Color565To888(color565, color888);
+	// From Compressonator, matches the hardware calculation.
+	return (19 * (unsigned int) color888[0] +
+			38 * (unsigned int) color888[1] +
+			7 * (unsigned int) color888[2]) >> 6;
+#endif
+}
+
+#if S3TCONV_LOOKUP_TABLES == 2
+void S3TConv_ATITC_InitLookupTables(void) {
+	unsigned int color565;
+	for (color565 = 0; color565 < 65536; ++color565) {
+		const uint8_t *color888 = S3TConv_Utility_Color565To888Table[color565];
+		S3TConv_ATITC_LuminanceTable[color565] = (uint8_t) ((19 * (unsigned int) color888[0] +
+				38 * (unsigned int) color888[1] + 7 * (unsigned int) color888[2]) >> 6);
+	}
+}
+#endif
+
+static void S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
+		uint16_t colorLow565, uint16_t colorHigh565, unsigned int lumaLow, unsigned int lumaHigh,
+		uint32_t dxtIndices, unsigned int indexCountLow, unsigned int indexCountHigh,
+		uint16_t *atitcColorLow555, uint16_t *atitcColorHigh565, uint32_t *atitcIndices) {
+	uint16_t colorMed565;
+	unsigned int lumaMed;
+	uint32_t colorIndexMask;
+
+	colorMed565 = (((colorLow565 & 0x001F) + (colorHigh565 & 0x001F)) >> 1) |
+			((((colorLow565 & 0x07E0) + (colorHigh565 & 0x07E0)) >> 1) & 0x07E0) |
+			((((colorLow565 & 0xF800) + (colorHigh565 & 0xF800)) >> 1) & 0xF800);
+	lumaMed = S3TConv_ATITC_GetLuminance(colorMed565);
+
+	colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
+	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+
+	if (indexCountLow > indexCountHigh) { // Not >= because low gets less green bits than high.
+		if (lumaMed >= lumaLow) {
+			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorLow565);
+			*atitcColorHigh565 = colorMed565;
+			// 0 1 2 3 -> 2 3 3 0.
+			*atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+		} else {
+			// Generally shouldn't happen without hue variation.
+			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorMed565);
+			*atitcColorHigh565 = colorLow565;
+			// 0 1 2 3 -> 3 2 2 0.
+			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ ((~dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+		}
+	} else {
+		if (lumaMed <= lumaHigh) {
+			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorMed565);
+			*atitcColorHigh565 = colorHigh565;
+			// 0 1 2 3 -> 2 3 2 0.
+			*atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
+		} else {
+			// Generally shouldn't happen without hue variation.
+			*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(colorHigh565);
+			*atitcColorHigh565 = colorMed565;
+			// 0 1 2 3 -> 3 2 3 0.
+			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ 0x55555555) & colorIndexMask;
+		}
+	}
+}
+
+// Low bits of the 2-bit indices of the pixels not in the padding.
+static inline uint32_t S3TConv_ATITC_GetPixelMask(unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint32_t rowMask = 0x55 >> ((4 - (remainingWidth < 4 ? remainingWidth : 4)) << 1);
+	uint32_t rowCountMask = (uint32_t) (((uint64_t) 1 << ((remainingHeight < 4 ? remainingHeight : 4) << 3)) - 1);
+	return rowMask * (0x01010101 & rowCountMask);
+}
+
+// Number of set low bits of 2-bit indices.
+static inline unsigned int S3TConv_ATITC_CountIndexBits(uint32_t bits) {
+	bits = (bits & 0x11111111) + ((bits >> 2) & 0x11111111);
+	bits = (bits + (bits >> 4)) & 0x0F0F0F0F;
+	return (bits * 0x01010101) >> 24;
+}
+
+// The black mode with S3TCONV_QUALITY_FAST. Indices of the whole block are counted with bit operations instead of the loop
+// over the pixels, and the medium color, if it's not kept exactly, is replaced in the same way in all 2x2 corners.
+static S3TConv_ATITC_Path S3TConv_ATITC_ConvertBlackModeFast(
+		uint16_t dxtColorLow565, uint16_t dxtColorHigh565, unsigned int dxtLumaLow, unsigned int dxtLumaHigh,
+		uint32_t dxtIndices, uint32_t pixelMask,
+		uint16_t *atitcColorLow555, uint16_t *atitcColorHigh565, uint32_t *atitcIndices) {
+	uint32_t indexLowBits = dxtIndices & pixelMask, indexHighBits = (dxtIndices >> 1) & pixelMask;
+	unsigned int countLow = S3TConv_ATITC_CountIndexBits(pixelMask & ~(indexLowBits | indexHighBits));
+	unsigned int countHigh = S3TConv_ATITC_CountIndexBits(indexLowBits & ~indexHighBits);
+	uint8_t dxtColorLow888[3], dxtColorHigh888[3];
+	uint32_t indexMask;
+
+	if ((indexHighBits & ~indexLowBits) == 0) {
+		// The medium color isn't used, same as with the default quality.
+		*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
+		*atitcColorHigh565 = dxtColorHigh565;
+		// 0 1 3 -> 2 3 0.
+		*atitcIndices = (dxtIndices ^ 0xAAAAAAAA) & ~((dxtIndices & 0xAAAAAAAA) >> 1);
+		return S3TCONV_ATITC_PATH_UNUSED_MEDIUM;
+	}
+
+	if (countLow == 0 || countHigh == 0) {
+		S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
+				dxtIndices, countLow, countHigh, atitcColorLow555, atitcColorHigh565, atitcIndices);
+		return S3TCONV_ATITC_PATH_UNUSED_LOW_OR_HIGH;
+	}
+
+	if ((indexLowBits & indexHighBits) == 0) {
+		// Black isn't used, medium becomes 3/8 if low is more common in the whole block, 5/8 otherwise.
+		*atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColorLow565);
+		*atitcColorHigh565 = dxtColorHigh565;
+		// 0 1 2 -> 0 3 2, or 0 3 1.
+		*atitcIndices = dxtIndices | ((dxtIndices & 0x55555555) << 1);
+		if (countLow > countHigh) {
+			indexMask = dxtIndices & 0xAAAAAAAA;
+			*atitcIndices ^= indexMask | (indexMask >> 1);
+		}
+		return S3TCONV_ATITC_PATH_UNUSED_BLACK;
+	}
+
+	// All 4 shades are used. The black trick is taken whenever it doesn't overflow, without the bound checks.
+	S3TConv_Utility_Color565To888(dxtColorLow565, dxtColorLow888);
+	S3TConv_Utility_Color565To888(dxtColorHigh565, dxtColorHigh888);
+	if (dxtColorLow888[0] + (dxtColorHigh888[0] >> 2) <= 255 && dxtColorLow888[1] + (dxtColorHigh888[1] >> 2) <= 255 &&
+			dxtColorLow888[2] + (dxtColorHigh888[2] >> 2) <= 255) {
+		*atitcColorLow555 = (uint16_t) (0x8000 | (((dxtColorLow888[0] + (dxtColorHigh888[0] >> 2)) >> 3) << 10) |
+				(((dxtColorLow888[1] + (dxtColorHigh888[1] >> 2)) >> 3) << 5) | ((dxtColorLow888[2] + (dxtColorHigh888[2] >> 2)) >> 3));
+		*atitcColorHigh565 = dxtColorHigh565;
+		// 0 1 2 3 -> 1 3 2 0.
+		*atitcIndices = ~dxtIndices;
+		*atitcIndices ^= (*atitcIndices & 0x55555555) << 1;
+		*atitcIndices ^= (*atitcIndices & 0xAAAAAAAA) >> 1;
+		return S3TCONV_ATITC_PATH_BLACK_TRICK;
+	}
+
+	*atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
+	*atitcColorHigh565 = dxtColorHigh565;
+	indexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
+	indexMask = ~(indexMask | (indexMask << 1));
+	if (countLow > countHigh) {
+		// 0 1 2 3 -> 2 3 2 0.
+		*atitcIndices = (0xAAAAAAAA | dxtIndices) & indexMask;
+	} else {
+		// 0 1 2 3 -> 2 3 3 0.
+		*atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & indexMask;
+	}
+	return S3TCONV_ATITC_PATH_DISCARD_MEDIUM;
+}
+
+static inline unsigned int S3TConv_ATITC_GetColorError(const int color0[3], const int color1[3]) {
+	int difference[3];
+	difference[0] = color0[0] - color1[0];
+	difference[1] = color0[1] - color1[1];
+	difference[2] = color0[2] - color1[2];
+	return (unsigned int) (difference[0] * difference[0] + difference[1] * difference[1] + difference[2] * difference[2]);
+}
+
+// Colors of the DXT RGB block in the order of the indices, interpolated like in S3TConv_Uncompressed.
+static void S3TConv_ATITC_DecodeDXTColors(uint16_t dxtColor0565, uint16_t dxtColor1565, int fourColor, int colors[4][3]) {
+	uint8_t color0888[3], color1888[3];
+	unsigned int component;
+	S3TConv_Utility_Color565To888(dxtColor0565, color0888);
+	S3TConv_Utility_Color565To888(dxtColor1565, color1888);
+	for (component = 0; component < 3; ++component) {
+		int color0 = color0888[component], color1 = color1888[component];
+		colors[0][component] = color0;
+		colors[1][component] = color1;
+		if (fourColor) {
+			colors[2][component] = (2 * color0 + color1 + 1) / 3;
+			colors[3][component] = (color0 + 2 * color1 + 1) / 3;
+		} else {
+			colors[2][component] = (color0 + color1 + 1) >> 1;
+			colors[3][component] = 0;
+		}
+	}
+}
+
+// Colors of the ATITC RGB block in the order of the indices, as decoded by Compressonator.
+static void S3TConv_ATITC_DecodeColors(uint16_t atitcColorLow555, uint16_t atitcColorHigh565, int colors[4][3]) {
+	uint8_t colorHigh888[3];
+	int colorLow888[3];
+	unsigned int component;
+	colorLow888[0] = (int) (((atitcColorLow555 >> 7) & 0xF8) | ((atitcColorLow555 >> 12) & 0x07));
+	colorLow888[1] = (int) (((atitcColorLow555 >> 2) & 0xF8) | ((atitcColorLow555 >> 7) & 0x07));
+	colorLow888[2] = (int) (((atitcColorLow555 << 3) & 0xF8) | ((atitcColorLow555 >> 2) & 0x07));
+	S3TConv_Utility_Color565To888(atitcColorHigh565, colorHigh888);
+	for (component = 0; component < 3; ++component) {
+		int colorLow = colorLow888[component], colorHigh = colorHigh888[component];
+		if (atitcColorLow555 & 0x8000) {
+			colors[0][component] = 0;
+			colors[1][component] = (colorLow > (colorHigh >> 2) ? colorLow - (colorHigh >> 2) : 0);
+			colors[2][component] = colorLow;
+		} else {
+			colors[0][component] = colorLow;
+			colors[1][component] = (5 * colorLow + 3 * colorHigh) >> 3;
+			colors[2][component] = (3 * colorLow + 5 * colorHigh) >> 3;
+		}
+		colors[3][component] = colorHigh;
+	}
+}
+
+// Total squared error of the DXT colors, weighted by how many pixels use them, replaced with the closest colors
+// of the ATITC endpoints (color low in bits 0-15, color high in 16-31). Returns the ATITC index for each DXT index.
+static unsigned int S3TConv_ATITC_MatchEndpoints(const int dxtColors[4][3], const unsigned int dxtIndexCount[4],
+		uint32_t atitcEndpoints, unsigned int atitcIndexMap[4]) {
+	int atitcColors[4][3];
+	unsigned int totalError = 0, dxtIndex, atitcIndex;
+
+	S3TConv_ATITC_DecodeColors((uint16_t) atitcEndpoints, (uint16_t) (atitcEndpoints >> 16), atitcColors);
+	for (dxtIndex = 0; dxtIndex < 4; ++dxtIndex) {
+		unsigned int bestError;
+		atitcIndexMap[dxtIndex] = 0;
+		if (dxtIndexCount[dxtIndex] == 0) {
+			continue;
+		}
+		bestError = S3TConv_ATITC_GetColorError(dxtColors[dxtIndex], atitcColors[0]);
+		for (atitcIndex = 1; atitcIndex < 4; ++atitcIndex) {
+			unsigned int error = S3TConv_ATITC_GetColorError(dxtColors[dxtIndex], atitcColors[atitcIndex]);
+			if (error < bestError) {
+				bestError = error;
+				atitcIndexMap[dxtIndex] = atitcIndex;
+			}
+		}
+		totalError += bestError * dxtIndexCount[dxtIndex];
+	}
+	return totalError;
+}
+
+// The black mode with S3TCONV_QUALITY_HIGH, applied to the result of the default conversion. The DXT colors are matched
+// to the closest colors of a few candidate endpoint pairs, then each component of the best pair is moved by 1 while this
+// reduces the error, in 2 passes at most. The default result is kept unless the error becomes strictly smaller.
+static void S3TConv_ATITC_RefineBlackMode(uint16_t dxtColorLow565, uint16_t dxtColorHigh565, uint32_t dxtIndices,
+		const unsigned int dxtIndexCount[4], unsigned int remainingWidth, unsigned int remainingHeight,
+		uint16_t *atitcColorLow555, uint16_t *atitcColorHigh565, uint32_t *atitcIndices) {
+	// Shifts and masks of the components in the endpoints, the mode bit is not changed.
+	static const unsigned int componentShifts[6] = { 0, 5, 10, 16, 21, 27 };
+	static const unsigned int componentMasks[6] = { 0x1F, 0x1F, 0x1F, 0x1F, 0x3F, 0x1F };
+
+	int dxtColors[4][3], atitcColors[4][3];
+	uint8_t dxtColorLow888[3], dxtColorHigh888[3];
+	uint16_t dxtColorMed565;
+	uint32_t candidates[8], bestEndpoints = 0;
+	unsigned int defaultError = 0, bestError = ~0u, bestIndexMap[4] = { 0 }, indexMap[4];
+	unsigned int candidateIndex, pass, componentIndex, pixelIndex;
+
+	// Low, high, medium and black, like the sorted DXT indices.
+	S3TConv_ATITC_DecodeDXTColors(dxtColorLow565, dxtColorHigh565, 0, dxtColors);
+
+	// The error of the default result is measured per pixel, as pixels with the same DXT index may have different indices.
+	S3TConv_ATITC_DecodeColors(*atitcColorLow555, *atitcColorHigh565, atitcColors);
+	for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+		if ((pixelIndex & 3) >= remainingWidth || (pixelIndex >> 2) >= remainingHeight) {
+			continue;
+		}
+		defaultError += S3TConv_ATITC_GetColorError(dxtColors[(dxtIndices >> (pixelIndex << 1)) & 3],
+				atitcColors[(*atitcIndices >> (pixelIndex << 1)) & 3]);
+	}
+	if (defaultError == 0) {
+		return;
+	}
+
+	dxtColorMed565 = (((dxtColorLow565 & 0x001F) + (dxtColorHigh565 & 0x001F)) >> 1) |
+			((((dxtColorLow565 & 0x07E0) + (dxtColorHigh565 & 0x07E0)) >> 1) & 0x07E0) |
+			((((dxtColorLow565 & 0xF800) + (dxtColorHigh565 & 0xF800)) >> 1) & 0xF800);
+	S3TConv_Utility_Color565To888(dxtColorLow565, dxtColorLow888);
+	S3TConv_Utility_Color565To888(dxtColorHigh565, dxtColorHigh888);
+
+	// The endpoints of all the default approximations, with the black trick clamped instead of being rejected.
+	candidates[0] = *atitcColorLow555 | ((uint32_t) *atitcColorHigh565 << 16);
+	candidates[1] = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565) | ((uint32_t) dxtColorHigh565 << 16);
+	candidates[2] = S3TConv_Utility_Color565To555(dxtColorLow565) | ((uint32_t) dxtColorHigh565 << 16);
+	candidates[3] = 0x8000 | ((uint32_t) dxtColorHigh565 << 16);
+	for (componentIndex = 0; componentIndex < 3; ++componentIndex) {
+		unsigned int component = dxtColorLow888[componentIndex] + (dxtColorHigh888[componentIndex] >> 2);
+		candidates[3] |= (component < 255 ? component >> 3 : 31) << componentShifts[2 - componentIndex];
+	}
+	candidates[4] = 0x8000 | S3TConv_Utility_Color565To555(dxtColorMed565) | ((uint32_t) dxtColorHigh565 << 16);
+	candidates[5] = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565) | ((uint32_t) dxtColorMed565 << 16);
+	candidates[6] = 0x8000 | S3TConv_Utility_Color565To555(dxtColorMed565) | ((uint32_t) dxtColorLow565 << 16);
+	candidates[7] = 0x8000 | S3TConv_Utility_Color565To555(dxtColorHigh565) | ((uint32_t) dxtColorMed565 << 16);
+	for (candidateIndex = 0; candidateIndex < 8; ++candidateIndex) {
+		unsigned int error = S3TConv_ATITC_MatchEndpoints((const int (*)[3]) dxtColors, dxtIndexCount,
+				candidates[candidateIndex], indexMap);
+		if (error < bestError) {
+			bestError = error;
+			bestEndpoints = candidates[candidateIndex];
+			memcpy(bestIndexMap, indexMap, sizeof(bestIndexMap));
+		}
+	}
+
+	for (pass = 0; pass < 2 && bestError != 0; ++pass) {
+		uint32_t passEndpoints = bestEndpoints;
+		for (componentIndex = 0; componentIndex < 6; ++componentIndex) {
+			unsigned int shift = componentShifts[componentIndex], mask = componentMasks[componentIndex];
+			unsigned int component = (bestEndpoints >> shift) & mask;
+			uint32_t endpoints, clearedEndpoints = bestEndpoints & ~((uint32_t) mask << shift);
+			unsigned int error;
+			if (component > 0) {
+				endpoints = clearedEndpoints | ((uint32_t) (component - 1) << shift);
+				error = S3TConv_ATITC_MatchEndpoints((const int (*)[3]) dxtColors, dxtIndexCount, endpoints, indexMap);
+				if (error < bestError) {
+					bestError = error;
+					bestEndpoints = endpoints;
+					memcpy(bestIndexMap, indexMap, sizeof(bestIndexMap));
+					continue;
+				}
+			}
+			if (component < mask) {
+				endpoints = clearedEndpoints | ((uint32_t) (component + 1) << shift);
+				error = S3TConv_ATITC_MatchEndpoints((const int (*)[3]) dxtColors, dxtIndexCount, endpoints, indexMap);
+				if (error < bestError) {
+					bestError = error;
+					bestEndpoints = endpoints;
+					memcpy(bestIndexMap, indexMap, sizeof(bestIndexMap));
+				}
+			}
+		}
+		if (bestEndpoints == passEndpoints) {
+			break;
+		}
+	}
+
+	if (bestError >= defaultError) {
+		return;
+	}
+	*atitcColorLow555 = (uint16_t) bestEndpoints;
+	*atitcColorHigh565 = (uint16_t) (bestEndpoints >> 16);
+	*atitcIndices = 0;
+	for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+		*atitcIndices |= (uint32_t) bestIndexMap[(dxtIndices >> (pixelIndex << 1)) & 3] << (pixelIndex << 1);
+	}
+}
+
+// Inlined with constant remainingWidth and remainingHeight for full blocks, so padding checks are removed.
+// Takes the fields of the DXT block already extracted, so the fused RGBA converters decode them only once.
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBColors(
+		uint16_t dxtColor0565, uint16_t dxtColor1565, uint32_t dxtSourceIndices, int asDXT1, S3TConv_Quality quality,
+		uint8_t atitcBlock[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_Path path;
+
+	// Source block data.
+	unsigned int dxtLuma0, dxtLuma1;
+
+	// Resulting block data.
+	uint16_t atitcColorLow555, atitcColorHigh565;
+	uint32_t atitcIndices;
+
+	dxtLuma0 = S3TConv_ATITC_GetLuminance(dxtColor0565);
+	dxtLuma1 = S3TConv_ATITC_GetLuminance(dxtColor1565);
+
+	// Handling 2 main modes.
+	if (!asDXT1 || dxtColor0565 > dxtColor1565) {
+		// The RGB0, RGB1, (2*RGB0+RGB1)/3, (RGB0+2*RGB1)/3 mode.
+		// Simply reordering the indices. DXT may be implemented as 1/3 and 2/3 or 3/8 and 5/8. ATITC is 3/8 and 5/8.
+		// 0 1 2 3 -> 0 3 1 2, if color 0 is the lower one (which is unlikely though).
+		path = S3TCONV_ATITC_PATH_FOUR_COLOR;
+		atitcIndices = dxtSourceIndices ^ ((dxtSourceIndices & 0xAAAAAAAA) >> 1);
+		atitcIndices ^= (atitcIndices & 0x55555555) << 1;
+		if (dxtLuma0 >= dxtLuma1) {
+			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColor1565);
+			atitcColorHigh565 = dxtColor0565;
+			atitcIndices = ~atitcIndices;
+		} else {
+			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColor0565);
+			atitcColorHigh565 = dxtColor1565;
+		}
+	} else if (quality == S3TCONV_QUALITY_FAST) {
+		if (dxtLuma0 <= dxtLuma1) {
+			path = S3TConv_ATITC_ConvertBlackModeFast(dxtColor0565, dxtColor1565, dxtLuma0, dxtLuma1, dxtSourceIndices,
+					S3TConv_ATITC_GetPixelMask(remainingWidth, remainingHeight),
+					&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+		} else {
+			path = S3TConv_ATITC_ConvertBlackModeFast(dxtColor1565, dxtColor0565, dxtLuma1, dxtLuma0,
+					dxtSourceIndices ^ ((~dxtSourceIndices & 0xAAAAAAAA) >> 1),
+					S3TConv_ATITC_GetPixelMask(remainingWidth, remainingHeight),
+					&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+		}
+	} else {
+		// The RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode. In general, can't be represented exactly by ATITC.
+
+		uint16_t dxtColorLow565, dxtColorHigh565;
+		unsigned int dxtLumaLow, dxtLumaHigh;
+		uint32_t dxtIndices = dxtSourceIndices;
+
+		unsigned int dxtIndexCount[4] = { 0 }, dxtLowHighIndexCounts[4][2] = { 0 };
+		unsigned int pixelIndex;
+
+		// Sort the DXT colors by luminance, so it's easier to interpolate and to match the way ATITC sorts shades.
+		if (dxtLuma0 <= dxtLuma1) {
+			dxtColorLow565 = dxtColor0565;
+			dxtColorHigh565 = dxtColor1565;
+			dxtLumaLow = dxtLuma0;
+			dxtLumaHigh = dxtLuma1;
+		} else {
+			dxtColorLow565 = dxtColor1565;
+			dxtColorHigh565 = dxtColor0565;
+			dxtLumaLow = dxtLuma1;
+			dxtLumaHigh = dxtLuma0;
+			dxtIndices ^= (~dxtIndices & 0xAAAAAAAA) >> 1; // Swap RGB0 and RGB1.
+		}
+
+		// Count all indices in the whole block, and also low and high colors in 2x2 corners, so less common ones may be neglected.
+		for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+			if ((pixelIndex & 3) >= remainingWidth || (pixelIndex >> 2) >= remainingHeight) {
+				continue;
+			}
+			unsigned int dxtIndex = (dxtIndices >> (pixelIndex << 1)) & 3;
+			++dxtIndexCount[dxtIndex];
+			// Count low and high colors in 2x2 corners in case they will be used to replace the medium color with close interpolations.
+			if ((dxtIndex & 2) == 0) {
+				++dxtLowHighIndexCounts[(pixelIndex >> 2) ^ (((pixelIndex >> 1) ^ (pixelIndex >> 2)) & 1)][dxtIndex];
+			}
+		}
+
+		// Try various conversions, from the most accurate ones in specific cases to the general ones.
+		if (dxtIndexCount[2] == 0) {
+			// If at least one shade is not used, the remaining two can be converted exactly.
+			// The medium color isn't used.
+			path = S3TCONV_ATITC_PATH_UNUSED_MEDIUM;
+			atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
+			atitcColorHigh565 = dxtColorHigh565;
+			// 0 1 3 -> 2 3 0.
+			atitcIndices = (dxtIndices ^ 0xAAAAAAAA) & ~((dxtIndices & 0xAAAAAAAA) >> 1);
+		} else if (dxtIndexCount[0] == 0 || dxtIndexCount[1] == 0) {
+			// Similar case, but either low or high isn't used.
+			path = S3TCONV_ATITC_PATH_UNUSED_LOW_OR_HIGH;
+			S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
+					dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
+					dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
+					&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+		} else if (dxtIndexCount[3] == 0) {
+			// If black isn't used, approximate 1/2 with 3/8 or 5/8, depending on whether low or high is more common in each 2x2 corner.
+			uint32_t medIndexMask;
+			int lowIsMoreCommon = (dxtIndexCount[0] > dxtIndexCount[1]); // Not >= because high has more green bits.
+			unsigned int subBlockIndex;
+			path = S3TCONV_ATITC_PATH_UNUSED_BLACK;
+			atitcColorLow555 = S3TConv_Utility_Color565To555(dxtColorLow565);
+			atitcColorHigh565 = dxtColorHigh565;
+			// 0 1 2 -> 0 3 2, or 0 2 1 -> 0 3 1 if the lower approximation is the closer one.
+			atitcIndices = dxtIndices | ((dxtIndices & 0x55555555) << 1);
+			medIndexMask = dxtIndices & 0xAAAAAAAA;
+			medIndexMask |= medIndexMask >> 1;
+			for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+				unsigned int countLow = dxtLowHighIndexCounts[subBlockIndex][0], countHigh = dxtLowHighIndexCounts[subBlockIndex][1];
+				if (countLow > countHigh || (lowIsMoreCommon && countLow == countHigh)) {
+					atitcIndices ^= ((uint32_t) 0x00000F0F << (((subBlockIndex & 2) << 3) | ((subBlockIndex & 1) << 2))) & medIndexMask;
+				}
+			}
+		} else {
+			// 3 shades will be used if the resulting approximation is near-perfect (if medium is the most common),
+			// or if it's at least somewhere between the original colors (if low or high is more common than medium).
+			// In other cases, 2 shades will be picked, depending on which ones are the most common.
+
+			uint8_t dxtColorLow888[3], dxtColorHigh888[3];
+			unsigned int colorBlackTrickMedHigh888[3];
+			unsigned int blackTrickBoundScaleLow, blackTrickBoundScaleHigh;
+			unsigned int blackTrickBoundLow[3], blackTrickBoundHigh[3];
+
+			S3TConv_Utility_Color565To888(dxtColorLow565, dxtColorLow888);
+			S3TConv_Utility_Color565To888(dxtColorHigh565, dxtColorHigh888);
+
+			colorBlackTrickMedHigh888[0] = dxtColorLow888[0] + (dxtColorHigh888[0] >> 2);
+			colorBlackTrickMedHigh888[1] = dxtColorLow888[1] + (dxtColorHigh888[1] >> 2);
+			colorBlackTrickMedHigh888[2] = dxtColorLow888[2] + (dxtColorHigh888[2] >> 2);
+
+			blackTrickBoundScaleLow = ((dxtIndexCount[2] >= dxtIndexCount[0] && dxtIndexCount[2] >= dxtIndexCount[1]) ? 3 : 0);
+			blackTrickBoundScaleHigh = 8 - blackTrickBoundScaleLow;
+
+			blackTrickBoundLow[0] = (blackTrickBoundScaleHigh * dxtColorLow888[0] + blackTrickBoundScaleLow * dxtColorHigh888[0]) >> 3;
+			blackTrickBoundLow[1] = (blackTrickBoundScaleHigh * dxtColorLow888[1] + blackTrickBoundScaleLow * dxtColorHigh888[1]) >> 3;
+			blackTrickBoundLow[2] = (blackTrickBoundScaleHigh * dxtColorLow888[2] + blackTrickBoundScaleLow * dxtColorHigh888[2]) >> 3;
+			blackTrickBoundHigh[0] = (blackTrickBoundScaleLow * dxtColorLow888[0] + blackTrickBoundScaleHigh * dxtColorHigh888[0]) >> 3;
+			blackTrickBoundHigh[1] = (blackTrickBoundScaleLow * dxtColorLow888[1] + blackTrickBoundScaleHigh * dxtColorHigh888[1]) >> 3;
+			blackTrickBoundHigh[2] = (blackTrickBoundScaleLow * dxtColorLow888[2] + blackTrickBoundScaleHigh * dxtColorHigh888[2]) >> 3;
+
+			// Will also ensure there's no overflow in each component.
+			if (colorBlackTrickMedHigh888[0] >= blackTrickBoundLow[0] && colorBlackTrickMedHigh888[0] <= blackTrickBoundHigh[0] &&
+					colorBlackTrickMedHigh888[1] >= blackTrickBoundLow[1] && colorBlackTrickMedHigh888[1] <= blackTrickBoundHigh[1] &&
+					colorBlackTrickMedHigh888[2] >= blackTrickBoundLow[2] && colorBlackTrickMedHigh888[2] <= blackTrickBoundHigh[2]) {
+				atitcColorLow555 = (uint16_t) (0x8000 | ((colorBlackTrickMedHigh888[0] >> 3) << 10) |
+						((colorBlackTrickMedHigh888[1] >> 3) << 5) | (colorBlackTrickMedHigh888[2] >> 3));
+				atitcColorHigh565 = dxtColorHigh565;
+				path = S3TCONV_ATITC_PATH_BLACK_TRICK;
+				// 0 1 2 3 -> 1 3 2 0.
+				atitcIndices = ~dxtIndices;
+				atitcIndices ^= (atitcIndices & 0x55555555) << 1;
+				atitcIndices ^= (atitcIndices & 0xAAAAAAAA) >> 1;
+			} else {
+				// Can't use the black trick to represent all 3 shades, so discard one of them.
+				if (dxtIndexCount[2] <= dxtIndexCount[0] && dxtIndexCount[2] <= dxtIndexCount[1]) {
+					// Discard the medium shade.
+					uint32_t colorIndexMask;
+					path = S3TCONV_ATITC_PATH_DISCARD_MEDIUM;
+					atitcColorLow555 = 0x8000 | S3TConv_Utility_Color565To555(dxtColorLow565);
+					atitcColorHigh565 = dxtColorHigh565;
+					colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
+					colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+					if (dxtIndexCount[0] > dxtIndexCount[1]) {
+						// 0 1 2 3 -> 2 3 2 0.
+						atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
+					} else {
+						// 0 1 2 3 -> 2 3 3 0.
+						atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+					}
+				} else {
+					// Discard the low or the high shade.
+					path = S3TCONV_ATITC_PATH_DISCARD_LOW_OR_HIGH;
+					S3TConv_ATITC_ConvertBlackTrickDiscardingLowOrHigh(
+							dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
+							dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
+							&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+				}
+			}
+		}
+
+		if (quality == S3TCONV_QUALITY_HIGH) {
+			S3TConv_ATITC_RefineBlackMode(dxtColorLow565, dxtColorHigh565, dxtIndices, dxtIndexCount,
+					remainingWidth, remainingHeight, &atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+		}
+	}
+
+	// Writing the ATITC block.
+	atitcBlock[0] = (uint8_t) atitcColorLow555;
+	atitcBlock[1] = (uint8_t) (atitcColorLow555 >> 8);
+	atitcBlock[2] = (uint8_t) atitcColorHigh565;
+	atitcBlock[3] = (uint8_t) (atitcColorHigh565 >> 8);
+	atitcBlock[4] = (uint8_t) atitcIndices;
+	atitcBlock[5] = (uint8_t) (atitcIndices >> 8);
+	atitcBlock[6] = (uint8_t) (atitcIndices >> 16);
+	atitcBlock[7] = (uint8_t) (atitcIndices >> 24);
+
+	return path;
+}
+
+// Copies of S3TConv_ATITC_ConvertRGBColors specialized for the mode and for full blocks, without asDXT1 and padding checks.
+// With asDXT1 being 0, only the four-color mode is left, which is small enough to be inlined everywhere.
+static S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBColorsAsDXT1Full(uint16_t dxtColor0565, uint16_t dxtColor1565,
+		uint32_t dxtSourceIndices, S3TConv_Quality quality, uint8_t atitcBlock[8]) {
+	return S3TConv_ATITC_ConvertRGBColors(dxtColor0565, dxtColor1565, dxtSourceIndices, 1, quality, atitcBlock, 4, 4);
+}
+
+static S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBColorsEdge(uint16_t dxtColor0565, uint16_t dxtColor1565,
+		uint32_t dxtSourceIndices, int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	return S3TConv_ATITC_ConvertRGBColors(dxtColor0565, dxtColor1565, dxtSourceIndices, asDXT1, quality, atitcBlock,
+			remainingWidth, remainingHeight);
+}
+
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBColorsSpecialized(uint16_t dxtColor0565,
+		uint16_t dxtColor1565, uint32_t dxtSourceIndices, int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	if (remainingWidth >= 4 && remainingHeight >= 4) {
+		if (!asDXT1) {
+			return S3TConv_ATITC_ConvertRGBColors(dxtColor0565, dxtColor1565, dxtSourceIndices, 0, S3TCONV_QUALITY_DEFAULT,
+					atitcBlock, 4, 4);
+		}
+		return S3TConv_ATITC_ConvertRGBColorsAsDXT1Full(dxtColor0565, dxtColor1565, dxtSourceIndices, quality, atitcBlock);
+	}
+	return S3TConv_ATITC_ConvertRGBColorsEdge(dxtColor0565, dxtColor1565, dxtSourceIndices, asDXT1, quality, atitcBlock,
+			remainingWidth, remainingHeight);
+}
+
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBBlockSpecialized(const uint8_t dxtBlock[8], int asDXT1,
+		S3TConv_Quality quality, uint8_t atitcBlock[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	// Extracting data from the DXT block bytes.
+	return S3TConv_ATITC_ConvertRGBColorsSpecialized(S3TConv_DXT_GetColor0(dxtBlock), S3TConv_DXT_GetColor1(dxtBlock),
+			S3TConv_DXT_GetIndices(dxtBlock), asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+}
+
+// Converts a DXT1 (punch-through), DXT3 or DXT5 block to an ATITC RGBA one, extracting the fields of the DXT color block
+// only once for both the alpha and the color halves. The DXT block is read before writing, so DXT3/DXT5 may be converted
+// in place.
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBABlock(const uint8_t *dxtBlock, S3TConv_Format dxtFormat,
+		int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[16], S3TConv_Format atitcFormat,
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	const uint8_t *dxtColorBlock = (dxtFormat == S3TCONV_FORMAT_DXT1 ? dxtBlock : dxtBlock + 8);
+	uint16_t dxtColor0565 = S3TConv_DXT_GetColor0(dxtColorBlock);
+	uint16_t dxtColor1565 = S3TConv_DXT_GetColor1(dxtColorBlock);
+	uint32_t dxtSourceIndices = S3TConv_DXT_GetIndices(dxtColorBlock);
+
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		asDXT1 = 1;
+		if (atitcFormat == S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT) {
+			S3TConv_DXT1_WriteExplicitAlpha(dxtColor0565, dxtColor1565, dxtSourceIndices, atitcBlock);
+		} else {
+			S3TConv_DXT1_WriteInterpolatedAlpha(dxtColor0565, dxtColor1565, dxtSourceIndices, atitcBlock);
+		}
+	} else if (atitcBlock != dxtBlock) {
+		memcpy(atitcBlock, dxtBlock, 8);
+	}
+	return S3TConv_ATITC_ConvertRGBColorsSpecialized(dxtColor0565, dxtColor1565, dxtSourceIndices, asDXT1, quality,
+			atitcBlock + 8, remainingWidth, remainingHeight);
+}
+
+void S3TConv_ATITC_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_ConvertRGBBlockSpecialized(dxtBlock, asDXT1, S3TCONV_QUALITY_DEFAULT, atitcBlock,
+			remainingWidth, remainingHeight);
+}
+
+void S3TConv_ATITC_RGBBlockFromDXTInPlace(uint8_t block[8], int asDXT1,
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	// The whole DXT block is read before writing the ATITC block.
+	S3TConv_ATITC_ConvertRGBBlockSpecialized(block, asDXT1, S3TCONV_QUALITY_DEFAULT, block, remainingWidth, remainingHeight);
+}
+
+void S3TConv_ATITC_RGBBlockFromDXTWithQuality(const uint8_t dxtBlock[8], int asDXT1, S3TConv_Quality quality,
+		uint8_t atitcBlock[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_ConvertRGBBlockSpecialized(dxtBlock, asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+}
+
+S3TConv_ATITC_Path S3TConv_ATITC_RGBBlockFromDXTWithPath(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	return S3TConv_ATITC_ConvertRGBBlockSpecialized(dxtBlock, asDXT1, S3TCONV_QUALITY_DEFAULT, atitcBlock,
+			remainingWidth, remainingHeight);
+}
+
+unsigned int S3TConv_ATITC_GetRGBBlockError(const uint8_t dxtBlock[8], int asDXT1, const uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint16_t dxtColor0565 = S3TConv_DXT_GetColor0(dxtBlock), dxtColor1565 = S3TConv_DXT_GetColor1(dxtBlock);
+	uint32_t dxtIndices = S3TConv_DXT_GetIndices(dxtBlock), atitcIndices = S3TConv_DXT_GetIndices(atitcBlock);
+	int dxtColors[4][3], atitcColors[4][3];
+	unsigned int error = 0, pixelIndex;
+
+	S3TConv_ATITC_DecodeDXTColors(dxtColor0565, dxtColor1565, !asDXT1 || dxtColor0565 > dxtColor1565, dxtColors);
+	S3TConv_ATITC_DecodeColors(S3TConv_DXT_GetColor0(atitcBlock), S3TConv_DXT_GetColor1(atitcBlock), atitcColors);
+	for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+		if ((pixelIndex & 3) >= remainingWidth || (pixelIndex >> 2) >= remainingHeight) {
+			continue;
+		}
+		error += S3TConv_ATITC_GetColorError(dxtColors[(dxtIndices >> (pixelIndex << 1)) & 3],
+				atitcColors[(atitcIndices >> (pixelIndex << 1)) & 3]);
+	}
+	return error;
+}
+
+void S3TConv_BlockCache_Init(S3TConv_BlockCache *cache) {
+	memset(cache->states, 0, sizeof(cache->states));
+	cache->lookups = 0;
+	cache->hits = 0;
+}
+
+const char *S3TConv_ATITC_GetPathName(S3TConv_ATITC_Path path) {
+	static const char * const pathNames[S3TCONV_ATITC_PATH_COUNT] = {
+		"Four-color",
+		"Black mode, unused medium",
+		"Black mode, unused low/high",
+		"Black mode, unused black (2x2 corners)",
+		"Black mode, black trick accepted",
+		"Black mode, black trick rejected, discard medium",
+		"Black mode, black trick rejected, discard low/high"
+	};
+	if ((unsigned int) path >= S3TCONV_ATITC_PATH_COUNT) {
+		return "Unknown";
+	}
+	return pathNames[path];
+}
+
+// S3TConv_ATITC_ConvertRGBBlockSpecialized counting the path in the statistics with S3TCONV_STATS.
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBBlockCounted(S3TConv_Stats *stats,
+		const uint8_t dxtBlock[8], int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_Path path;
+#ifdef S3TCONV_STATS_TIMING
+	uint64_t startTicks = S3TConv_Stats_GetTicks();
+#endif
+	path = S3TConv_ATITC_ConvertRGBBlockSpecialized(dxtBlock, asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+#ifdef S3TCONV_STATS
+	if (stats != NULL) {
+		++stats->pathBlockCounts[path];
+#ifdef S3TCONV_STATS_TIMING
+		stats->pathTicks[path] += S3TConv_Stats_GetTicks() - startTicks;
+#endif
+	}
+#else
+	(void) stats;
+#endif
+	return path;
+}
+
+#ifdef S3TCONV_STATS
+// Counts the blocks converted by the vectorized four-color code, ticks are for the whole group of 4 blocks.
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_CountVectorBlocks(S3TConv_Stats *stats,
+		unsigned int fourColorBlockMask, uint64_t ticks) {
+	if (stats != NULL && fourColorBlockMask != 0) {
+		stats->pathBlockCounts[S3TCONV_ATITC_PATH_FOUR_COLOR] += (fourColorBlockMask & 1) + ((fourColorBlockMask >> 1) & 1) +
+				((fourColorBlockMask >> 2) & 1) + (fourColorBlockMask >> 3);
+		stats->pathTicks[S3TCONV_ATITC_PATH_FOUR_COLOR] += ticks;
+	}
+}
+#endif
+
+static void S3TConv_ATITC_ConvertRGBBlockCached(S3TConv_BlockCache *cache, S3TConv_Stats *stats,
+		const uint8_t dxtBlock[8], int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint64_t sourceBlock;
+	unsigned int state, entryIndex;
+	S3TConv_ATITC_Path path;
+
+	memcpy(&sourceBlock, dxtBlock, 8);
+	state = S3TConv_BlockCache_GetState(asDXT1, remainingWidth, remainingHeight);
+	if (S3TConv_BlockCache_Find(cache, sourceBlock, state, &entryIndex)) {
+		memcpy(atitcBlock, cache->targetBlocks[entryIndex], 8);
+#ifdef S3TCONV_STATS
+		if (stats != NULL) {
+			++stats->pathBlockCounts[cache->paths[entryIndex]];
+		}
+#endif
+		return;
+	}
+
+	path = S3TConv_ATITC_ConvertRGBBlockCounted(stats, dxtBlock, asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+	S3TConv_BlockCache_Store(cache, entryIndex, sourceBlock, state, atitcBlock);
+#ifdef S3TCONV_STATS
+	cache->paths[entryIndex] = (uint8_t) path;
+#else
+	(void) path;
+#endif
+}
+
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_ConvertRGBBlockWithCache(S3TConv_BlockCache *cache, S3TConv_Stats *stats,
+		const uint8_t dxtBlock[8], int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	if (cache != NULL) {
+		S3TConv_ATITC_ConvertRGBBlockCached(cache, stats, dxtBlock, asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+	} else {
+		S3TConv_ATITC_ConvertRGBBlockCounted(stats, dxtBlock, asDXT1, quality, atitcBlock, remainingWidth, remainingHeight);
+	}
+}
+
+#if defined(S3TCONV_SSE2)
+// The 4-color mode for 4 blocks at once, same as in S3TConv_ATITC_ConvertRGBColors. Takes 2 DXT RGB blocks in each
+// register and returns the ATITC RGB blocks in the same layout, and the mask of the blocks in the four-color mode,
+// which are the only ones converted correctly.
+static S3TCONV_FORCEINLINE unsigned int S3TConv_ATITC_ConvertFourColorBlocks(__m128i dxtBlocks01, __m128i dxtBlocks23,
+		int asDXT1, __m128i *atitcBlocks01, __m128i *atitcBlocks23) {
+	__m128i dxtColorsIndices02, dxtColorsIndices13, dxtColors, dxtIndices;
+	__m128i dxtColorRGB, dxtLumas, dxtColor0565, dxtColor1565, dxtLuma0, dxtLuma1;
+	__m128i noSwapMask, atitcColorLow565, atitcColors, atitcIndices;
+	unsigned int fourColorBlockMask;
+
+	dxtColorsIndices02 = _mm_unpacklo_epi32(dxtBlocks01, dxtBlocks23);
+	dxtColorsIndices13 = _mm_unpackhi_epi32(dxtBlocks01, dxtBlocks23);
+	dxtColors = _mm_unpacklo_epi32(dxtColorsIndices02, dxtColorsIndices13);
+	dxtIndices = _mm_unpackhi_epi32(dxtColorsIndices02, dxtColorsIndices13);
+
+	// Luminance of both colors of each block in 16-bit lanes, as in S3TConv_ATITC_GetLuminance.
+	dxtColorRGB = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(dxtColors, 8), _mm_set1_epi16(0xF8)),
+			_mm_srli_epi16(dxtColors, 13));
+	dxtLumas = _mm_mullo_epi16(dxtColorRGB, _mm_set1_epi16(19));
+	dxtColorRGB = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(dxtColors, 3), _mm_set1_epi16(0xFC)),
+			_mm_and_si128(_mm_srli_epi16(dxtColors, 9), _mm_set1_epi16(0x03)));
+	dxtLumas = _mm_add_epi16(dxtLumas, _mm_mullo_epi16(dxtColorRGB, _mm_set1_epi16(38)));
+	dxtColorRGB = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(dxtColors, 3), _mm_set1_epi16(0xF8)),
+			_mm_and_si128(_mm_srli_epi16(dxtColors, 2), _mm_set1_epi16(0x07)));
+	dxtLumas = _mm_add_epi16(dxtLumas, _mm_mullo_epi16(dxtColorRGB, _mm_set1_epi16(7)));
+	dxtLumas = _mm_srli_epi16(dxtLumas, 6);
+
+	dxtColor0565 = _mm_and_si128(dxtColors, _mm_set1_epi32(0xFFFF));
+	dxtColor1565 = _mm_srli_epi32(dxtColors, 16);
+	dxtLuma0 = _mm_and_si128(dxtLumas, _mm_set1_epi32(0xFFFF));
+	dxtLuma1 = _mm_srli_epi32(dxtLumas, 16);
+	fourColorBlockMask = (asDXT1 ? (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(dxtColor0565, dxtColor1565))) : 0xF);
+
+	// Color 0 is the lower one if dxtLuma0 < dxtLuma1.
+	noSwapMask = _mm_cmpgt_epi32(dxtLuma1, dxtLuma0);
+	atitcColorLow565 = _mm_or_si128(_mm_and_si128(noSwapMask, dxtColor0565), _mm_andnot_si128(noSwapMask, dxtColor1565));
+	atitcColors = _mm_or_si128(_mm_and_si128(atitcColorLow565, _mm_set1_epi32(0x001F)),
+			_mm_srli_epi32(_mm_and_si128(atitcColorLow565, _mm_set1_epi32(0xFFC0)), 1));
+	atitcColors = _mm_or_si128(atitcColors, _mm_slli_epi32(_mm_or_si128(
+			_mm_and_si128(noSwapMask, dxtColor1565), _mm_andnot_si128(noSwapMask, dxtColor0565)), 16));
+	atitcIndices = _mm_xor_si128(dxtIndices, _mm_srli_epi32(_mm_and_si128(dxtIndices, _mm_set1_epi32((int) 0xAAAAAAAA)), 1));
+	atitcIndices = _mm_xor_si128(atitcIndices, _mm_slli_epi32(_mm_and_si128(atitcIndices, _mm_set1_epi32(0x55555555)), 1));
+	atitcIndices = _mm_xor_si128(atitcIndices, _mm_xor_si128(noSwapMask, _mm_set1_epi32(-1)));
+
+	*atitcBlocks01 = _mm_unpacklo_epi32(atitcColors, atitcIndices);
+	*atitcBlocks23 = _mm_unpackhi_epi32(atitcColors, atitcIndices);
+	return fourColorBlockMask;
+}
+#elif defined(S3TCONV_NEON)
+// The 4-color mode for 4 blocks at once, same as in S3TConv_ATITC_ConvertRGBColors. Takes the colors and the indices
+// of the DXT RGB blocks deinterleaved and returns the ATITC RGB blocks interleaved in pairs, and the mask of the blocks
+// in the four-color mode, which are the only ones converted correctly.
+static S3TCONV_FORCEINLINE unsigned int S3TConv_ATITC_ConvertFourColorBlocks(uint32x4x2_t dxtColorsIndices,
+		int asDXT1, uint32x4x2_t *atitcBlockData) {
+	uint16x8_t dxtColors16, dxtLumas;
+	uint32x4_t dxtLumas32, dxtColor0565, dxtColor1565, dxtLuma0, dxtLuma1;
+	uint32x4_t noSwapMask, atitcColorLow565, atitcColors, atitcIndices;
+	unsigned int fourColorBlockMask;
+
+	// Luminance of both colors of each block in 16-bit lanes, as in S3TConv_ATITC_GetLuminance.
+	dxtColors16 = vreinterpretq_u16_u32(dxtColorsIndices.val[0]);
+	dxtLumas = vmulq_n_u16(vorrq_u16(vandq_u16(vshrq_n_u16(dxtColors16, 8), vdupq_n_u16(0xF8)),
+			vshrq_n_u16(dxtColors16, 13)), 19);
+	dxtLumas = vmlaq_n_u16(dxtLumas, vorrq_u16(vandq_u16(vshrq_n_u16(dxtColors16, 3), vdupq_n_u16(0xFC)),
+			vandq_u16(vshrq_n_u16(dxtColors16, 9), vdupq_n_u16(0x03))), 38);
+	dxtLumas = vmlaq_n_u16(dxtLumas, vorrq_u16(vandq_u16(vshlq_n_u16(dxtColors16, 3), vdupq_n_u16(0xF8)),
+			vandq_u16(vshrq_n_u16(dxtColors16, 2), vdupq_n_u16(0x07))), 7);
+	dxtLumas32 = vreinterpretq_u32_u16(vshrq_n_u16(dxtLumas, 6));
+
+	dxtColor0565 = vandq_u32(dxtColorsIndices.val[0], vdupq_n_u32(0xFFFF));
+	dxtColor1565 = vshrq_n_u32(dxtColorsIndices.val[0], 16);
+	dxtLuma0 = vandq_u32(dxtLumas32, vdupq_n_u32(0xFFFF));
+	dxtLuma1 = vshrq_n_u32(dxtLumas32, 16);
+	fourColorBlockMask = 0xF;
+	if (asDXT1) {
+		uint32x4_t fourColorMask = vcgtq_u32(dxtColor0565, dxtColor1565);
+		fourColorBlockMask = (vgetq_lane_u32(fourColorMask, 0) & 1) | (vgetq_lane_u32(fourColorMask, 1) & 2) |
+				(vgetq_lane_u32(fourColorMask, 2) & 4) | (vgetq_lane_u32(fourColorMask, 3) & 8);
+	}
+
+	// Color 0 is the lower one if dxtLuma0 < dxtLuma1.
+	noSwapMask = vcgtq_u32(dxtLuma1, dxtLuma0);
+	atitcColorLow565 = vbslq_u32(noSwapMask, dxtColor0565, dxtColor1565);
+	atitcColors = vorrq_u32(vandq_u32(atitcColorLow565, vdupq_n_u32(0x001F)),
+			vshrq_n_u32(vandq_u32(atitcColorLow565, vdupq_n_u32(0xFFC0)), 1));
+	atitcColors = vorrq_u32(atitcColors, vshlq_n_u32(vbslq_u32(noSwapMask, dxtColor1565, dxtColor0565), 16));
+	atitcIndices = veorq_u32(dxtColorsIndices.val[1], vshrq_n_u32(vandq_u32(dxtColorsIndices.val[1], vdupq_n_u32(0xAAAAAAAA)), 1));
+	atitcIndices = veorq_u32(atitcIndices, vshlq_n_u32(vandq_u32(atitcIndices, vdupq_n_u32(0x55555555)), 1));
+	atitcIndices = veorq_u32(atitcIndices, vmvnq_u32(noSwapMask));
+
+	*atitcBlockData = vzipq_u32(atitcColors, atitcIndices);
+	return fourColorBlockMask;
+}
+#endif
+
+// The cache is only used for the blocks not converted by the vectorized four-color code, which is faster than a lookup.
+// Inlined with constant asDXT1, so with 0, the scalar fallback is removed from the vectorized code.
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_ConvertRGBBlocks(const uint8_t *dxtBlocks, size_t dxtBlockStride,
+		int asDXT1, S3TConv_Quality quality, uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount,
+		S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	unsigned int blockIndex = 0;
+
+#if defined(S3TCONV_SSE2) || defined(S3TCONV_NEON)
+	// Blocks in the black mode are converted by the scalar code after their DXT data is loaded,
+	// and each block is stored separately, so the source and the target may be the same.
+	for (; blockIndex + 4 <= blockCount; blockIndex += 4) {
+		const uint8_t *dxtBlock = dxtBlocks + blockIndex * dxtBlockStride;
+		uint8_t *atitcBlock = atitcBlocks + blockIndex * atitcBlockStride;
+		unsigned int fourColorBlockMask, subBlockIndex;
+#ifdef S3TCONV_STATS_TIMING
+		uint64_t groupStartTicks = S3TConv_Stats_GetTicks();
+#endif
+#if defined(S3TCONV_SSE2)
+		__m128i atitcBlocks01, atitcBlocks23;
+		fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(
+				_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) dxtBlock),
+						_mm_loadl_epi64((const __m128i *) (dxtBlock + dxtBlockStride))),
+				_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) (dxtBlock + 2 * dxtBlockStride)),
+						_mm_loadl_epi64((const __m128i *) (dxtBlock + 3 * dxtBlockStride))),
+				asDXT1, &atitcBlocks01, &atitcBlocks23);
+#if defined(S3TCONV_STATS_TIMING)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, S3TConv_Stats_GetTicks() - groupStartTicks);
+#elif defined(S3TCONV_STATS)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, 0);
+#endif
+		for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+			if (fourColorBlockMask & (1 << subBlockIndex)) {
+				__m128i atitcBlockData = ((subBlockIndex & 2) ? atitcBlocks23 : atitcBlocks01);
+				if (subBlockIndex & 1) {
+					atitcBlockData = _mm_srli_si128(atitcBlockData, 8);
+				}
+				_mm_storel_epi64((__m128i *) (atitcBlock + subBlockIndex * atitcBlockStride), atitcBlockData);
+			} else {
+				S3TConv_ATITC_ConvertRGBBlockWithCache(cache, stats, dxtBlock + subBlockIndex * dxtBlockStride, 1, quality,
+						atitcBlock + subBlockIndex * atitcBlockStride, 4, 4);
+			}
+		}
+#elif defined(S3TCONV_NEON)
+		uint32x4x2_t atitcBlockData;
+		fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(vuzpq_u32(
+				vcombine_u32(vreinterpret_u32_u8(vld1_u8(dxtBlock)), vreinterpret_u32_u8(vld1_u8(dxtBlock + dxtBlockStride))),
+				vcombine_u32(vreinterpret_u32_u8(vld1_u8(dxtBlock + 2 * dxtBlockStride)),
+						vreinterpret_u32_u8(vld1_u8(dxtBlock + 3 * dxtBlockStride)))),
+				asDXT1, &atitcBlockData);
+#if defined(S3TCONV_STATS_TIMING)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, S3TConv_Stats_GetTicks() - groupStartTicks);
+#elif defined(S3TCONV_STATS)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, 0);
+#endif
+		for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+			if (fourColorBlockMask & (1 << subBlockIndex)) {
+				uint32x4_t atitcBlockPair = atitcBlockData.val[subBlockIndex >> 1];
+				vst1_u8(atitcBlock + subBlockIndex * atitcBlockStride, vreinterpret_u8_u32(
+						(subBlockIndex & 1) ? vget_high_u32(atitcBlockPair) : vget_low_u32(atitcBlockPair)));
+			} else {
+				S3TConv_ATITC_ConvertRGBBlockWithCache(cache, stats, dxtBlock + subBlockIndex * dxtBlockStride, 1, quality,
+						atitcBlock + subBlockIndex * atitcBlockStride, 4, 4);
+			}
+		}
+#endif
+	}
+#endif
+
+	for (; blockIndex < blockCount; ++blockIndex) {
+		S3TConv_ATITC_ConvertRGBBlockWithCache(cache, stats, dxtBlocks + blockIndex * dxtBlockStride, asDXT1, quality,
+				atitcBlocks + blockIndex * atitcBlockStride, 4, 4);
+	}
+}
+
+static void S3TConv_ATITC_ConvertRGBBlocksAsDXT1(const uint8_t *dxtBlocks, size_t dxtBlockStride, S3TConv_Quality quality,
+		uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount, S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	S3TConv_ATITC_ConvertRGBBlocks(dxtBlocks, dxtBlockStride, 1, quality, atitcBlocks, atitcBlockStride, blockCount,
+			cache, stats);
+}
+
+static void S3TConv_ATITC_ConvertRGBBlocksFourColor(const uint8_t *dxtBlocks, size_t dxtBlockStride,
+		uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount, S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	S3TConv_ATITC_ConvertRGBBlocks(dxtBlocks, dxtBlockStride, 0, S3TCONV_QUALITY_DEFAULT, atitcBlocks, atitcBlockStride,
+			blockCount, cache, stats);
+}
+
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_ConvertRGBBlocksSpecialized(const uint8_t *dxtBlocks, size_t dxtBlockStride,
+		int asDXT1, S3TConv_Quality quality, uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount,
+		S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	if (asDXT1) {
+		S3TConv_ATITC_ConvertRGBBlocksAsDXT1(dxtBlocks, dxtBlockStride, quality, atitcBlocks, atitcBlockStride, blockCount,
+				cache, stats);
+	} else {
+		S3TConv_ATITC_ConvertRGBBlocksFourColor(dxtBlocks, dxtBlockStride, atitcBlocks, atitcBlockStride, blockCount, cache, stats);
+	}
+}
+
+void S3TConv_ATITC_RGBBlocksFromDXT(const uint8_t *dxtBlocks, size_t dxtBlockStride, int asDXT1,
+		uint8_t *atitcBlocks, size_t atitcBlockStride, unsigned int blockCount) {
+	S3TConv_ATITC_ConvertRGBBlocksSpecialized(dxtBlocks, dxtBlockStride, asDXT1, S3TCONV_QUALITY_DEFAULT,
+			atitcBlocks, atitcBlockStride, blockCount, NULL, NULL);
+}
+
+// S3TConv_ATITC_ConvertRGBABlock counting the path in the statistics with S3TCONV_STATS.
+static S3TCONV_FORCEINLINE S3TConv_ATITC_Path S3TConv_ATITC_ConvertRGBABlockCounted(S3TConv_Stats *stats,
+		const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality, uint8_t atitcBlock[16],
+		S3TConv_Format atitcFormat, unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_Path path;
+#ifdef S3TCONV_STATS_TIMING
+	uint64_t startTicks = S3TConv_Stats_GetTicks();
+#endif
+	path = S3TConv_ATITC_ConvertRGBABlock(dxtBlock, dxtFormat, asDXT1, quality, atitcBlock, atitcFormat,
+			remainingWidth, remainingHeight);
+#ifdef S3TCONV_STATS
+	if (stats != NULL) {
+		++stats->pathBlockCounts[path];
+#ifdef S3TCONV_STATS_TIMING
+		stats->pathTicks[path] += S3TConv_Stats_GetTicks() - startTicks;
+#endif
+	}
+#else
+	(void) stats;
+#endif
+	return path;
+}
+
+// Full, tightly packed blocks. Each group of 4 blocks is loaded with 16-byte loads before anything is stored, so DXT3/DXT5
+// may be converted in place. Inlined with constant dxtFormat and asDXT1, like S3TConv_ATITC_ConvertRGBBlocks.
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_ConvertRGBABlocks(const uint8_t *dxtBlocks, S3TConv_Format dxtFormat,
+		int asDXT1, S3TConv_Quality quality, uint8_t *atitcBlocks, S3TConv_Format atitcFormat, unsigned int blockCount,
+		S3TConv_Stats *stats) {
+	unsigned int dxtBlockSize = (dxtFormat == S3TCONV_FORMAT_DXT1 ? 8 : 16);
+	unsigned int blockIndex = 0;
+
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		asDXT1 = 1;
+	}
+
+#if defined(S3TCONV_SSE2) || defined(S3TCONV_NEON)
+	for (; blockIndex + 4 <= blockCount; blockIndex += 4) {
+		const uint8_t *dxtBlock = dxtBlocks + blockIndex * dxtBlockSize;
+		uint8_t *atitcBlock = atitcBlocks + (blockIndex << 4);
+		unsigned int fourColorBlockMask, subBlockIndex;
+#ifdef S3TCONV_STATS_TIMING
+		uint64_t groupStartTicks = S3TConv_Stats_GetTicks();
+#endif
+#if defined(S3TCONV_SSE2)
+		__m128i dxtAlphas[4], atitcBlocks01, atitcBlocks23;
+		if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+			// Alpha of the four-color blocks is opaque, 0xFF for explicit, or alpha 0 = alpha 1 = 0xFF and codes 0.
+			dxtAlphas[0] = (atitcFormat == S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT ? _mm_set1_epi32(-1) : _mm_cvtsi32_si128(0xFFFF));
+			fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(_mm_loadu_si128((const __m128i *) dxtBlock),
+					_mm_loadu_si128((const __m128i *) (dxtBlock + 16)), 1, &atitcBlocks01, &atitcBlocks23);
+		} else {
+			for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+				dxtAlphas[subBlockIndex] = _mm_loadu_si128((const __m128i *) (dxtBlock + (subBlockIndex << 4)));
+			}
+			fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(_mm_unpackhi_epi64(dxtAlphas[0], dxtAlphas[1]),
+					_mm_unpackhi_epi64(dxtAlphas[2], dxtAlphas[3]), asDXT1, &atitcBlocks01, &atitcBlocks23);
+		}
+#if defined(S3TCONV_STATS_TIMING)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, S3TConv_Stats_GetTicks() - groupStartTicks);
+#elif defined(S3TCONV_STATS)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, 0);
+#endif
+		for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+			if (fourColorBlockMask & (1 << subBlockIndex)) {
+				__m128i atitcColorData = ((subBlockIndex & 2) ? atitcBlocks23 : atitcBlocks01);
+				if (subBlockIndex & 1) {
+					atitcColorData = _mm_srli_si128(atitcColorData, 8);
+				}
+				_mm_storeu_si128((__m128i *) (atitcBlock + (subBlockIndex << 4)), _mm_unpacklo_epi64(
+						dxtAlphas[dxtFormat == S3TCONV_FORMAT_DXT1 ? 0 : subBlockIndex], atitcColorData));
+			} else {
+				S3TConv_ATITC_ConvertRGBABlockCounted(stats, dxtBlock + subBlockIndex * dxtBlockSize, dxtFormat, 1, quality,
+						atitcBlock + (subBlockIndex << 4), atitcFormat, 4, 4);
+			}
+		}
+#elif defined(S3TCONV_NEON)
+		uint8x8_t dxtAlphas[4];
+		uint32x4x2_t atitcBlockData;
+		if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+			// Alpha of the four-color blocks is opaque, 0xFF for explicit, or alpha 0 = alpha 1 = 0xFF and codes 0.
+			dxtAlphas[0] = (atitcFormat == S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT ? vdup_n_u8(0xFF) :
+					vreinterpret_u8_u64(vcreate_u64(0xFFFF)));
+			fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(vuzpq_u32(vreinterpretq_u32_u8(vld1q_u8(dxtBlock)),
+					vreinterpretq_u32_u8(vld1q_u8(dxtBlock + 16))), 1, &atitcBlockData);
+		} else {
+			uint8x16_t dxtBlockData[4];
+			for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+				dxtBlockData[subBlockIndex] = vld1q_u8(dxtBlock + (subBlockIndex << 4));
+				dxtAlphas[subBlockIndex] = vget_low_u8(dxtBlockData[subBlockIndex]);
+			}
+			fourColorBlockMask = S3TConv_ATITC_ConvertFourColorBlocks(vuzpq_u32(
+					vreinterpretq_u32_u8(vcombine_u8(vget_high_u8(dxtBlockData[0]), vget_high_u8(dxtBlockData[1]))),
+					vreinterpretq_u32_u8(vcombine_u8(vget_high_u8(dxtBlockData[2]), vget_high_u8(dxtBlockData[3])))),
+					asDXT1, &atitcBlockData);
+		}
+#if defined(S3TCONV_STATS_TIMING)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, S3TConv_Stats_GetTicks() - groupStartTicks);
+#elif defined(S3TCONV_STATS)
+		S3TConv_ATITC_CountVectorBlocks(stats, fourColorBlockMask, 0);
+#endif
+		for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+			if (fourColorBlockMask & (1 << subBlockIndex)) {
+				uint32x4_t atitcBlockPair = atitcBlockData.val[subBlockIndex >> 1];
+				vst1q_u8(atitcBlock + (subBlockIndex << 4), vcombine_u8(
+						dxtAlphas[dxtFormat == S3TCONV_FORMAT_DXT1 ? 0 : subBlockIndex], vreinterpret_u8_u32(
+						(subBlockIndex & 1) ? vget_high_u32(atitcBlockPair) : vget_low_u32(atitcBlockPair))));
+			} else {
+				S3TConv_ATITC_ConvertRGBABlockCounted(stats, dxtBlock + subBlockIndex * dxtBlockSize, dxtFormat, 1, quality,
+						atitcBlock + (subBlockIndex << 4), atitcFormat, 4, 4);
+			}
+		}
+#endif
+	}
+#endif
+
+	for (; blockIndex < blockCount; ++blockIndex) {
+		S3TConv_ATITC_ConvertRGBABlockCounted(stats, dxtBlocks + blockIndex * dxtBlockSize, dxtFormat, asDXT1, quality,
+				atitcBlocks + (blockIndex << 4), atitcFormat, 4, 4);
+	}
+}
+
+static void S3TConv_ATITC_ConvertRGBABlocksFromDXT1(const uint8_t *dxtBlocks, S3TConv_Quality quality, uint8_t *atitcBlocks,
+		S3TConv_Format atitcFormat, unsigned int blockCount, S3TConv_Stats *stats) {
+	S3TConv_ATITC_ConvertRGBABlocks(dxtBlocks, S3TCONV_FORMAT_DXT1, 1, quality, atitcBlocks, atitcFormat, blockCount, stats);
+}
+
+// DXT3 and DXT5 differ only in the target format, which is not used when the alpha block is copied.
+static void S3TConv_ATITC_ConvertRGBABlocksAsDXT1(const uint8_t *dxtBlocks, S3TConv_Quality quality, uint8_t *atitcBlocks,
+		unsigned int blockCount, S3TConv_Stats *stats) {
+	S3TConv_ATITC_ConvertRGBABlocks(dxtBlocks, S3TCONV_FORMAT_DXT5, 1, quality, atitcBlocks,
+			S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, blockCount, stats);
+}
+
+static void S3TConv_ATITC_ConvertRGBABlocksFourColor(const uint8_t *dxtBlocks, uint8_t *atitcBlocks,
+		unsigned int blockCount, S3TConv_Stats *stats) {
+	S3TConv_ATITC_ConvertRGBABlocks(dxtBlocks, S3TCONV_FORMAT_DXT5, 0, S3TCONV_QUALITY_DEFAULT, atitcBlocks,
+			S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, blockCount, stats);
+}
+
+static S3TCONV_FORCEINLINE void S3TConv_ATITC_ConvertRGBABlocksSpecialized(const uint8_t *dxtBlocks,
+		S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality, uint8_t *atitcBlocks, S3TConv_Format atitcFormat,
+		unsigned int blockCount, S3TConv_Stats *stats) {
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		S3TConv_ATITC_ConvertRGBABlocksFromDXT1(dxtBlocks, quality, atitcBlocks, atitcFormat, blockCount, stats);
+	} else if (asDXT1) {
+		S3TConv_ATITC_ConvertRGBABlocksAsDXT1(dxtBlocks, quality, atitcBlocks, blockCount, stats);
+	} else {
+		S3TConv_ATITC_ConvertRGBABlocksFourColor(dxtBlocks, atitcBlocks, blockCount, stats);
+	}
+}
+
+void S3TConv_ATITC_RGBABlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t atitcBlock[16], S3TConv_Format atitcFormat, unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ATITC_ConvertRGBABlock(dxtBlock, dxtFormat, asDXT1, S3TCONV_QUALITY_DEFAULT, atitcBlock, atitcFormat,
+			remainingWidth, remainingHeight);
+}
+
+void S3TConv_ATITC_RGBABlocksFromDXT(const uint8_t *dxtBlocks, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *atitcBlocks, S3TConv_Format atitcFormat, unsigned int blockCount) {
+	S3TConv_ATITC_ConvertRGBABlocksSpecialized(dxtBlocks, dxtFormat, asDXT1, S3TCONV_QUALITY_DEFAULT, atitcBlocks, atitcFormat,
+			blockCount, NULL);
+}
+
+int S3TConv_ATITC_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format atitcFormat) {
+	switch (atitcFormat) {
+	case S3TCONV_FORMAT_ATITC_RGB:
+		return dxtFormat == S3TCONV_FORMAT_DXT1 || dxtFormat == S3TCONV_FORMAT_DXT3 || dxtFormat == S3TCONV_FORMAT_DXT5;
+	case S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT:
+		return dxtFormat == S3TCONV_FORMAT_DXT1 || dxtFormat == S3TCONV_FORMAT_DXT3;
+	case S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED:
+		return dxtFormat == S3TCONV_FORMAT_DXT1 || dxtFormat == S3TCONV_FORMAT_DXT5;
+	default:
+		break;
+	}
+	return 0;
+}
+
+void S3TConv_ATITC_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality,
+		uint8_t *atitcRow, S3TConv_Format atitcFormat, unsigned int blockCount,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_BlockCache *cache, S3TConv_Stats *stats) {
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	unsigned int atitcBlockSize = S3TConv_Format_GetBlockSize(atitcFormat);
+	const uint8_t *dxtColorBlock = dxtRow + (dxtBlockSize - 8);
+	uint8_t *atitcColorBlock = atitcRow + (atitcBlockSize - 8);
+	unsigned int fullBlockCount, blockIndex;
+
+	// Only the blocks on the right and the bottom edges need padding checks.
+	fullBlockCount = (remainingHeight >= 4 ? remainingWidth >> 2 : 0);
+	if (fullBlockCount > blockCount) {
+		fullBlockCount = blockCount;
+	}
+
+	// Without the cache, both halves of RGBA blocks are converted at once.
+	if (atitcFormat != S3TCONV_FORMAT_ATITC_RGB && cache == NULL) {
+		S3TConv_ATITC_ConvertRGBABlocksSpecialized(dxtRow, dxtFormat, asDXT1, quality, atitcRow, atitcFormat, fullBlockCount,
+				stats);
+		for (blockIndex = fullBlockCount; blockIndex < blockCount; ++blockIndex) {
+			unsigned int blockLeft = blockIndex << 2;
+			S3TConv_ATITC_ConvertRGBABlockCounted(stats, dxtRow + blockIndex * dxtBlockSize, dxtFormat, asDXT1, quality,
+					atitcRow + (blockIndex << 4), atitcFormat,
+					remainingWidth > blockLeft ? remainingWidth - blockLeft : 0, remainingHeight);
+		}
+		return;
+	}
+
+	// Alpha, if needed, is taken either from punch-through pixels or directly from DXT3/DXT5.
+	if (atitcFormat != S3TCONV_FORMAT_ATITC_RGB) {
+		if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+			if (atitcFormat == S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT) {
+				for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+					S3TConv_DXT1_PunchthroughToExplicitAlpha(dxtRow + (blockIndex << 3), atitcRow + (blockIndex << 4));
+				}
+			} else {
+				for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+					S3TConv_DXT1_PunchthroughToInterpolatedAlpha(dxtRow + (blockIndex << 3), atitcRow + (blockIndex << 4));
+				}
+			}
+		} else if (atitcRow != dxtRow) {
+			for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+				memcpy(atitcRow + (blockIndex << 4), dxtRow + (blockIndex << 4), 8);
+			}
+		}
+	}
+
+	S3TConv_ATITC_ConvertRGBBlocksSpecialized(dxtColorBlock, dxtBlockSize, asDXT1, quality,
+			atitcColorBlock, atitcBlockSize, fullBlockCount, cache, stats);
+	for (blockIndex = fullBlockCount; blockIndex < blockCount; ++blockIndex) {
+		unsigned int blockLeft = blockIndex << 2;
+		S3TConv_ATITC_ConvertRGBBlockWithCache(cache, stats, dxtColorBlock + blockIndex * dxtBlockSize, asDXT1, quality,
+				atitcColorBlock + blockIndex * atitcBlockSize,
+				remainingWidth > blockLeft ? remainingWidth - blockLeft : 0, remainingHeight);
+	}
+}
+
+int S3TConv_ATITC_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *atitcData, S3TConv_Format atitcFormat, size_t atitcRowPitch,
+		unsigned int width, unsigned int height) {
+	S3TConv_Surface surface;
+
+	if (!S3TConv_ATITC_IsConversionFromDXTSupported(dxtFormat, atitcFormat)) {
+		return 0;
+	}
+
+	surface.sourceData = dxtData;
+	surface.sourceFormat = dxtFormat;
+	surface.asDXT1 = asDXT1;
+	surface.sourceRowPitch = dxtRowPitch;
+	surface.targetData = atitcData;
+	surface.targetFormat = atitcFormat;
+	surface.targetRowPitch = atitcRowPitch;
+	surface.width = width;
+	surface.height = height;
+	surface.useBlockCache = 0;
+	surface.quality = S3TCONV_QUALITY_DEFAULT;
+	surface.stats = NULL;
+	S3TConv_Surface_ConvertBlockRows(&surface, 0, (height + 3) >> 2, NULL);
+	return 1;
+}
+
+int S3TConv_ATITC_SurfaceFromDXTInPlace(uint8_t *data, S3TConv_Format dxtFormat, int asDXT1, size_t rowPitch,
+		unsigned int width, unsigned int height) {
+	switch (dxtFormat) {
+	case S3TCONV_FORMAT_DXT1:
+		return S3TConv_ATITC_SurfaceFromDXT(data, dxtFormat, asDXT1, rowPitch,
+				data, S3TCONV_FORMAT_ATITC_RGB, rowPitch, width, height);
+	case S3TCONV_FORMAT_DXT3:
+		return S3TConv_ATITC_SurfaceFromDXT(data, dxtFormat, asDXT1, rowPitch,
+				data, S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT, rowPitch, width, height);
+	case S3TCONV_FORMAT_DXT5:
+		return S3TConv_ATITC_SurfaceFromDXT(data, dxtFormat, asDXT1, rowPitch,
+				data, S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, rowPitch, width, height);
+	default:
+		break;
+	}
+	return 0;
+}
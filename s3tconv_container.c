@@ -0,0 +1,468 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//
+// Memory-mapped files.
+//
+
+int S3TConv_MappedFile_Open(S3TConv_MappedFile *mappedFile, const char *path) {
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+	mappedFile->data = NULL;
+	mappedFile->size = 0;
+	mappedFile->mappingHandle = NULL;
+	mappedFile->fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mappedFile->fileHandle == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+	if (!GetFileSizeEx((HANDLE) mappedFile->fileHandle, &fileSize) || (uint64_t) fileSize.QuadPart > (size_t) -1) {
+		CloseHandle((HANDLE) mappedFile->fileHandle);
+		return 0;
+	}
+	mappedFile->size = (size_t) fileSize.QuadPart;
+	if (mappedFile->size == 0) {
+		// Empty files can't be mapped.
+		return 1;
+	}
+	mappedFile->mappingHandle = CreateFileMappingA((HANDLE) mappedFile->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappedFile->mappingHandle == NULL) {
+		CloseHandle((HANDLE) mappedFile->fileHandle);
+		return 0;
+	}
+	mappedFile->data = (const uint8_t *) MapViewOfFile((HANDLE) mappedFile->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (mappedFile->data == NULL) {
+		CloseHandle((HANDLE) mappedFile->mappingHandle);
+		CloseHandle((HANDLE) mappedFile->fileHandle);
+		return 0;
+	}
+	return 1;
+#else
+	int fileDescriptor;
+	struct stat fileStat;
+	void *data;
+	mappedFile->data = NULL;
+	mappedFile->size = 0;
+	fileDescriptor = open(path, O_RDONLY);
+	if (fileDescriptor < 0) {
+		return 0;
+	}
+	if (fstat(fileDescriptor, &fileStat) != 0 || (uint64_t) fileStat.st_size > (size_t) -1) {
+		close(fileDescriptor);
+		return 0;
+	}
+	mappedFile->size = (size_t) fileStat.st_size;
+	if (mappedFile->size == 0) {
+		// Empty files can't be mapped.
+		close(fileDescriptor);
+		return 1;
+	}
+	data = mmap(NULL, mappedFile->size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	// The mapping stays valid after closing the file.
+	close(fileDescriptor);
+	if (data == MAP_FAILED) {
+		return 0;
+	}
+	mappedFile->data = (const uint8_t *) data;
+	return 1;
+#endif
+}
+
+void S3TConv_MappedFile_Close(S3TConv_MappedFile *mappedFile) {
+#ifdef _WIN32
+	if (mappedFile->data != NULL) {
+		UnmapViewOfFile(mappedFile->data);
+		CloseHandle((HANDLE) mappedFile->mappingHandle);
+	}
+	CloseHandle((HANDLE) mappedFile->fileHandle);
+#else
+	if (mappedFile->data != NULL) {
+		munmap((void *) mappedFile->data, mappedFile->size);
+	}
+#endif
+	mappedFile->data = NULL;
+	mappedFile->size = 0;
+}
+
+//
+// DDS.
+//
+
+static inline uint32_t S3TConv_Container_Read32(const uint8_t *data) {
+	return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static inline void S3TConv_Container_Write32(uint8_t *data, uint32_t value) {
+	data[0] = (uint8_t) value;
+	data[1] = (uint8_t) (value >> 8);
+	data[2] = (uint8_t) (value >> 16);
+	data[3] = (uint8_t) (value >> 24);
+}
+
+static size_t S3TConv_Container_GetSurfaceSize(S3TConv_Format format, unsigned int width, unsigned int height) {
+	return (size_t) ((width + 3) >> 2) * ((height + 3) >> 2) * S3TConv_Format_GetBlockSize(format);
+}
+
+static size_t S3TConv_DDS_GetLevelSize(const S3TConv_DDSInfo *info, unsigned int level) {
+	unsigned int width = info->width >> level, height = info->height >> level;
+	return S3TConv_Container_GetSurfaceSize(info->format, width != 0 ? width : 1, height != 0 ? height : 1);
+}
+
+// Maximum number of array layers, the Direct3D 11 limit, so the number of surfaces stays small.
+#define S3TCONV_DDS_MAX_LAYERS 2048
+
+int S3TConv_DDS_Parse(const uint8_t *ddsData, size_t ddsSize, S3TConv_DDSInfo *info) {
+	uint32_t flags, pixelFormatFlags, fourCC, caps2, dimensionBits;
+	size_t chainSize, totalSize;
+	unsigned int widthInBlocks, heightInBlocks, maxLevelCount, level;
+
+	if (ddsSize < 128 || memcmp(ddsData, "DDS ", 4) != 0 || S3TConv_Container_Read32(ddsData + 4) != 124) {
+		return 0;
+	}
+	flags = S3TConv_Container_Read32(ddsData + 8);
+	info->height = S3TConv_Container_Read32(ddsData + 12);
+	info->width = S3TConv_Container_Read32(ddsData + 16);
+	info->levelCount = ((flags & 0x20000) ? S3TConv_Container_Read32(ddsData + 28) : 1); // DDSD_MIPMAPCOUNT.
+	pixelFormatFlags = S3TConv_Container_Read32(ddsData + 80);
+	fourCC = S3TConv_Container_Read32(ddsData + 84);
+	caps2 = S3TConv_Container_Read32(ddsData + 112);
+	info->layerCount = 1;
+	info->faceCount = 1;
+	info->dataOffset = 128;
+
+	if (!(pixelFormatFlags & 0x4)) { // DDPF_FOURCC.
+		return 0;
+	}
+	if (caps2 & 0x200000) { // DDSCAPS2_VOLUME.
+		return 0;
+	}
+	if (caps2 & 0x200) { // DDSCAPS2_CUBEMAP.
+		// Only complete cubemaps are supported.
+		if ((caps2 & 0xFC00) != 0xFC00) {
+			return 0;
+		}
+		info->faceCount = 6;
+	}
+	switch (fourCC) {
+	case 0x31545844: // DXT1.
+		info->format = S3TCONV_FORMAT_DXT1;
+		break;
+	case 0x32545844: // DXT2.
+	case 0x33545844: // DXT3.
+		info->format = S3TCONV_FORMAT_DXT3;
+		break;
+	case 0x34545844: // DXT4.
+	case 0x35545844: // DXT5.
+		info->format = S3TCONV_FORMAT_DXT5;
+		break;
+	case 0x30315844: // DX10.
+		if (ddsSize < 148) {
+			return 0;
+		}
+		switch (S3TConv_Container_Read32(ddsData + 128)) {
+		case 70: // DXGI_FORMAT_BC1_TYPELESS.
+		case 71: // DXGI_FORMAT_BC1_UNORM.
+		case 72: // DXGI_FORMAT_BC1_UNORM_SRGB.
+			info->format = S3TCONV_FORMAT_DXT1;
+			break;
+		case 73: // DXGI_FORMAT_BC2_TYPELESS.
+		case 74: // DXGI_FORMAT_BC2_UNORM.
+		case 75: // DXGI_FORMAT_BC2_UNORM_SRGB.
+			info->format = S3TCONV_FORMAT_DXT3;
+			break;
+		case 76: // DXGI_FORMAT_BC3_TYPELESS.
+		case 77: // DXGI_FORMAT_BC3_UNORM.
+		case 78: // DXGI_FORMAT_BC3_UNORM_SRGB.
+			info->format = S3TCONV_FORMAT_DXT5;
+			break;
+		default:
+			return 0;
+		}
+		if (S3TConv_Container_Read32(ddsData + 132) != 3) { // D3D10_RESOURCE_DIMENSION_TEXTURE2D.
+			return 0;
+		}
+		info->faceCount = ((S3TConv_Container_Read32(ddsData + 136) & 0x4) ? 6 : 1); // D3D10_RESOURCE_MISC_TEXTURECUBE.
+		info->layerCount = S3TConv_Container_Read32(ddsData + 140);
+		info->dataOffset = 148;
+		break;
+	default:
+		return 0;
+	}
+
+	if (info->width == 0 || info->height == 0 || info->layerCount == 0 || info->layerCount > S3TCONV_DDS_MAX_LAYERS) {
+		return 0;
+	}
+	// The size in blocks must not wrap, and the size of the largest level must be far from overflowing size_t.
+	if (info->width > 0xFFFFFFFC || info->height > 0xFFFFFFFC) {
+		return 0;
+	}
+	widthInBlocks = (info->width + 3) >> 2;
+	heightInBlocks = (info->height + 3) >> 2;
+	if (heightInBlocks > (SIZE_MAX >> 6) / widthInBlocks) {
+		return 0;
+	}
+	// The dimensions are shifted as a local copy, as shifting a 32-bit value by 32 is undefined.
+	dimensionBits = info->width | info->height;
+	for (maxLevelCount = 1; (dimensionBits >>= 1) != 0; ++maxLevelCount) {}
+	if (info->levelCount == 0) {
+		info->levelCount = 1;
+	}
+	if (info->levelCount > maxLevelCount) {
+		return 0;
+	}
+
+	chainSize = 0;
+	for (level = 0; level < info->levelCount; ++level) {
+		chainSize += S3TConv_DDS_GetLevelSize(info, level);
+	}
+	totalSize = chainSize * info->faceCount;
+	if (totalSize / info->faceCount != chainSize || (totalSize * info->layerCount) / info->layerCount != totalSize) {
+		return 0;
+	}
+	totalSize *= info->layerCount;
+	if (totalSize > ddsSize - info->dataOffset) {
+		return 0;
+	}
+	return 1;
+}
+
+size_t S3TConv_DDS_GetSurfaceOffset(const S3TConv_DDSInfo *info,
+		unsigned int layer, unsigned int face, unsigned int level) {
+	// DDS stores all mipmaps of each face of each layer together.
+	size_t chainSize = 0, levelOffset = 0;
+	unsigned int levelIndex;
+	for (levelIndex = 0; levelIndex < info->levelCount; ++levelIndex) {
+		size_t levelSize = S3TConv_DDS_GetLevelSize(info, levelIndex);
+		if (levelIndex < level) {
+			levelOffset += levelSize;
+		}
+		chainSize += levelSize;
+	}
+	return info->dataOffset + ((size_t) layer * info->faceCount + face) * chainSize + levelOffset;
+}
+
+//
+// KTX.
+//
+
+static const uint8_t S3TConv_KTX_Identifier[12] = {
+	0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+static int S3TConv_KTX_GetGLFormats(S3TConv_Format format, uint32_t *internalFormat, uint32_t *baseInternalFormat) {
+	switch (format) {
+	case S3TCONV_FORMAT_ATITC_RGB:
+		*internalFormat = 0x8C92; // GL_ATC_RGB_AMD.
+		*baseInternalFormat = 0x1907; // GL_RGB.
+		return 1;
+	case S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT:
+		*internalFormat = 0x8C93; // GL_ATC_RGBA_EXPLICIT_ALPHA_AMD.
+		*baseInternalFormat = 0x1908; // GL_RGBA.
+		return 1;
+	case S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED:
+		*internalFormat = 0x87EE; // GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD.
+		*baseInternalFormat = 0x1908; // GL_RGBA.
+		return 1;
+	case S3TCONV_FORMAT_ETC2_RGB:
+		*internalFormat = 0x9274; // GL_COMPRESSED_RGB8_ETC2.
+		*baseInternalFormat = 0x1907; // GL_RGB.
+		return 1;
+	case S3TCONV_FORMAT_ETC2_RGB8A1:
+		*internalFormat = 0x9276; // GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2.
+		*baseInternalFormat = 0x1908; // GL_RGBA.
+		return 1;
+	case S3TCONV_FORMAT_ETC2_RGBA:
+		*internalFormat = 0x9278; // GL_COMPRESSED_RGBA8_ETC2_EAC.
+		*baseInternalFormat = 0x1908; // GL_RGBA.
+		return 1;
+	case S3TCONV_FORMAT_ASTC_4X4:
+		*internalFormat = 0x93B0; // GL_COMPRESSED_RGBA_ASTC_4x4_KHR.
+		*baseInternalFormat = 0x1908; // GL_RGBA.
+		return 1;
+	default:
+		break;
+	}
+	return 0;
+}
+
+size_t S3TConv_KTX_GetSizeForDDS(const S3TConv_DDSInfo *info, S3TConv_Format targetFormat) {
+	// Block sizes are multiples of 4, so no padding is needed.
+	size_t size = 64;
+	unsigned int level;
+	for (level = 0; level < info->levelCount; ++level) {
+		unsigned int width = info->width >> level, height = info->height >> level;
+		size_t surfaceSize = S3TConv_Container_GetSurfaceSize(targetFormat, width != 0 ? width : 1, height != 0 ? height : 1);
+		size_t levelSize;
+		// The surface sizes are bounded by S3TConv_DDS_Parse, but the whole level must also fit in the 32-bit imageSize.
+		if (surfaceSize > SIZE_MAX / info->layerCount / info->faceCount) {
+			return 0;
+		}
+		levelSize = surfaceSize * info->layerCount * info->faceCount;
+		if (levelSize > UINT32_MAX || levelSize > SIZE_MAX - 4 - size) {
+			return 0;
+		}
+		size += 4 + levelSize;
+	}
+	return size;
+}
+
+int S3TConv_DDS_ConvertToKTX(const uint8_t *ddsData, size_t ddsSize, int asDXT1,
+		S3TConv_Format targetFormat, S3TConv_Quality quality, uint8_t *ktxData,
+		const S3TConv_Scheduler *scheduler, S3TConv_Stats *stats) {
+	S3TConv_DDSInfo info;
+	uint32_t internalFormat, baseInternalFormat;
+	S3TConv_Surface *surfaces;
+	unsigned int surfaceCount, surfaceIndex, level, layer, face;
+	uint8_t *ktxLevelData;
+	int converted;
+
+	if (!S3TConv_DDS_Parse(ddsData, ddsSize, &info) ||
+			!S3TConv_KTX_GetGLFormats(targetFormat, &internalFormat, &baseInternalFormat) ||
+			!S3TConv_IsConversionSupported(info.format, targetFormat) ||
+			S3TConv_KTX_GetSizeForDDS(&info, targetFormat) == 0) {
+		return 0;
+	}
+
+	// Bounded by S3TConv_DDS_Parse, but checked again as the surfaces array is filled for every layer and face.
+	if ((size_t) info.levelCount * info.layerCount * info.faceCount > SIZE_MAX / sizeof(S3TConv_Surface) ||
+			(size_t) info.levelCount * info.layerCount * info.faceCount > UINT_MAX) {
+		return 0;
+	}
+	surfaceCount = info.levelCount * info.layerCount * info.faceCount;
+	surfaces = (S3TConv_Surface *) malloc(surfaceCount * sizeof(S3TConv_Surface));
+	if (surfaces == NULL) {
+		return 0;
+	}
+
+	memcpy(ktxData, S3TConv_KTX_Identifier, 12);
+	S3TConv_Container_Write32(ktxData + 12, 0x04030201); // Endianness.
+	S3TConv_Container_Write32(ktxData + 16, 0); // glType.
+	S3TConv_Container_Write32(ktxData + 20, 1); // glTypeSize.
+	S3TConv_Container_Write32(ktxData + 24, 0); // glFormat.
+	S3TConv_Container_Write32(ktxData + 28, internalFormat);
+	S3TConv_Container_Write32(ktxData + 32, baseInternalFormat);
+	S3TConv_Container_Write32(ktxData + 36, info.width);
+	S3TConv_Container_Write32(ktxData + 40, info.height);
+	S3TConv_Container_Write32(ktxData + 44, 0); // pixelDepth.
+	S3TConv_Container_Write32(ktxData + 48, info.layerCount > 1 ? info.layerCount : 0);
+	S3TConv_Container_Write32(ktxData + 52, info.faceCount);
+	S3TConv_Container_Write32(ktxData + 56, info.levelCount);
+	S3TConv_Container_Write32(ktxData + 60, 0); // bytesOfKeyValueData.
+
+	// KTX stores all faces of all layers of each mipmap together.
+	ktxLevelData = ktxData + 64;
+	surfaceIndex = 0;
+	for (level = 0; level < info.levelCount; ++level) {
+		unsigned int width = info.width >> level, height = info.height >> level;
+		size_t surfaceSize;
+		width = (width != 0 ? width : 1);
+		height = (height != 0 ? height : 1);
+		surfaceSize = S3TConv_Container_GetSurfaceSize(targetFormat, width, height);
+		// imageSize is the size of one face for non-array cubemaps, and of the whole level otherwise.
+		S3TConv_Container_Write32(ktxLevelData, (uint32_t) (info.faceCount == 6 && info.layerCount == 1 ?
+				surfaceSize : surfaceSize * info.layerCount * info.faceCount));
+		ktxLevelData += 4;
+		for (layer = 0; layer < info.layerCount; ++layer) {
+			for (face = 0; face < info.faceCount; ++face) {
+				S3TConv_Surface *surface = &surfaces[surfaceIndex++];
+				surface->sourceData = ddsData + S3TConv_DDS_GetSurfaceOffset(&info, layer, face, level);
+				surface->sourceFormat = info.format;
+				surface->asDXT1 = asDXT1;
+				surface->sourceRowPitch = 0;
+				surface->targetData = ktxLevelData;
+				surface->targetFormat = targetFormat;
+				surface->targetRowPitch = 0;
+				surface->width = width;
+				surface->height = height;
+				surface->useBlockCache = 0;
+				surface->quality = quality;
+				surface->stats = stats;
+				ktxLevelData += surfaceSize;
+			}
+		}
+	}
+
+	converted = S3TConv_ConvertSurfacesParallel(surfaces, surfaceCount, scheduler, 0);
+	free(surfaces);
+	return converted;
+}
+
+int S3TConv_DDS_ConvertFileToKTX(const char *ddsPath, const char *ktxPath, int asDXT1,
+		S3TConv_Format targetFormat, S3TConv_Quality quality,
+		const S3TConv_Scheduler *scheduler, S3TConv_Stats *stats) {
+	S3TConv_MappedFile ddsFile;
+	S3TConv_DDSInfo info;
+	uint8_t *ktxData;
+	size_t ktxSize;
+	FILE *ktxFile;
+	int converted;
+
+	if (!S3TConv_MappedFile_Open(&ddsFile, ddsPath)) {
+		return 0;
+	}
+	if (!S3TConv_DDS_Parse(ddsFile.data, ddsFile.size, &info)) {
+		S3TConv_MappedFile_Close(&ddsFile);
+		return 0;
+	}
+	ktxSize = S3TConv_KTX_GetSizeForDDS(&info, targetFormat);
+	ktxData = (ktxSize != 0 ? (uint8_t *) malloc(ktxSize) : NULL);
+	if (ktxData == NULL) {
+		S3TConv_MappedFile_Close(&ddsFile);
+		return 0;
+	}
+	converted = S3TConv_DDS_ConvertToKTX(ddsFile.data, ddsFile.size, asDXT1, targetFormat, quality, ktxData, scheduler, stats);
+	S3TConv_MappedFile_Close(&ddsFile);
+
+	if (converted) {
+		ktxFile = fopen(ktxPath, "wb");
+		converted = (ktxFile != NULL);
+		if (ktxFile != NULL) {
+			converted = (fwrite(ktxData, 1, ktxSize, ktxFile) == ktxSize);
+			converted = (fclose(ktxFile) == 0 && converted);
+		}
+	}
+	free(ktxData);
+	return converted;
+}
@@ -0,0 +1,1191 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <limits.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+// Squared error (summed over the pixels and the components) up to which the slow T, H and planar modes aren't tried.
+#define S3TCONV_ETC2_GOOD_ERROR 48
+
+// Intensity modifiers of the individual and the differential modes, by pixel index (MSB << 1 | LSB).
+static const int S3TConv_ETC2_Modifiers[8][4] = {
+	{ 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+	{ 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 }
+};
+
+// RGB8A1 differential mode with the opaque bit cleared: index 0 doesn't modify the color, and 2 is transparent.
+static const int S3TConv_ETC2_PunchthroughModifiers[8][4] = {
+	{ 0, 8, 0, -8 }, { 0, 17, 0, -17 }, { 0, 29, 0, -29 }, { 0, 42, 0, -42 },
+	{ 0, 60, 0, -60 }, { 0, 80, 0, -80 }, { 0, 106, 0, -106 }, { 0, 183, 0, -183 }
+};
+
+// Distances of the paint colors in the T and the H modes.
+static const int S3TConv_ETC2_Distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int S3TConv_ETC2_AlphaModifiers[16][8] = {
+	{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+	{ -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+	{ -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+// Modes other than individual and differential are selected by overflows of the differential colors.
+typedef enum {
+	S3TCONV_ETC2_MODE_DIFFERENTIAL,
+	S3TCONV_ETC2_MODE_T,
+	S3TCONV_ETC2_MODE_H,
+	S3TCONV_ETC2_MODE_PLANAR
+} S3TConv_ETC2_Mode;
+
+// Colors of a DXT block and how many visible opaque pixels use each of them, in the whole block and in its halves.
+typedef struct {
+	int colors[4][3];
+	unsigned int counts[4];
+	// Left, right, top and bottom - the subblocks with the flip bit 0 and 1.
+	unsigned int halfCounts[4][4];
+	unsigned int usedMask;
+	uint32_t indices;
+	// Target is RGB8A1, so the individual mode is not available.
+	int punchthrough;
+	// 3 for the black mode if punch-through transparency is kept, -1 otherwise.
+	int transparentIndex;
+	int hasTransparentPixels;
+	int isFull;
+	// All colors are on one line, in the 0, 2, 3, 1 order.
+	int isFourColor;
+	// Below S3TCONV_QUALITY_HIGH, only the tables closest to the colors are tried.
+	S3TConv_Quality quality;
+} S3TConv_ETC2_Palette;
+
+typedef struct {
+	// Without the pixel indices, unless the mode is planar.
+	uint64_t block;
+	unsigned int error;
+	int flip;
+	int hasIndices;
+	// ETC2 pixel index for every DXT index, for each subblock.
+	uint8_t indexMaps[2][4];
+} S3TConv_ETC2_Encoding;
+
+static inline int S3TConv_ETC2_Clamp255(int value) {
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static inline int S3TConv_ETC2_DivideRounded(int numerator, int denominator) {
+	return numerator >= 0 ? (numerator + (denominator >> 1)) / denominator :
+			-((-numerator + (denominator >> 1)) / denominator);
+}
+
+// Bit replication from 4 to 7 bits to 8 bits.
+static inline int S3TConv_ETC2_Expand(int value, unsigned int bits) {
+	return (value << (8 - bits)) | (value >> (2 * bits - 8));
+}
+
+static inline int S3TConv_ETC2_Quantize(int value, unsigned int bits) {
+	// x / 255 for x up to 65534.
+	int scaled = S3TConv_ETC2_Clamp255(value) * ((1 << bits) - 1) + 127;
+	return (scaled + (scaled >> 8) + 1) >> 8;
+}
+
+static inline void S3TConv_ETC2_ExpandColor(const int quantizedColor[3], unsigned int bits, int color[3]) {
+	color[0] = S3TConv_ETC2_Expand(quantizedColor[0], bits);
+	color[1] = S3TConv_ETC2_Expand(quantizedColor[1], bits);
+	color[2] = S3TConv_ETC2_Expand(quantizedColor[2], bits);
+}
+
+static inline unsigned int S3TConv_ETC2_GetSquaredDistance(const int color[3], const int otherColor[3]) {
+	int red = color[0] - otherColor[0], green = color[1] - otherColor[1], blue = color[2] - otherColor[2];
+	return (unsigned int) (red * red + green * green + blue * blue);
+}
+
+static void S3TConv_ETC2_GetPalette(const uint8_t dxtBlock[8], int asDXT1, int punchthrough, S3TConv_Quality quality,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_ETC2_Palette *palette) {
+	uint16_t colorLow565 = (uint16_t) dxtBlock[0] | ((uint16_t) dxtBlock[1] << 8);
+	uint16_t colorHigh565 = (uint16_t) dxtBlock[2] | ((uint16_t) dxtBlock[3] << 8);
+	uint8_t colorLow888[3], colorHigh888[3];
+	unsigned int width = (remainingWidth < 4 ? remainingWidth : 4), height = (remainingHeight < 4 ? remainingHeight : 4);
+	unsigned int component, x, y;
+
+	S3TConv_Utility_Color565To888(colorLow565, colorLow888);
+	S3TConv_Utility_Color565To888(colorHigh565, colorHigh888);
+	palette->transparentIndex = -1;
+	palette->isFourColor = (colorLow565 > colorHigh565 || !asDXT1);
+	for (component = 0; component < 3; ++component) {
+		int low = colorLow888[component], high = colorHigh888[component];
+		palette->colors[0][component] = low;
+		palette->colors[1][component] = high;
+		if (palette->isFourColor) {
+			palette->colors[2][component] = (2 * low + high + 1) / 3;
+			palette->colors[3][component] = (low + 2 * high + 1) / 3;
+		} else {
+			palette->colors[2][component] = (low + high + 1) >> 1;
+			palette->colors[3][component] = 0;
+			if (punchthrough) {
+				palette->transparentIndex = 3;
+			}
+		}
+	}
+
+	palette->indices = (uint32_t) dxtBlock[4] | ((uint32_t) dxtBlock[5] << 8) |
+			((uint32_t) dxtBlock[6] << 16) | ((uint32_t) dxtBlock[7] << 24);
+	memset(palette->counts, 0, sizeof(palette->counts));
+	memset(palette->halfCounts, 0, sizeof(palette->halfCounts));
+	palette->hasTransparentPixels = 0;
+	for (y = 0; y < height; ++y) {
+		for (x = 0; x < width; ++x) {
+			int index = (int) ((palette->indices >> ((y * 4 + x) * 2)) & 3);
+			if (index == palette->transparentIndex) {
+				palette->hasTransparentPixels = 1;
+				continue;
+			}
+			++palette->counts[index];
+			++palette->halfCounts[x >> 1][index];
+			++palette->halfCounts[2 + (y >> 1)][index];
+		}
+	}
+	palette->usedMask = (palette->counts[0] != 0 ? 1 : 0) | (palette->counts[1] != 0 ? 2 : 0) |
+			(palette->counts[2] != 0 ? 4 : 0) | (palette->counts[3] != 0 ? 8 : 0);
+	palette->punchthrough = punchthrough;
+	palette->quality = quality;
+	palette->isFull = (width == 4 && height == 4);
+}
+
+static void S3TConv_ETC2_StoreBlock(const S3TConv_ETC2_Palette *palette, const S3TConv_ETC2_Encoding *encoding,
+		uint8_t etc2Block[8]) {
+	uint64_t block = encoding->block;
+	unsigned int x, y, byteIndex;
+
+	if (encoding->hasIndices) {
+		for (y = 0; y < 4; ++y) {
+			for (x = 0; x < 4; ++x) {
+				int dxtIndex = (int) ((palette->indices >> ((y * 4 + x) * 2)) & 3);
+				unsigned int etc2Index = encoding->indexMaps[(encoding->flip ? y : x) >> 1][dxtIndex];
+				unsigned int pixel = x * 4 + y; // ETC2 pixels are in columns.
+				if (dxtIndex == palette->transparentIndex && palette->hasTransparentPixels) {
+					etc2Index = 2;
+				}
+				block |= ((uint64_t) (etc2Index >> 1) << (16 + pixel)) | ((uint64_t) (etc2Index & 1) << pixel);
+			}
+		}
+	}
+	for (byteIndex = 0; byteIndex < 8; ++byteIndex) {
+		etc2Block[byteIndex] = (uint8_t) (block >> (56 - byteIndex * 8));
+	}
+}
+
+static S3TConv_ETC2_Mode S3TConv_ETC2_GetMode(uint64_t block) {
+	// 5-bit colors with 3-bit signed offsets.
+	int red = (int) ((block >> 59) & 31) + (((int) ((block >> 56) & 7) ^ 4) - 4);
+	int green = (int) ((block >> 51) & 31) + (((int) ((block >> 48) & 7) ^ 4) - 4);
+	int blue = (int) ((block >> 43) & 31) + (((int) ((block >> 40) & 7) ^ 4) - 4);
+	if (red < 0 || red > 31) {
+		return S3TCONV_ETC2_MODE_T;
+	}
+	if (green < 0 || green > 31) {
+		return S3TCONV_ETC2_MODE_H;
+	}
+	if (blue < 0 || blue > 31) {
+		return S3TCONV_ETC2_MODE_PLANAR;
+	}
+	return S3TCONV_ETC2_MODE_DIFFERENTIAL;
+}
+
+// Sets the bits not used by the T, the H or the planar mode so the differential colors overflow in the way selecting it.
+static uint64_t S3TConv_ETC2_SelectMode(uint64_t block, uint64_t unusedBits, S3TConv_ETC2_Mode mode) {
+	uint64_t bits = 0;
+	do {
+		if (S3TConv_ETC2_GetMode(block | bits) == mode) {
+			break;
+		}
+		bits = (bits - unusedBits) & unusedBits; // Next subset of the unused bits.
+	} while (bits != 0);
+	return block | bits;
+}
+
+// Returns the quantized base color component giving the value with the modifier, or -1 if there's none.
+static int S3TConv_ETC2_GetExactBase(int value, int modifier, unsigned int bits) {
+	int base, quantizedBase;
+	if (value == 0 && modifier < 0) {
+		return 0;
+	}
+	if (value == 255 && modifier > 0) {
+		return (1 << bits) - 1;
+	}
+	base = value - modifier;
+	if (base < 0 || base > 255) {
+		return -1;
+	}
+	quantizedBase = base >> (8 - bits);
+	return S3TConv_ETC2_Expand(quantizedBase, bits) == base ? quantizedBase : -1;
+}
+
+// A solid color is encoded exactly if possible, using a single modifier or the planar mode.
+static int S3TConv_ETC2_EncodeSolid(const S3TConv_ETC2_Palette *palette, const int color[3], S3TConv_ETC2_Encoding *encoding) {
+	int quantizedColor[3];
+	unsigned int bits, table, pixelIndex, component;
+
+	for (bits = 5; bits >= (palette->punchthrough ? 5u : 4u); --bits) {
+		for (table = 0; table < 8; ++table) {
+			for (pixelIndex = 0; pixelIndex < 4; ++pixelIndex) {
+				for (component = 0; component < 3; ++component) {
+					quantizedColor[component] = S3TConv_ETC2_GetExactBase(color[component],
+							S3TConv_ETC2_Modifiers[table][pixelIndex], bits);
+					if (quantizedColor[component] < 0) {
+						break;
+					}
+				}
+				if (component < 3) {
+					continue;
+				}
+				if (bits == 5) {
+					// Differential with zero offsets.
+					encoding->block = ((uint64_t) quantizedColor[0] << 59) | ((uint64_t) quantizedColor[1] << 51) |
+							((uint64_t) quantizedColor[2] << 43) | ((uint64_t) 1 << 33);
+				} else {
+					encoding->block = ((uint64_t) quantizedColor[0] << 60) | ((uint64_t) quantizedColor[0] << 56) |
+							((uint64_t) quantizedColor[1] << 52) | ((uint64_t) quantizedColor[1] << 48) |
+							((uint64_t) quantizedColor[2] << 44) | ((uint64_t) quantizedColor[2] << 40);
+				}
+				encoding->block |= ((uint64_t) table << 37) | ((uint64_t) table << 34);
+				encoding->error = 0;
+				encoding->flip = 0;
+				encoding->hasIndices = 1;
+				memset(encoding->indexMaps, (int) pixelIndex, sizeof(encoding->indexMaps));
+				return 1;
+			}
+		}
+	}
+
+	// Planar with the same origin, horizontal and vertical colors.
+	quantizedColor[0] = S3TConv_ETC2_GetExactBase(color[0], 0, 6);
+	quantizedColor[1] = S3TConv_ETC2_GetExactBase(color[1], 0, 7);
+	quantizedColor[2] = S3TConv_ETC2_GetExactBase(color[2], 0, 6);
+	if (quantizedColor[0] >= 0 && quantizedColor[1] >= 0 && quantizedColor[2] >= 0) {
+		uint64_t red = (uint64_t) quantizedColor[0], green = (uint64_t) quantizedColor[1], blue = (uint64_t) quantizedColor[2];
+		encoding->block = S3TConv_ETC2_SelectMode((red << 57) | ((green >> 6) << 56) | ((green & 63) << 49) |
+				((blue >> 5) << 48) | (((blue >> 3) & 3) << 43) | ((blue & 7) << 39) | ((red >> 1) << 34) |
+				((uint64_t) 1 << 33) | ((red & 1) << 32) | (green << 25) | (blue << 19) | (red << 13) | (green << 6) | blue,
+				0x8080E40000000000ull, S3TCONV_ETC2_MODE_PLANAR);
+		encoding->error = 0;
+		encoding->hasIndices = 0;
+		return 1;
+	}
+	return 0;
+}
+
+// Chooses the table and the modifier for each color of a subblock with a fixed base color, returning the error.
+// Clamping is ignored, as it can only make the colors closer. With the color minus the base being d, the error for the
+// modifier m is |d|^2 + m * (3 * m - 2 * (dr + dg + db)), so the sign of the modifier is the sign of the sum, and the
+// larger one of the table is closer if 2 * |sum| > 3 * (small + large).
+static unsigned int S3TConv_ETC2_FitSubblockTable(const S3TConv_ETC2_Palette *palette, const unsigned int counts[4],
+		const int base[3], unsigned int *table, uint8_t indexMap[4]) {
+	int sums[4], largestSum = 0;
+	unsigned int colorIndex, tableIndex = 0, lastTableIndex = 7, bestError = UINT_MAX, squaredDistanceError = 0;
+
+	for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+		const int *color = palette->colors[colorIndex];
+		squaredDistanceError += counts[colorIndex] * S3TConv_ETC2_GetSquaredDistance(color, base);
+		sums[colorIndex] = (color[0] - base[0]) + (color[1] - base[1]) + (color[2] - base[2]);
+		if (counts[colorIndex] != 0) {
+			int absoluteSum = (sums[colorIndex] >= 0 ? sums[colorIndex] : -sums[colorIndex]);
+			largestSum = (absoluteSum > largestSum ? absoluteSum : largestSum);
+		}
+	}
+	if (palette->quality != S3TCONV_QUALITY_HIGH) {
+		// The large modifier closest to a third of the sum is the best for the farthest color, so only the tables with
+		// the large modifiers around it are tried.
+		for (lastTableIndex = 0; lastTableIndex < 7 && 3 * S3TConv_ETC2_Modifiers[lastTableIndex][1] < largestSum;
+				++lastTableIndex) {}
+		tableIndex = (lastTableIndex != 0 ? lastTableIndex - 1 : 0);
+	}
+	for (; tableIndex <= lastTableIndex && bestError != 0; ++tableIndex) {
+		// Without the small modifiers (index 0 is 0, index 2 is transparent) if there are transparent pixels.
+		int small = (palette->hasTransparentPixels ? 0 : S3TConv_ETC2_Modifiers[tableIndex][0]);
+		int large = S3TConv_ETC2_Modifiers[tableIndex][1];
+		uint8_t tableIndexMap[4];
+		int error = (int) squaredDistanceError;
+		// Branchless, as the choices are unpredictable.
+		for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+			int sum = sums[colorIndex], absoluteSum = (sum >= 0 ? sum : -sum);
+			int useLarge = (2 * absoluteSum > 3 * (small + large));
+			int modifier = (useLarge ? large : small);
+			int negative = (sum < 0) & (useLarge | !palette->hasTransparentPixels);
+			tableIndexMap[colorIndex] = (uint8_t) (useLarge | (negative << 1));
+			error += (int) counts[colorIndex] * modifier * (3 * modifier - 2 * absoluteSum);
+		}
+		if ((unsigned int) error < bestError) {
+			bestError = (unsigned int) error;
+			*table = tableIndex;
+			memcpy(indexMap, tableIndexMap, 4);
+		}
+	}
+	return bestError;
+}
+
+// Fits a subblock with the base color quantized to 4 or 5 bits, starting from the mean of the colors and then, unless
+// the quality is S3TCONV_QUALITY_FAST, refining it once for the chosen modifiers. An empty subblock gets black with
+// zero error.
+static unsigned int S3TConv_ETC2_FitSubblock(const S3TConv_ETC2_Palette *palette, const unsigned int counts[4],
+		unsigned int bits, int quantizedBase[3], unsigned int *table, uint8_t indexMap[4]) {
+	const int (*modifiers)[4] = (palette->hasTransparentPixels ?
+			S3TConv_ETC2_PunchthroughModifiers : S3TConv_ETC2_Modifiers);
+	int base[3], refinedQuantizedBase[3], refinedBase[3];
+	unsigned int pixelCount = counts[0] + counts[1] + counts[2] + counts[3];
+	unsigned int colorIndex, component, error, refinedError, refinedTable;
+	uint8_t refinedIndexMap[4];
+
+	if (pixelCount == 0) {
+		quantizedBase[0] = quantizedBase[1] = quantizedBase[2] = 0;
+		*table = 0;
+		memset(indexMap, 0, 4);
+		return 0;
+	}
+
+	for (component = 0; component < 3; ++component) {
+		int sum = 0;
+		for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+			sum += (int) counts[colorIndex] * palette->colors[colorIndex][component];
+		}
+		quantizedBase[component] = S3TConv_ETC2_Quantize(S3TConv_ETC2_DivideRounded(sum, (int) pixelCount), bits);
+	}
+	S3TConv_ETC2_ExpandColor(quantizedBase, bits, base);
+	error = S3TConv_ETC2_FitSubblockTable(palette, counts, base, table, indexMap);
+	if (error == 0 || palette->quality == S3TCONV_QUALITY_FAST) {
+		return error;
+	}
+
+	for (component = 0; component < 3; ++component) {
+		int sum = 0;
+		for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+			sum += (int) counts[colorIndex] *
+					(palette->colors[colorIndex][component] - modifiers[*table][indexMap[colorIndex]]);
+		}
+		refinedQuantizedBase[component] = S3TConv_ETC2_Quantize(S3TConv_ETC2_DivideRounded(sum, (int) pixelCount), bits);
+	}
+	if (memcmp(refinedQuantizedBase, quantizedBase, sizeof(refinedQuantizedBase)) != 0) {
+		S3TConv_ETC2_ExpandColor(refinedQuantizedBase, bits, refinedBase);
+		refinedError = S3TConv_ETC2_FitSubblockTable(palette, counts, refinedBase, &refinedTable, refinedIndexMap);
+		if (refinedError < error) {
+			memcpy(quantizedBase, refinedQuantizedBase, sizeof(refinedQuantizedBase));
+			*table = refinedTable;
+			memcpy(indexMap, refinedIndexMap, 4);
+			error = refinedError;
+		}
+	}
+	return error;
+}
+
+// Differential and individual modes with the given subblock orientation.
+static void S3TConv_ETC2_EncodeSubblocks(const S3TConv_ETC2_Palette *palette, int flip, S3TConv_ETC2_Encoding *encoding) {
+	const unsigned int *counts[2];
+	int bases[2][3];
+	unsigned int tables[2], errors[2], subblock, component;
+	uint8_t indexMaps[2][4];
+	int deltasFit = 1, clampDeltas;
+
+	counts[0] = palette->halfCounts[flip << 1];
+	counts[1] = palette->halfCounts[(flip << 1) + 1];
+
+	for (subblock = 0; subblock < 2; ++subblock) {
+		errors[subblock] = S3TConv_ETC2_FitSubblock(palette, counts[subblock], 5,
+				bases[subblock], &tables[subblock], indexMaps[subblock]);
+	}
+	// An empty subblock (only padding or transparent pixels) takes the base of the other.
+	if (counts[0][0] + counts[0][1] + counts[0][2] + counts[0][3] == 0) {
+		memcpy(bases[0], bases[1], sizeof(bases[0]));
+	} else if (counts[1][0] + counts[1][1] + counts[1][2] + counts[1][3] == 0) {
+		memcpy(bases[1], bases[0], sizeof(bases[1]));
+	}
+	for (component = 0; component < 3; ++component) {
+		int delta = bases[1][component] - bases[0][component];
+		if (delta < -4 || delta > 3) {
+			deltasFit = 0;
+		}
+	}
+	// Below S3TCONV_QUALITY_HIGH, only the individual mode is tried if it's available and the deltas don't fit.
+	clampDeltas = (!deltasFit && (palette->punchthrough || palette->quality == S3TCONV_QUALITY_HIGH));
+	if (clampDeltas) {
+		// Move one of the bases towards the other, whichever loses less.
+		int clampedBases[2][3], clampedBase[3];
+		unsigned int clampedTables[2], clampedErrors[2];
+		uint8_t clampedIndexMaps[2][4];
+		for (component = 0; component < 3; ++component) {
+			int delta = bases[1][component] - bases[0][component];
+			delta = (delta < -4 ? -4 : (delta > 3 ? 3 : delta));
+			clampedBases[0][component] = bases[1][component] - delta;
+			clampedBases[1][component] = bases[0][component] + delta;
+		}
+		for (subblock = 0; subblock < 2; ++subblock) {
+			S3TConv_ETC2_ExpandColor(clampedBases[subblock], 5, clampedBase);
+			clampedErrors[subblock] = S3TConv_ETC2_FitSubblockTable(palette, counts[subblock], clampedBase,
+					&clampedTables[subblock], clampedIndexMaps[subblock]);
+		}
+		subblock = (errors[0] + clampedErrors[1] <= clampedErrors[0] + errors[1] ? 1 : 0);
+		memcpy(bases[subblock], clampedBases[subblock], sizeof(bases[subblock]));
+		tables[subblock] = clampedTables[subblock];
+		memcpy(indexMaps[subblock], clampedIndexMaps[subblock], 4);
+		errors[subblock] = clampedErrors[subblock];
+	}
+	if ((deltasFit || clampDeltas) && errors[0] + errors[1] < encoding->error) {
+		encoding->block = ((uint64_t) bases[0][0] << 59) | ((uint64_t) ((bases[1][0] - bases[0][0]) & 7) << 56) |
+				((uint64_t) bases[0][1] << 51) | ((uint64_t) ((bases[1][1] - bases[0][1]) & 7) << 48) |
+				((uint64_t) bases[0][2] << 43) | ((uint64_t) ((bases[1][2] - bases[0][2]) & 7) << 40) |
+				((uint64_t) tables[0] << 37) | ((uint64_t) tables[1] << 34) |
+				((uint64_t) (palette->hasTransparentPixels ? 0 : 1) << 33) | ((uint64_t) flip << 32);
+		encoding->error = errors[0] + errors[1];
+		encoding->flip = flip;
+		encoding->hasIndices = 1;
+		memcpy(encoding->indexMaps, indexMaps, sizeof(indexMaps));
+	}
+
+	// Individual mode only helps if the base colors are too far apart for the differential mode.
+	// In RGB8A1, the individual mode bit is the opaque bit instead.
+	if (deltasFit || palette->punchthrough || encoding->error == 0) {
+		return;
+	}
+	for (subblock = 0; subblock < 2; ++subblock) {
+		errors[subblock] = S3TConv_ETC2_FitSubblock(palette, counts[subblock], 4,
+				bases[subblock], &tables[subblock], indexMaps[subblock]);
+	}
+	if (errors[0] + errors[1] < encoding->error) {
+		encoding->block = ((uint64_t) bases[0][0] << 60) | ((uint64_t) bases[1][0] << 56) |
+				((uint64_t) bases[0][1] << 52) | ((uint64_t) bases[1][1] << 48) |
+				((uint64_t) bases[0][2] << 44) | ((uint64_t) bases[1][2] << 40) |
+				((uint64_t) tables[0] << 37) | ((uint64_t) tables[1] << 34) | ((uint64_t) flip << 32);
+		encoding->error = errors[0] + errors[1];
+		encoding->flip = flip;
+		encoding->hasIndices = 1;
+		memcpy(encoding->indexMaps, indexMaps, sizeof(indexMaps));
+	}
+}
+
+// Chooses the nearest paint color for every used color, returning the error with clamping.
+static unsigned int S3TConv_ETC2_MapToPaintColors(const S3TConv_ETC2_Palette *palette, int paintColors[4][3],
+		uint8_t indexMap[4]) {
+	unsigned int colorIndex, pixelIndex, error = 0;
+	for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+		unsigned int bestColorError = UINT_MAX;
+		indexMap[colorIndex] = 0;
+		if (palette->counts[colorIndex] == 0) {
+			continue;
+		}
+		for (pixelIndex = 0; pixelIndex < 4; ++pixelIndex) {
+			unsigned int colorError;
+			if (pixelIndex == 2 && palette->hasTransparentPixels) {
+				continue;
+			}
+			colorError = S3TConv_ETC2_GetSquaredDistance(palette->colors[colorIndex], paintColors[pixelIndex]);
+			if (colorError < bestColorError) {
+				bestColorError = colorError;
+				indexMap[colorIndex] = (uint8_t) pixelIndex;
+			}
+		}
+		error += palette->counts[colorIndex] * bestColorError;
+	}
+	return error;
+}
+
+static inline void S3TConv_ETC2_GetPaintColor(const int base[3], int distance, int paintColor[3]) {
+	paintColor[0] = S3TConv_ETC2_Clamp255(base[0] + distance);
+	paintColor[1] = S3TConv_ETC2_Clamp255(base[1] + distance);
+	paintColor[2] = S3TConv_ETC2_Clamp255(base[2] + distance);
+}
+
+static void S3TConv_ETC2_BuildT(const S3TConv_ETC2_Palette *palette, const int quantizedColors[2][3],
+		unsigned int distanceIndex, S3TConv_ETC2_Encoding *encoding) {
+	int colors[2][3], paintColors[4][3];
+	uint8_t indexMap[4];
+	unsigned int error;
+	int distance = S3TConv_ETC2_Distances[distanceIndex];
+
+	S3TConv_ETC2_ExpandColor(quantizedColors[0], 4, colors[0]);
+	S3TConv_ETC2_ExpandColor(quantizedColors[1], 4, colors[1]);
+	memcpy(paintColors[0], colors[0], sizeof(paintColors[0]));
+	S3TConv_ETC2_GetPaintColor(colors[1], distance, paintColors[1]);
+	memcpy(paintColors[2], colors[1], sizeof(paintColors[2]));
+	S3TConv_ETC2_GetPaintColor(colors[1], -distance, paintColors[3]);
+	error = S3TConv_ETC2_MapToPaintColors(palette, paintColors, indexMap);
+	if (error >= encoding->error) {
+		return;
+	}
+	encoding->block = S3TConv_ETC2_SelectMode(((uint64_t) (quantizedColors[0][0] >> 2) << 59) |
+			((uint64_t) (quantizedColors[0][0] & 3) << 56) | ((uint64_t) quantizedColors[0][1] << 52) |
+			((uint64_t) quantizedColors[0][2] << 48) | ((uint64_t) quantizedColors[1][0] << 44) |
+			((uint64_t) quantizedColors[1][1] << 40) | ((uint64_t) quantizedColors[1][2] << 36) |
+			((uint64_t) (distanceIndex >> 1) << 34) | ((uint64_t) (palette->hasTransparentPixels ? 0 : 1) << 33) |
+			((uint64_t) (distanceIndex & 1) << 32), 0xE400000000000000ull, S3TCONV_ETC2_MODE_T);
+	encoding->error = error;
+	encoding->flip = 0;
+	encoding->hasIndices = 1;
+	memcpy(encoding->indexMaps[0], indexMap, 4);
+	memcpy(encoding->indexMaps[1], indexMap, 4);
+}
+
+static void S3TConv_ETC2_BuildH(const S3TConv_ETC2_Palette *palette, const int quantizedColors[2][3],
+		unsigned int distanceIndex, S3TConv_ETC2_Encoding *encoding) {
+	int colors[2][3], paintColors[4][3];
+	uint8_t indexMap[4];
+	unsigned int error, first;
+	int distance = S3TConv_ETC2_Distances[distanceIndex];
+	const int *firstColor, *secondColor;
+
+	// The lowest bit of the distance index is whether the first color is greater than or equal to the second.
+	first = ((((quantizedColors[0][0] << 8) | (quantizedColors[0][1] << 4) | quantizedColors[0][2]) >=
+			((quantizedColors[1][0] << 8) | (quantizedColors[1][1] << 4) | quantizedColors[1][2])) ==
+			(int) (distanceIndex & 1) ? 0 : 1);
+	firstColor = quantizedColors[first];
+	secondColor = quantizedColors[first ^ 1];
+	S3TConv_ETC2_ExpandColor(firstColor, 4, colors[0]);
+	S3TConv_ETC2_ExpandColor(secondColor, 4, colors[1]);
+	S3TConv_ETC2_GetPaintColor(colors[0], distance, paintColors[0]);
+	S3TConv_ETC2_GetPaintColor(colors[0], -distance, paintColors[1]);
+	S3TConv_ETC2_GetPaintColor(colors[1], distance, paintColors[2]);
+	S3TConv_ETC2_GetPaintColor(colors[1], -distance, paintColors[3]);
+	error = S3TConv_ETC2_MapToPaintColors(palette, paintColors, indexMap);
+	if (error >= encoding->error) {
+		return;
+	}
+	encoding->block = S3TConv_ETC2_SelectMode(((uint64_t) firstColor[0] << 59) |
+			((uint64_t) (firstColor[1] >> 1) << 56) | ((uint64_t) (firstColor[1] & 1) << 52) |
+			((uint64_t) (firstColor[2] >> 3) << 51) | ((uint64_t) (firstColor[2] & 7) << 47) |
+			((uint64_t) secondColor[0] << 43) | ((uint64_t) secondColor[1] << 39) | ((uint64_t) secondColor[2] << 35) |
+			((uint64_t) (distanceIndex >> 2) << 34) | ((uint64_t) 1 << 33) | ((uint64_t) ((distanceIndex >> 1) & 1) << 32),
+			0x80E4000000000000ull, S3TCONV_ETC2_MODE_H);
+	encoding->error = error;
+	encoding->flip = 0;
+	encoding->hasIndices = 1;
+	memcpy(encoding->indexMaps[0], indexMap, 4);
+	memcpy(encoding->indexMaps[1], indexMap, 4);
+}
+
+// T and H modes for a split of the used colors into two groups, each represented by its mean. The T mode is tried if
+// the first group is a single color, and the H mode if tryH is non-zero. The errors are first estimated with every
+// color painted only from its own group, ignoring clamping.
+static void S3TConv_ETC2_EncodeTHGroups(const S3TConv_ETC2_Palette *palette, unsigned int groupMask, int tryH,
+		S3TConv_ETC2_Encoding *encoding) {
+	unsigned int otherGroupMask = palette->usedMask & ~groupMask, group, colorIndex, distanceIndex, component;
+	unsigned int bestDistanceIndex, bestError;
+	int quantizedColors[2][3], colors[2][3], squaredDistances[4], sums[4];
+	// Every distance with a smaller estimate than the current error is built, or only the one with the smallest.
+	int exhaustive = (palette->quality == S3TCONV_QUALITY_HIGH);
+
+	for (group = 0; group < 2; ++group) {
+		unsigned int mask = (group ? otherGroupMask : groupMask), pixelCount = 0;
+		for (component = 0; component < 3; ++component) {
+			int sum = 0;
+			pixelCount = 0;
+			for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+				if (mask & (1u << colorIndex)) {
+					sum += (int) palette->counts[colorIndex] * palette->colors[colorIndex][component];
+					pixelCount += palette->counts[colorIndex];
+				}
+			}
+			quantizedColors[group][component] = S3TConv_ETC2_Quantize(
+					S3TConv_ETC2_DivideRounded(sum, (int) pixelCount), 4);
+		}
+		S3TConv_ETC2_ExpandColor(quantizedColors[group], 4, colors[group]);
+	}
+	for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+		const int *color = palette->colors[colorIndex], *groupColor = colors[(groupMask >> colorIndex) & 1 ? 0 : 1];
+		squaredDistances[colorIndex] = (int) S3TConv_ETC2_GetSquaredDistance(color, groupColor);
+		sums[colorIndex] = (color[0] - groupColor[0]) + (color[1] - groupColor[1]) + (color[2] - groupColor[2]);
+		sums[colorIndex] = (sums[colorIndex] >= 0 ? sums[colorIndex] : -sums[colorIndex]);
+	}
+
+	// T mode: the first group is a single color, the second is spread along the gray axis.
+	if ((groupMask & (groupMask - 1)) == 0) {
+		bestDistanceIndex = 8;
+		bestError = encoding->error;
+		for (distanceIndex = 0; distanceIndex < 8; ++distanceIndex) {
+			int distance = S3TConv_ETC2_Distances[distanceIndex];
+			unsigned int error = 0;
+			for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+				int colorError = squaredDistances[colorIndex];
+				if (!(groupMask & (1u << colorIndex))) {
+					int spreadError = colorError + distance * (3 * distance - 2 * sums[colorIndex]);
+					// With transparency, the second color itself is not available.
+					if (spreadError < colorError || palette->hasTransparentPixels) {
+						colorError = spreadError;
+					}
+				}
+				error += palette->counts[colorIndex] * (unsigned int) colorError;
+			}
+			if (exhaustive && error < encoding->error) {
+				S3TConv_ETC2_BuildT(palette, (const int (*)[3]) quantizedColors, distanceIndex, encoding);
+			} else if (!exhaustive && error < bestError) {
+				bestError = error;
+				bestDistanceIndex = distanceIndex;
+			}
+		}
+		if (bestDistanceIndex < 8) {
+			S3TConv_ETC2_BuildT(palette, (const int (*)[3]) quantizedColors, bestDistanceIndex, encoding);
+		}
+	}
+
+	// H mode: both groups are spread. Not used with transparency, as one paint color is lost. Equal colors can't have
+	// even distance indices.
+	if (tryH && !palette->hasTransparentPixels) {
+		int sameColors = (memcmp(quantizedColors[0], quantizedColors[1], sizeof(quantizedColors[0])) == 0);
+		bestDistanceIndex = 8;
+		bestError = encoding->error;
+		for (distanceIndex = sameColors ? 1 : 0; distanceIndex < 8; distanceIndex += sameColors ? 2 : 1) {
+			int distance = S3TConv_ETC2_Distances[distanceIndex];
+			unsigned int error = 0;
+			for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+				error += palette->counts[colorIndex] * (unsigned int)
+						(squaredDistances[colorIndex] + distance * (3 * distance - 2 * sums[colorIndex]));
+			}
+			if (exhaustive && error < encoding->error) {
+				S3TConv_ETC2_BuildH(palette, (const int (*)[3]) quantizedColors, distanceIndex, encoding);
+			} else if (!exhaustive && error < bestError) {
+				bestError = error;
+				bestDistanceIndex = distanceIndex;
+			}
+		}
+		if (bestDistanceIndex < 8) {
+			S3TConv_ETC2_BuildH(palette, (const int (*)[3]) quantizedColors, bestDistanceIndex, encoding);
+		}
+	}
+}
+
+// T and H modes for every meaningful split of the used colors, each H split checked once.
+static void S3TConv_ETC2_EncodeTH(const S3TConv_ETC2_Palette *palette, S3TConv_ETC2_Encoding *encoding) {
+	// Colors from the ends of the 0, 2, 3, 1 line.
+	static const unsigned int lineSegmentMasks[6] = { 0x1, 0x5, 0xD, 0x2, 0xA, 0xE };
+	unsigned int usedMask = palette->usedMask, groupMask;
+
+	for (groupMask = (usedMask - 1) & usedMask; groupMask != 0; groupMask = (groupMask - 1) & usedMask) {
+		// In the four-color mode, only single colors and splits of the line into two segments are meaningful.
+		if (palette->isFourColor && (groupMask & (groupMask - 1)) != 0) {
+			unsigned int segmentIndex;
+			for (segmentIndex = 0; segmentIndex < 6; ++segmentIndex) {
+				if (groupMask == (lineSegmentMasks[segmentIndex] & usedMask)) {
+					break;
+				}
+			}
+			if (segmentIndex == 6) {
+				continue;
+			}
+		}
+		S3TConv_ETC2_EncodeTHGroups(palette, groupMask, groupMask < (usedMask & ~groupMask), encoding);
+	}
+}
+
+// Planar mode, a least squares fit of a gradient to a full block.
+static void S3TConv_ETC2_EncodePlanar(const S3TConv_ETC2_Palette *palette, S3TConv_ETC2_Encoding *encoding) {
+	static const unsigned int bits[3] = { 6, 7, 6 };
+	int sums[3] = { 0, 0, 0 }, sumsX[3] = { 0, 0, 0 }, sumsY[3] = { 0, 0, 0 };
+	int origins[3], horizontals[3], verticals[3];
+	uint64_t red, green, blue;
+	unsigned int x, y, component, error = 0;
+
+	for (y = 0; y < 4; ++y) {
+		for (x = 0; x < 4; ++x) {
+			const int *color = palette->colors[(palette->indices >> ((y * 4 + x) * 2)) & 3];
+			for (component = 0; component < 3; ++component) {
+				sums[component] += color[component];
+				sumsX[component] += (2 * (int) x - 3) * color[component];
+				sumsY[component] += (2 * (int) y - 3) * color[component];
+			}
+		}
+	}
+	// The colors at (0, 0), (4, 0) and (0, 4), multiplied by 80.
+	for (component = 0; component < 3; ++component) {
+		origins[component] = S3TConv_ETC2_Quantize(S3TConv_ETC2_DivideRounded(
+				5 * sums[component] - 3 * (sumsX[component] + sumsY[component]), 80), bits[component]);
+		horizontals[component] = S3TConv_ETC2_Quantize(S3TConv_ETC2_DivideRounded(
+				5 * sums[component] + 5 * sumsX[component] - 3 * sumsY[component], 80), bits[component]);
+		verticals[component] = S3TConv_ETC2_Quantize(S3TConv_ETC2_DivideRounded(
+				5 * sums[component] - 3 * sumsX[component] + 5 * sumsY[component], 80), bits[component]);
+	}
+
+	for (component = 0; component < 3; ++component) {
+		int origin = S3TConv_ETC2_Expand(origins[component], bits[component]);
+		int horizontal = S3TConv_ETC2_Expand(horizontals[component], bits[component]) - origin;
+		int vertical = S3TConv_ETC2_Expand(verticals[component], bits[component]) - origin;
+		for (y = 0; y < 4; ++y) {
+			int rowValue = (int) y * vertical + 4 * origin + 2;
+			for (x = 0; x < 4; ++x) {
+				int value = rowValue + (int) x * horizontal;
+				value = (value < 0 ? 0 : S3TConv_ETC2_Clamp255(value >> 2)) -
+						palette->colors[(palette->indices >> ((y * 4 + x) * 2)) & 3][component];
+				error += (unsigned int) (value * value);
+			}
+		}
+	}
+	if (error >= encoding->error) {
+		return;
+	}
+
+	red = (uint64_t) origins[0];
+	green = (uint64_t) origins[1];
+	blue = (uint64_t) origins[2];
+	encoding->block = (red << 57) | ((green >> 6) << 56) | ((green & 63) << 49) | ((blue >> 5) << 48) |
+			(((blue >> 3) & 3) << 43) | ((blue & 7) << 39) | ((uint64_t) 1 << 33);
+	red = (uint64_t) horizontals[0];
+	encoding->block |= ((red >> 1) << 34) | ((red & 1) << 32) |
+			((uint64_t) horizontals[1] << 25) | ((uint64_t) horizontals[2] << 19) |
+			((uint64_t) verticals[0] << 13) | ((uint64_t) verticals[1] << 6) | (uint64_t) verticals[2];
+	encoding->block = S3TConv_ETC2_SelectMode(encoding->block, 0x8080E40000000000ull, S3TCONV_ETC2_MODE_PLANAR);
+	encoding->error = error;
+	encoding->hasIndices = 0;
+}
+
+// Orientation for a single differential attempt: the one with the smaller spread of the colors within the halves, which
+// is the larger sum of the squared lengths of the half sums divided by the pixel counts.
+static int S3TConv_ETC2_ChooseFlip(const S3TConv_ETC2_Palette *palette) {
+	unsigned int scores[2] = { 0, 0 }, half, colorIndex, component;
+	for (half = 0; half < 4; ++half) {
+		unsigned int pixelCount = 0, squaredLength = 0;
+		for (component = 0; component < 3; ++component) {
+			int sum = 0;
+			pixelCount = 0;
+			for (colorIndex = 0; colorIndex < 4; ++colorIndex) {
+				sum += (int) palette->halfCounts[half][colorIndex] * palette->colors[colorIndex][component];
+				pixelCount += palette->halfCounts[half][colorIndex];
+			}
+			squaredLength += (unsigned int) (sum * sum);
+		}
+		if (pixelCount != 0) {
+			scores[half >> 1] += squaredLength / pixelCount;
+		}
+	}
+	return scores[1] > scores[0];
+}
+
+// Split of the used colors for a single T or H attempt: the black of the black mode alone, as it's off the line of the
+// other colors, or otherwise the line cut in the middle. At least two colors must be used.
+static unsigned int S3TConv_ETC2_GetDirectGroupMask(const S3TConv_ETC2_Palette *palette) {
+	static const unsigned int lineOrders[2][4] = { { 0, 2, 1, 3 }, { 0, 2, 3, 1 } };
+	const unsigned int *lineOrder = lineOrders[palette->isFourColor ? 1 : 0];
+	unsigned int usedMask = palette->usedMask, groupMask = 0, colorCount, orderIndex;
+
+	if (!palette->isFourColor && (usedMask & 8)) {
+		return 8;
+	}
+	colorCount = (usedMask & 1) + ((usedMask >> 1) & 1) + ((usedMask >> 2) & 1) + ((usedMask >> 3) & 1);
+	colorCount >>= 1;
+	for (orderIndex = 0; colorCount != 0; ++orderIndex) {
+		if (usedMask & (1u << lineOrder[orderIndex])) {
+			groupMask |= 1u << lineOrder[orderIndex];
+			--colorCount;
+		}
+	}
+	return groupMask;
+}
+
+static void S3TConv_ETC2_ConvertRGBBlock(const uint8_t dxtBlock[8], int asDXT1, int punchthrough, S3TConv_Quality quality,
+		uint8_t etc2Block[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ETC2_Palette palette;
+	S3TConv_ETC2_Encoding encoding;
+	unsigned int usedMask;
+
+	S3TConv_ETC2_GetPalette(dxtBlock, asDXT1, punchthrough, quality, remainingWidth, remainingHeight, &palette);
+	usedMask = palette.usedMask;
+
+	// Fast path for solid opaque blocks that can be encoded exactly.
+	if (usedMask != 0 && (usedMask & (usedMask - 1)) == 0 && !palette.hasTransparentPixels) {
+		unsigned int colorIndex = (usedMask & 3 ? (usedMask & 1 ? 0 : 1) : (usedMask & 4 ? 2 : 3));
+		if (S3TConv_ETC2_EncodeSolid(&palette, palette.colors[colorIndex], &encoding)) {
+			S3TConv_ETC2_StoreBlock(&palette, &encoding, etc2Block);
+			return;
+		}
+	}
+
+	encoding.error = UINT_MAX;
+	if (quality != S3TCONV_QUALITY_HIGH) {
+		// One orientation chosen from the palette, and for the default quality, if the error is large, the T or the H
+		// mode with one split of the DXT colors.
+		S3TConv_ETC2_EncodeSubblocks(&palette, S3TConv_ETC2_ChooseFlip(&palette), &encoding);
+		if (quality != S3TCONV_QUALITY_FAST && encoding.error > S3TCONV_ETC2_GOOD_ERROR &&
+				(usedMask & (usedMask - 1)) != 0) {
+			S3TConv_ETC2_EncodeTHGroups(&palette, S3TConv_ETC2_GetDirectGroupMask(&palette), 1, &encoding);
+		}
+		S3TConv_ETC2_StoreBlock(&palette, &encoding, etc2Block);
+		return;
+	}
+
+	// Re-encoding from the DXT palette, stopping at the first exact encoding.
+	S3TConv_ETC2_EncodeSubblocks(&palette, 0, &encoding);
+	if (encoding.error != 0) {
+		S3TConv_ETC2_EncodeSubblocks(&palette, 1, &encoding);
+	}
+	// The other modes are much slower to search, so they're skipped if the error is already small.
+	if (encoding.error > S3TCONV_ETC2_GOOD_ERROR && (usedMask & (usedMask - 1)) != 0) {
+		S3TConv_ETC2_EncodeTH(&palette, &encoding);
+	}
+	if (encoding.error > S3TCONV_ETC2_GOOD_ERROR && palette.isFull && !palette.hasTransparentPixels) {
+		S3TConv_ETC2_EncodePlanar(&palette, &encoding);
+	}
+	S3TConv_ETC2_StoreBlock(&palette, &encoding, etc2Block);
+}
+
+void S3TConv_ETC2_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, int punchthrough, uint8_t etc2Block[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ETC2_ConvertRGBBlock(dxtBlock, asDXT1, punchthrough, S3TCONV_QUALITY_DEFAULT, etc2Block,
+			remainingWidth, remainingHeight);
+}
+
+void S3TConv_ETC2_RGBBlockFromDXTWithQuality(const uint8_t dxtBlock[8], int asDXT1, int punchthrough,
+		S3TConv_Quality quality, uint8_t etc2Block[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ETC2_ConvertRGBBlock(dxtBlock, asDXT1, punchthrough, quality, etc2Block, remainingWidth, remainingHeight);
+}
+
+// Decodes the RGB part of an ETC2 block, with the pixels in rows. Transparent pixels of RGB8A1 are marked in opaque.
+static void S3TConv_ETC2_DecodeRGBBlock(const uint8_t etc2Block[8], int punchthrough, int colors[16][3], int opaque[16]) {
+	uint64_t block = 0;
+	int baseColors[2][3], paintColors[4][3];
+	int differential, transparent, isTH = 0;
+	unsigned int byteIndex, component, pixel;
+
+	for (byteIndex = 0; byteIndex < 8; ++byteIndex) {
+		block = (block << 8) | etc2Block[byteIndex];
+	}
+	// In RGB8A1, the differential bit is the opaque bit instead, and pixels with the index 2 are transparent without it.
+	differential = (int) ((block >> 33) & 1);
+	transparent = (punchthrough && !differential);
+
+	if (!punchthrough && !differential) {
+		for (component = 0; component < 3; ++component) {
+			baseColors[0][component] = S3TConv_ETC2_Expand((int) ((block >> (60 - component * 8)) & 15), 4);
+			baseColors[1][component] = S3TConv_ETC2_Expand((int) ((block >> (56 - component * 8)) & 15), 4);
+		}
+	} else {
+		int quantizedColors[2][3], distance;
+		unsigned int distanceIndex;
+		switch (S3TConv_ETC2_GetMode(block)) {
+		case S3TCONV_ETC2_MODE_T:
+			quantizedColors[0][0] = (int) ((((block >> 59) & 3) << 2) | ((block >> 56) & 3));
+			quantizedColors[0][1] = (int) ((block >> 52) & 15);
+			quantizedColors[0][2] = (int) ((block >> 48) & 15);
+			quantizedColors[1][0] = (int) ((block >> 44) & 15);
+			quantizedColors[1][1] = (int) ((block >> 40) & 15);
+			quantizedColors[1][2] = (int) ((block >> 36) & 15);
+			distance = S3TConv_ETC2_Distances[(((block >> 34) & 3) << 1) | ((block >> 32) & 1)];
+			S3TConv_ETC2_ExpandColor(quantizedColors[0], 4, baseColors[0]);
+			S3TConv_ETC2_ExpandColor(quantizedColors[1], 4, baseColors[1]);
+			memcpy(paintColors[0], baseColors[0], sizeof(paintColors[0]));
+			S3TConv_ETC2_GetPaintColor(baseColors[1], distance, paintColors[1]);
+			memcpy(paintColors[2], baseColors[1], sizeof(paintColors[2]));
+			S3TConv_ETC2_GetPaintColor(baseColors[1], -distance, paintColors[3]);
+			isTH = 1;
+			break;
+		case S3TCONV_ETC2_MODE_H:
+			quantizedColors[0][0] = (int) ((block >> 59) & 15);
+			quantizedColors[0][1] = (int) ((((block >> 56) & 7) << 1) | ((block >> 52) & 1));
+			quantizedColors[0][2] = (int) ((((block >> 51) & 1) << 3) | ((block >> 47) & 7));
+			quantizedColors[1][0] = (int) ((block >> 43) & 15);
+			quantizedColors[1][1] = (int) ((block >> 39) & 15);
+			quantizedColors[1][2] = (int) ((block >> 35) & 15);
+			distanceIndex = (unsigned int) ((((block >> 34) & 1) << 2) | (((block >> 32) & 1) << 1));
+			distanceIndex |= (((quantizedColors[0][0] << 8) | (quantizedColors[0][1] << 4) | quantizedColors[0][2]) >=
+					((quantizedColors[1][0] << 8) | (quantizedColors[1][1] << 4) | quantizedColors[1][2]) ? 1 : 0);
+			distance = S3TConv_ETC2_Distances[distanceIndex];
+			S3TConv_ETC2_ExpandColor(quantizedColors[0], 4, baseColors[0]);
+			S3TConv_ETC2_ExpandColor(quantizedColors[1], 4, baseColors[1]);
+			S3TConv_ETC2_GetPaintColor(baseColors[0], distance, paintColors[0]);
+			S3TConv_ETC2_GetPaintColor(baseColors[0], -distance, paintColors[1]);
+			S3TConv_ETC2_GetPaintColor(baseColors[1], distance, paintColors[2]);
+			S3TConv_ETC2_GetPaintColor(baseColors[1], -distance, paintColors[3]);
+			isTH = 1;
+			break;
+		case S3TCONV_ETC2_MODE_PLANAR: {
+			// Always opaque, even in RGB8A1.
+			static const unsigned int bits[3] = { 6, 7, 6 };
+			int origins[3], horizontals[3], verticals[3];
+			origins[0] = (int) ((block >> 57) & 63);
+			origins[1] = (int) ((((block >> 56) & 1) << 6) | ((block >> 49) & 63));
+			origins[2] = (int) ((((block >> 48) & 1) << 5) | (((block >> 43) & 3) << 3) | ((block >> 39) & 7));
+			horizontals[0] = (int) ((((block >> 34) & 31) << 1) | ((block >> 32) & 1));
+			horizontals[1] = (int) ((block >> 25) & 127);
+			horizontals[2] = (int) ((block >> 19) & 63);
+			verticals[0] = (int) ((block >> 13) & 63);
+			verticals[1] = (int) ((block >> 6) & 127);
+			verticals[2] = (int) (block & 63);
+			for (component = 0; component < 3; ++component) {
+				int origin = S3TConv_ETC2_Expand(origins[component], bits[component]);
+				int horizontal = S3TConv_ETC2_Expand(horizontals[component], bits[component]) - origin;
+				int vertical = S3TConv_ETC2_Expand(verticals[component], bits[component]) - origin;
+				for (pixel = 0; pixel < 16; ++pixel) {
+					int value = (int) (pixel & 3) * horizontal + (int) (pixel >> 2) * vertical + 4 * origin + 2;
+					colors[pixel][component] = (value < 0 ? 0 : S3TConv_ETC2_Clamp255(value >> 2));
+				}
+			}
+			for (pixel = 0; pixel < 16; ++pixel) {
+				opaque[pixel] = 1;
+			}
+			return;
+		}
+		default:
+			for (component = 0; component < 3; ++component) {
+				int base = (int) ((block >> (59 - component * 8)) & 31);
+				int delta = ((int) ((block >> (56 - component * 8)) & 7) ^ 4) - 4;
+				baseColors[0][component] = S3TConv_ETC2_Expand(base, 5);
+				baseColors[1][component] = S3TConv_ETC2_Expand(base + delta, 5);
+			}
+			break;
+		}
+	}
+
+	for (pixel = 0; pixel < 16; ++pixel) {
+		unsigned int x = pixel & 3, y = pixel >> 2, bit = x * 4 + y;
+		unsigned int pixelIndex = (unsigned int) ((((block >> (16 + bit)) & 1) << 1) | ((block >> bit) & 1));
+		opaque[pixel] = (!transparent || pixelIndex != 2);
+		if (isTH) {
+			memcpy(colors[pixel], paintColors[pixelIndex], sizeof(colors[pixel]));
+		} else {
+			unsigned int subblock = (((block >> 32) & 1) ? y : x) >> 1;
+			unsigned int table = (unsigned int) ((block >> (subblock ? 34 : 37)) & 7);
+			int modifier = (transparent ? S3TConv_ETC2_PunchthroughModifiers : S3TConv_ETC2_Modifiers)[table][pixelIndex];
+			S3TConv_ETC2_GetPaintColor(baseColors[subblock], modifier, colors[pixel]);
+		}
+	}
+}
+
+unsigned int S3TConv_ETC2_GetRGBBlockError(const uint8_t dxtBlock[8], int asDXT1, int punchthrough,
+		const uint8_t etc2Block[8], unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_ETC2_Palette palette;
+	int colors[16][3], opaque[16];
+	unsigned int error = 0, pixel;
+
+	S3TConv_ETC2_GetPalette(dxtBlock, asDXT1, punchthrough, S3TCONV_QUALITY_DEFAULT, 4, 4, &palette);
+	S3TConv_ETC2_DecodeRGBBlock(etc2Block, punchthrough, colors, opaque);
+	for (pixel = 0; pixel < 16; ++pixel) {
+		int dxtIndex = (int) ((palette.indices >> (pixel << 1)) & 3);
+		if ((pixel & 3) >= remainingWidth || (pixel >> 2) >= remainingHeight) {
+			continue;
+		}
+		if (dxtIndex == palette.transparentIndex || !opaque[pixel]) {
+			// Transparency must be kept exactly, the colors of transparent pixels don't matter.
+			error += (dxtIndex == palette.transparentIndex) == !opaque[pixel] ? 0 : 3 * 255 * 255;
+			continue;
+		}
+		error += S3TConv_ETC2_GetSquaredDistance(palette.colors[dxtIndex], colors[pixel]);
+	}
+	return error;
+}
+
+static unsigned int S3TConv_ETC2_GetAlphaError(const int *values, const unsigned int *counts, unsigned int valueCount,
+		int base, int multiplier, const int modifiers[8]) {
+	unsigned int valueIndex, pixelIndex, error = 0;
+	for (valueIndex = 0; valueIndex < valueCount; ++valueIndex) {
+		unsigned int bestValueError = UINT_MAX;
+		for (pixelIndex = 0; pixelIndex < 8; ++pixelIndex) {
+			int difference = S3TConv_ETC2_Clamp255(base + multiplier * modifiers[pixelIndex]) - values[valueIndex];
+			if ((unsigned int) (difference * difference) < bestValueError) {
+				bestValueError = (unsigned int) (difference * difference);
+			}
+		}
+		error += counts[valueIndex] * bestValueError;
+	}
+	return error;
+}
+
+void S3TConv_ETC2_AlphaBlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, uint8_t eacBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	int alphas[16], values[16], minValue = 255, maxValue = 0, base, multiplier;
+	unsigned int counts[16], valueCount = 0, table;
+	unsigned int width = (remainingWidth < 4 ? remainingWidth : 4), height = (remainingHeight < 4 ? remainingHeight : 4);
+	unsigned int x, y, valueIndex, byteIndex;
+	uint64_t block;
+
+	S3TConv_DXT_GetAlphas(dxtBlock, dxtFormat, alphas);
+	for (y = 0; y < height; ++y) {
+		for (x = 0; x < width; ++x) {
+			int alpha = alphas[y * 4 + x];
+			for (valueIndex = 0; valueIndex < valueCount && values[valueIndex] != alpha; ++valueIndex) {}
+			if (valueIndex == valueCount) {
+				values[valueCount] = alpha;
+				counts[valueCount++] = 0;
+			}
+			++counts[valueIndex];
+			minValue = (alpha < minValue ? alpha : minValue);
+			maxValue = (alpha > maxValue ? alpha : maxValue);
+		}
+	}
+
+	if (valueCount <= 1) {
+		// Solid, exact with the zero multiplier.
+		base = (valueCount != 0 ? values[0] : 255);
+		multiplier = 0;
+		table = 0;
+	} else if (valueCount == 2 && minValue == 0 && maxValue == 255) {
+		// Punch-through, 128 + 15 * -15 and 128 + 15 * 14 are clamped to 0 and 255.
+		base = 128;
+		multiplier = 15;
+		table = 0;
+	} else {
+		unsigned int bestError = UINT_MAX, tableIndex;
+		int bestBase = 0, bestMultiplier = 1, baseOffset, multiplierOffset;
+		table = 0;
+		// Every table scaled to the range of the values.
+		for (tableIndex = 0; tableIndex < 16 && bestError != 0; ++tableIndex) {
+			const int *modifiers = S3TConv_ETC2_AlphaModifiers[tableIndex];
+			int span = modifiers[7] - modifiers[3];
+			unsigned int error;
+			multiplier = (maxValue - minValue + (span >> 1)) / span;
+			multiplier = (multiplier < 1 ? 1 : (multiplier > 15 ? 15 : multiplier));
+			base = S3TConv_ETC2_Clamp255((minValue + maxValue - (modifiers[3] + modifiers[7]) * multiplier + 1) >> 1);
+			error = S3TConv_ETC2_GetAlphaError(values, counts, valueCount, base, multiplier, modifiers);
+			if (error < bestError) {
+				bestError = error;
+				bestBase = base;
+				bestMultiplier = multiplier;
+				table = tableIndex;
+			}
+		}
+		// Refinement of the best one.
+		base = bestBase;
+		multiplier = bestMultiplier;
+		for (multiplierOffset = -1; multiplierOffset <= 1 && bestError != 0; ++multiplierOffset) {
+			int refinedMultiplier = multiplier + multiplierOffset;
+			if (refinedMultiplier < 1 || refinedMultiplier > 15) {
+				continue;
+			}
+			for (baseOffset = -2; baseOffset <= 2; ++baseOffset) {
+				int refinedBase = S3TConv_ETC2_Clamp255(base + baseOffset);
+				unsigned int error = S3TConv_ETC2_GetAlphaError(values, counts, valueCount,
+						refinedBase, refinedMultiplier, S3TConv_ETC2_AlphaModifiers[table]);
+				if (error < bestError) {
+					bestError = error;
+					bestBase = refinedBase;
+					bestMultiplier = refinedMultiplier;
+				}
+			}
+		}
+		base = bestBase;
+		multiplier = bestMultiplier;
+	}
+
+	block = ((uint64_t) base << 56) | ((uint64_t) multiplier << 52) | ((uint64_t) table << 48);
+	for (y = 0; y < 4; ++y) {
+		for (x = 0; x < 4; ++x) {
+			int alpha = alphas[y * 4 + x], bestDifference = INT_MAX;
+			unsigned int pixelIndex, bestPixelIndex = 0;
+			for (pixelIndex = 0; pixelIndex < 8; ++pixelIndex) {
+				int difference = S3TConv_ETC2_Clamp255(base + multiplier * S3TConv_ETC2_AlphaModifiers[table][pixelIndex]) - alpha;
+				difference = (difference >= 0 ? difference : -difference);
+				if (difference < bestDifference) {
+					bestDifference = difference;
+					bestPixelIndex = pixelIndex;
+				}
+			}
+			block |= (uint64_t) bestPixelIndex << (45 - 3 * (x * 4 + y));
+		}
+	}
+	for (byteIndex = 0; byteIndex < 8; ++byteIndex) {
+		eacBlock[byteIndex] = (uint8_t) (block >> (56 - byteIndex * 8));
+	}
+}
+
+static void S3TConv_ETC2_ConvertRGBBlockWithCache(S3TConv_BlockCache *cache,
+		const uint8_t dxtBlock[8], int asDXT1, int punchthrough, S3TConv_Quality quality, uint8_t etc2Block[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint64_t sourceBlock;
+	unsigned int state, entryIndex;
+
+	if (cache == NULL) {
+		S3TConv_ETC2_ConvertRGBBlock(dxtBlock, asDXT1, punchthrough, quality, etc2Block, remainingWidth, remainingHeight);
+		return;
+	}
+	// punchthrough and quality are the same for the whole lifetime of the cache.
+	memcpy(&sourceBlock, dxtBlock, 8);
+	state = S3TConv_BlockCache_GetState(asDXT1, remainingWidth, remainingHeight);
+	if (S3TConv_BlockCache_Find(cache, sourceBlock, state, &entryIndex)) {
+		memcpy(etc2Block, cache->targetBlocks[entryIndex], 8);
+		return;
+	}
+	S3TConv_ETC2_ConvertRGBBlock(dxtBlock, asDXT1, punchthrough, quality, etc2Block, remainingWidth, remainingHeight);
+	S3TConv_BlockCache_Store(cache, entryIndex, sourceBlock, state, etc2Block);
+}
+
+int S3TConv_ETC2_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format etc2Format) {
+	switch (etc2Format) {
+	case S3TCONV_FORMAT_ETC2_RGB:
+	case S3TCONV_FORMAT_ETC2_RGBA:
+		return dxtFormat == S3TCONV_FORMAT_DXT1 || dxtFormat == S3TCONV_FORMAT_DXT3 || dxtFormat == S3TCONV_FORMAT_DXT5;
+	case S3TCONV_FORMAT_ETC2_RGB8A1:
+		return dxtFormat == S3TCONV_FORMAT_DXT1;
+	default:
+		break;
+	}
+	return 0;
+}
+
+void S3TConv_ETC2_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality,
+		uint8_t *etc2Row, S3TConv_Format etc2Format, unsigned int blockCount,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_BlockCache *cache) {
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	unsigned int etc2BlockSize = S3TConv_Format_GetBlockSize(etc2Format);
+	int punchthrough = (etc2Format == S3TCONV_FORMAT_ETC2_RGB8A1);
+	unsigned int blockIndex;
+
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		const uint8_t *dxtBlock = dxtRow + blockIndex * dxtBlockSize;
+		uint8_t *etc2Block = etc2Row + blockIndex * etc2BlockSize;
+		unsigned int blockLeft = blockIndex << 2;
+		unsigned int blockWidth = (remainingWidth > blockLeft ? remainingWidth - blockLeft : 0);
+		// Written after the color, which may be converted in place.
+		uint8_t eacBlock[8];
+		if (etc2Format == S3TCONV_FORMAT_ETC2_RGBA) {
+			S3TConv_ETC2_AlphaBlockFromDXT(dxtBlock, dxtFormat, eacBlock, blockWidth, remainingHeight);
+		}
+		S3TConv_ETC2_ConvertRGBBlockWithCache(cache, dxtBlock + (dxtBlockSize - 8), asDXT1, punchthrough, quality,
+				etc2Block + (etc2BlockSize - 8), blockWidth, remainingHeight);
+		if (etc2Format == S3TCONV_FORMAT_ETC2_RGBA) {
+			memcpy(etc2Block, eacBlock, 8);
+		}
+	}
+}
+
+int S3TConv_ETC2_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *etc2Data, S3TConv_Format etc2Format, size_t etc2RowPitch,
+		unsigned int width, unsigned int height) {
+	S3TConv_Surface surface;
+
+	if (!S3TConv_ETC2_IsConversionFromDXTSupported(dxtFormat, etc2Format)) {
+		return 0;
+	}
+
+	surface.sourceData = dxtData;
+	surface.sourceFormat = dxtFormat;
+	surface.asDXT1 = asDXT1;
+	surface.sourceRowPitch = dxtRowPitch;
+	surface.targetData = etc2Data;
+	surface.targetFormat = etc2Format;
+	surface.targetRowPitch = etc2RowPitch;
+	surface.width = width;
+	surface.height = height;
+	surface.useBlockCache = 0;
+	surface.quality = S3TCONV_QUALITY_DEFAULT;
+	surface.stats = NULL;
+	S3TConv_Surface_ConvertBlockRows(&surface, 0, (height + 3) >> 2, NULL);
+	return 1;
+}
@@ -0,0 +1,606 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+//
+// Hashing (XXH64).
+//
+
+#define S3TCONV_HASH64_PRIME1 0x9E3779B185EBCA87ull
+#define S3TCONV_HASH64_PRIME2 0xC2B2AE3D27D4EB4Full
+#define S3TCONV_HASH64_PRIME3 0x165667B19E3779F9ull
+#define S3TCONV_HASH64_PRIME4 0x85EBCA77C2B2AE63ull
+#define S3TCONV_HASH64_PRIME5 0x27D4EB2F165667C5ull
+
+static inline uint64_t S3TConv_Hash64_Rotate(uint64_t value, unsigned int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian like the rest of the library, so hashes are the same on all supported CPUs.
+static inline uint64_t S3TConv_Hash64_Read64(const uint8_t *data) {
+	uint64_t value;
+	memcpy(&value, data, 8);
+	return value;
+}
+
+static inline uint32_t S3TConv_Hash64_Read32(const uint8_t *data) {
+	uint32_t value;
+	memcpy(&value, data, 4);
+	return value;
+}
+
+static inline uint64_t S3TConv_Hash64_Round(uint64_t accumulator, uint64_t input) {
+	accumulator += input * S3TCONV_HASH64_PRIME2;
+	return S3TConv_Hash64_Rotate(accumulator, 31) * S3TCONV_HASH64_PRIME1;
+}
+
+static inline uint64_t S3TConv_Hash64_MergeRound(uint64_t accumulator, uint64_t value) {
+	accumulator ^= S3TConv_Hash64_Round(0, value);
+	return accumulator * S3TCONV_HASH64_PRIME1 + S3TCONV_HASH64_PRIME4;
+}
+
+uint64_t S3TConv_Hash64(const void *data, size_t size, uint64_t seed) {
+	const uint8_t *bytes = (const uint8_t *) data, *end = bytes + size;
+	uint64_t hash;
+
+	if (size >= 32) {
+		// 4 independent lanes of 8 bytes.
+		uint64_t lane0 = seed + S3TCONV_HASH64_PRIME1 + S3TCONV_HASH64_PRIME2;
+		uint64_t lane1 = seed + S3TCONV_HASH64_PRIME2;
+		uint64_t lane2 = seed;
+		uint64_t lane3 = seed - S3TCONV_HASH64_PRIME1;
+		const uint8_t *lastStripe = end - 32;
+		do {
+			lane0 = S3TConv_Hash64_Round(lane0, S3TConv_Hash64_Read64(bytes));
+			lane1 = S3TConv_Hash64_Round(lane1, S3TConv_Hash64_Read64(bytes + 8));
+			lane2 = S3TConv_Hash64_Round(lane2, S3TConv_Hash64_Read64(bytes + 16));
+			lane3 = S3TConv_Hash64_Round(lane3, S3TConv_Hash64_Read64(bytes + 24));
+			bytes += 32;
+		} while (bytes <= lastStripe);
+		hash = S3TConv_Hash64_Rotate(lane0, 1) + S3TConv_Hash64_Rotate(lane1, 7) +
+				S3TConv_Hash64_Rotate(lane2, 12) + S3TConv_Hash64_Rotate(lane3, 18);
+		hash = S3TConv_Hash64_MergeRound(hash, lane0);
+		hash = S3TConv_Hash64_MergeRound(hash, lane1);
+		hash = S3TConv_Hash64_MergeRound(hash, lane2);
+		hash = S3TConv_Hash64_MergeRound(hash, lane3);
+	} else {
+		hash = seed + S3TCONV_HASH64_PRIME5;
+	}
+	hash += (uint64_t) size;
+
+	for (; bytes + 8 <= end; bytes += 8) {
+		hash ^= S3TConv_Hash64_Round(0, S3TConv_Hash64_Read64(bytes));
+		hash = S3TConv_Hash64_Rotate(hash, 27) * S3TCONV_HASH64_PRIME1 + S3TCONV_HASH64_PRIME4;
+	}
+	if (bytes + 4 <= end) {
+		hash ^= (uint64_t) S3TConv_Hash64_Read32(bytes) * S3TCONV_HASH64_PRIME1;
+		hash = S3TConv_Hash64_Rotate(hash, 23) * S3TCONV_HASH64_PRIME2 + S3TCONV_HASH64_PRIME3;
+		bytes += 4;
+	}
+	for (; bytes < end; ++bytes) {
+		hash ^= *bytes * S3TCONV_HASH64_PRIME5;
+		hash = S3TConv_Hash64_Rotate(hash, 11) * S3TCONV_HASH64_PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= S3TCONV_HASH64_PRIME2;
+	hash ^= hash >> 29;
+	hash *= S3TCONV_HASH64_PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+//
+// Cache file.
+//
+// Layout (little-endian):
+// - Header (64 bytes):
+//   - 0: "S3TCache".
+//   - 8: Version of the file layout.
+//   - 12: S3TCONV_VERSION.
+//   - 16: Number of entries.
+//   - 20: Generation, incremented every time the file is written.
+//   - 24: Size of the whole file, to detect truncation.
+//   - 32: Hash of the first 32 bytes of the header and of the index.
+//   - 40: Reserved, 0.
+// - Index, sorted by the key (56 bytes per entry):
+//   - 0: Source hash.
+//   - 8: Source size.
+//   - 16: Target format.
+//   - 20: Parameters.
+//   - 24: Offset of the data in the file.
+//   - 32: Size of the data.
+//   - 40: Hash of the data.
+//   - 48: Generation when the entry was last used.
+//   - 52: Reserved, 0.
+// - Data of the entries, each aligned to 16 bytes.
+//
+
+#define S3TCONV_FILECACHE_LAYOUT_VERSION 1
+#define S3TCONV_FILECACHE_HEADER_SIZE 64
+#define S3TCONV_FILECACHE_ENTRY_SIZE 56
+#define S3TCONV_FILECACHE_DATA_ALIGNMENT 16
+// Generations since the saved last use of a found entry after which the file is rewritten even if nothing was added
+// or removed, so entries that are in use aren't evicted in favor of ones added since.
+#define S3TCONV_FILECACHE_MAX_USE_AGE 4
+
+static const uint8_t S3TConv_FileCache_Magic[8] = { 'S', '3', 'T', 'C', 'a', 'c', 'h', 'e' };
+
+typedef enum {
+	S3TCONV_FILECACHE_ENTRY_UNCHECKED,
+	S3TCONV_FILECACHE_ENTRY_VALID,
+	// Corrupted or replaced, not found anymore and not written.
+	S3TCONV_FILECACHE_ENTRY_REMOVED
+} S3TConv_FileCache_EntryState;
+
+typedef struct {
+	S3TConv_FileCacheKey key;
+	const uint8_t *data;
+	uint64_t dataSize;
+	uint64_t dataHash;
+	uint32_t lastUsedGeneration;
+	S3TConv_FileCache_EntryState state;
+} S3TConv_FileCache_Entry;
+
+struct S3TConv_FileCache {
+	char *path;
+	uint64_t maxSize;
+	S3TConv_MappedFile file;
+	int isFileMapped;
+	// Generation of the file that will be written.
+	uint32_t generation;
+	// Entries of the file (sorted by the key) followed by the added ones, which own their data.
+	S3TConv_FileCache_Entry *entries;
+	unsigned int fileEntryCount, entryCount, entryCapacity;
+	int isModified;
+};
+
+static inline uint32_t S3TConv_FileCache_Read32(const uint8_t *data) {
+	return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static inline uint64_t S3TConv_FileCache_Read64(const uint8_t *data) {
+	return (uint64_t) S3TConv_FileCache_Read32(data) | ((uint64_t) S3TConv_FileCache_Read32(data + 4) << 32);
+}
+
+static inline void S3TConv_FileCache_Write32(uint8_t *data, uint32_t value) {
+	data[0] = (uint8_t) value;
+	data[1] = (uint8_t) (value >> 8);
+	data[2] = (uint8_t) (value >> 16);
+	data[3] = (uint8_t) (value >> 24);
+}
+
+static inline void S3TConv_FileCache_Write64(uint8_t *data, uint64_t value) {
+	S3TConv_FileCache_Write32(data, (uint32_t) value);
+	S3TConv_FileCache_Write32(data + 4, (uint32_t) (value >> 32));
+}
+
+static inline uint64_t S3TConv_FileCache_AlignData(uint64_t offset) {
+	return (offset + (S3TCONV_FILECACHE_DATA_ALIGNMENT - 1)) & ~(uint64_t) (S3TCONV_FILECACHE_DATA_ALIGNMENT - 1);
+}
+
+static int S3TConv_FileCache_CompareKeys(const S3TConv_FileCacheKey *key1, const S3TConv_FileCacheKey *key2) {
+	if (key1->sourceHash != key2->sourceHash) {
+		return key1->sourceHash < key2->sourceHash ? -1 : 1;
+	}
+	if (key1->sourceSize != key2->sourceSize) {
+		return key1->sourceSize < key2->sourceSize ? -1 : 1;
+	}
+	if (key1->targetFormat != key2->targetFormat) {
+		return (unsigned int) key1->targetFormat < (unsigned int) key2->targetFormat ? -1 : 1;
+	}
+	if (key1->parameters != key2->parameters) {
+		return key1->parameters < key2->parameters ? -1 : 1;
+	}
+	return 0;
+}
+
+static int S3TConv_FileCache_CompareEntryKeys(const void *entry1, const void *entry2) {
+	return S3TConv_FileCache_CompareKeys(&((const S3TConv_FileCache_Entry *) entry1)->key,
+			&((const S3TConv_FileCache_Entry *) entry2)->key);
+}
+
+static int S3TConv_FileCache_CompareEntryPointerKeys(const void *entry1, const void *entry2) {
+	return S3TConv_FileCache_CompareKeys(&(*(const S3TConv_FileCache_Entry * const *) entry1)->key,
+			&(*(const S3TConv_FileCache_Entry * const *) entry2)->key);
+}
+
+// Most recently used first.
+static int S3TConv_FileCache_CompareEntryUse(const void *entry1, const void *entry2) {
+	uint32_t generation1 = (*(const S3TConv_FileCache_Entry * const *) entry1)->lastUsedGeneration;
+	uint32_t generation2 = (*(const S3TConv_FileCache_Entry * const *) entry2)->lastUsedGeneration;
+	return generation1 != generation2 ? (generation1 > generation2 ? -1 : 1) : 0;
+}
+
+static int S3TConv_FileCache_ReserveEntries(S3TConv_FileCache *cache, unsigned int entryCount) {
+	S3TConv_FileCache_Entry *entries;
+	unsigned int entryCapacity;
+	if (entryCount <= cache->entryCapacity) {
+		return 1;
+	}
+	entryCapacity = (cache->entryCapacity != 0 ? cache->entryCapacity : 16);
+	while (entryCapacity < entryCount) {
+		entryCapacity <<= 1;
+	}
+	entries = (S3TConv_FileCache_Entry *) realloc(cache->entries, entryCapacity * sizeof(S3TConv_FileCache_Entry));
+	if (entries == NULL) {
+		return 0;
+	}
+	cache->entries = entries;
+	cache->entryCapacity = entryCapacity;
+	return 1;
+}
+
+// Reads the index of the mapped file, returns 0 if it's corrupted or stale.
+static int S3TConv_FileCache_ReadIndex(S3TConv_FileCache *cache) {
+	const uint8_t *fileData = cache->file.data;
+	uint64_t fileSize = cache->file.size, dataStart;
+	unsigned int entryCount, entryIndex;
+
+	if (fileSize < S3TCONV_FILECACHE_HEADER_SIZE || memcmp(fileData, S3TConv_FileCache_Magic, 8) != 0 ||
+			S3TConv_FileCache_Read32(fileData + 8) != S3TCONV_FILECACHE_LAYOUT_VERSION ||
+			S3TConv_FileCache_Read32(fileData + 12) != S3TCONV_VERSION ||
+			S3TConv_FileCache_Read64(fileData + 24) != fileSize) {
+		return 0;
+	}
+	entryCount = S3TConv_FileCache_Read32(fileData + 16);
+	if (entryCount > (fileSize - S3TCONV_FILECACHE_HEADER_SIZE) / S3TCONV_FILECACHE_ENTRY_SIZE) {
+		return 0;
+	}
+	if (S3TConv_Hash64(fileData + S3TCONV_FILECACHE_HEADER_SIZE, (size_t) entryCount * S3TCONV_FILECACHE_ENTRY_SIZE,
+			S3TConv_Hash64(fileData, 32, 0)) != S3TConv_FileCache_Read64(fileData + 32)) {
+		return 0;
+	}
+	if (!S3TConv_FileCache_ReserveEntries(cache, entryCount)) {
+		return 0;
+	}
+
+	dataStart = S3TCONV_FILECACHE_HEADER_SIZE + (uint64_t) entryCount * S3TCONV_FILECACHE_ENTRY_SIZE;
+	for (entryIndex = 0; entryIndex < entryCount; ++entryIndex) {
+		const uint8_t *entryData = fileData + S3TCONV_FILECACHE_HEADER_SIZE + entryIndex * S3TCONV_FILECACHE_ENTRY_SIZE;
+		S3TConv_FileCache_Entry *entry = &cache->entries[entryIndex];
+		uint64_t dataOffset = S3TConv_FileCache_Read64(entryData + 24);
+		entry->key.sourceHash = S3TConv_FileCache_Read64(entryData);
+		entry->key.sourceSize = S3TConv_FileCache_Read64(entryData + 8);
+		entry->key.targetFormat = (S3TConv_Format) S3TConv_FileCache_Read32(entryData + 16);
+		entry->key.parameters = S3TConv_FileCache_Read32(entryData + 20);
+		entry->dataSize = S3TConv_FileCache_Read64(entryData + 32);
+		entry->dataHash = S3TConv_FileCache_Read64(entryData + 40);
+		entry->lastUsedGeneration = S3TConv_FileCache_Read32(entryData + 48);
+		entry->state = S3TCONV_FILECACHE_ENTRY_UNCHECKED;
+		if (dataOffset < dataStart || dataOffset > fileSize || entry->dataSize > fileSize - dataOffset ||
+				(entryIndex != 0 && S3TConv_FileCache_CompareEntryKeys(entry - 1, entry) >= 0)) {
+			return 0;
+		}
+		entry->data = fileData + dataOffset;
+	}
+	cache->fileEntryCount = cache->entryCount = entryCount;
+	cache->generation = S3TConv_FileCache_Read32(fileData + 20) + 1;
+	return 1;
+}
+
+S3TConv_FileCache *S3TConv_FileCache_Open(const char *path, uint64_t maxSize) {
+	S3TConv_FileCache *cache;
+	size_t pathLength = strlen(path);
+
+	cache = (S3TConv_FileCache *) malloc(sizeof(S3TConv_FileCache));
+	if (cache == NULL) {
+		return NULL;
+	}
+	memset(cache, 0, sizeof(S3TConv_FileCache));
+	cache->maxSize = maxSize;
+	cache->generation = 1;
+	cache->path = (char *) malloc(pathLength + 1);
+	if (cache->path == NULL) {
+		free(cache);
+		return NULL;
+	}
+	memcpy(cache->path, path, pathLength + 1);
+
+	cache->isFileMapped = S3TConv_MappedFile_Open(&cache->file, path);
+	if (cache->isFileMapped && !S3TConv_FileCache_ReadIndex(cache)) {
+		// Treated as empty, replaced when anything is added.
+		cache->fileEntryCount = cache->entryCount = 0;
+		cache->generation = 1;
+		S3TConv_MappedFile_Close(&cache->file);
+		cache->isFileMapped = 0;
+	}
+	return cache;
+}
+
+static S3TConv_FileCache_Entry *S3TConv_FileCache_FindEntry(S3TConv_FileCache *cache, const S3TConv_FileCacheKey *key) {
+	S3TConv_FileCache_Entry keyEntry, *entry;
+	unsigned int entryIndex;
+
+	// Added entries replace the ones in the file, and the latest additions replace the earlier ones.
+	for (entryIndex = cache->entryCount; entryIndex > cache->fileEntryCount; --entryIndex) {
+		entry = &cache->entries[entryIndex - 1];
+		if (entry->state != S3TCONV_FILECACHE_ENTRY_REMOVED && S3TConv_FileCache_CompareKeys(&entry->key, key) == 0) {
+			return entry;
+		}
+	}
+	if (cache->fileEntryCount == 0) {
+		return NULL;
+	}
+	keyEntry.key = *key;
+	entry = (S3TConv_FileCache_Entry *) bsearch(&keyEntry, cache->entries, cache->fileEntryCount,
+			sizeof(S3TConv_FileCache_Entry), S3TConv_FileCache_CompareEntryKeys);
+	return (entry != NULL && entry->state != S3TCONV_FILECACHE_ENTRY_REMOVED) ? entry : NULL;
+}
+
+const uint8_t *S3TConv_FileCache_Find(S3TConv_FileCache *cache, const S3TConv_FileCacheKey *key, size_t *dataSize) {
+	S3TConv_FileCache_Entry *entry = S3TConv_FileCache_FindEntry(cache, key);
+	if (entry == NULL) {
+		return NULL;
+	}
+	if (entry->state == S3TCONV_FILECACHE_ENTRY_UNCHECKED) {
+		if (entry->dataSize > (size_t) -1 || S3TConv_Hash64(entry->data, (size_t) entry->dataSize, 0) != entry->dataHash) {
+			entry->state = S3TCONV_FILECACHE_ENTRY_REMOVED;
+			cache->isModified = 1;
+			return NULL;
+		}
+		entry->state = S3TCONV_FILECACHE_ENTRY_VALID;
+	}
+	if (cache->generation - entry->lastUsedGeneration > S3TCONV_FILECACHE_MAX_USE_AGE) {
+		cache->isModified = 1;
+	}
+	entry->lastUsedGeneration = cache->generation;
+	*dataSize = (size_t) entry->dataSize;
+	return entry->data;
+}
+
+int S3TConv_FileCache_Add(S3TConv_FileCache *cache, const S3TConv_FileCacheKey *key, const void *data, size_t dataSize) {
+	S3TConv_FileCache_Entry *entry;
+	uint8_t *entryData;
+
+	if (S3TCONV_FILECACHE_HEADER_SIZE + S3TCONV_FILECACHE_ENTRY_SIZE + S3TConv_FileCache_AlignData(dataSize) > cache->maxSize ||
+			!S3TConv_FileCache_ReserveEntries(cache, cache->entryCount + 1)) {
+		return 0;
+	}
+	entryData = (uint8_t *) malloc(dataSize != 0 ? dataSize : 1);
+	if (entryData == NULL) {
+		return 0;
+	}
+	memcpy(entryData, data, dataSize);
+
+	entry = S3TConv_FileCache_FindEntry(cache, key);
+	if (entry != NULL) {
+		entry->state = S3TCONV_FILECACHE_ENTRY_REMOVED;
+		if (entry >= cache->entries + cache->fileEntryCount) {
+			free((void *) entry->data);
+			entry->data = NULL;
+		}
+	}
+
+	entry = &cache->entries[cache->entryCount++];
+	entry->key = *key;
+	entry->data = entryData;
+	entry->dataSize = dataSize;
+	entry->dataHash = S3TConv_Hash64(entryData, dataSize, 0);
+	entry->lastUsedGeneration = cache->generation;
+	entry->state = S3TCONV_FILECACHE_ENTRY_VALID;
+	cache->isModified = 1;
+	return 1;
+}
+
+// Writes the entries that fit in the maximum size to a temporary file and replaces the cache file with it.
+static int S3TConv_FileCache_Write(S3TConv_FileCache *cache) {
+	S3TConv_FileCache_Entry **entries;
+	uint8_t *index, header[S3TCONV_FILECACHE_HEADER_SIZE];
+	static const uint8_t padding[S3TCONV_FILECACHE_DATA_ALIGNMENT] = { 0 };
+	unsigned int entryCount = 0, writtenEntryCount = 0, entryIndex;
+	uint64_t fileSize, dataOffset;
+	size_t temporaryPathSize = strlen(cache->path) + 64;
+	char *temporaryPath;
+	FILE *file;
+	int written;
+
+	entries = (S3TConv_FileCache_Entry **) malloc((cache->entryCount != 0 ? cache->entryCount : 1) *
+			sizeof(S3TConv_FileCache_Entry *));
+	index = (uint8_t *) malloc((size_t) (cache->entryCount != 0 ? cache->entryCount : 1) * S3TCONV_FILECACHE_ENTRY_SIZE);
+	temporaryPath = (char *) malloc(temporaryPathSize);
+	if (entries == NULL || index == NULL || temporaryPath == NULL) {
+		free(temporaryPath);
+		free(index);
+		free(entries);
+		return 0;
+	}
+	// Unique for every process and cache, so caches written at the same time don't overwrite each other's files.
+	snprintf(temporaryPath, temporaryPathSize, "%s.%lu.%llx.tmp", cache->path,
+#ifdef _WIN32
+			(unsigned long) GetCurrentProcessId(),
+#else
+			(unsigned long) getpid(),
+#endif
+			(unsigned long long) (uintptr_t) cache);
+
+	// Keeping the most recently used entries that fit, then sorting them by the key for lookups.
+	for (entryIndex = 0; entryIndex < cache->entryCount; ++entryIndex) {
+		if (cache->entries[entryIndex].state != S3TCONV_FILECACHE_ENTRY_REMOVED) {
+			entries[entryCount++] = &cache->entries[entryIndex];
+		}
+	}
+	qsort(entries, entryCount, sizeof(S3TConv_FileCache_Entry *), S3TConv_FileCache_CompareEntryUse);
+	fileSize = S3TCONV_FILECACHE_HEADER_SIZE;
+	for (entryIndex = 0; entryIndex < entryCount; ++entryIndex) {
+		uint64_t entrySize = S3TCONV_FILECACHE_ENTRY_SIZE + S3TConv_FileCache_AlignData(entries[entryIndex]->dataSize);
+		if (fileSize + entrySize <= cache->maxSize) {
+			entries[writtenEntryCount++] = entries[entryIndex];
+			fileSize += entrySize;
+		}
+	}
+	qsort(entries, writtenEntryCount, sizeof(S3TConv_FileCache_Entry *), S3TConv_FileCache_CompareEntryPointerKeys);
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, S3TConv_FileCache_Magic, 8);
+	S3TConv_FileCache_Write32(header + 8, S3TCONV_FILECACHE_LAYOUT_VERSION);
+	S3TConv_FileCache_Write32(header + 12, S3TCONV_VERSION);
+	S3TConv_FileCache_Write32(header + 16, writtenEntryCount);
+	S3TConv_FileCache_Write32(header + 20, cache->generation);
+	S3TConv_FileCache_Write64(header + 24, fileSize);
+	dataOffset = S3TCONV_FILECACHE_HEADER_SIZE + (uint64_t) writtenEntryCount * S3TCONV_FILECACHE_ENTRY_SIZE;
+	for (entryIndex = 0; entryIndex < writtenEntryCount; ++entryIndex) {
+		const S3TConv_FileCache_Entry *entry = entries[entryIndex];
+		uint8_t *entryData = index + entryIndex * S3TCONV_FILECACHE_ENTRY_SIZE;
+		S3TConv_FileCache_Write64(entryData, entry->key.sourceHash);
+		S3TConv_FileCache_Write64(entryData + 8, entry->key.sourceSize);
+		S3TConv_FileCache_Write32(entryData + 16, (uint32_t) entry->key.targetFormat);
+		S3TConv_FileCache_Write32(entryData + 20, entry->key.parameters);
+		S3TConv_FileCache_Write64(entryData + 24, dataOffset);
+		S3TConv_FileCache_Write64(entryData + 32, entry->dataSize);
+		S3TConv_FileCache_Write64(entryData + 40, entry->dataHash);
+		S3TConv_FileCache_Write32(entryData + 48, entry->lastUsedGeneration);
+		S3TConv_FileCache_Write32(entryData + 52, 0);
+		dataOffset += S3TConv_FileCache_AlignData(entry->dataSize);
+	}
+	S3TConv_FileCache_Write64(header + 32, S3TConv_Hash64(index, (size_t) writtenEntryCount * S3TCONV_FILECACHE_ENTRY_SIZE,
+			S3TConv_Hash64(header, 32, 0)));
+
+	written = 0;
+	file = fopen(temporaryPath, "wb");
+	if (file != NULL) {
+		written = (fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+				fwrite(index, S3TCONV_FILECACHE_ENTRY_SIZE, writtenEntryCount, file) == writtenEntryCount);
+		for (entryIndex = 0; written && entryIndex < writtenEntryCount; ++entryIndex) {
+			size_t dataSize = (size_t) entries[entryIndex]->dataSize;
+			size_t paddingSize = (size_t) (S3TConv_FileCache_AlignData(dataSize) - dataSize);
+			written = (fwrite(entries[entryIndex]->data, 1, dataSize, file) == dataSize &&
+					fwrite(padding, 1, paddingSize, file) == paddingSize);
+		}
+		written = (fclose(file) == 0) && written;
+	}
+	free(index);
+	free(entries);
+
+	// The entries of the old file point to its mapping, so it's only unmapped once everything is written.
+	if (cache->isFileMapped) {
+		S3TConv_MappedFile_Close(&cache->file);
+		cache->isFileMapped = 0;
+	}
+	if (written) {
+#ifdef _WIN32
+		written = (MoveFileExA(temporaryPath, cache->path, MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+		written = (rename(temporaryPath, cache->path) == 0);
+#endif
+	}
+	if (!written) {
+		remove(temporaryPath);
+	}
+	free(temporaryPath);
+	return written;
+}
+
+int S3TConv_FileCache_Close(S3TConv_FileCache *cache) {
+	unsigned int entryIndex;
+	int written = 1;
+
+	if (cache->isModified) {
+		written = S3TConv_FileCache_Write(cache);
+	} else if (cache->isFileMapped) {
+		// Recent usage of the entries is not saved if nothing was added or removed, to avoid rewriting the whole file.
+		S3TConv_MappedFile_Close(&cache->file);
+	}
+	for (entryIndex = cache->fileEntryCount; entryIndex < cache->entryCount; ++entryIndex) {
+		free((void *) cache->entries[entryIndex].data);
+	}
+	free(cache->entries);
+	free(cache->path);
+	free(cache);
+	return written;
+}
+
+//
+// Surfaces.
+//
+
+void S3TConv_FileCache_GetSurfaceKey(const S3TConv_Surface *surface, S3TConv_FileCacheKey *key) {
+	unsigned int blockSize = S3TConv_Format_GetBlockSize(surface->sourceFormat);
+	unsigned int widthInBlocks = (surface->width + 3) >> 2, heightInBlocks = (surface->height + 3) >> 2;
+	size_t rowSize = (size_t) widthInBlocks * blockSize;
+	size_t sourceRowPitch = (surface->sourceRowPitch != 0 ? surface->sourceRowPitch : rowSize);
+	uint64_t hash = ((uint64_t) surface->width << 32) | surface->height;
+	unsigned int rowIndex;
+	int asDXT1 = (surface->sourceFormat == S3TCONV_FORMAT_DXT1 || surface->asDXT1);
+
+	hash = S3TConv_Hash64(&hash, sizeof(hash), (uint64_t) surface->sourceFormat);
+	// Padding between the rows is not hashed.
+	for (rowIndex = 0; rowIndex < heightInBlocks; ++rowIndex) {
+		hash = S3TConv_Hash64(surface->sourceData + rowIndex * sourceRowPitch, rowSize, hash);
+	}
+	key->sourceHash = hash;
+	key->sourceSize = (uint64_t) rowSize * heightInBlocks;
+	key->targetFormat = surface->targetFormat;
+	key->parameters = (uint32_t) surface->sourceFormat | (asDXT1 ? 0x100u : 0u) | ((uint32_t) surface->quality << 16);
+}
+
+int S3TConv_FileCache_ConvertSurface(S3TConv_FileCache *cache, const S3TConv_Surface *surface) {
+	S3TConv_FileCacheKey key;
+	unsigned int targetBlockSize = S3TConv_Format_GetBlockSize(surface->targetFormat);
+	unsigned int heightInBlocks = (surface->height + 3) >> 2, rowIndex;
+	size_t rowSize = (size_t) ((surface->width + 3) >> 2) * targetBlockSize;
+	size_t targetRowPitch = (surface->targetRowPitch != 0 ? surface->targetRowPitch : rowSize);
+	const uint8_t *cachedData;
+	size_t cachedDataSize;
+	uint8_t *packedData;
+
+	// The key is taken before converting because the conversion may be done in place.
+	S3TConv_FileCache_GetSurfaceKey(surface, &key);
+	cachedData = S3TConv_FileCache_Find(cache, &key, &cachedDataSize);
+	if (cachedData != NULL && cachedDataSize == rowSize * heightInBlocks) {
+		for (rowIndex = 0; rowIndex < heightInBlocks; ++rowIndex) {
+			memcpy(surface->targetData + rowIndex * targetRowPitch, cachedData + rowIndex * rowSize, rowSize);
+		}
+		return 1;
+	}
+
+	if (!S3TConv_ConvertSurface(surface)) {
+		return 0;
+	}
+	if (targetRowPitch == rowSize) {
+		S3TConv_FileCache_Add(cache, &key, surface->targetData, rowSize * heightInBlocks);
+	} else {
+		packedData = (uint8_t *) malloc(rowSize * heightInBlocks);
+		if (packedData != NULL) {
+			for (rowIndex = 0; rowIndex < heightInBlocks; ++rowIndex) {
+				memcpy(packedData + rowIndex * rowSize, surface->targetData + rowIndex * targetRowPitch, rowSize);
+			}
+			S3TConv_FileCache_Add(cache, &key, packedData, rowSize * heightInBlocks);
+			free(packedData);
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,153 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "s3tconv_internal.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Number of blocks converted between time checks.
+#define S3TCONV_INCREMENTAL_BLOCKS_PER_TIME_CHECK 256
+
+static uint64_t S3TConv_Incremental_GetMicroseconds(void) {
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000 +
+			(uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000 / (uint64_t) frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t) time.tv_sec * 1000000 + (uint64_t) time.tv_nsec / 1000;
+#endif
+}
+
+int S3TConv_IncrementalConversion_Init(S3TConv_IncrementalConversion *conversion,
+		const S3TConv_Surface *surfaces, unsigned int surfaceCount) {
+	unsigned int surfaceIndex;
+	for (surfaceIndex = 0; surfaceIndex < surfaceCount; ++surfaceIndex) {
+		if (!S3TConv_IsConversionSupported(surfaces[surfaceIndex].sourceFormat, surfaces[surfaceIndex].targetFormat)) {
+			return 0;
+		}
+	}
+	conversion->surfaces = surfaces;
+	conversion->surfaceCount = surfaceCount;
+	conversion->surfaceIndex = 0;
+	conversion->blockRow = 0;
+	conversion->block = 0;
+	return 1;
+}
+
+int S3TConv_IncrementalConversion_Step(S3TConv_IncrementalConversion *conversion,
+		unsigned int maxBlocks, unsigned int maxMicroseconds) {
+	uint64_t endTime = 0;
+	unsigned int blocksUntilTimeCheck = S3TCONV_INCREMENTAL_BLOCKS_PER_TIME_CHECK;
+	S3TConv_BlockCache cache;
+	// Not a target format, so the cache is initialized when it's first used.
+	S3TConv_Format cacheTargetFormat = S3TCONV_FORMAT_DXT1;
+	S3TConv_Quality cacheQuality = S3TCONV_QUALITY_DEFAULT;
+
+	if (maxMicroseconds != 0) {
+		endTime = S3TConv_Incremental_GetMicroseconds() + maxMicroseconds;
+	}
+
+	while (conversion->surfaceIndex < conversion->surfaceCount) {
+		const S3TConv_Surface *surface = &conversion->surfaces[conversion->surfaceIndex];
+		unsigned int widthInBlocks = (surface->width + 3) >> 2, heightInBlocks = (surface->height + 3) >> 2;
+		unsigned int blockCount;
+
+		if (conversion->blockRow >= heightInBlocks) {
+			++conversion->surfaceIndex;
+			conversion->blockRow = 0;
+			conversion->block = 0;
+			continue;
+		}
+
+		blockCount = widthInBlocks - conversion->block;
+		if (maxBlocks != 0 && blockCount > maxBlocks) {
+			blockCount = maxBlocks;
+		}
+		if (maxMicroseconds != 0 && blockCount > blocksUntilTimeCheck) {
+			blockCount = blocksUntilTimeCheck;
+		}
+		// Converted blocks depend on the target format and the quality.
+		if (surface->useBlockCache && (surface->targetFormat != cacheTargetFormat || surface->quality != cacheQuality)) {
+			S3TConv_BlockCache_Init(&cache);
+			cacheTargetFormat = surface->targetFormat;
+			cacheQuality = surface->quality;
+		}
+		S3TConv_Surface_ConvertBlockRowPart(surface, conversion->blockRow, conversion->block, blockCount, &cache);
+		conversion->block += blockCount;
+		if (conversion->block >= widthInBlocks) {
+			++conversion->blockRow;
+			conversion->block = 0;
+		}
+
+		if (maxBlocks != 0) {
+			maxBlocks -= blockCount;
+			if (maxBlocks == 0) {
+				break;
+			}
+		}
+		if (maxMicroseconds != 0) {
+			blocksUntilTimeCheck -= blockCount;
+			if (blocksUntilTimeCheck == 0) {
+				if (S3TConv_Incremental_GetMicroseconds() >= endTime) {
+					break;
+				}
+				blocksUntilTimeCheck = S3TCONV_INCREMENTAL_BLOCKS_PER_TIME_CHECK;
+			}
+		}
+	}
+
+	// Skip the finished surface, so the caller knows it can be uploaded.
+	if (conversion->surfaceIndex < conversion->surfaceCount &&
+			conversion->blockRow >= ((conversion->surfaces[conversion->surfaceIndex].height + 3) >> 2)) {
+		++conversion->surfaceIndex;
+		conversion->blockRow = 0;
+		conversion->block = 0;
+	}
+	return conversion->surfaceIndex < conversion->surfaceCount;
+}
+
+unsigned int S3TConv_IncrementalConversion_GetCompletedBlockRows(const S3TConv_IncrementalConversion *conversion,
+		unsigned int surfaceIndex) {
+	if (surfaceIndex < conversion->surfaceIndex) {
+		return (conversion->surfaces[surfaceIndex].height + 3) >> 2;
+	}
+	if (surfaceIndex == conversion->surfaceIndex) {
+		return conversion->blockRow;
+	}
+	return 0;
+}
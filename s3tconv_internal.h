@@ -1,48 +1,306 @@
-/*
-Part of S3TConv, a library for converting S3TC textures to other formats.
-https://github.com/Triang3l/S3TConv
-
-Copyright (c) 2017 Triang3l.
-Contains portions of Compressonator:
-Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
-Copyright (c) 2004-2006 ATI Technologies Inc.
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in
-all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-THE SOFTWARE.
-*/
-
-#ifndef S3TCONV_INTERNAL_H
-#define S3TCONV_INTERNAL_H
-
-#include "s3tconv.h"
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-void S3TConv_Utility_Color565To888(uint16_t color565, uint8_t color888[3]);
-
-static inline uint16_t S3TConv_Utility_Color565To555(uint16_t color565) {
-	return (color565 & 0x001F) | ((color565 & 0xFFC0) >> 1);
-}
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+Contains portions of Compressonator:
+Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+Copyright (c) 2004-2006 ATI Technologies Inc.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef S3TCONV_INTERNAL_H
+#define S3TCONV_INTERNAL_H
+
+#include <string.h>
+#include "s3tconv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER)
+#define S3TCONV_FORCEINLINE __forceinline
+#elif defined(__GNUC__)
+#define S3TCONV_FORCEINLINE inline __attribute__((always_inline))
+#else
+#define S3TCONV_FORCEINLINE inline
+#endif
+
+// Vectorized code paths, may be disabled by defining S3TCONV_NO_SIMD. They assume little-endian data layout.
+#ifndef S3TCONV_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define S3TCONV_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)) && !defined(__ARM_BIG_ENDIAN)
+#define S3TCONV_NEON 1
+#endif
+#endif
+
+// Counting of the ways blocks are converted, and optionally timing of them, for S3TConv_Stats.
+#if defined(S3TCONV_STATS_TIMING) && !defined(S3TCONV_STATS)
+#define S3TCONV_STATS 1
+#endif
+
+#ifdef S3TCONV_STATS_TIMING
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define S3TConv_Stats_GetTicks() ((uint64_t) __rdtsc())
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define S3TConv_Stats_GetTicks() ((uint64_t) __rdtsc())
+#elif defined(__GNUC__) && defined(__aarch64__)
+static inline uint64_t S3TConv_Stats_GetTicks(void) {
+	uint64_t ticks;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+	return ticks;
+}
+#else
+// Too coarse for single blocks, but the errors average out over many of them.
+#include <time.h>
+#define S3TConv_Stats_GetTicks() ((uint64_t) clock())
+#endif
+#endif
+
+// Expansion of 565 colors and luminance calculation can use lookup tables:
+// 0 - arithmetic (default).
+// 1 - small per-component tables, a few hundred bytes.
+// 2 - 64K-entry tables, S3TConv_InitLookupTables must be called before converting.
+#ifndef S3TCONV_LOOKUP_TABLES
+#define S3TCONV_LOOKUP_TABLES 0
+#endif
+
+#if S3TCONV_LOOKUP_TABLES == 1
+extern const uint8_t S3TConv_Utility_Expand5To8[32];
+extern const uint8_t S3TConv_Utility_Expand6To8[64];
+#elif S3TCONV_LOOKUP_TABLES == 2
+extern uint8_t S3TConv_Utility_Color565To888Table[65536][4];
+#endif
+
+static inline void S3TConv_Utility_Color565To888(uint16_t color565, uint8_t color888[3]) {
+#if S3TCONV_LOOKUP_TABLES == 1
+	color888[0] = S3TConv_Utility_Expand5To8[color565 >> 11];
+	color888[1] = S3TConv_Utility_Expand6To8[(color565 >> 5) & 0x3F];
+	color888[2] = S3TConv_Utility_Expand5To8[color565 & 0x1F];
+#elif S3TCONV_LOOKUP_TABLES == 2
+	const uint8_t *tableColor888 = S3TConv_Utility_Color565To888Table[color565];
+	color888[0] = tableColor888[0];
+	color888[1] = tableColor888[1];
+	color888[2] = tableColor888[2];
+#else
+	// From Compressonator.
+	color888[0] = (uint8_t) (((color565 & 0xF800) >> 8) | ((color565 & 0xE000) >> 13));
+	color888[1] = (uint8_t) (((color565 & 0x07E0) >> 3) | ((color565 & 0x0600) >> 9));
+	color888[2] = (uint8_t) (((color565 & 0x001F) << 3) | ((color565 & 0x001C) >> 2));
+#endif
+}
+
+static inline uint16_t S3TConv_Utility_Color565To555(uint16_t color565) {
+	return (color565 & 0x001F) | ((color565 & 0xFFC0) >> 1);
+}
+
+// Fields of a DXT color block (8 bytes).
+static inline uint16_t S3TConv_DXT_GetColor0(const uint8_t colorBlock[8]) {
+	return (uint16_t) colorBlock[0] | ((uint16_t) colorBlock[1] << 8);
+}
+
+static inline uint16_t S3TConv_DXT_GetColor1(const uint8_t colorBlock[8]) {
+	return (uint16_t) colorBlock[2] | ((uint16_t) colorBlock[3] << 8);
+}
+
+static inline uint32_t S3TConv_DXT_GetIndices(const uint8_t colorBlock[8]) {
+	return (uint32_t) colorBlock[4] | ((uint32_t) colorBlock[5] << 8) |
+			((uint32_t) colorBlock[6] << 16) | ((uint32_t) colorBlock[7] << 24);
+}
+
+// Explicit alpha of DXT1 punch-through transparency from the already extracted fields of the block.
+static inline void S3TConv_DXT1_WriteExplicitAlpha(uint16_t color0565, uint16_t color1565, uint32_t indices,
+		uint8_t alphaBlock[8]) {
+	uint32_t colorIndexMask;
+	unsigned int alphaByteIndex;
+
+	if (color0565 > color1565) {
+		// Four-color blocks are opaque.
+		memset(alphaBlock, 0xFF, 8);
+		return;
+	}
+
+	colorIndexMask = indices & 0x55555555 & ((indices & 0xAAAAAAAA) >> 1);
+	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+	for (alphaByteIndex = 0; alphaByteIndex < 8; ++alphaByteIndex) {
+		alphaBlock[alphaByteIndex] = (uint8_t) ((colorIndexMask & 0x3) | ((colorIndexMask & 0x3) << 2) |
+				((colorIndexMask & 0xC) << 2) | ((colorIndexMask & 0xC) << 4));
+		colorIndexMask >>= 4;
+	}
+}
+
+// Interpolated alpha of DXT1 punch-through transparency from the already extracted fields of the block.
+static inline void S3TConv_DXT1_WriteInterpolatedAlpha(uint16_t color0565, uint16_t color1565, uint32_t indices,
+		uint8_t alphaBlock[8]) {
+	uint32_t blackIndexBits, alphaCodesLow, alphaCodesHigh;
+	unsigned int pixelIndex;
+
+	if (color0565 > color1565) {
+		alphaBlock[0] = alphaBlock[1] = 0xFF;
+		memset(alphaBlock + 2, 0, 6);
+		return;
+	}
+
+	blackIndexBits = indices & 0x55555555 & ((indices & 0xAAAAAAAA) >> 1);
+	alphaCodesLow = alphaCodesHigh = 0;
+	for (pixelIndex = 0; pixelIndex < 8; ++pixelIndex) {
+		unsigned int alphaCodeShift = pixelIndex * 3;
+		alphaCodesLow |= ((blackIndexBits >> (pixelIndex << 1)) & 1) << alphaCodeShift;
+		alphaCodesHigh |= ((blackIndexBits >> (16 + (pixelIndex << 1))) & 1) << alphaCodeShift;
+	}
+	alphaBlock[0] = 0xFF;
+	alphaBlock[1] = 0;
+	alphaBlock[2] = (uint8_t) alphaCodesLow;
+	alphaBlock[3] = (uint8_t) (alphaCodesLow >> 8);
+	alphaBlock[4] = (uint8_t) (alphaCodesLow >> 16);
+	alphaBlock[5] = (uint8_t) alphaCodesHigh;
+	alphaBlock[6] = (uint8_t) (alphaCodesHigh >> 8);
+	alphaBlock[7] = (uint8_t) (alphaCodesHigh >> 16);
+}
+
+// Alpha values of a DXT1 (punch-through), DXT3 or DXT5 block in the DXT pixel order (y * 4 + x).
+void S3TConv_DXT_GetAlphas(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int alphas[16]);
+
+// Read-only memory mapping of a whole file.
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+#ifdef _WIN32
+	void *fileHandle, *mappingHandle;
+#endif
+} S3TConv_MappedFile;
+
+int S3TConv_MappedFile_Open(S3TConv_MappedFile *mappedFile, const char *path);
+void S3TConv_MappedFile_Close(S3TConv_MappedFile *mappedFile);
+
+// Converted RGB blocks, looked up by the source block and the state affecting the conversion.
+// 256 entries of 17 bytes, small enough to stay in the L1 cache.
+#define S3TCONV_BLOCK_CACHE_SIZE_LOG2 8
+#define S3TCONV_BLOCK_CACHE_MAX_PROBES 4
+typedef struct {
+	uint64_t sourceBlocks[1 << S3TCONV_BLOCK_CACHE_SIZE_LOG2];
+	uint8_t targetBlocks[1 << S3TCONV_BLOCK_CACHE_SIZE_LOG2][8];
+	// 0 for empty entries, otherwise 0x80 | asDXT1 << 6 | min(remainingWidth, 4) << 3 | min(remainingHeight, 4).
+	uint8_t states[1 << S3TCONV_BLOCK_CACHE_SIZE_LOG2];
+#ifdef S3TCONV_STATS
+	uint8_t paths[1 << S3TCONV_BLOCK_CACHE_SIZE_LOG2];
+#endif
+	uint64_t lookups, hits;
+} S3TConv_BlockCache;
+
+void S3TConv_BlockCache_Init(S3TConv_BlockCache *cache);
+
+static inline unsigned int S3TConv_BlockCache_GetState(int asDXT1, unsigned int remainingWidth, unsigned int remainingHeight) {
+	return 0x80 | ((asDXT1 ? 1 : 0) << 6) | ((remainingWidth < 4 ? remainingWidth : 4) << 3) |
+			(remainingHeight < 4 ? remainingHeight : 4);
+}
+
+// Returns 1 and the index of the entry if the block has already been converted,
+// or 0 and the index of the entry to store the block in after converting it.
+static inline int S3TConv_BlockCache_Find(S3TConv_BlockCache *cache, uint64_t sourceBlock, unsigned int state,
+		unsigned int *entryIndex) {
+	unsigned int firstEntryIndex, probe;
+	// Fibonacci hashing, the state is mixed in so edge blocks don't collide with mid-image ones.
+	firstEntryIndex = (unsigned int) (((sourceBlock ^ state) * 0x9E3779B97F4A7C15ull) >> (64 - S3TCONV_BLOCK_CACHE_SIZE_LOG2));
+	// If all probed entries are occupied, the first one is replaced.
+	*entryIndex = firstEntryIndex;
+	++cache->lookups;
+	for (probe = 0; probe < S3TCONV_BLOCK_CACHE_MAX_PROBES; ++probe) {
+		unsigned int probedIndex = (firstEntryIndex + probe) & ((1 << S3TCONV_BLOCK_CACHE_SIZE_LOG2) - 1);
+		unsigned int probedState = cache->states[probedIndex];
+		if (probedState == 0) {
+			*entryIndex = probedIndex;
+			return 0;
+		}
+		if (probedState == state && cache->sourceBlocks[probedIndex] == sourceBlock) {
+			*entryIndex = probedIndex;
+			++cache->hits;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static inline void S3TConv_BlockCache_Store(S3TConv_BlockCache *cache, unsigned int entryIndex,
+		uint64_t sourceBlock, unsigned int state, const uint8_t targetBlock[8]) {
+	cache->sourceBlocks[entryIndex] = sourceBlock;
+	memcpy(cache->targetBlocks[entryIndex], targetBlock, 8);
+	cache->states[entryIndex] = (uint8_t) state;
+}
+
+// Converts a range of block rows of a surface, the formats must be checked with S3TConv_IsConversionSupported.
+// Statistics are added to stats if it's not NULL rather than to surface->stats.
+void S3TConv_Surface_ConvertBlockRows(const S3TConv_Surface *surface, unsigned int firstBlockRow, unsigned int blockRowCount,
+		S3TConv_Stats *stats);
+// Converts blockCount blocks of a row starting from firstBlock, which must be within the row.
+// If surface->useBlockCache is set, cache must be initialized, and it may be reused between calls for surfaces
+// with the same target format and quality.
+void S3TConv_Surface_ConvertBlockRowPart(const S3TConv_Surface *surface, unsigned int blockRow,
+		unsigned int firstBlock, unsigned int blockCount, S3TConv_BlockCache *cache);
+
+// S3TConv_ATITC_RGBBlockFromDXT also returning the chosen way of conversion.
+S3TConv_ATITC_Path S3TConv_ATITC_RGBBlockFromDXTWithPath(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+// Sum of squared RGB differences between the pixels of the decoded DXT and ATITC RGB blocks, not counting padding.
+// Measured the same way as S3TCONV_QUALITY_HIGH minimizes the error.
+unsigned int S3TConv_ATITC_GetRGBBlockError(const uint8_t dxtBlock[8], int asDXT1, const uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight);
+
+#if S3TCONV_LOOKUP_TABLES == 2
+void S3TConv_ATITC_InitLookupTables(void);
+#endif
+
+int S3TConv_ATITC_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format atitcFormat);
+
+// Converts a row of blocks, remainingWidth is counted from the leftmost pixel of the first block.
+// The formats must be checked with S3TConv_ATITC_IsConversionFromDXTSupported.
+// If cache is not NULL, the RGB parts are converted through it. With S3TCONV_STATS, paths are counted in stats if it's not NULL.
+void S3TConv_ATITC_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality,
+		uint8_t *atitcRow, S3TConv_Format atitcFormat, unsigned int blockCount,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_BlockCache *cache, S3TConv_Stats *stats);
+
+// Sum of squared RGB differences between the pixels of the decoded DXT and ETC2 RGB blocks, not counting padding, with
+// every pixel whose punch-through transparency is not kept counted as the largest error.
+unsigned int S3TConv_ETC2_GetRGBBlockError(const uint8_t dxtBlock[8], int asDXT1, int punchthrough,
+		const uint8_t etc2Block[8], unsigned int remainingWidth, unsigned int remainingHeight);
+
+int S3TConv_ETC2_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format etc2Format);
+
+// Converts a row of blocks like S3TConv_ATITC_BlockRowFromDXT. If cache is not NULL, the RGB parts are converted through it.
+void S3TConv_ETC2_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1, S3TConv_Quality quality,
+		uint8_t *etc2Row, S3TConv_Format etc2Format, unsigned int blockCount,
+		unsigned int remainingWidth, unsigned int remainingHeight, S3TConv_BlockCache *cache);
+
+int S3TConv_ASTC_IsConversionFromDXTSupported(S3TConv_Format dxtFormat, S3TConv_Format astcFormat);
+
+// Converts a row of blocks like S3TConv_ATITC_BlockRowFromDXT, without a cache.
+void S3TConv_ASTC_BlockRowFromDXT(const uint8_t *dxtRow, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *astcRow, unsigned int blockCount, unsigned int remainingWidth, unsigned int remainingHeight);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
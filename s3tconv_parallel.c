@@ -0,0 +1,347 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+#ifndef S3TCONV_NO_THREADS
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+// Preferred minimum number of blocks converted by one job if the number of rows is chosen automatically.
+#define S3TCONV_PARALLEL_MIN_JOB_BLOCKS 4096
+
+typedef struct {
+	const S3TConv_Surface *surface;
+	unsigned int firstBlockRow, blockRowCount;
+	// Gathered separately for every job and added to the surface statistics after all jobs are done.
+	S3TConv_Stats stats;
+} S3TConv_Parallel_Job;
+
+static void S3TConv_Parallel_RunJob(void *jobData) {
+	S3TConv_Parallel_Job *job = (S3TConv_Parallel_Job *) jobData;
+	S3TConv_Surface_ConvertBlockRows(job->surface, job->firstBlockRow, job->blockRowCount, &job->stats);
+}
+
+static unsigned int S3TConv_Parallel_GetJobBlockRows(const S3TConv_Surface *surface, unsigned int blockRowsPerJob) {
+	if (blockRowsPerJob == 0) {
+		unsigned int widthInBlocks = (surface->width + 3) >> 2;
+		blockRowsPerJob = (S3TCONV_PARALLEL_MIN_JOB_BLOCKS + widthInBlocks - 1) / (widthInBlocks != 0 ? widthInBlocks : 1);
+	}
+	return blockRowsPerJob;
+}
+
+int S3TConv_ConvertSurfacesParallel(const S3TConv_Surface *surfaces, unsigned int surfaceCount,
+		const S3TConv_Scheduler *scheduler, unsigned int blockRowsPerJob) {
+	S3TConv_Parallel_Job *jobs = NULL;
+	size_t jobCount = 0, jobIndex;
+	unsigned int surfaceIndex;
+
+	for (surfaceIndex = 0; surfaceIndex < surfaceCount; ++surfaceIndex) {
+		const S3TConv_Surface *surface = &surfaces[surfaceIndex];
+		unsigned int jobBlockRows = S3TConv_Parallel_GetJobBlockRows(surface, blockRowsPerJob);
+		if (!S3TConv_IsConversionSupported(surface->sourceFormat, surface->targetFormat)) {
+			return 0;
+		}
+		jobCount += (((surface->height + 3) >> 2) + jobBlockRows - 1) / jobBlockRows;
+	}
+
+	if (scheduler != NULL && jobCount > 1) {
+		jobs = (S3TConv_Parallel_Job *) malloc(jobCount * sizeof(S3TConv_Parallel_Job));
+	}
+	if (jobs == NULL) {
+		// Not worth or not possible to run in parallel.
+		for (surfaceIndex = 0; surfaceIndex < surfaceCount; ++surfaceIndex) {
+			S3TConv_Surface_ConvertBlockRows(&surfaces[surfaceIndex], 0, (surfaces[surfaceIndex].height + 3) >> 2, NULL);
+		}
+		return 1;
+	}
+
+	jobIndex = 0;
+	for (surfaceIndex = 0; surfaceIndex < surfaceCount; ++surfaceIndex) {
+		const S3TConv_Surface *surface = &surfaces[surfaceIndex];
+		unsigned int heightInBlocks = (surface->height + 3) >> 2;
+		unsigned int jobBlockRows = S3TConv_Parallel_GetJobBlockRows(surface, blockRowsPerJob);
+		unsigned int firstBlockRow;
+		for (firstBlockRow = 0; firstBlockRow < heightInBlocks; firstBlockRow += jobBlockRows) {
+			S3TConv_Parallel_Job *job = &jobs[jobIndex++];
+			job->surface = surface;
+			job->firstBlockRow = firstBlockRow;
+			job->blockRowCount = heightInBlocks - firstBlockRow;
+			if (job->blockRowCount > jobBlockRows) {
+				job->blockRowCount = jobBlockRows;
+			}
+			memset(&job->stats, 0, sizeof(job->stats));
+			scheduler->submit(scheduler->schedulerData, S3TConv_Parallel_RunJob, job);
+		}
+	}
+	scheduler->wait(scheduler->schedulerData);
+
+	for (jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+		if (jobs[jobIndex].surface->stats != NULL) {
+			S3TConv_Stats_Add(jobs[jobIndex].surface->stats, &jobs[jobIndex].stats);
+		}
+	}
+	free(jobs);
+	return 1;
+}
+
+//
+// Built-in thread pool.
+//
+
+#ifndef S3TCONV_NO_THREADS
+
+#ifdef _WIN32
+typedef HANDLE S3TConv_Thread;
+typedef SRWLOCK S3TConv_Mutex;
+typedef CONDITION_VARIABLE S3TConv_Condition;
+#define S3TConv_Mutex_Lock(mutex) AcquireSRWLockExclusive(mutex)
+#define S3TConv_Mutex_Unlock(mutex) ReleaseSRWLockExclusive(mutex)
+#define S3TConv_Condition_Wait(condition, mutex) SleepConditionVariableSRW(condition, mutex, INFINITE, 0)
+#define S3TConv_Condition_Signal(condition) WakeConditionVariable(condition)
+#define S3TConv_Condition_Broadcast(condition) WakeAllConditionVariable(condition)
+#else
+typedef pthread_t S3TConv_Thread;
+typedef pthread_mutex_t S3TConv_Mutex;
+typedef pthread_cond_t S3TConv_Condition;
+#define S3TConv_Mutex_Lock(mutex) pthread_mutex_lock(mutex)
+#define S3TConv_Mutex_Unlock(mutex) pthread_mutex_unlock(mutex)
+#define S3TConv_Condition_Wait(condition, mutex) pthread_cond_wait(condition, mutex)
+#define S3TConv_Condition_Signal(condition) pthread_cond_signal(condition)
+#define S3TConv_Condition_Broadcast(condition) pthread_cond_broadcast(condition)
+#endif
+
+typedef struct {
+	S3TConv_JobFunction function;
+	void *data;
+} S3TConv_ThreadPool_Job;
+
+struct S3TConv_ThreadPool {
+	S3TConv_Mutex mutex;
+	S3TConv_Condition jobsQueuedCondition, jobsDoneCondition;
+	// Queue of jobs not taken by any thread yet, from firstQueuedJob to jobCount.
+	S3TConv_ThreadPool_Job *jobs;
+	size_t jobCapacity, jobCount, firstQueuedJob;
+	// Jobs that are queued or being executed.
+	size_t pendingJobCount;
+	int stopping;
+	S3TConv_Thread *threads;
+	unsigned int threadCount;
+};
+
+// Must be called with the mutex locked, returns 0 if there are no queued jobs.
+static int S3TConv_ThreadPool_TakeJob(S3TConv_ThreadPool *pool, S3TConv_ThreadPool_Job *job) {
+	if (pool->firstQueuedJob >= pool->jobCount) {
+		return 0;
+	}
+	*job = pool->jobs[pool->firstQueuedJob++];
+	if (pool->firstQueuedJob >= pool->jobCount) {
+		pool->firstQueuedJob = pool->jobCount = 0;
+	}
+	return 1;
+}
+
+// Must be called with the mutex locked, unlocks it while the job is running.
+static void S3TConv_ThreadPool_RunJob(S3TConv_ThreadPool *pool, const S3TConv_ThreadPool_Job *job) {
+	S3TConv_Mutex_Unlock(&pool->mutex);
+	job->function(job->data);
+	S3TConv_Mutex_Lock(&pool->mutex);
+	if (--pool->pendingJobCount == 0) {
+		S3TConv_Condition_Broadcast(&pool->jobsDoneCondition);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI S3TConv_ThreadPool_ThreadFunction(LPVOID parameter) {
+#else
+static void *S3TConv_ThreadPool_ThreadFunction(void *parameter) {
+#endif
+	S3TConv_ThreadPool *pool = (S3TConv_ThreadPool *) parameter;
+	S3TConv_ThreadPool_Job job;
+	S3TConv_Mutex_Lock(&pool->mutex);
+	for (;;) {
+		if (S3TConv_ThreadPool_TakeJob(pool, &job)) {
+			S3TConv_ThreadPool_RunJob(pool, &job);
+		} else if (pool->stopping) {
+			break;
+		} else {
+			S3TConv_Condition_Wait(&pool->jobsQueuedCondition, &pool->mutex);
+		}
+	}
+	S3TConv_Mutex_Unlock(&pool->mutex);
+	return 0;
+}
+
+static void S3TConv_ThreadPool_Submit(void *schedulerData, S3TConv_JobFunction job, void *jobData) {
+	S3TConv_ThreadPool *pool = (S3TConv_ThreadPool *) schedulerData;
+	S3TConv_Mutex_Lock(&pool->mutex);
+	if (pool->jobCount >= pool->jobCapacity) {
+		size_t newCapacity = (pool->jobCapacity != 0 ? pool->jobCapacity << 1 : 64);
+		S3TConv_ThreadPool_Job *newJobs = (S3TConv_ThreadPool_Job *) realloc(pool->jobs, newCapacity * sizeof(S3TConv_ThreadPool_Job));
+		if (newJobs == NULL) {
+			// Out of memory, but the job still must be done.
+			S3TConv_Mutex_Unlock(&pool->mutex);
+			job(jobData);
+			return;
+		}
+		pool->jobs = newJobs;
+		pool->jobCapacity = newCapacity;
+	}
+	pool->jobs[pool->jobCount].function = job;
+	pool->jobs[pool->jobCount].data = jobData;
+	++pool->jobCount;
+	++pool->pendingJobCount;
+	S3TConv_Condition_Signal(&pool->jobsQueuedCondition);
+	S3TConv_Mutex_Unlock(&pool->mutex);
+}
+
+static void S3TConv_ThreadPool_Wait(void *schedulerData) {
+	S3TConv_ThreadPool *pool = (S3TConv_ThreadPool *) schedulerData;
+	S3TConv_ThreadPool_Job job;
+	S3TConv_Mutex_Lock(&pool->mutex);
+	// The waiting thread also executes jobs.
+	while (pool->pendingJobCount != 0) {
+		if (S3TConv_ThreadPool_TakeJob(pool, &job)) {
+			S3TConv_ThreadPool_RunJob(pool, &job);
+		} else {
+			S3TConv_Condition_Wait(&pool->jobsDoneCondition, &pool->mutex);
+		}
+	}
+	S3TConv_Mutex_Unlock(&pool->mutex);
+}
+
+S3TConv_ThreadPool *S3TConv_ThreadPool_Create(unsigned int threadCount) {
+	S3TConv_ThreadPool *pool;
+
+	if (threadCount == 0) {
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		threadCount = (unsigned int) systemInfo.dwNumberOfProcessors;
+#else
+		long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+		threadCount = (processorCount > 0 ? (unsigned int) processorCount : 1);
+#endif
+	}
+
+	pool = (S3TConv_ThreadPool *) calloc(1, sizeof(S3TConv_ThreadPool));
+	if (pool == NULL) {
+		return NULL;
+	}
+	// The thread waiting for the jobs is one of the workers.
+	pool->threads = (S3TConv_Thread *) malloc((threadCount > 1 ? threadCount - 1 : 1) * sizeof(S3TConv_Thread));
+	if (pool->threads == NULL) {
+		free(pool);
+		return NULL;
+	}
+#ifdef _WIN32
+	InitializeSRWLock(&pool->mutex);
+	InitializeConditionVariable(&pool->jobsQueuedCondition);
+	InitializeConditionVariable(&pool->jobsDoneCondition);
+#else
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->jobsQueuedCondition, NULL);
+	pthread_cond_init(&pool->jobsDoneCondition, NULL);
+#endif
+
+	for (pool->threadCount = 0; pool->threadCount + 1 < threadCount; ++pool->threadCount) {
+#ifdef _WIN32
+		pool->threads[pool->threadCount] = CreateThread(NULL, 0, S3TConv_ThreadPool_ThreadFunction, pool, 0, NULL);
+		if (pool->threads[pool->threadCount] == NULL) {
+			break;
+		}
+#else
+		if (pthread_create(&pool->threads[pool->threadCount], NULL, S3TConv_ThreadPool_ThreadFunction, pool) != 0) {
+			break;
+		}
+#endif
+	}
+
+	return pool;
+}
+
+void S3TConv_ThreadPool_Destroy(S3TConv_ThreadPool *pool) {
+	unsigned int threadIndex;
+
+	if (pool == NULL) {
+		return;
+	}
+
+	S3TConv_Mutex_Lock(&pool->mutex);
+	pool->stopping = 1;
+	S3TConv_Condition_Broadcast(&pool->jobsQueuedCondition);
+	S3TConv_Mutex_Unlock(&pool->mutex);
+	for (threadIndex = 0; threadIndex < pool->threadCount; ++threadIndex) {
+#ifdef _WIN32
+		WaitForSingleObject(pool->threads[threadIndex], INFINITE);
+		CloseHandle(pool->threads[threadIndex]);
+#else
+		pthread_join(pool->threads[threadIndex], NULL);
+#endif
+	}
+
+#ifndef _WIN32
+	pthread_cond_destroy(&pool->jobsDoneCondition);
+	pthread_cond_destroy(&pool->jobsQueuedCondition);
+	pthread_mutex_destroy(&pool->mutex);
+#endif
+	free(pool->threads);
+	free(pool->jobs);
+	free(pool);
+}
+
+void S3TConv_ThreadPool_GetScheduler(S3TConv_ThreadPool *pool, S3TConv_Scheduler *scheduler) {
+	scheduler->submit = S3TConv_ThreadPool_Submit;
+	scheduler->wait = S3TConv_ThreadPool_Wait;
+	scheduler->schedulerData = pool;
+}
+
+#else
+
+S3TConv_ThreadPool *S3TConv_ThreadPool_Create(unsigned int threadCount) {
+	(void) threadCount;
+	return NULL;
+}
+
+void S3TConv_ThreadPool_Destroy(S3TConv_ThreadPool *pool) {
+	(void) pool;
+}
+
+void S3TConv_ThreadPool_GetScheduler(S3TConv_ThreadPool *pool, S3TConv_Scheduler *scheduler) {
+	(void) pool;
+	scheduler->submit = NULL;
+	scheduler->wait = NULL;
+	scheduler->schedulerData = NULL;
+}
+
+#endif
@@ -0,0 +1,262 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "s3tconv_internal.h"
+#if defined(S3TCONV_SSE2)
+#include <emmintrin.h>
+#elif defined(S3TCONV_NEON)
+#include <arm_neon.h>
+#endif
+
+unsigned int S3TConv_PixelFormat_GetPixelSize(S3TConv_PixelFormat format) {
+	switch (format) {
+	case S3TCONV_PIXEL_FORMAT_RGB565:
+	case S3TCONV_PIXEL_FORMAT_RGBA4444:
+		return 2;
+	case S3TCONV_PIXEL_FORMAT_RGBA8:
+		return 4;
+	}
+	return 0;
+}
+
+// Packs an 8-bit color and alpha to a pixel, rounding to the nearest value for 565 and 4444.
+static inline uint32_t S3TConv_Uncompressed_PackPixel(S3TConv_PixelFormat pixelFormat, const int color[3], int alpha) {
+	switch (pixelFormat) {
+	case S3TCONV_PIXEL_FORMAT_RGB565:
+		return ((uint32_t) ((color[0] * 31 + 127) / 255) << 11) | ((uint32_t) ((color[1] * 63 + 127) / 255) << 5) |
+				(uint32_t) ((color[2] * 31 + 127) / 255);
+	case S3TCONV_PIXEL_FORMAT_RGBA4444:
+		return ((uint32_t) ((color[0] * 15 + 127) / 255) << 12) | ((uint32_t) ((color[1] * 15 + 127) / 255) << 8) |
+				((uint32_t) ((color[2] * 15 + 127) / 255) << 4) | (uint32_t) ((alpha * 15 + 127) / 255);
+	default:
+		return (uint32_t) color[0] | ((uint32_t) color[1] << 8) | ((uint32_t) color[2] << 16) | ((uint32_t) alpha << 24);
+	}
+}
+
+// Pixels of the 4 colors of the palette, and the alpha bits of every pixel ORed with them.
+// For DXT1, alpha is in the palette (0 for the punch-through black), for DXT3 and DXT5, it's in the pixel bits.
+typedef struct {
+	uint32_t palette[4];
+	uint32_t alphaBits[16];
+	uint32_t indices;
+} S3TConv_Uncompressed_Block;
+
+static void S3TConv_Uncompressed_GetBlock(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		S3TConv_PixelFormat pixelFormat, S3TConv_Uncompressed_Block *block) {
+	const uint8_t *colorBlock = dxtBlock + (dxtFormat == S3TCONV_FORMAT_DXT1 ? 0 : 8);
+	uint16_t colorLow565 = (uint16_t) colorBlock[0] | ((uint16_t) colorBlock[1] << 8);
+	uint16_t colorHigh565 = (uint16_t) colorBlock[2] | ((uint16_t) colorBlock[3] << 8);
+	uint8_t colorLow888[3], colorHigh888[3];
+	int colors[4][3], paletteAlpha = (dxtFormat == S3TCONV_FORMAT_DXT1 ? 255 : 0);
+	int isFourColor = (colorLow565 > colorHigh565 || !(asDXT1 || dxtFormat == S3TCONV_FORMAT_DXT1));
+	unsigned int component, pixel;
+
+	S3TConv_Utility_Color565To888(colorLow565, colorLow888);
+	S3TConv_Utility_Color565To888(colorHigh565, colorHigh888);
+	for (component = 0; component < 3; ++component) {
+		int low = colorLow888[component], high = colorHigh888[component];
+		colors[0][component] = low;
+		colors[1][component] = high;
+		if (isFourColor) {
+			colors[2][component] = (2 * low + high + 1) / 3;
+			colors[3][component] = (low + 2 * high + 1) / 3;
+		} else {
+			colors[2][component] = (low + high + 1) >> 1;
+			colors[3][component] = 0;
+		}
+	}
+	block->palette[0] = S3TConv_Uncompressed_PackPixel(pixelFormat, colors[0], paletteAlpha);
+	block->palette[1] = S3TConv_Uncompressed_PackPixel(pixelFormat, colors[1], paletteAlpha);
+	block->palette[2] = S3TConv_Uncompressed_PackPixel(pixelFormat, colors[2], paletteAlpha);
+	block->palette[3] = S3TConv_Uncompressed_PackPixel(pixelFormat, colors[3],
+			(!isFourColor && dxtFormat == S3TCONV_FORMAT_DXT1) ? 0 : paletteAlpha);
+	block->indices = (uint32_t) colorBlock[4] | ((uint32_t) colorBlock[5] << 8) |
+			((uint32_t) colorBlock[6] << 16) | ((uint32_t) colorBlock[7] << 24);
+
+	if (dxtFormat == S3TCONV_FORMAT_DXT1 || pixelFormat == S3TCONV_PIXEL_FORMAT_RGB565) {
+		memset(block->alphaBits, 0, sizeof(block->alphaBits));
+	} else if (dxtFormat == S3TCONV_FORMAT_DXT3) {
+		// 4-bit alpha is stored directly in RGBA4444 and expanded by replication to RGBA8.
+		for (pixel = 0; pixel < 16; ++pixel) {
+			uint32_t alpha = (dxtBlock[pixel >> 1] >> ((pixel & 1) << 2)) & 15;
+			block->alphaBits[pixel] = (pixelFormat == S3TCONV_PIXEL_FORMAT_RGBA8 ? (alpha * 17) << 24 : alpha);
+		}
+	} else {
+		int alphas[16];
+		S3TConv_DXT_GetAlphas(dxtBlock, dxtFormat, alphas);
+		for (pixel = 0; pixel < 16; ++pixel) {
+			block->alphaBits[pixel] = (pixelFormat == S3TCONV_PIXEL_FORMAT_RGBA8 ?
+					(uint32_t) alphas[pixel] << 24 : (uint32_t) ((alphas[pixel] * 15 + 127) / 255));
+		}
+	}
+}
+
+// Stores the pixels inside the image one by one.
+static void S3TConv_Uncompressed_StoreBlockEdge(const S3TConv_Uncompressed_Block *block,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch,
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	unsigned int width = (remainingWidth < 4 ? remainingWidth : 4), height = (remainingHeight < 4 ? remainingHeight : 4);
+	unsigned int x, y;
+
+	for (y = 0; y < height; ++y) {
+		uint8_t *rowPixels = pixels + y * pixelRowPitch;
+		for (x = 0; x < width; ++x) {
+			unsigned int pixel = y * 4 + x;
+			uint32_t value = block->palette[(block->indices >> (pixel * 2)) & 3] | block->alphaBits[pixel];
+			if (pixelFormat == S3TCONV_PIXEL_FORMAT_RGBA8) {
+				rowPixels[x * 4] = (uint8_t) value;
+				rowPixels[x * 4 + 1] = (uint8_t) (value >> 8);
+				rowPixels[x * 4 + 2] = (uint8_t) (value >> 16);
+				rowPixels[x * 4 + 3] = (uint8_t) (value >> 24);
+			} else {
+				rowPixels[x * 2] = (uint8_t) value;
+				rowPixels[x * 2 + 1] = (uint8_t) (value >> 8);
+			}
+		}
+	}
+}
+
+// Stores all 16 pixels, selecting the palette colors for 4 (32-bit) or 8 (16-bit) pixels at once using SIMD.
+static void S3TConv_Uncompressed_StoreBlockFull(const S3TConv_Uncompressed_Block *block,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch) {
+#if defined(S3TCONV_SSE2)
+	unsigned int row;
+	if (pixelFormat == S3TCONV_PIXEL_FORMAT_RGBA8) {
+		__m128i palette0 = _mm_set1_epi32((int) block->palette[0]), palette1 = _mm_set1_epi32((int) block->palette[1]);
+		__m128i palette2 = _mm_set1_epi32((int) block->palette[2]), palette3 = _mm_set1_epi32((int) block->palette[3]);
+		__m128i lowBits = _mm_setr_epi32(1, 4, 16, 64), highBits = _mm_setr_epi32(2, 8, 32, 128);
+		for (row = 0; row < 4; ++row) {
+			__m128i indices = _mm_set1_epi32((int) ((block->indices >> (row * 8)) & 0xFF));
+			__m128i lowMask = _mm_cmpeq_epi32(_mm_and_si128(indices, lowBits), lowBits);
+			__m128i highMask = _mm_cmpeq_epi32(_mm_and_si128(indices, highBits), highBits);
+			__m128i colors01 = _mm_or_si128(_mm_and_si128(lowMask, palette1), _mm_andnot_si128(lowMask, palette0));
+			__m128i colors23 = _mm_or_si128(_mm_and_si128(lowMask, palette3), _mm_andnot_si128(lowMask, palette2));
+			__m128i colors = _mm_or_si128(_mm_and_si128(highMask, colors23), _mm_andnot_si128(highMask, colors01));
+			colors = _mm_or_si128(colors, _mm_loadu_si128((const __m128i *) (block->alphaBits + row * 4)));
+			_mm_storeu_si128((__m128i *) (pixels + row * pixelRowPitch), colors);
+		}
+	} else {
+		__m128i palette0 = _mm_set1_epi16((short) block->palette[0]), palette1 = _mm_set1_epi16((short) block->palette[1]);
+		__m128i palette2 = _mm_set1_epi16((short) block->palette[2]), palette3 = _mm_set1_epi16((short) block->palette[3]);
+		__m128i lowBits = _mm_setr_epi16(1, 4, 16, 64, 256, 1024, 4096, 16384);
+		__m128i highBits = _mm_setr_epi16(2, 8, 32, 128, 512, 2048, 8192, (short) 32768);
+		for (row = 0; row < 4; row += 2) {
+			__m128i indices = _mm_set1_epi16((short) ((block->indices >> (row * 8)) & 0xFFFF));
+			__m128i lowMask = _mm_cmpeq_epi16(_mm_and_si128(indices, lowBits), lowBits);
+			__m128i highMask = _mm_cmpeq_epi16(_mm_and_si128(indices, highBits), highBits);
+			__m128i colors01 = _mm_or_si128(_mm_and_si128(lowMask, palette1), _mm_andnot_si128(lowMask, palette0));
+			__m128i colors23 = _mm_or_si128(_mm_and_si128(lowMask, palette3), _mm_andnot_si128(lowMask, palette2));
+			__m128i colors = _mm_or_si128(_mm_and_si128(highMask, colors23), _mm_andnot_si128(highMask, colors01));
+			// The alpha bits of the 16-bit formats fit in the low halves of the 32-bit values.
+			__m128i alphaBits = _mm_packs_epi32(_mm_loadu_si128((const __m128i *) (block->alphaBits + row * 4)),
+					_mm_loadu_si128((const __m128i *) (block->alphaBits + row * 4 + 4)));
+			colors = _mm_or_si128(colors, alphaBits);
+			_mm_storel_epi64((__m128i *) (pixels + row * pixelRowPitch), colors);
+			_mm_storel_epi64((__m128i *) (pixels + (row + 1) * pixelRowPitch), _mm_srli_si128(colors, 8));
+		}
+	}
+#elif defined(S3TCONV_NEON)
+	unsigned int row;
+	if (pixelFormat == S3TCONV_PIXEL_FORMAT_RGBA8) {
+		static const uint32_t lowBitValues[4] = { 1, 4, 16, 64 }, highBitValues[4] = { 2, 8, 32, 128 };
+		uint32x4_t palette0 = vdupq_n_u32(block->palette[0]), palette1 = vdupq_n_u32(block->palette[1]);
+		uint32x4_t palette2 = vdupq_n_u32(block->palette[2]), palette3 = vdupq_n_u32(block->palette[3]);
+		uint32x4_t lowBits = vld1q_u32(lowBitValues), highBits = vld1q_u32(highBitValues);
+		for (row = 0; row < 4; ++row) {
+			uint32x4_t indices = vdupq_n_u32((block->indices >> (row * 8)) & 0xFF);
+			uint32x4_t lowMask = vtstq_u32(indices, lowBits), highMask = vtstq_u32(indices, highBits);
+			uint32x4_t colors = vbslq_u32(highMask, vbslq_u32(lowMask, palette3, palette2), vbslq_u32(lowMask, palette1, palette0));
+			colors = vorrq_u32(colors, vld1q_u32(block->alphaBits + row * 4));
+			vst1q_u8(pixels + row * pixelRowPitch, vreinterpretq_u8_u32(colors));
+		}
+	} else {
+		static const uint16_t lowBitValues[8] = { 1, 4, 16, 64, 256, 1024, 4096, 16384 };
+		static const uint16_t highBitValues[8] = { 2, 8, 32, 128, 512, 2048, 8192, 32768 };
+		uint16x8_t palette0 = vdupq_n_u16((uint16_t) block->palette[0]), palette1 = vdupq_n_u16((uint16_t) block->palette[1]);
+		uint16x8_t palette2 = vdupq_n_u16((uint16_t) block->palette[2]), palette3 = vdupq_n_u16((uint16_t) block->palette[3]);
+		uint16x8_t lowBits = vld1q_u16(lowBitValues), highBits = vld1q_u16(highBitValues);
+		for (row = 0; row < 4; row += 2) {
+			uint16x8_t indices = vdupq_n_u16((uint16_t) ((block->indices >> (row * 8)) & 0xFFFF));
+			uint16x8_t lowMask = vtstq_u16(indices, lowBits), highMask = vtstq_u16(indices, highBits);
+			uint16x8_t colors = vbslq_u16(highMask, vbslq_u16(lowMask, palette3, palette2), vbslq_u16(lowMask, palette1, palette0));
+			// The alpha bits of the 16-bit formats fit in the low halves of the 32-bit values.
+			colors = vorrq_u16(colors, vcombine_u16(vmovn_u32(vld1q_u32(block->alphaBits + row * 4)),
+					vmovn_u32(vld1q_u32(block->alphaBits + row * 4 + 4))));
+			vst1_u8(pixels + row * pixelRowPitch, vreinterpret_u8_u16(vget_low_u16(colors)));
+			vst1_u8(pixels + (row + 1) * pixelRowPitch, vreinterpret_u8_u16(vget_high_u16(colors)));
+		}
+	}
+#else
+	S3TConv_Uncompressed_StoreBlockEdge(block, pixels, pixelFormat, pixelRowPitch, 4, 4);
+#endif
+}
+
+void S3TConv_Uncompressed_BlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch,
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	S3TConv_Uncompressed_Block block;
+
+	S3TConv_Uncompressed_GetBlock(dxtBlock, dxtFormat, asDXT1, pixelFormat, &block);
+	if (remainingWidth >= 4 && remainingHeight >= 4) {
+		S3TConv_Uncompressed_StoreBlockFull(&block, pixels, pixelFormat, pixelRowPitch);
+	} else {
+		S3TConv_Uncompressed_StoreBlockEdge(&block, pixels, pixelFormat, pixelRowPitch, remainingWidth, remainingHeight);
+	}
+}
+
+int S3TConv_Uncompressed_SurfaceFromDXT(const uint8_t *dxtData, S3TConv_Format dxtFormat, int asDXT1, size_t dxtRowPitch,
+		uint8_t *pixels, S3TConv_PixelFormat pixelFormat, size_t pixelRowPitch,
+		unsigned int width, unsigned int height) {
+	unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2;
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	unsigned int pixelSize = S3TConv_PixelFormat_GetPixelSize(pixelFormat);
+	unsigned int blockRow, blockIndex;
+
+	if ((dxtFormat != S3TCONV_FORMAT_DXT1 && dxtFormat != S3TCONV_FORMAT_DXT3 && dxtFormat != S3TCONV_FORMAT_DXT5) ||
+			pixelSize == 0) {
+		return 0;
+	}
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		asDXT1 = 1;
+	}
+	if (dxtRowPitch == 0) {
+		dxtRowPitch = (size_t) widthInBlocks * dxtBlockSize;
+	}
+	if (pixelRowPitch == 0) {
+		pixelRowPitch = (size_t) width * pixelSize;
+	}
+
+	for (blockRow = 0; blockRow < heightInBlocks; ++blockRow) {
+		const uint8_t *dxtRow = dxtData + blockRow * dxtRowPitch;
+		uint8_t *pixelRow = pixels + (size_t) (blockRow << 2) * pixelRowPitch;
+		unsigned int remainingHeight = height - (blockRow << 2);
+		for (blockIndex = 0; blockIndex < widthInBlocks; ++blockIndex) {
+			S3TConv_Uncompressed_BlockFromDXT(dxtRow + blockIndex * dxtBlockSize, dxtFormat, asDXT1,
+					pixelRow + (size_t) (blockIndex << 2) * pixelSize, pixelFormat, pixelRowPitch,
+					width - (blockIndex << 2), remainingHeight);
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,813 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Throughput benchmark of the conversion functions.
+// Usage: s3tconv_benchmark [-blocks count] [-time seconds] [file.dds...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static unsigned int S3TConv_Benchmark_BlockCount = 1 << 16;
+static double S3TConv_Benchmark_MinTime = 0.25;
+
+static double S3TConv_Benchmark_GetTime(void) {
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+#endif
+}
+
+static uint32_t S3TConv_Benchmark_RandomState = 0x12345678;
+
+static uint32_t S3TConv_Benchmark_Random(void) {
+	// xorshift32.
+	uint32_t state = S3TConv_Benchmark_RandomState;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return S3TConv_Benchmark_RandomState = state;
+}
+
+// Generates a DXT1 block with indices chosen from allowedIndexMask with random weights.
+static void S3TConv_Benchmark_GenerateBlock(uint8_t block[8], int blackMode, unsigned int allowedIndexMask) {
+	uint32_t colors = S3TConv_Benchmark_Random(), indices = 0;
+	uint16_t color0565 = (uint16_t) colors, color1565 = (uint16_t) (colors >> 16);
+	unsigned int indexWeights[4], totalWeight = 0, index, pixelIndex;
+
+	if (blackMode != (color0565 <= color1565)) {
+		uint16_t color = color0565;
+		color0565 = color1565;
+		color1565 = color;
+	}
+	if (!blackMode && color0565 == color1565) {
+		color0565 |= 1;
+		color1565 &= ~1;
+	}
+
+	for (index = 0; index < 4; ++index) {
+		indexWeights[index] = ((allowedIndexMask >> index) & 1) ? 1 + (S3TConv_Benchmark_Random() & 7) : 0;
+		totalWeight += indexWeights[index];
+	}
+	for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+		unsigned int weight = S3TConv_Benchmark_Random() % totalWeight;
+		for (index = 0; weight >= indexWeights[index]; ++index) {
+			weight -= indexWeights[index];
+		}
+		indices |= (uint32_t) index << (pixelIndex << 1);
+	}
+
+	block[0] = (uint8_t) color0565;
+	block[1] = (uint8_t) (color0565 >> 8);
+	block[2] = (uint8_t) color1565;
+	block[3] = (uint8_t) (color1565 >> 8);
+	block[4] = (uint8_t) indices;
+	block[5] = (uint8_t) (indices >> 8);
+	block[6] = (uint8_t) (indices >> 16);
+	block[7] = (uint8_t) (indices >> 24);
+}
+
+// Creates S3TConv_Benchmark_BlockCount DXT1 blocks converted to ATITC through the specified path.
+static uint8_t *S3TConv_Benchmark_GenerateCorpus(S3TConv_ATITC_Path path) {
+	static const unsigned int allowedIndexMasks[S3TCONV_ATITC_PATH_COUNT] = {
+		0xF, // Four-color.
+		0xB, // Unused medium.
+		0xD, // Unused low or high (alternating with 0xE).
+		0x7, // Unused black.
+		0xF, 0xF, 0xF // All shades used.
+	};
+	uint8_t *corpus = (uint8_t *) malloc((size_t) S3TConv_Benchmark_BlockCount * 8);
+	unsigned int blockIndex = 0, attempts = 0;
+	uint8_t atitcBlock[8];
+
+	if (corpus == NULL) {
+		return NULL;
+	}
+	while (blockIndex < S3TConv_Benchmark_BlockCount) {
+		uint8_t *block = corpus + (size_t) blockIndex * 8;
+		unsigned int allowedIndexMask = allowedIndexMasks[path];
+		if (path == S3TCONV_ATITC_PATH_UNUSED_LOW_OR_HIGH && (attempts & 1)) {
+			allowedIndexMask = 0xE;
+		}
+		S3TConv_Benchmark_GenerateBlock(block, path != S3TCONV_ATITC_PATH_FOUR_COLOR, allowedIndexMask);
+		++attempts;
+		if (S3TConv_ATITC_RGBBlockFromDXTWithPath(block, 1, atitcBlock, 4, 4) == path) {
+			++blockIndex;
+		}
+	}
+	return corpus;
+}
+
+static void S3TConv_Benchmark_Report(const char *name, unsigned int blockCount, size_t bytesPerBlock, double time) {
+	printf("%-56s %10.2f Mblocks/s %10.1f MB/s\n", name,
+			(double) blockCount / time * 1e-6, (double) blockCount * (double) bytesPerBlock / time / (1024.0 * 1024.0));
+}
+
+// Runs a benchmark callback repeatedly for at least S3TConv_Benchmark_MinTime, returns the best time of a run.
+typedef void (*S3TConv_Benchmark_Function)(void *data);
+
+static double S3TConv_Benchmark_Run(S3TConv_Benchmark_Function function, void *data) {
+	double startTime = S3TConv_Benchmark_GetTime(), bestTime = 0.0;
+	do {
+		double runStartTime = S3TConv_Benchmark_GetTime(), runTime;
+		function(data);
+		runTime = S3TConv_Benchmark_GetTime() - runStartTime;
+		if (bestTime == 0.0 || runTime < bestTime) {
+			bestTime = runTime;
+		}
+	} while (S3TConv_Benchmark_GetTime() - startTime < S3TConv_Benchmark_MinTime);
+	return bestTime > 0.0 ? bestTime : 1e-9;
+}
+
+typedef struct {
+	const uint8_t *source;
+	uint8_t *target;
+	unsigned int blockCount;
+	int asDXT1;
+	// For the RGBA functions, DXT1 to ATC_RGBA_INTERPOLATED or DXT5 to ATC_RGBA_INTERPOLATED.
+	S3TConv_Format sourceFormat;
+	S3TConv_Quality quality;
+} S3TConv_Benchmark_Blocks;
+
+static void S3TConv_Benchmark_RGBBlockFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ATITC_RGBBlockFromDXT(blocks->source + (size_t) blockIndex * 8, blocks->asDXT1,
+				blocks->target + (size_t) blockIndex * 8, 4, 4);
+	}
+}
+
+static void S3TConv_Benchmark_RGBBlockFromDXTWithQuality(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ATITC_RGBBlockFromDXTWithQuality(blocks->source + (size_t) blockIndex * 8, blocks->asDXT1, blocks->quality,
+				blocks->target + (size_t) blockIndex * 8, 4, 4);
+	}
+}
+
+static const char * const S3TConv_Benchmark_QualityNames[] = { "default", "fast", "high" };
+
+// Mean squared RGB error per pixel of the converted blocks, which S3TCONV_QUALITY_HIGH minimizes.
+static void S3TConv_Benchmark_ReportError(const uint8_t *dxtBlocks, int asDXT1, const uint8_t *atitcBlocks,
+		unsigned int blockCount) {
+	uint64_t error = 0;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		error += S3TConv_ATITC_GetRGBBlockError(dxtBlocks + (size_t) blockIndex * 8, asDXT1,
+				atitcBlocks + (size_t) blockIndex * 8, 4, 4);
+	}
+	printf("%-56s %10.2f MSE\n", "", (double) error / ((double) blockCount * 16.0));
+}
+
+// Converts the blocks at every level of quality, reporting the speed and the error of each.
+static void S3TConv_Benchmark_Qualities(const char *name, S3TConv_Benchmark_Blocks *blocks) {
+	char levelName[64];
+	int quality;
+	for (quality = S3TCONV_QUALITY_DEFAULT; quality <= S3TCONV_QUALITY_HIGH; ++quality) {
+		snprintf(levelName, sizeof(levelName), "%s, %s", name, S3TConv_Benchmark_QualityNames[quality]);
+		blocks->quality = (S3TConv_Quality) quality;
+		S3TConv_Benchmark_Report(levelName, blocks->blockCount, 8,
+				S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlockFromDXTWithQuality, blocks));
+		S3TConv_Benchmark_ReportError(blocks->source, blocks->asDXT1, blocks->target, blocks->blockCount);
+	}
+}
+
+static void S3TConv_Benchmark_RGBBlocksFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	S3TConv_ATITC_RGBBlocksFromDXT(blocks->source, 8, blocks->asDXT1, blocks->target, 8, blocks->blockCount);
+}
+
+// Alpha and color halves converted by separate calls, as before the fused converters.
+static void S3TConv_Benchmark_RGBABlockFromDXTSeparately(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		uint8_t *atitcBlock = blocks->target + (size_t) blockIndex * 16;
+		if (blocks->sourceFormat == S3TCONV_FORMAT_DXT1) {
+			const uint8_t *dxtBlock = blocks->source + (size_t) blockIndex * 8;
+			S3TConv_DXT1_PunchthroughToInterpolatedAlpha(dxtBlock, atitcBlock);
+			S3TConv_ATITC_RGBBlockFromDXT(dxtBlock, 1, atitcBlock + 8, 4, 4);
+		} else {
+			const uint8_t *dxtBlock = blocks->source + (size_t) blockIndex * 16;
+			memcpy(atitcBlock, dxtBlock, 8);
+			S3TConv_ATITC_RGBBlockFromDXT(dxtBlock + 8, blocks->asDXT1, atitcBlock + 8, 4, 4);
+		}
+	}
+}
+
+static void S3TConv_Benchmark_RGBABlockFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(blocks->sourceFormat), blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ATITC_RGBABlockFromDXT(blocks->source + (size_t) blockIndex * dxtBlockSize, blocks->sourceFormat,
+				blocks->asDXT1, blocks->target + (size_t) blockIndex * 16, S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, 4, 4);
+	}
+}
+
+static void S3TConv_Benchmark_RGBABlocksFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	S3TConv_ATITC_RGBABlocksFromDXT(blocks->source, blocks->sourceFormat, blocks->asDXT1,
+			blocks->target, S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, blocks->blockCount);
+}
+
+static void S3TConv_Benchmark_ETC2RGBBlockFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ETC2_RGBBlockFromDXT(blocks->source + (size_t) blockIndex * 8, blocks->asDXT1, 0,
+				blocks->target + (size_t) blockIndex * 8, 4, 4);
+	}
+}
+
+static void S3TConv_Benchmark_ETC2RGBBlockFromDXTWithQuality(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ETC2_RGBBlockFromDXTWithQuality(blocks->source + (size_t) blockIndex * 8, blocks->asDXT1, 0, blocks->quality,
+				blocks->target + (size_t) blockIndex * 8, 4, 4);
+	}
+}
+
+// Minimum speed of each level of the ETC2 conversion relative to the exhaustive search of S3TCONV_QUALITY_HIGH.
+static const double S3TConv_Benchmark_ETC2SpeedTargets[] = { 3.0, 5.0, 1.0 };
+
+// Like S3TConv_Benchmark_Qualities, also reporting the speed of each level relative to the high one and its target.
+static void S3TConv_Benchmark_ETC2Qualities(const char *name, S3TConv_Benchmark_Blocks *blocks) {
+	double times[S3TCONV_QUALITY_HIGH + 1];
+	uint64_t errors[S3TCONV_QUALITY_HIGH + 1];
+	char levelName[64];
+	unsigned int blockIndex;
+	int quality;
+	for (quality = S3TCONV_QUALITY_DEFAULT; quality <= S3TCONV_QUALITY_HIGH; ++quality) {
+		blocks->quality = (S3TConv_Quality) quality;
+		times[quality] = S3TConv_Benchmark_Run(S3TConv_Benchmark_ETC2RGBBlockFromDXTWithQuality, blocks);
+		errors[quality] = 0;
+		for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+			errors[quality] += S3TConv_ETC2_GetRGBBlockError(blocks->source + (size_t) blockIndex * 8, blocks->asDXT1, 0,
+					blocks->target + (size_t) blockIndex * 8, 4, 4);
+		}
+	}
+	for (quality = S3TCONV_QUALITY_DEFAULT; quality <= S3TCONV_QUALITY_HIGH; ++quality) {
+		double speedup = times[S3TCONV_QUALITY_HIGH] / times[quality];
+		snprintf(levelName, sizeof(levelName), "%s, %s", name, S3TConv_Benchmark_QualityNames[quality]);
+		S3TConv_Benchmark_Report(levelName, blocks->blockCount, 8, times[quality]);
+		printf("%-56s %10.2f MSE %8.1fx high", "", (double) errors[quality] / ((double) blocks->blockCount * 16.0), speedup);
+		if (quality != S3TCONV_QUALITY_HIGH) {
+			printf(" (target %.0fx%s)", S3TConv_Benchmark_ETC2SpeedTargets[quality],
+					speedup < S3TConv_Benchmark_ETC2SpeedTargets[quality] ? ", missed" : "");
+		}
+		printf("\n");
+	}
+}
+
+static void S3TConv_Benchmark_ASTCBlockFromDXT(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_ASTC_BlockFromDXT(blocks->source + (size_t) blockIndex * 8, S3TCONV_FORMAT_DXT1, 1,
+				blocks->target + (size_t) blockIndex * 16, 4, 4);
+	}
+}
+
+static void S3TConv_Benchmark_BlockHasPunchthroughPixels(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex, punchthroughCount = 0;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		punchthroughCount += (unsigned int) S3TConv_DXT1_BlockHasPunchthroughPixels(blocks->source + (size_t) blockIndex * 8, 4, 4);
+	}
+	blocks->target[0] = (uint8_t) punchthroughCount;
+}
+
+static void S3TConv_Benchmark_PunchthroughToExplicitAlpha(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_DXT1_PunchthroughToExplicitAlpha(blocks->source + (size_t) blockIndex * 8, blocks->target + (size_t) blockIndex * 8);
+	}
+}
+
+static void S3TConv_Benchmark_PunchthroughToInterpolatedAlpha(void *data) {
+	const S3TConv_Benchmark_Blocks *blocks = (const S3TConv_Benchmark_Blocks *) data;
+	unsigned int blockIndex;
+	for (blockIndex = 0; blockIndex < blocks->blockCount; ++blockIndex) {
+		S3TConv_DXT1_PunchthroughToInterpolatedAlpha(blocks->source + (size_t) blockIndex * 8, blocks->target + (size_t) blockIndex * 8);
+	}
+}
+
+static void S3TConv_Benchmark_AnalyzeSurface(void *data) {
+	const S3TConv_Surface *surface = (const S3TConv_Surface *) data;
+	S3TConv_DXT1_SurfaceInfo info;
+	S3TConv_DXT1_AnalyzeSurface(surface->sourceData, surface->sourceRowPitch, surface->width, surface->height, &info);
+	surface->targetData[0] = (uint8_t) info.isOpaque;
+}
+
+typedef struct {
+	const S3TConv_Surface *surfaces;
+	unsigned int surfaceCount;
+	const S3TConv_Scheduler *scheduler;
+} S3TConv_Benchmark_Surfaces;
+
+static void S3TConv_Benchmark_ConvertSurfaces(void *data) {
+	const S3TConv_Benchmark_Surfaces *surfaces = (const S3TConv_Benchmark_Surfaces *) data;
+	S3TConv_ConvertSurfacesParallel(surfaces->surfaces, surfaces->surfaceCount, surfaces->scheduler, 0);
+}
+
+static void S3TConv_Benchmark_Surface(const char *name, const S3TConv_Surface *surface, const S3TConv_Scheduler *scheduler) {
+	S3TConv_Benchmark_Surfaces surfaces;
+	unsigned int blockCount = ((surface->width + 3) >> 2) * ((surface->height + 3) >> 2);
+	surfaces.surfaces = surface;
+	surfaces.surfaceCount = 1;
+	surfaces.scheduler = scheduler;
+	S3TConv_Benchmark_Report(name, blockCount, S3TConv_Format_GetBlockSize(surface->sourceFormat),
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_ConvertSurfaces, &surfaces));
+}
+
+typedef struct {
+	const S3TConv_Surface *surface;
+	S3TConv_PixelFormat pixelFormat;
+} S3TConv_Benchmark_Decoding;
+
+static void S3TConv_Benchmark_DecodeSurface(void *data) {
+	const S3TConv_Benchmark_Decoding *decoding = (const S3TConv_Benchmark_Decoding *) data;
+	const S3TConv_Surface *surface = decoding->surface;
+	S3TConv_Uncompressed_SurfaceFromDXT(surface->sourceData, surface->sourceFormat, surface->asDXT1, surface->sourceRowPitch,
+			surface->targetData, decoding->pixelFormat, 0, surface->width, surface->height);
+}
+
+// Decodes the source of the surface to uncompressed pixels instead of converting it.
+static void S3TConv_Benchmark_Decoded(const char *name, const S3TConv_Surface *surface, S3TConv_PixelFormat pixelFormat) {
+	S3TConv_Benchmark_Decoding decoding;
+	unsigned int blockCount = ((surface->width + 3) >> 2) * ((surface->height + 3) >> 2);
+	decoding.surface = surface;
+	decoding.pixelFormat = pixelFormat;
+	S3TConv_Benchmark_Report(name, blockCount, S3TConv_Format_GetBlockSize(surface->sourceFormat),
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_DecodeSurface, &decoding));
+}
+
+typedef struct {
+	const S3TConv_Surface *surface;
+	unsigned int pageSize;
+} S3TConv_Benchmark_Pages;
+
+static void S3TConv_Benchmark_ConvertPages(void *data) {
+	const S3TConv_Benchmark_Pages *pages = (const S3TConv_Benchmark_Pages *) data;
+	S3TConv_Rect rect;
+	rect.width = rect.height = pages->pageSize;
+	rect.border = 4;
+	rect.wrapBorder = 1;
+	for (rect.y = 0; rect.y < pages->surface->height; rect.y += pages->pageSize) {
+		for (rect.x = 0; rect.x < pages->surface->width; rect.x += pages->pageSize) {
+			S3TConv_ConvertSurfaceRect(pages->surface, &rect);
+		}
+	}
+}
+
+// Converts the surface page by page into the same page buffer, like a virtual texture being made resident.
+// The throughput is of the pages without the border, which is converted in addition to them.
+static void S3TConv_Benchmark_PagedSurface(const char *name, const S3TConv_Surface *surface, unsigned int pageSize) {
+	S3TConv_Benchmark_Pages pages;
+	unsigned int blockCount = ((surface->width + 3) >> 2) * ((surface->height + 3) >> 2);
+	pages.surface = surface;
+	pages.pageSize = pageSize;
+	S3TConv_Benchmark_Report(name, blockCount, S3TConv_Format_GetBlockSize(surface->sourceFormat),
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_ConvertPages, &pages));
+}
+
+typedef struct {
+	S3TConv_FileCache *cache;
+	const S3TConv_Surface *surface;
+} S3TConv_Benchmark_FileCache;
+
+static void S3TConv_Benchmark_LoadFromFileCache(void *data) {
+	const S3TConv_Benchmark_FileCache *fileCache = (const S3TConv_Benchmark_FileCache *) data;
+	S3TConv_FileCache_ConvertSurface(fileCache->cache, fileCache->surface);
+}
+
+// Loads the converted surface from a cache file written by a previous "launch", including hashing the source.
+static void S3TConv_Benchmark_FileCachedSurface(const char *name, const S3TConv_Surface *surface) {
+	static const char *path = "s3tconv_benchmark.cache";
+	S3TConv_Benchmark_FileCache fileCache;
+	unsigned int blockCount = ((surface->width + 3) >> 2) * ((surface->height + 3) >> 2);
+	fileCache.cache = S3TConv_FileCache_Open(path, (uint64_t) 1 << 30);
+	if (fileCache.cache == NULL) {
+		return;
+	}
+	S3TConv_FileCache_ConvertSurface(fileCache.cache, surface);
+	if (!S3TConv_FileCache_Close(fileCache.cache)) {
+		printf("%-56s %16s\n", name, "not written");
+		return;
+	}
+	fileCache.cache = S3TConv_FileCache_Open(path, (uint64_t) 1 << 30);
+	if (fileCache.cache != NULL) {
+		fileCache.surface = surface;
+		S3TConv_Benchmark_Report(name, blockCount, S3TConv_Format_GetBlockSize(surface->sourceFormat),
+				S3TConv_Benchmark_Run(S3TConv_Benchmark_LoadFromFileCache, &fileCache));
+		S3TConv_FileCache_Close(fileCache.cache);
+	}
+	remove(path);
+}
+
+// Also reports the hit rate of the block cache if the surface uses it.
+static void S3TConv_Benchmark_CachedSurface(const char *name, const S3TConv_Surface *surface) {
+	S3TConv_Surface statsSurface = *surface;
+	S3TConv_Stats stats;
+	memset(&stats, 0, sizeof(stats));
+	statsSurface.stats = &stats;
+	S3TConv_ConvertSurface(&statsSurface);
+	S3TConv_Benchmark_Surface(name, surface, NULL);
+	printf("%-56s %10.1f%% hits\n", "", stats.cacheLookups != 0 ?
+			100.0 * (double) stats.cacheHits / (double) stats.cacheLookups : 0.0);
+}
+
+static void S3TConv_Benchmark_Synthetic(const S3TConv_Scheduler *scheduler) {
+	uint8_t *corpora[S3TCONV_ATITC_PATH_COUNT];
+	uint8_t *mixed, *blackMode, *mixedRGBA, *repeated, *target;
+	unsigned int blockCount = S3TConv_Benchmark_BlockCount, blockIndex, surfaceSize;
+	S3TConv_Benchmark_Blocks blocks;
+	S3TConv_Surface surface;
+	int path;
+
+	mixed = (uint8_t *) malloc((size_t) blockCount * 8);
+	blackMode = (uint8_t *) malloc((size_t) blockCount * 8);
+	mixedRGBA = (uint8_t *) malloc((size_t) blockCount * 16);
+	repeated = (uint8_t *) malloc((size_t) blockCount * 8);
+	// Large enough for RGBA8 pixels.
+	target = (uint8_t *) malloc((size_t) blockCount * 64);
+	if (mixed == NULL || blackMode == NULL || mixedRGBA == NULL || repeated == NULL || target == NULL) {
+		fprintf(stderr, "Out of memory.\n");
+		exit(EXIT_FAILURE);
+	}
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		corpora[path] = S3TConv_Benchmark_GenerateCorpus((S3TConv_ATITC_Path) path);
+		if (corpora[path] == NULL) {
+			fprintf(stderr, "Out of memory.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	printf("Synthetic corpora, %u blocks each.\n\nS3TConv_ATITC_RGBBlockFromDXT by path (DXT1):\n", blockCount);
+	blocks.target = target;
+	blocks.blockCount = blockCount;
+	blocks.asDXT1 = 1;
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		blocks.source = corpora[path];
+		S3TConv_Benchmark_Report(S3TConv_ATITC_GetPathName((S3TConv_ATITC_Path) path), blockCount, 8,
+				S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlockFromDXT, &blocks));
+	}
+
+	// Mixed corpus: blocks of all paths, half in the four-color mode.
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		unsigned int sourcePath = ((blockIndex & 1) ? 1 + (blockIndex >> 1) % (S3TCONV_ATITC_PATH_COUNT - 1) : 0);
+		memcpy(mixed + (size_t) blockIndex * 8, corpora[sourcePath] + (size_t) blockIndex * 8, 8);
+		memcpy(blackMode + (size_t) blockIndex * 8,
+				corpora[1 + blockIndex % (S3TCONV_ATITC_PATH_COUNT - 1)] + (size_t) blockIndex * 8, 8);
+		mixedRGBA[(size_t) blockIndex * 16] = (uint8_t) S3TConv_Benchmark_Random();
+		mixedRGBA[(size_t) blockIndex * 16 + 1] = (uint8_t) S3TConv_Benchmark_Random();
+		for (path = 2; path < 8; ++path) {
+			mixedRGBA[(size_t) blockIndex * 16 + path] = (uint8_t) S3TConv_Benchmark_Random();
+		}
+		memcpy(mixedRGBA + (size_t) blockIndex * 16 + 8, corpora[0] + (size_t) blockIndex * 8, 8);
+	}
+	// Mixed corpus with 30% of the blocks taken from a set of 32, like solid colors and borders in atlases.
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		memcpy(repeated + (size_t) blockIndex * 8, mixed + (size_t) (S3TConv_Benchmark_Random() % 10 < 3 ?
+				S3TConv_Benchmark_Random() % 32 : blockIndex) * 8, 8);
+	}
+
+	printf("\nS3TConv_ATITC_RGBBlockFromDXTWithQuality by level (DXT1):\n");
+	blocks.source = blackMode;
+	S3TConv_Benchmark_Qualities("Black mode blocks of all paths", &blocks);
+	blocks.source = mixed;
+	S3TConv_Benchmark_Qualities("Mixed", &blocks);
+
+	printf("\nS3TConv_ETC2_RGBBlockFromDXTWithQuality by level (DXT1):\n");
+	S3TConv_Benchmark_ETC2Qualities("Mixed", &blocks);
+	blocks.source = corpora[S3TCONV_ATITC_PATH_FOUR_COLOR];
+	S3TConv_Benchmark_ETC2Qualities("Four-color", &blocks);
+
+	printf("\nPublic functions (mixed DXT1 corpus unless specified):\n");
+	blocks.source = mixed;
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBBlockFromDXT", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlockFromDXT, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBBlocksFromDXT", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlocksFromDXT, &blocks));
+	blocks.source = corpora[S3TCONV_ATITC_PATH_FOUR_COLOR];
+	blocks.asDXT1 = 0;
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBBlockFromDXT (DXT3/DXT5 colors)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlockFromDXT, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBBlocksFromDXT (DXT3/DXT5 colors)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBBlocksFromDXT, &blocks));
+	blocks.source = mixed;
+	blocks.asDXT1 = 1;
+	blocks.sourceFormat = S3TCONV_FORMAT_DXT1;
+	S3TConv_Benchmark_Report("DXT1 to ATC_RGBA_INTERPOLATED, separate alpha and RGB", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlockFromDXTSeparately, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBABlockFromDXT (DXT1)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlockFromDXT, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBABlocksFromDXT (DXT1)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlocksFromDXT, &blocks));
+	blocks.source = mixedRGBA;
+	blocks.asDXT1 = 0;
+	blocks.sourceFormat = S3TCONV_FORMAT_DXT5;
+	S3TConv_Benchmark_Report("DXT5 to ATC_RGBA_INTERPOLATED, separate alpha and RGB", blockCount, 16,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlockFromDXTSeparately, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBABlockFromDXT (DXT5)", blockCount, 16,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlockFromDXT, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ATITC_RGBABlocksFromDXT (DXT5)", blockCount, 16,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_RGBABlocksFromDXT, &blocks));
+	blocks.source = mixed;
+	blocks.asDXT1 = 1;
+	S3TConv_Benchmark_Report("S3TConv_ETC2_RGBBlockFromDXT", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_ETC2RGBBlockFromDXT, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_ASTC_BlockFromDXT", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_ASTCBlockFromDXT, &blocks));
+	blocks.source = corpora[S3TCONV_ATITC_PATH_FOUR_COLOR];
+	S3TConv_Benchmark_Report("S3TConv_ASTC_BlockFromDXT (four-color blocks)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_ASTCBlockFromDXT, &blocks));
+	blocks.source = mixed;
+	S3TConv_Benchmark_Report("S3TConv_DXT1_BlockHasPunchthroughPixels", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_BlockHasPunchthroughPixels, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_DXT1_PunchthroughToExplicitAlpha", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_PunchthroughToExplicitAlpha, &blocks));
+	S3TConv_Benchmark_Report("S3TConv_DXT1_PunchthroughToInterpolatedAlpha", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_PunchthroughToInterpolatedAlpha, &blocks));
+
+	// Square-ish surfaces made of the mixed corpus.
+	for (surfaceSize = 4; (surfaceSize >> 2) * (surfaceSize >> 2) * 4 <= blockCount; surfaceSize <<= 1) {}
+	memset(&surface, 0, sizeof(surface));
+	surface.asDXT1 = 0;
+	surface.sourceRowPitch = 0;
+	surface.targetData = target;
+	surface.targetRowPitch = 0;
+	surface.width = surfaceSize;
+	surface.height = ((blockCount / (surfaceSize >> 2)) << 2);
+	printf("\nSurface conversion (%ux%u):\n", surface.width, surface.height);
+	surface.sourceData = corpora[S3TCONV_ATITC_PATH_FOUR_COLOR];
+	surface.sourceFormat = S3TCONV_FORMAT_DXT1;
+	S3TConv_Benchmark_Report("S3TConv_DXT1_AnalyzeSurface (opaque four-color)", blockCount, 8,
+			S3TConv_Benchmark_Run(S3TConv_Benchmark_AnalyzeSurface, &surface));
+	surface.sourceData = mixed;
+	surface.targetFormat = S3TCONV_FORMAT_ATITC_RGB;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGB", &surface, NULL);
+	surface.quality = S3TCONV_QUALITY_FAST;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGB (fast quality)", &surface, NULL);
+	surface.quality = S3TCONV_QUALITY_HIGH;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGB (high quality)", &surface, NULL);
+	surface.quality = S3TCONV_QUALITY_DEFAULT;
+	surface.useBlockCache = 1;
+	S3TConv_Benchmark_CachedSurface("DXT1 to ATC_RGB (block cache)", &surface);
+	surface.useBlockCache = 0;
+	S3TConv_Benchmark_PagedSurface("DXT1 to ATC_RGB (128x128 pages, 4-pixel border)", &surface, 128);
+	S3TConv_Benchmark_FileCachedSurface("DXT1 to ATC_RGB (loaded from the file cache)", &surface);
+	surface.sourceData = repeated;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGB (30% repeated blocks)", &surface, NULL);
+	surface.useBlockCache = 1;
+	S3TConv_Benchmark_CachedSurface("DXT1 to ATC_RGB (30% repeated blocks, block cache)", &surface);
+	surface.sourceData = mixed;
+	surface.useBlockCache = 0;
+	surface.targetFormat = S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGBA_EXPLICIT", &surface, NULL);
+	surface.targetFormat = S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED;
+	S3TConv_Benchmark_Surface("DXT1 to ATC_RGBA_INTERPOLATED", &surface, NULL);
+	surface.sourceData = mixedRGBA;
+	surface.sourceFormat = S3TCONV_FORMAT_DXT5;
+	S3TConv_Benchmark_Surface("DXT5 to ATC_RGBA_INTERPOLATED", &surface, NULL);
+	if (scheduler != NULL) {
+		S3TConv_Benchmark_Surface("DXT5 to ATC_RGBA_INTERPOLATED (thread pool)", &surface, scheduler);
+	}
+	surface.targetFormat = S3TCONV_FORMAT_ETC2_RGBA;
+	S3TConv_Benchmark_Surface("DXT5 to ETC2_RGBA", &surface, NULL);
+	surface.targetFormat = S3TCONV_FORMAT_ASTC_4X4;
+	S3TConv_Benchmark_Surface("DXT5 to ASTC_4X4", &surface, NULL);
+	S3TConv_Benchmark_Decoded("DXT5 decoding to RGBA4444", &surface, S3TCONV_PIXEL_FORMAT_RGBA4444);
+	S3TConv_Benchmark_Decoded("DXT5 decoding to RGBA8", &surface, S3TCONV_PIXEL_FORMAT_RGBA8);
+	surface.sourceData = mixed;
+	surface.sourceFormat = S3TCONV_FORMAT_DXT1;
+	surface.targetFormat = S3TCONV_FORMAT_ETC2_RGB;
+	S3TConv_Benchmark_Surface("DXT1 to ETC2_RGB", &surface, NULL);
+	surface.targetFormat = S3TCONV_FORMAT_ETC2_RGB8A1;
+	S3TConv_Benchmark_Surface("DXT1 to ETC2_RGB8A1", &surface, NULL);
+	surface.targetFormat = S3TCONV_FORMAT_ASTC_4X4;
+	S3TConv_Benchmark_Surface("DXT1 to ASTC_4X4", &surface, NULL);
+	S3TConv_Benchmark_Decoded("DXT1 decoding to RGB565", &surface, S3TCONV_PIXEL_FORMAT_RGB565);
+	S3TConv_Benchmark_Decoded("DXT1 decoding to RGBA8", &surface, S3TCONV_PIXEL_FORMAT_RGBA8);
+	surface.sourceData = repeated;
+	surface.targetFormat = S3TCONV_FORMAT_ETC2_RGB;
+	surface.useBlockCache = 1;
+	S3TConv_Benchmark_CachedSurface("DXT1 to ETC2_RGB (30% repeated blocks, block cache)", &surface);
+	surface.useBlockCache = 0;
+	if (scheduler != NULL) {
+		surface.sourceData = mixed;
+		S3TConv_Benchmark_Surface("DXT1 to ETC2_RGB (thread pool)", &surface, scheduler);
+	}
+
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		free(corpora[path]);
+	}
+	free(target);
+	free(repeated);
+	free(mixedRGBA);
+	free(blackMode);
+	free(mixed);
+}
+
+typedef struct {
+	const uint8_t *ddsData;
+	size_t ddsSize;
+	S3TConv_Format targetFormat;
+	S3TConv_Quality quality;
+	uint8_t *ktxData;
+	const S3TConv_Scheduler *scheduler;
+} S3TConv_Benchmark_DDS;
+
+static void S3TConv_Benchmark_ConvertDDS(void *data) {
+	const S3TConv_Benchmark_DDS *dds = (const S3TConv_Benchmark_DDS *) data;
+	S3TConv_DDS_ConvertToKTX(dds->ddsData, dds->ddsSize, 0, dds->targetFormat, dds->quality, dds->ktxData,
+			dds->scheduler, NULL);
+}
+
+static void S3TConv_Benchmark_File(const char *fileName, const S3TConv_Scheduler *scheduler) {
+	static const char * const formatNames[] = { "DXT1", "DXT3", "DXT5" };
+	S3TConv_MappedFile file;
+	S3TConv_DDSInfo info;
+	unsigned int blockSize, blockCount = 0, layer, face, level;
+	unsigned int pathBlockCounts[S3TCONV_ATITC_PATH_COUNT] = { 0 };
+	uint64_t qualityErrors[S3TCONV_QUALITY_HIGH + 1] = { 0 };
+	S3TConv_Benchmark_DDS dds;
+	uint8_t atitcBlock[8];
+	int path, quality;
+
+	if (!S3TConv_MappedFile_Open(&file, fileName)) {
+		fprintf(stderr, "%s: couldn't open the file.\n", fileName);
+		return;
+	}
+	if (!S3TConv_DDS_Parse(file.data, file.size, &info)) {
+		S3TConv_MappedFile_Close(&file);
+		fprintf(stderr, "%s: not a supported DXT1, DXT3 or DXT5 DDS file.\n", fileName);
+		return;
+	}
+	dds.ddsData = file.data;
+	dds.ddsSize = file.size;
+	dds.targetFormat = (info.format == S3TCONV_FORMAT_DXT1 ? S3TCONV_FORMAT_ATITC_RGB :
+			(info.format == S3TCONV_FORMAT_DXT3 ? S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT : S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED));
+	if (S3TConv_KTX_GetSizeForDDS(&info, dds.targetFormat) == 0) {
+		S3TConv_MappedFile_Close(&file);
+		fprintf(stderr, "%s: too large for KTX.\n", fileName);
+		return;
+	}
+	dds.ktxData = (uint8_t *) malloc(S3TConv_KTX_GetSizeForDDS(&info, dds.targetFormat));
+	if (dds.ktxData == NULL) {
+		S3TConv_MappedFile_Close(&file);
+		fprintf(stderr, "Out of memory.\n");
+		return;
+	}
+
+	printf("\n%s (%s, %ux%u, %u mipmaps, %u layers, %u faces):\n", fileName, formatNames[info.format],
+			info.width, info.height, info.levelCount, info.layerCount, info.faceCount);
+	blockSize = S3TConv_Format_GetBlockSize(info.format);
+	for (layer = 0; layer < info.layerCount; ++layer) {
+		for (face = 0; face < info.faceCount; ++face) {
+			for (level = 0; level < info.levelCount; ++level) {
+				const uint8_t *surfaceData = file.data + S3TConv_DDS_GetSurfaceOffset(&info, layer, face, level);
+				unsigned int width = info.width >> level, height = info.height >> level, blockX, blockY;
+				width = (width != 0 ? width : 1);
+				height = (height != 0 ? height : 1);
+				for (blockY = 0; blockY < ((height + 3) >> 2); ++blockY) {
+					for (blockX = 0; blockX < ((width + 3) >> 2); ++blockX) {
+						const uint8_t *dxtBlock =
+								surfaceData + ((size_t) blockY * ((width + 3) >> 2) + blockX) * blockSize + (blockSize - 8);
+						int asDXT1 = (info.format == S3TCONV_FORMAT_DXT1);
+						++pathBlockCounts[S3TConv_ATITC_RGBBlockFromDXTWithPath(dxtBlock, asDXT1, atitcBlock,
+								width - (blockX << 2), height - (blockY << 2))];
+						for (quality = S3TCONV_QUALITY_DEFAULT; quality <= S3TCONV_QUALITY_HIGH; ++quality) {
+							S3TConv_ATITC_RGBBlockFromDXTWithQuality(dxtBlock, asDXT1, (S3TConv_Quality) quality, atitcBlock,
+									width - (blockX << 2), height - (blockY << 2));
+							qualityErrors[quality] += S3TConv_ATITC_GetRGBBlockError(dxtBlock, asDXT1, atitcBlock,
+									width - (blockX << 2), height - (blockY << 2));
+						}
+						++blockCount;
+					}
+				}
+			}
+		}
+	}
+	for (path = 0; path < S3TCONV_ATITC_PATH_COUNT; ++path) {
+		printf("%-56s %10u blocks (%.1f%%)\n", S3TConv_ATITC_GetPathName((S3TConv_ATITC_Path) path), pathBlockCounts[path],
+				100.0 * (double) pathBlockCounts[path] / (double) blockCount);
+	}
+
+#ifdef S3TCONV_STATS
+	{
+		// Paths counted by the library itself, with timing if enabled.
+		S3TConv_Stats stats;
+		char statsText[2048];
+		memset(&stats, 0, sizeof(stats));
+		S3TConv_DDS_ConvertToKTX(dds.ddsData, dds.ddsSize, 0, dds.targetFormat, S3TCONV_QUALITY_DEFAULT, dds.ktxData,
+				NULL, &stats);
+		S3TConv_Stats_Format(&stats, statsText, sizeof(statsText));
+		printf("Library statistics:\n%s", statsText);
+	}
+#endif
+
+	// Each level of quality with the mean squared error per pixel, with padding pixels counted as exact for simplicity.
+	dds.scheduler = NULL;
+	for (quality = S3TCONV_QUALITY_DEFAULT; quality <= S3TCONV_QUALITY_HIGH; ++quality) {
+		char name[64];
+		snprintf(name, sizeof(name), "DDS to KTX (%s quality)", S3TConv_Benchmark_QualityNames[quality]);
+		dds.quality = (S3TConv_Quality) quality;
+		S3TConv_Benchmark_Report(name, blockCount, blockSize, S3TConv_Benchmark_Run(S3TConv_Benchmark_ConvertDDS, &dds));
+		printf("%-56s %10.2f MSE\n", "", (double) qualityErrors[quality] / ((double) blockCount * 16.0));
+	}
+	dds.quality = S3TCONV_QUALITY_DEFAULT;
+	if (scheduler != NULL) {
+		dds.scheduler = scheduler;
+		S3TConv_Benchmark_Report("DDS to KTX (thread pool)", blockCount, blockSize,
+				S3TConv_Benchmark_Run(S3TConv_Benchmark_ConvertDDS, &dds));
+	}
+
+	free(dds.ktxData);
+	S3TConv_MappedFile_Close(&file);
+}
+
+int main(int argc, char **argv) {
+	S3TConv_ThreadPool *pool;
+	S3TConv_Scheduler scheduler;
+	int argIndex, fileCount = 0;
+
+	for (argIndex = 1; argIndex < argc; ++argIndex) {
+		if (strcmp(argv[argIndex], "-blocks") == 0 && argIndex + 1 < argc) {
+			S3TConv_Benchmark_BlockCount = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+			if (S3TConv_Benchmark_BlockCount < 64) {
+				S3TConv_Benchmark_BlockCount = 64;
+			}
+		} else if (strcmp(argv[argIndex], "-time") == 0 && argIndex + 1 < argc) {
+			S3TConv_Benchmark_MinTime = atof(argv[++argIndex]);
+		} else if (argv[argIndex][0] == '-') {
+			fprintf(stderr, "Usage: %s [-blocks count] [-time seconds] [file.dds...]\n", argv[0]);
+			return EXIT_FAILURE;
+		} else {
+			++fileCount;
+		}
+	}
+
+	S3TConv_InitLookupTables();
+	printf("Lookup tables: %s.\n\n", S3TCONV_LOOKUP_TABLES == 1 ? "small per-component" :
+			(S3TCONV_LOOKUP_TABLES == 2 ? "64K-entry" : "none (arithmetic)"));
+
+	pool = S3TConv_ThreadPool_Create(0);
+	if (pool != NULL) {
+		S3TConv_ThreadPool_GetScheduler(pool, &scheduler);
+	}
+
+	if (fileCount == 0) {
+		S3TConv_Benchmark_Synthetic(pool != NULL ? &scheduler : NULL);
+	}
+	for (argIndex = 1; argIndex < argc; ++argIndex) {
+		if (argv[argIndex][0] == '-') {
+			++argIndex;
+			continue;
+		}
+		S3TConv_Benchmark_File(argv[argIndex], pool != NULL ? &scheduler : NULL);
+	}
+
+	S3TConv_ThreadPool_Destroy(pool);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,601 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Incremental batch conversion of DDS directory trees to KTX.
+// Usage: s3tconv [-format name] [-dxt1] [-quality level] [-threads count] [-cache path] [-force] input output
+// Input is a DDS file or a directory searched recursively, output is the directory for the KTX files, where the tree of
+// the input directory is recreated. Files are converted in parallel, and large ones are split into ranges of block rows
+// of all their mipmaps. Files that haven't changed since the last run with the same options are skipped, as the hashes
+// of the source and of the written KTX of every output file are stored in a cache file in the output directory.
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "s3tconv_internal.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <time.h>
+#endif
+
+#ifndef S_ISDIR
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#endif
+
+// Files with at least this many blocks are converted one by one, with their rows split between the threads, smaller
+// ones are converted in parallel with each other.
+#define S3TCONV_TOOL_LARGE_FILE_BLOCKS 16384
+
+typedef enum {
+	S3TCONV_TOOL_FORMAT_ATITC, // By the source format.
+	S3TCONV_TOOL_FORMAT_ETC2, // By the source format.
+	S3TCONV_TOOL_FORMAT_EXACT
+} S3TConv_Tool_FormatChoice;
+
+static const struct {
+	const char *name;
+	S3TConv_Tool_FormatChoice choice;
+	S3TConv_Format format;
+} S3TConv_Tool_Formats[] = {
+	{ "atc", S3TCONV_TOOL_FORMAT_ATITC, S3TCONV_FORMAT_ATITC_RGB },
+	{ "atc_rgb", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ATITC_RGB },
+	{ "atc_explicit", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT },
+	{ "atc_interpolated", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED },
+	{ "etc2", S3TCONV_TOOL_FORMAT_ETC2, S3TCONV_FORMAT_ETC2_RGB },
+	{ "etc2_rgb", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ETC2_RGB },
+	{ "etc2_rgb8a1", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ETC2_RGB8A1 },
+	{ "etc2_rgba", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ETC2_RGBA },
+	{ "astc", S3TCONV_TOOL_FORMAT_EXACT, S3TCONV_FORMAT_ASTC_4X4 }
+};
+
+typedef enum {
+	S3TCONV_TOOL_FILE_INVALID,
+	S3TCONV_TOOL_FILE_CACHED, // Converted with the same options before, the output is yet to be checked.
+	S3TCONV_TOOL_FILE_UNCHANGED,
+	S3TCONV_TOOL_FILE_PENDING,
+	S3TCONV_TOOL_FILE_CONVERTED,
+	S3TCONV_TOOL_FILE_FAILED
+} S3TConv_Tool_FileState;
+
+// Cache entry data of an output file, keyed by the path of the output file, so an entry is replaced whenever the file
+// is written, and options changed and then restored don't make an outdated file look unchanged.
+typedef struct {
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint32_t targetFormat;
+	uint32_t parameters;
+	uint64_t ktxSize;
+	// S3TConv_Hash64 of the written KTX file, checked against the file before skipping it.
+	uint64_t ktxHash;
+} S3TConv_Tool_CacheEntry;
+
+typedef struct {
+	// Relative to the input directory, with '/' separators and without the extension.
+	char *relativePath;
+	char *ddsPath;
+	char *ktxPath;
+	S3TConv_FileCacheKey key;
+	S3TConv_Tool_CacheEntry entry;
+	uint64_t ddsSize;
+	uint64_t blockCount;
+	S3TConv_Tool_FileState state;
+	S3TConv_Stats stats;
+} S3TConv_Tool_File;
+
+typedef struct {
+	S3TConv_Tool_FormatChoice formatChoice;
+	S3TConv_Format format;
+	int asDXT1;
+	S3TConv_Quality quality;
+	S3TConv_Tool_File *files;
+	unsigned int fileCount, fileCapacity;
+} S3TConv_Tool_Batch;
+
+typedef struct {
+	const S3TConv_Tool_Batch *batch;
+	S3TConv_Tool_File *file;
+} S3TConv_Tool_Job;
+
+static double S3TConv_Tool_GetTime(void) {
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+#endif
+}
+
+static char *S3TConv_Tool_JoinPath(const char *directory, const char *name, const char *extension) {
+	size_t directoryLength = strlen(directory), nameLength = strlen(name), extensionLength = strlen(extension);
+	char *path = (char *) malloc(directoryLength + 1 + nameLength + extensionLength + 1);
+	if (path == NULL) {
+		return NULL;
+	}
+	memcpy(path, directory, directoryLength);
+	path[directoryLength] = '/';
+	memcpy(path + directoryLength + 1, name, nameLength);
+	memcpy(path + directoryLength + 1 + nameLength, extension, extensionLength + 1);
+	return path;
+}
+
+static int S3TConv_Tool_HasDDSExtension(const char *name) {
+	size_t length = strlen(name);
+	const char *extension = name + length - 4;
+	return length > 4 && extension[0] == '.' && (extension[1] | 0x20) == 'd' &&
+			(extension[2] | 0x20) == 'd' && (extension[3] | 0x20) == 's';
+}
+
+static int S3TConv_Tool_AddFile(S3TConv_Tool_Batch *batch, const char *ddsPath, const char *relativePath) {
+	S3TConv_Tool_File *file;
+	size_t relativePathLength = strlen(relativePath) - 4;
+	if (batch->fileCount >= batch->fileCapacity) {
+		unsigned int fileCapacity = (batch->fileCapacity != 0 ? batch->fileCapacity << 1 : 256);
+		S3TConv_Tool_File *files = (S3TConv_Tool_File *) realloc(batch->files, fileCapacity * sizeof(S3TConv_Tool_File));
+		if (files == NULL) {
+			return 0;
+		}
+		batch->files = files;
+		batch->fileCapacity = fileCapacity;
+	}
+	file = &batch->files[batch->fileCount];
+	memset(file, 0, sizeof(S3TConv_Tool_File));
+	file->ddsPath = (char *) malloc(strlen(ddsPath) + 1);
+	file->relativePath = (char *) malloc(relativePathLength + 1);
+	if (file->ddsPath == NULL || file->relativePath == NULL) {
+		free(file->relativePath);
+		free(file->ddsPath);
+		return 0;
+	}
+	strcpy(file->ddsPath, ddsPath);
+	memcpy(file->relativePath, relativePath, relativePathLength);
+	file->relativePath[relativePathLength] = '\0';
+	++batch->fileCount;
+	return 1;
+}
+
+// Adds all DDS files in a directory and its subdirectories. relativePath is "" for the input directory itself.
+static int S3TConv_Tool_AddDirectory(S3TConv_Tool_Batch *batch, const char *path, const char *relativePath) {
+	int succeeded = 1;
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle;
+	char *pattern = S3TConv_Tool_JoinPath(path, "*", "");
+	if (pattern == NULL) {
+		return 0;
+	}
+	findHandle = FindFirstFileA(pattern, &findData);
+	free(pattern);
+	if (findHandle == INVALID_HANDLE_VALUE) {
+		return 1;
+	}
+	do {
+		const char *name = findData.cFileName;
+		int isDirectory = ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+#else
+	DIR *directory = opendir(path);
+	struct dirent *entry;
+	struct stat entryStat;
+	if (directory == NULL) {
+		fprintf(stderr, "%s: couldn't open the directory.\n", path);
+		return 1;
+	}
+	while (succeeded && (entry = readdir(directory)) != NULL) {
+		const char *name = entry->d_name;
+		int isDirectory;
+#endif
+		char *entryPath, *entryRelativePath;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+			continue;
+		}
+		entryPath = S3TConv_Tool_JoinPath(path, name, "");
+		entryRelativePath = (relativePath[0] != '\0' ? S3TConv_Tool_JoinPath(relativePath, name, "") : NULL);
+		if (entryPath == NULL || (relativePath[0] != '\0' && entryRelativePath == NULL)) {
+			free(entryRelativePath);
+			free(entryPath);
+			succeeded = 0;
+			break;
+		}
+#ifndef _WIN32
+		isDirectory = (stat(entryPath, &entryStat) == 0 && S_ISDIR(entryStat.st_mode));
+#endif
+		if (isDirectory) {
+			succeeded = S3TConv_Tool_AddDirectory(batch, entryPath, entryRelativePath != NULL ? entryRelativePath : name);
+		} else if (S3TConv_Tool_HasDDSExtension(name)) {
+			succeeded = S3TConv_Tool_AddFile(batch, entryPath, entryRelativePath != NULL ? entryRelativePath : name);
+		}
+		free(entryRelativePath);
+		free(entryPath);
+#ifdef _WIN32
+	} while (succeeded && FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+#else
+	}
+	closedir(directory);
+#endif
+	return succeeded;
+}
+
+// Creates the directories containing a file, returns 0 if it can't be written there.
+static int S3TConv_Tool_CreateParentDirectories(const char *filePath) {
+	size_t length = strlen(filePath), position;
+	char *path = (char *) malloc(length + 1);
+	if (path == NULL) {
+		return 0;
+	}
+	memcpy(path, filePath, length + 1);
+	for (position = 1; position < length; ++position) {
+		if (path[position] != '/' && path[position] != '\\') {
+			continue;
+		}
+		path[position] = '\0';
+		// Existing directories are not an error.
+#ifdef _WIN32
+		_mkdir(path);
+#else
+		mkdir(path, 0777);
+#endif
+		path[position] = filePath[position];
+	}
+	free(path);
+	return 1;
+}
+
+static S3TConv_Format S3TConv_Tool_GetTargetFormat(const S3TConv_Tool_Batch *batch, S3TConv_Format sourceFormat) {
+	switch (batch->formatChoice) {
+	case S3TCONV_TOOL_FORMAT_ATITC:
+		return sourceFormat == S3TCONV_FORMAT_DXT1 ? S3TCONV_FORMAT_ATITC_RGB :
+				(sourceFormat == S3TCONV_FORMAT_DXT3 ? S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT : S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED);
+	case S3TCONV_TOOL_FORMAT_ETC2:
+		return sourceFormat == S3TCONV_FORMAT_DXT1 ? S3TCONV_FORMAT_ETC2_RGB : S3TCONV_FORMAT_ETC2_RGBA;
+	default:
+		return batch->format;
+	}
+}
+
+// Hashes and parses a file to check whether it needs to be converted.
+static void S3TConv_Tool_ScanFile(void *jobData) {
+	const S3TConv_Tool_Job *job = (const S3TConv_Tool_Job *) jobData;
+	S3TConv_Tool_File *file = job->file;
+	S3TConv_MappedFile ddsFile;
+	S3TConv_DDSInfo info;
+	unsigned int level;
+
+	if (!S3TConv_MappedFile_Open(&ddsFile, file->ddsPath)) {
+		return;
+	}
+	if (S3TConv_DDS_Parse(ddsFile.data, ddsFile.size, &info)) {
+		// Relative to the output directory, so the cache stays valid if it's moved together with the output.
+		memset(&file->key, 0, sizeof(file->key));
+		file->key.sourceHash = S3TConv_Hash64(file->relativePath, strlen(file->relativePath), 0);
+		file->entry.sourceHash = S3TConv_Hash64(ddsFile.data, ddsFile.size, 0);
+		file->entry.sourceSize = ddsFile.size;
+		file->entry.targetFormat = (uint32_t) S3TConv_Tool_GetTargetFormat(job->batch, info.format);
+		file->entry.parameters = (job->batch->asDXT1 ? 1 : 0) | ((uint32_t) job->batch->quality << 16);
+		file->entry.ktxSize = S3TConv_KTX_GetSizeForDDS(&info, (S3TConv_Format) file->entry.targetFormat);
+		if (S3TConv_IsConversionSupported(info.format, (S3TConv_Format) file->entry.targetFormat) &&
+				file->entry.ktxSize != 0) {
+			file->ddsSize = ddsFile.size;
+			// Counted in 64 bits, as large arrays may have more blocks than fit in unsigned int.
+			for (level = 0; level < info.levelCount; ++level) {
+				unsigned int width = info.width >> level, height = info.height >> level;
+				file->blockCount += (uint64_t) (((width != 0 ? width : 1) + 3) >> 2) *
+						(((height != 0 ? height : 1) + 3) >> 2) * info.layerCount * info.faceCount;
+			}
+			file->state = S3TCONV_TOOL_FILE_PENDING;
+		}
+	}
+	S3TConv_MappedFile_Close(&ddsFile);
+}
+
+// Hashes the whole file, returns 0 if it can't be read.
+static int S3TConv_Tool_HashFile(const char *path, uint64_t *size, uint64_t *hash) {
+	S3TConv_MappedFile mappedFile;
+	if (!S3TConv_MappedFile_Open(&mappedFile, path)) {
+		return 0;
+	}
+	*size = mappedFile.size;
+	*hash = S3TConv_Hash64(mappedFile.data, mappedFile.size, 0);
+	S3TConv_MappedFile_Close(&mappedFile);
+	return 1;
+}
+
+// Converts a file found in the cache again if its output has been changed or removed since it was written.
+static void S3TConv_Tool_CheckOutput(void *jobData) {
+	const S3TConv_Tool_Job *job = (const S3TConv_Tool_Job *) jobData;
+	S3TConv_Tool_File *file = job->file;
+	uint64_t ktxSize, ktxHash;
+	file->state = (S3TConv_Tool_HashFile(file->ktxPath, &ktxSize, &ktxHash) &&
+			ktxSize == file->entry.ktxSize && ktxHash == file->entry.ktxHash) ?
+			S3TCONV_TOOL_FILE_UNCHANGED : S3TCONV_TOOL_FILE_PENDING;
+}
+
+static void S3TConv_Tool_ConvertFile(const S3TConv_Tool_Batch *batch, S3TConv_Tool_File *file,
+		const S3TConv_Scheduler *scheduler) {
+	uint64_t ktxSize;
+	file->state = S3TCONV_TOOL_FILE_FAILED;
+	if (S3TConv_Tool_CreateParentDirectories(file->ktxPath) &&
+			S3TConv_DDS_ConvertFileToKTX(file->ddsPath, file->ktxPath, batch->asDXT1,
+					(S3TConv_Format) file->entry.targetFormat, batch->quality, scheduler, &file->stats) &&
+			S3TConv_Tool_HashFile(file->ktxPath, &ktxSize, &file->entry.ktxHash) && ktxSize == file->entry.ktxSize) {
+		file->state = S3TCONV_TOOL_FILE_CONVERTED;
+	}
+}
+
+static void S3TConv_Tool_ConvertSmallFile(void *jobData) {
+	const S3TConv_Tool_Job *job = (const S3TConv_Tool_Job *) jobData;
+	S3TConv_Tool_ConvertFile(job->batch, job->file, NULL);
+}
+
+// Runs a job for every file in the state, on the scheduler if there is one.
+static void S3TConv_Tool_RunJobs(S3TConv_Tool_Batch *batch, S3TConv_Tool_Job *jobs, S3TConv_JobFunction function,
+		S3TConv_Tool_FileState state, uint64_t maxBlockCount, const S3TConv_Scheduler *scheduler) {
+	unsigned int fileIndex;
+	for (fileIndex = 0; fileIndex < batch->fileCount; ++fileIndex) {
+		S3TConv_Tool_File *file = &batch->files[fileIndex];
+		if (file->state != state || file->blockCount > maxBlockCount) {
+			continue;
+		}
+		jobs[fileIndex].batch = batch;
+		jobs[fileIndex].file = file;
+		if (scheduler != NULL) {
+			scheduler->submit(scheduler->schedulerData, function, &jobs[fileIndex]);
+		} else {
+			function(&jobs[fileIndex]);
+		}
+	}
+	if (scheduler != NULL) {
+		scheduler->wait(scheduler->schedulerData);
+	}
+}
+
+static void S3TConv_Tool_PrintUsage(const char *program) {
+	unsigned int formatIndex;
+	fprintf(stderr, "Usage: %s [-format name] [-dxt1] [-quality level] [-threads count] [-cache path] [-force] input output\n"
+			"  input            DDS file or directory with DDS files (searched recursively).\n"
+			"  output           Directory for the KTX files.\n"
+			"  -format name     Target format (atc by default):", program);
+	for (formatIndex = 0; formatIndex < sizeof(S3TConv_Tool_Formats) / sizeof(S3TConv_Tool_Formats[0]); ++formatIndex) {
+		fprintf(stderr, "%s %s", formatIndex != 0 ? "," : "", S3TConv_Tool_Formats[formatIndex].name);
+	}
+	fprintf(stderr, ".\n"
+			"                   atc and etc2 choose the alpha format by the source format.\n"
+			"  -dxt1            Decode DXT3 and DXT5 colors like DXT1 (asDXT1).\n"
+			"  -quality level   Conversion of DXT1 black mode blocks to ATITC and of all blocks to ETC2:\n"
+			"                   fast, default or high.\n"
+			"  -threads count   Number of threads, 0 for all logical processors (default).\n"
+			"  -cache path      File storing the hashes of the sources and the outputs\n"
+			"                   (output/s3tconv.cache by default).\n"
+			"  -force           Convert all files, even if they haven't changed.\n");
+}
+
+int main(int argc, char **argv) {
+	S3TConv_Tool_Batch batch;
+	S3TConv_Tool_Job *jobs = NULL;
+	S3TConv_ThreadPool *pool;
+	S3TConv_Scheduler scheduler;
+	const S3TConv_Scheduler *usedScheduler;
+	S3TConv_FileCache *cache;
+	S3TConv_Stats stats;
+	const char *inputPath = NULL, *outputPath = NULL, *formatName = "atc", *qualityName = "default", *cachePath = NULL;
+	char *defaultCachePath = NULL, statsText[2048];
+	unsigned int threadCount = 0, fileIndex, formatIndex;
+	unsigned int convertedCount = 0, unchangedCount = 0, failedCount = 0;
+	uint64_t ddsSize = 0;
+	struct stat inputStat;
+	double startTime, scanTime, time;
+	int argIndex, force = 0, succeeded = 1;
+
+	memset(&batch, 0, sizeof(batch));
+	for (argIndex = 1; argIndex < argc; ++argIndex) {
+		if (strcmp(argv[argIndex], "-format") == 0 && argIndex + 1 < argc) {
+			formatName = argv[++argIndex];
+		} else if (strcmp(argv[argIndex], "-dxt1") == 0) {
+			batch.asDXT1 = 1;
+		} else if (strcmp(argv[argIndex], "-quality") == 0 && argIndex + 1 < argc) {
+			qualityName = argv[++argIndex];
+		} else if (strcmp(argv[argIndex], "-threads") == 0 && argIndex + 1 < argc) {
+			threadCount = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+		} else if (strcmp(argv[argIndex], "-cache") == 0 && argIndex + 1 < argc) {
+			cachePath = argv[++argIndex];
+		} else if (strcmp(argv[argIndex], "-force") == 0) {
+			force = 1;
+		} else if (argv[argIndex][0] != '-' && inputPath == NULL) {
+			inputPath = argv[argIndex];
+		} else if (argv[argIndex][0] != '-' && outputPath == NULL) {
+			outputPath = argv[argIndex];
+		} else {
+			inputPath = NULL;
+			break;
+		}
+	}
+	for (formatIndex = 0; formatIndex < sizeof(S3TConv_Tool_Formats) / sizeof(S3TConv_Tool_Formats[0]); ++formatIndex) {
+		if (strcmp(formatName, S3TConv_Tool_Formats[formatIndex].name) == 0) {
+			batch.formatChoice = S3TConv_Tool_Formats[formatIndex].choice;
+			batch.format = S3TConv_Tool_Formats[formatIndex].format;
+			break;
+		}
+	}
+	if (strcmp(qualityName, "fast") == 0) {
+		batch.quality = S3TCONV_QUALITY_FAST;
+	} else if (strcmp(qualityName, "high") == 0) {
+		batch.quality = S3TCONV_QUALITY_HIGH;
+	} else if (strcmp(qualityName, "default") != 0) {
+		inputPath = NULL;
+	}
+	if (inputPath == NULL || outputPath == NULL ||
+			formatIndex >= sizeof(S3TConv_Tool_Formats) / sizeof(S3TConv_Tool_Formats[0])) {
+		S3TConv_Tool_PrintUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	S3TConv_InitLookupTables();
+	startTime = S3TConv_Tool_GetTime();
+
+	// Gathering the files.
+	if (stat(inputPath, &inputStat) != 0) {
+		fprintf(stderr, "%s: not found.\n", inputPath);
+		return EXIT_FAILURE;
+	}
+	if (S_ISDIR(inputStat.st_mode)) {
+		succeeded = S3TConv_Tool_AddDirectory(&batch, inputPath, "");
+	} else {
+		const char *name = inputPath + strlen(inputPath);
+		while (name > inputPath && name[-1] != '/' && name[-1] != '\\') {
+			--name;
+		}
+		if (!S3TConv_Tool_HasDDSExtension(name)) {
+			fprintf(stderr, "%s: not a DDS file.\n", inputPath);
+			return EXIT_FAILURE;
+		}
+		succeeded = S3TConv_Tool_AddFile(&batch, inputPath, name);
+	}
+	for (fileIndex = 0; succeeded && fileIndex < batch.fileCount; ++fileIndex) {
+		batch.files[fileIndex].ktxPath = S3TConv_Tool_JoinPath(outputPath, batch.files[fileIndex].relativePath, ".ktx");
+		succeeded = (batch.files[fileIndex].ktxPath != NULL);
+	}
+	if (cachePath == NULL) {
+		defaultCachePath = S3TConv_Tool_JoinPath(outputPath, "s3tconv.cache", "");
+		cachePath = defaultCachePath;
+	}
+	if (batch.fileCount != 0) {
+		jobs = (S3TConv_Tool_Job *) malloc(batch.fileCount * sizeof(S3TConv_Tool_Job));
+	}
+	// The cache file is in the output directory by default.
+	if (cachePath != NULL && !S3TConv_Tool_CreateParentDirectories(cachePath)) {
+		cachePath = NULL;
+	}
+	cache = (cachePath != NULL ? S3TConv_FileCache_Open(cachePath, (uint64_t) 1 << 30) : NULL);
+	if (!succeeded || cache == NULL || (batch.fileCount != 0 && jobs == NULL)) {
+		fprintf(stderr, "Out of memory.\n");
+		return EXIT_FAILURE;
+	}
+
+	pool = S3TConv_ThreadPool_Create(threadCount);
+	usedScheduler = NULL;
+	if (pool != NULL) {
+		S3TConv_ThreadPool_GetScheduler(pool, &scheduler);
+		usedScheduler = &scheduler;
+	}
+
+	// Hashing all files and skipping those converted with the same options before.
+	S3TConv_Tool_RunJobs(&batch, jobs, S3TConv_Tool_ScanFile, S3TCONV_TOOL_FILE_INVALID, UINT_MAX, usedScheduler);
+	for (fileIndex = 0; fileIndex < batch.fileCount; ++fileIndex) {
+		S3TConv_Tool_File *file = &batch.files[fileIndex];
+		const uint8_t *cachedEntry;
+		size_t cachedEntrySize;
+		if (file->state != S3TCONV_TOOL_FILE_PENDING) {
+			fprintf(stderr, "%s: not a supported DXT1, DXT3 or DXT5 DDS file, or not convertible to the target format.\n",
+					file->ddsPath);
+			continue;
+		}
+		// The hash of the written KTX is taken from the entry, and the output is checked against it later.
+		cachedEntry = S3TConv_FileCache_Find(cache, &file->key, &cachedEntrySize);
+		if (!force && cachedEntry != NULL && cachedEntrySize == sizeof(S3TConv_Tool_CacheEntry)) {
+			S3TConv_Tool_CacheEntry entry;
+			memcpy(&entry, cachedEntry, sizeof(entry));
+			if (entry.sourceHash == file->entry.sourceHash && entry.sourceSize == file->entry.sourceSize &&
+					entry.targetFormat == file->entry.targetFormat && entry.parameters == file->entry.parameters &&
+					entry.ktxSize == file->entry.ktxSize) {
+				file->entry.ktxHash = entry.ktxHash;
+				file->state = S3TCONV_TOOL_FILE_CACHED;
+			}
+		}
+	}
+	// The output must also still be there and not modified.
+	S3TConv_Tool_RunJobs(&batch, jobs, S3TConv_Tool_CheckOutput, S3TCONV_TOOL_FILE_CACHED, UINT64_MAX, usedScheduler);
+	scanTime = S3TConv_Tool_GetTime();
+
+	// Small files in parallel with each other, then large files one by one split into jobs.
+	S3TConv_Tool_RunJobs(&batch, jobs, S3TConv_Tool_ConvertSmallFile, S3TCONV_TOOL_FILE_PENDING,
+			S3TCONV_TOOL_LARGE_FILE_BLOCKS - 1, usedScheduler);
+	for (fileIndex = 0; fileIndex < batch.fileCount; ++fileIndex) {
+		if (batch.files[fileIndex].state == S3TCONV_TOOL_FILE_PENDING) {
+			S3TConv_Tool_ConvertFile(&batch, &batch.files[fileIndex], usedScheduler);
+		}
+	}
+	time = S3TConv_Tool_GetTime();
+	S3TConv_ThreadPool_Destroy(pool);
+
+	memset(&stats, 0, sizeof(stats));
+	for (fileIndex = 0; fileIndex < batch.fileCount; ++fileIndex) {
+		S3TConv_Tool_File *file = &batch.files[fileIndex];
+		switch (file->state) {
+		case S3TCONV_TOOL_FILE_UNCHANGED:
+			++unchangedCount;
+			break;
+		case S3TCONV_TOOL_FILE_CONVERTED:
+			++convertedCount;
+			ddsSize += file->ddsSize;
+			S3TConv_Stats_Add(&stats, &file->stats);
+			S3TConv_FileCache_Add(cache, &file->key, &file->entry, sizeof(file->entry));
+			break;
+		case S3TCONV_TOOL_FILE_FAILED:
+			fprintf(stderr, "%s: couldn't convert to %s.\n", file->ddsPath, file->ktxPath);
+			++failedCount;
+			break;
+		default:
+			++failedCount;
+			break;
+		}
+	}
+	if (!S3TConv_FileCache_Close(cache)) {
+		fprintf(stderr, "%s: couldn't write the cache file.\n", cachePath);
+	}
+
+	printf("%u files converted, %u unchanged, %u failed.\n", convertedCount, unchangedCount, failedCount);
+	printf("Scanning: %.3f s.\n", scanTime - startTime);
+	if (time > scanTime && convertedCount != 0) {
+		printf("Conversion: %.3f s, %.2f Mblocks/s, %.1f MB/s of DDS data.\n", time - scanTime,
+				(double) stats.blockCount / (time - scanTime) * 1e-6,
+				(double) ddsSize / (time - scanTime) / (1024.0 * 1024.0));
+		S3TConv_Stats_Format(&stats, statsText, sizeof(statsText));
+		printf("%s", statsText);
+	}
+
+	for (fileIndex = 0; fileIndex < batch.fileCount; ++fileIndex) {
+		free(batch.files[fileIndex].ktxPath);
+		free(batch.files[fileIndex].ddsPath);
+		free(batch.files[fileIndex].relativePath);
+	}
+	free(batch.files);
+	free(jobs);
+	free(defaultCachePath);
+	return failedCount != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Test of the skipping of unchanged files by the s3tconv tool, run by CTest.
+// Usage: s3tconv_tool_test tool directory
+// Converts a small DXT1 DDS file written to the directory several times, switching the options between the runs, and
+// checks that the KTX file is converted again whenever it doesn't match the options or has been modified, and is
+// skipped otherwise.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define S3TCONV_TOOL_TEST_KTX_SIZE_MAX 1024
+
+typedef struct {
+	const char *tool;
+	char ddsPath[1024], outputPath[1024], ktxPath[1024], cachePath[1024], logPath[1024];
+} S3TConv_ToolTest;
+
+static uint32_t S3TConv_ToolTest_Read32(const uint8_t *data) {
+	return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static void S3TConv_ToolTest_Write32(uint8_t *data, uint32_t value) {
+	data[0] = (uint8_t) value;
+	data[1] = (uint8_t) (value >> 8);
+	data[2] = (uint8_t) (value >> 16);
+	data[3] = (uint8_t) (value >> 24);
+}
+
+// 8x8 DXT1 texture without mipmaps, with different colors in every block.
+static int S3TConv_ToolTest_WriteDDS(const char *path) {
+	static const uint8_t blocks[4][8] = {
+		{ 0x00, 0xF8, 0x1F, 0x00, 0x1B, 0x6C, 0xB1, 0xE4 },
+		{ 0xE0, 0x07, 0x00, 0xF8, 0xE4, 0xB1, 0x6C, 0x1B },
+		{ 0xFF, 0xFF, 0x10, 0x84, 0x00, 0x55, 0xAA, 0xFF },
+		{ 0x1F, 0x7C, 0xE0, 0x83, 0x4E, 0x4E, 0x93, 0x93 }
+	};
+	uint8_t dds[128 + sizeof(blocks)];
+	FILE *file;
+	size_t written;
+	memset(dds, 0, sizeof(dds));
+	memcpy(dds, "DDS ", 4);
+	S3TConv_ToolTest_Write32(dds + 4, 124);
+	// DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE.
+	S3TConv_ToolTest_Write32(dds + 8, 0x81007);
+	S3TConv_ToolTest_Write32(dds + 12, 8);
+	S3TConv_ToolTest_Write32(dds + 16, 8);
+	S3TConv_ToolTest_Write32(dds + 20, sizeof(blocks));
+	S3TConv_ToolTest_Write32(dds + 76, 32);
+	S3TConv_ToolTest_Write32(dds + 80, 0x4); // DDPF_FOURCC.
+	memcpy(dds + 84, "DXT1", 4);
+	S3TConv_ToolTest_Write32(dds + 108, 0x1000); // DDSCAPS_TEXTURE.
+	memcpy(dds + 128, blocks, sizeof(blocks));
+	file = fopen(path, "wb");
+	if (file == NULL) {
+		return 0;
+	}
+	written = fwrite(dds, 1, sizeof(dds), file);
+	return fclose(file) == 0 && written == sizeof(dds);
+}
+
+// Reads the whole file into data, returns its size, or 0 if it can't be read.
+static size_t S3TConv_ToolTest_ReadFile(const char *path, uint8_t *data, size_t maxSize) {
+	FILE *file = fopen(path, "rb");
+	size_t size;
+	if (file == NULL) {
+		return 0;
+	}
+	size = fread(data, 1, maxSize, file);
+	fclose(file);
+	return size;
+}
+
+// Runs the tool, and checks the glInternalFormat of the KTX file and the numbers of converted and unchanged files.
+static int S3TConv_ToolTest_Run(const S3TConv_ToolTest *test, const char *options, uint32_t internalFormat,
+		int expectConverted) {
+	char command[4096], log[4096];
+	uint8_t ktx[S3TCONV_TOOL_TEST_KTX_SIZE_MAX];
+	size_t ktxSize, logSize;
+	const char *expectedCounts = expectConverted ? "1 files converted, 0 unchanged" : "0 files converted, 1 unchanged";
+	snprintf(command, sizeof(command), "\"%s\" %s -threads 1 \"%s\" \"%s\" > \"%s\"",
+			test->tool, options, test->ddsPath, test->outputPath, test->logPath);
+	printf("s3tconv %s\n", options);
+	if (system(command) != 0) {
+		fprintf(stderr, "The tool has failed.\n");
+		return 0;
+	}
+	logSize = S3TConv_ToolTest_ReadFile(test->logPath, (uint8_t *) log, sizeof(log) - 1);
+	log[logSize] = '\0';
+	if (strstr(log, expectedCounts) == NULL) {
+		fprintf(stderr, "Expected \"%s\", the output is:\n%s", expectedCounts, log);
+		return 0;
+	}
+	ktxSize = S3TConv_ToolTest_ReadFile(test->ktxPath, ktx, sizeof(ktx));
+	if (ktxSize < 64 || S3TConv_ToolTest_Read32(ktx + 28) != internalFormat) {
+		fprintf(stderr, "Expected glInternalFormat 0x%X in %s.\n", internalFormat, test->ktxPath);
+		return 0;
+	}
+	return 1;
+}
+
+// Flips a byte in the last block of the KTX file.
+static int S3TConv_ToolTest_ModifyKTX(const S3TConv_ToolTest *test) {
+	uint8_t ktx[S3TCONV_TOOL_TEST_KTX_SIZE_MAX];
+	size_t ktxSize = S3TConv_ToolTest_ReadFile(test->ktxPath, ktx, sizeof(ktx)), written;
+	FILE *file;
+	if (ktxSize == 0) {
+		return 0;
+	}
+	ktx[ktxSize - 1] ^= 0xFF;
+	file = fopen(test->ktxPath, "wb");
+	if (file == NULL) {
+		return 0;
+	}
+	written = fwrite(ktx, 1, ktxSize, file);
+	return fclose(file) == 0 && written == ktxSize;
+}
+
+int main(int argc, char **argv) {
+	S3TConv_ToolTest test;
+	uint8_t ktx[S3TCONV_TOOL_TEST_KTX_SIZE_MAX], convertedKTX[S3TCONV_TOOL_TEST_KTX_SIZE_MAX];
+	size_t ktxSize, convertedKTXSize;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s tool directory\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	test.tool = argv[1];
+	snprintf(test.ddsPath, sizeof(test.ddsPath), "%s/s3tconv_tool_test.dds", argv[2]);
+	snprintf(test.outputPath, sizeof(test.outputPath), "%s/s3tconv_tool_test_output", argv[2]);
+	snprintf(test.ktxPath, sizeof(test.ktxPath), "%s/s3tconv_tool_test_output/s3tconv_tool_test.ktx", argv[2]);
+	snprintf(test.cachePath, sizeof(test.cachePath), "%s/s3tconv_tool_test_output/s3tconv.cache", argv[2]);
+	snprintf(test.logPath, sizeof(test.logPath), "%s/s3tconv_tool_test.log", argv[2]);
+	// Starting without the results of previous runs.
+	remove(test.ktxPath);
+	remove(test.cachePath);
+	if (!S3TConv_ToolTest_WriteDDS(test.ddsPath)) {
+		fprintf(stderr, "%s: couldn't write the DDS file.\n", test.ddsPath);
+		return EXIT_FAILURE;
+	}
+
+	// Switching the format back after a run with another one must not leave the file in the other format.
+	if (!S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 1) || // GL_COMPRESSED_RGB8_ETC2.
+			!S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 0) ||
+			!S3TConv_ToolTest_Run(&test, "-format atc", 0x8C92, 1) || // GL_ATC_RGB_AMD.
+			!S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 1) ||
+			!S3TConv_ToolTest_Run(&test, "-format etc2 -quality high", 0x9274, 1) ||
+			!S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 1)) {
+		return EXIT_FAILURE;
+	}
+
+	// A modified output must be converted again even though its size is the same.
+	convertedKTXSize = S3TConv_ToolTest_ReadFile(test.ktxPath, convertedKTX, sizeof(convertedKTX));
+	if (!S3TConv_ToolTest_ModifyKTX(&test) || !S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 1)) {
+		return EXIT_FAILURE;
+	}
+	ktxSize = S3TConv_ToolTest_ReadFile(test.ktxPath, ktx, sizeof(ktx));
+	if (ktxSize != convertedKTXSize || memcmp(ktx, convertedKTX, ktxSize) != 0) {
+		fprintf(stderr, "%s: the modified file hasn't been restored.\n", test.ktxPath);
+		return EXIT_FAILURE;
+	}
+	if (!S3TConv_ToolTest_Run(&test, "-format etc2", 0x9274, 0)) {
+		return EXIT_FAILURE;
+	}
+
+	printf("All runs converted or skipped the file as expected.\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,1055 @@
+/*
+Part of S3TConv, a library for converting S3TC textures to other formats.
+https://github.com/Triang3l/S3TConv
+
+Copyright (c) 2017 Triang3l.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Bit-exact differential verification of the ATITC conversion and punch-through extraction against a frozen reference.
+// Usage: s3tconv_verify [-stride count] [-blocks count] [-surfaces count] [-seed value] [-threads count]
+// Every optimized path (SIMD, lookup tables, specialized and fused converters, block cache, surfaces) is compared with the
+// scalar reference below, which is a copy of the original implementation and must only be changed deliberately, when the
+// output of the library is meant to change (along with S3TCONV_VERSION). The comparisons are:
+// - Sweep of color endpoint pairs (all pairs for -stride 1, every stride-th first color otherwise) in both DXT1 modes
+//   and in the four-color mode of DXT5, with several index words per pair.
+// - Random blocks with all 16 combinations of remainingWidth and remainingHeight.
+// - Random surfaces with random sizes, row pitches and repeated blocks, with and without the block cache and in place.
+// The fast and the high quality levels are checked for consistency between the paths instead, and the high quality level
+// for never having a larger error than the default one.
+// To cover other configurations of the library, build it with S3TCONV_NO_SIMD or different S3TCONV_LOOKUP_TABLES.
+// With S3TCONV_VERIFY_FUZZER defined, LLVMFuzzerTestOneInput is built instead of main, for libFuzzer or similar fuzzers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "s3tconv_internal.h"
+
+//
+// Frozen reference.
+//
+
+static void S3TConv_Reference_Color565To888(uint16_t color565, uint8_t color888[3]) {
+	color888[0] = (uint8_t) (((color565 & 0xF800) >> 8) | ((color565 & 0xE000) >> 13));
+	color888[1] = (uint8_t) (((color565 & 0x07E0) >> 3) | ((color565 & 0x0600) >> 9));
+	color888[2] = (uint8_t) (((color565 & 0x001F) << 3) | ((color565 & 0x001C) >> 2));
+}
+
+static uint16_t S3TConv_Reference_Color565To555(uint16_t color565) {
+	return (color565 & 0x001F) | ((color565 & 0xFFC0) >> 1);
+}
+
+static unsigned int S3TConv_Reference_GetLuminance(const uint8_t color888[3]) {
+	return (19 * (unsigned int) color888[0] + 38 * (unsigned int) color888[1] + 7 * (unsigned int) color888[2]) >> 6;
+}
+
+static void S3TConv_Reference_ConvertBlackTrickDiscardingLowOrHigh(
+		uint16_t colorLow565, uint16_t colorHigh565, unsigned int lumaLow, unsigned int lumaHigh,
+		uint32_t dxtIndices, unsigned int indexCountLow, unsigned int indexCountHigh,
+		uint16_t *atitcColorLow555, uint16_t *atitcColorHigh565, uint32_t *atitcIndices) {
+	uint16_t colorMed565;
+	uint8_t colorMed888[3];
+	unsigned int lumaMed;
+	uint32_t colorIndexMask;
+
+	colorMed565 = (((colorLow565 & 0x001F) + (colorHigh565 & 0x001F)) >> 1) |
+			((((colorLow565 & 0x07E0) + (colorHigh565 & 0x07E0)) >> 1) & 0x07E0) |
+			((((colorLow565 & 0xF800) + (colorHigh565 & 0xF800)) >> 1) & 0xF800);
+	S3TConv_Reference_Color565To888(colorMed565, colorMed888);
+	lumaMed = S3TConv_Reference_GetLuminance(colorMed888);
+
+	colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
+	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+
+	if (indexCountLow > indexCountHigh) {
+		if (lumaMed >= lumaLow) {
+			*atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(colorLow565);
+			*atitcColorHigh565 = colorMed565;
+			*atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+		} else {
+			*atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(colorMed565);
+			*atitcColorHigh565 = colorLow565;
+			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ ((~dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+		}
+	} else {
+		if (lumaMed <= lumaHigh) {
+			*atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(colorMed565);
+			*atitcColorHigh565 = colorHigh565;
+			*atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
+		} else {
+			*atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(colorHigh565);
+			*atitcColorHigh565 = colorMed565;
+			*atitcIndices = ((dxtIndices | 0xAAAAAAAA) ^ 0x55555555) & colorIndexMask;
+		}
+	}
+}
+
+static void S3TConv_Reference_RGBBlockFromDXT(const uint8_t dxtBlock[8], int asDXT1, uint8_t atitcBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	uint16_t dxtColor0565, dxtColor1565;
+	uint8_t dxtColor0888[3], dxtColor1888[3];
+	unsigned int dxtLuma0, dxtLuma1;
+	uint32_t dxtSourceIndices;
+	uint16_t atitcColorLow555, atitcColorHigh565;
+	uint32_t atitcIndices;
+
+	dxtColor0565 = (uint16_t) dxtBlock[0] | ((uint16_t) dxtBlock[1] << 8);
+	dxtColor1565 = (uint16_t) dxtBlock[2] | ((uint16_t) dxtBlock[3] << 8);
+	dxtSourceIndices = (uint32_t) dxtBlock[4] | ((uint32_t) dxtBlock[5] << 8) |
+			((uint32_t) dxtBlock[6] << 16) | ((uint32_t) dxtBlock[7] << 24);
+	S3TConv_Reference_Color565To888(dxtColor0565, dxtColor0888);
+	dxtLuma0 = S3TConv_Reference_GetLuminance(dxtColor0888);
+	S3TConv_Reference_Color565To888(dxtColor1565, dxtColor1888);
+	dxtLuma1 = S3TConv_Reference_GetLuminance(dxtColor1888);
+
+	if (!asDXT1 || dxtColor0565 > dxtColor1565) {
+		// The RGB0, RGB1, (2*RGB0+RGB1)/3, (RGB0+2*RGB1)/3 mode.
+		atitcIndices = dxtSourceIndices ^ ((dxtSourceIndices & 0xAAAAAAAA) >> 1);
+		atitcIndices ^= (atitcIndices & 0x55555555) << 1;
+		if (dxtLuma0 >= dxtLuma1) {
+			atitcColorLow555 = S3TConv_Reference_Color565To555(dxtColor1565);
+			atitcColorHigh565 = dxtColor0565;
+			atitcIndices = ~atitcIndices;
+		} else {
+			atitcColorLow555 = S3TConv_Reference_Color565To555(dxtColor0565);
+			atitcColorHigh565 = dxtColor1565;
+		}
+	} else {
+		// The RGB0, RGB1, (RGB0+RGB1)/2, BLACK mode.
+		uint16_t dxtColorLow565, dxtColorHigh565;
+		const uint8_t *dxtColorLow888, *dxtColorHigh888;
+		unsigned int dxtLumaLow, dxtLumaHigh;
+		uint32_t dxtIndices = dxtSourceIndices;
+		unsigned int dxtIndexCount[4] = { 0 }, dxtLowHighIndexCounts[4][2] = { { 0 } };
+		unsigned int pixelIndex;
+
+		if (dxtLuma0 <= dxtLuma1) {
+			dxtColorLow565 = dxtColor0565;
+			dxtColorHigh565 = dxtColor1565;
+			dxtColorLow888 = dxtColor0888;
+			dxtColorHigh888 = dxtColor1888;
+			dxtLumaLow = dxtLuma0;
+			dxtLumaHigh = dxtLuma1;
+		} else {
+			dxtColorLow565 = dxtColor1565;
+			dxtColorHigh565 = dxtColor0565;
+			dxtColorLow888 = dxtColor1888;
+			dxtColorHigh888 = dxtColor0888;
+			dxtLumaLow = dxtLuma1;
+			dxtLumaHigh = dxtLuma0;
+			dxtIndices ^= (~dxtIndices & 0xAAAAAAAA) >> 1;
+		}
+
+		for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+			unsigned int dxtIndex;
+			if ((pixelIndex & 3) >= remainingWidth || (pixelIndex >> 2) >= remainingHeight) {
+				continue;
+			}
+			dxtIndex = (dxtIndices >> (pixelIndex << 1)) & 3;
+			++dxtIndexCount[dxtIndex];
+			if ((dxtIndex & 2) == 0) {
+				++dxtLowHighIndexCounts[(pixelIndex >> 2) ^ (((pixelIndex >> 1) ^ (pixelIndex >> 2)) & 1)][dxtIndex];
+			}
+		}
+
+		if (dxtIndexCount[2] == 0) {
+			atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(dxtColorLow565);
+			atitcColorHigh565 = dxtColorHigh565;
+			atitcIndices = (dxtIndices ^ 0xAAAAAAAA) & ~((dxtIndices & 0xAAAAAAAA) >> 1);
+		} else if (dxtIndexCount[0] == 0 || dxtIndexCount[1] == 0) {
+			S3TConv_Reference_ConvertBlackTrickDiscardingLowOrHigh(
+					dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
+					dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
+					&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+		} else if (dxtIndexCount[3] == 0) {
+			uint32_t medIndexMask;
+			int lowIsMoreCommon = (dxtIndexCount[0] > dxtIndexCount[1]);
+			unsigned int subBlockIndex;
+			atitcColorLow555 = S3TConv_Reference_Color565To555(dxtColorLow565);
+			atitcColorHigh565 = dxtColorHigh565;
+			atitcIndices = dxtIndices | ((dxtIndices & 0x55555555) << 1);
+			medIndexMask = dxtIndices & 0xAAAAAAAA;
+			medIndexMask |= medIndexMask >> 1;
+			for (subBlockIndex = 0; subBlockIndex < 4; ++subBlockIndex) {
+				unsigned int countLow = dxtLowHighIndexCounts[subBlockIndex][0], countHigh = dxtLowHighIndexCounts[subBlockIndex][1];
+				if (countLow > countHigh || (lowIsMoreCommon && countLow == countHigh)) {
+					atitcIndices ^= ((uint32_t) 0x00000F0F << (((subBlockIndex & 2) << 3) | ((subBlockIndex & 1) << 2))) & medIndexMask;
+				}
+			}
+		} else {
+			unsigned int colorBlackTrickMedHigh888[3];
+			unsigned int blackTrickBoundScaleLow, blackTrickBoundScaleHigh;
+			unsigned int blackTrickBoundLow[3], blackTrickBoundHigh[3];
+			unsigned int component;
+
+			blackTrickBoundScaleLow = ((dxtIndexCount[2] >= dxtIndexCount[0] && dxtIndexCount[2] >= dxtIndexCount[1]) ? 3 : 0);
+			blackTrickBoundScaleHigh = 8 - blackTrickBoundScaleLow;
+			for (component = 0; component < 3; ++component) {
+				colorBlackTrickMedHigh888[component] = dxtColorLow888[component] + (dxtColorHigh888[component] >> 2);
+				blackTrickBoundLow[component] = (blackTrickBoundScaleHigh * dxtColorLow888[component] +
+						blackTrickBoundScaleLow * dxtColorHigh888[component]) >> 3;
+				blackTrickBoundHigh[component] = (blackTrickBoundScaleLow * dxtColorLow888[component] +
+						blackTrickBoundScaleHigh * dxtColorHigh888[component]) >> 3;
+			}
+
+			if (colorBlackTrickMedHigh888[0] >= blackTrickBoundLow[0] && colorBlackTrickMedHigh888[0] <= blackTrickBoundHigh[0] &&
+					colorBlackTrickMedHigh888[1] >= blackTrickBoundLow[1] && colorBlackTrickMedHigh888[1] <= blackTrickBoundHigh[1] &&
+					colorBlackTrickMedHigh888[2] >= blackTrickBoundLow[2] && colorBlackTrickMedHigh888[2] <= blackTrickBoundHigh[2]) {
+				atitcColorLow555 = (uint16_t) (0x8000 | ((colorBlackTrickMedHigh888[0] >> 3) << 10) |
+						((colorBlackTrickMedHigh888[1] >> 3) << 5) | (colorBlackTrickMedHigh888[2] >> 3));
+				atitcColorHigh565 = dxtColorHigh565;
+				atitcIndices = ~dxtIndices;
+				atitcIndices ^= (atitcIndices & 0x55555555) << 1;
+				atitcIndices ^= (atitcIndices & 0xAAAAAAAA) >> 1;
+			} else if (dxtIndexCount[2] <= dxtIndexCount[0] && dxtIndexCount[2] <= dxtIndexCount[1]) {
+				uint32_t colorIndexMask;
+				atitcColorLow555 = 0x8000 | S3TConv_Reference_Color565To555(dxtColorLow565);
+				atitcColorHigh565 = dxtColorHigh565;
+				colorIndexMask = dxtIndices & 0x55555555 & ((dxtIndices & 0xAAAAAAAA) >> 1);
+				colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+				if (dxtIndexCount[0] > dxtIndexCount[1]) {
+					atitcIndices = (0xAAAAAAAA | dxtIndices) & colorIndexMask;
+				} else {
+					atitcIndices = (dxtIndices | 0xAAAAAAAA | ((dxtIndices & 0xAAAAAAAA) >> 1)) & colorIndexMask;
+				}
+			} else {
+				S3TConv_Reference_ConvertBlackTrickDiscardingLowOrHigh(
+						dxtColorLow565, dxtColorHigh565, dxtLumaLow, dxtLumaHigh,
+						dxtIndices, dxtIndexCount[0], dxtIndexCount[1],
+						&atitcColorLow555, &atitcColorHigh565, &atitcIndices);
+			}
+		}
+	}
+
+	atitcBlock[0] = (uint8_t) atitcColorLow555;
+	atitcBlock[1] = (uint8_t) (atitcColorLow555 >> 8);
+	atitcBlock[2] = (uint8_t) atitcColorHigh565;
+	atitcBlock[3] = (uint8_t) (atitcColorHigh565 >> 8);
+	atitcBlock[4] = (uint8_t) atitcIndices;
+	atitcBlock[5] = (uint8_t) (atitcIndices >> 8);
+	atitcBlock[6] = (uint8_t) (atitcIndices >> 16);
+	atitcBlock[7] = (uint8_t) (atitcIndices >> 24);
+}
+
+static int S3TConv_Reference_BlockHasPunchthroughPixels(const uint8_t rgbBlock[8],
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	static const uint32_t remainingWidthMask[] = { 0, 0x03030303, 0x0F0F0F0F, 0x3F3F3F3F };
+	uint32_t indices;
+	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) > ((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
+		return 0;
+	}
+	indices = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
+			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
+	if (remainingWidth < 4) {
+		indices &= remainingWidthMask[remainingWidth];
+	}
+	if (remainingHeight < 4) {
+		indices &= ((uint32_t) 1 << (remainingHeight << 3)) - 1;
+	}
+	return (indices & 0x55555555 & ((indices >> 1) & 0x55555555)) != 0;
+}
+
+static void S3TConv_Reference_AnalyzeSurface(const uint8_t *data, size_t rowPitch, unsigned int width, unsigned int height,
+		S3TConv_DXT1_SurfaceInfo *info) {
+	unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2, blockX, blockY;
+	info->hasPunchthroughPixels = 0;
+	info->hasThreeColorBlocks = 0;
+	for (blockY = 0; blockY < heightInBlocks; ++blockY) {
+		for (blockX = 0; blockX < widthInBlocks; ++blockX) {
+			const uint8_t *block = data + blockY * (rowPitch != 0 ? rowPitch : widthInBlocks * 8) + blockX * 8;
+			if (((uint16_t) block[0] | ((uint16_t) block[1] << 8)) <= ((uint16_t) block[2] | ((uint16_t) block[3] << 8))) {
+				info->hasThreeColorBlocks = 1;
+			}
+			if (S3TConv_Reference_BlockHasPunchthroughPixels(block, width - (blockX << 2), height - (blockY << 2))) {
+				info->hasPunchthroughPixels = 1;
+			}
+		}
+	}
+	info->isOpaque = !info->hasPunchthroughPixels;
+}
+
+// Deliberately differs from the original implementation, which wrote alpha 0 (fully transparent) for four-color blocks.
+// The fix was made along with the fused RGBA converters, before S3TCONV_VERSION was introduced.
+static void S3TConv_Reference_PunchthroughToExplicitAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
+	uint32_t colorIndexMask;
+	unsigned int alphaByteIndex;
+	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) > ((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
+		// Opaque four-color block.
+		memset(alphaBlock, 0xFF, 8);
+		return;
+	}
+	colorIndexMask = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
+			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
+	colorIndexMask = colorIndexMask & 0x55555555 & ((colorIndexMask & 0xAAAAAAAA) >> 1);
+	colorIndexMask = ~(colorIndexMask | (colorIndexMask << 1));
+	for (alphaByteIndex = 0; alphaByteIndex < 8; ++alphaByteIndex) {
+		alphaBlock[alphaByteIndex] = (uint8_t) ((colorIndexMask & 0x3) | ((colorIndexMask & 0x3) << 2) |
+				((colorIndexMask & 0xC) << 2) | ((colorIndexMask & 0xC) << 4));
+		colorIndexMask >>= 4;
+	}
+}
+
+static void S3TConv_Reference_PunchthroughToInterpolatedAlpha(const uint8_t rgbBlock[8], uint8_t alphaBlock[8]) {
+	uint32_t blackIndexBits, alphaCodesLow = 0, alphaCodesHigh = 0;
+	unsigned int pixelIndex;
+	if (((uint16_t) rgbBlock[0] | ((uint16_t) rgbBlock[1] << 8)) > ((uint16_t) rgbBlock[2] | ((uint16_t) rgbBlock[3] << 8))) {
+		alphaBlock[0] = alphaBlock[1] = 0xFF;
+		memset(alphaBlock + 2, 0, 6);
+		return;
+	}
+	blackIndexBits = (uint32_t) rgbBlock[4] | ((uint32_t) rgbBlock[5] << 8) |
+			((uint32_t) rgbBlock[6] << 16) | ((uint32_t) rgbBlock[7] << 24);
+	blackIndexBits = blackIndexBits & 0x55555555 & ((blackIndexBits & 0xAAAAAAAA) >> 1);
+	for (pixelIndex = 0; pixelIndex < 8; ++pixelIndex) {
+		alphaCodesLow |= ((blackIndexBits >> (pixelIndex << 1)) & 1) << (pixelIndex * 3);
+		alphaCodesHigh |= ((blackIndexBits >> (16 + (pixelIndex << 1))) & 1) << (pixelIndex * 3);
+	}
+	alphaBlock[0] = 0xFF;
+	alphaBlock[1] = 0;
+	alphaBlock[2] = (uint8_t) alphaCodesLow;
+	alphaBlock[3] = (uint8_t) (alphaCodesLow >> 8);
+	alphaBlock[4] = (uint8_t) (alphaCodesLow >> 16);
+	alphaBlock[5] = (uint8_t) alphaCodesHigh;
+	alphaBlock[6] = (uint8_t) (alphaCodesHigh >> 8);
+	alphaBlock[7] = (uint8_t) (alphaCodesHigh >> 16);
+}
+
+// Reference conversion of a whole block to any ATITC format supported for the DXT format.
+static void S3TConv_Reference_BlockFromDXT(const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		uint8_t *atitcBlock, S3TConv_Format atitcFormat, unsigned int remainingWidth, unsigned int remainingHeight) {
+	const uint8_t *colorBlock = dxtBlock + (dxtFormat != S3TCONV_FORMAT_DXT1 ? 8 : 0);
+	uint8_t alphaBlock[8];
+	if (atitcFormat == S3TCONV_FORMAT_ATITC_RGB) {
+		S3TConv_Reference_RGBBlockFromDXT(colorBlock, dxtFormat == S3TCONV_FORMAT_DXT1 || asDXT1, atitcBlock,
+				remainingWidth, remainingHeight);
+		return;
+	}
+	if (dxtFormat != S3TCONV_FORMAT_DXT1) {
+		memcpy(alphaBlock, dxtBlock, 8);
+	} else if (atitcFormat == S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT) {
+		S3TConv_Reference_PunchthroughToExplicitAlpha(colorBlock, alphaBlock);
+	} else {
+		S3TConv_Reference_PunchthroughToInterpolatedAlpha(colorBlock, alphaBlock);
+	}
+	S3TConv_Reference_RGBBlockFromDXT(colorBlock, dxtFormat == S3TCONV_FORMAT_DXT1 || asDXT1, atitcBlock + 8,
+			remainingWidth, remainingHeight);
+	memcpy(atitcBlock, alphaBlock, 8);
+}
+
+//
+// Comparison.
+//
+
+// ATITC targets supported for each DXT format, the first one is the in-place target.
+static const S3TConv_Format S3TConv_Verify_Targets[3][3] = {
+	{ S3TCONV_FORMAT_ATITC_RGB, S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT, S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED },
+	{ S3TCONV_FORMAT_ATITC_RGBA_EXPLICIT, S3TCONV_FORMAT_ATITC_RGB, S3TCONV_FORMAT_ATITC_RGB },
+	{ S3TCONV_FORMAT_ATITC_RGBA_INTERPOLATED, S3TCONV_FORMAT_ATITC_RGB, S3TCONV_FORMAT_ATITC_RGB }
+};
+static const unsigned int S3TConv_Verify_TargetCounts[3] = { 3, 2, 2 };
+
+typedef struct {
+	uint64_t comparisonCount;
+	uint64_t mismatchCount;
+	// The first mismatch.
+	const char *function;
+	uint8_t dxtBlock[16];
+	S3TConv_Format dxtFormat;
+	int asDXT1;
+	unsigned int remainingWidth, remainingHeight;
+	uint8_t expected[16], actual[16];
+	unsigned int resultSize;
+} S3TConv_Verify_Result;
+
+static void S3TConv_Verify_Compare(S3TConv_Verify_Result *result, const char *function,
+		const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1, unsigned int remainingWidth, unsigned int remainingHeight,
+		const uint8_t *expected, const uint8_t *actual, unsigned int resultSize) {
+	++result->comparisonCount;
+	if (memcmp(expected, actual, resultSize) == 0) {
+		return;
+	}
+	if (result->mismatchCount++ != 0) {
+		return;
+	}
+	result->function = function;
+	memcpy(result->dxtBlock, dxtBlock, S3TConv_Format_GetBlockSize(dxtFormat));
+	result->dxtFormat = dxtFormat;
+	result->asDXT1 = asDXT1;
+	result->remainingWidth = remainingWidth;
+	result->remainingHeight = remainingHeight;
+	memcpy(result->expected, expected, resultSize);
+	memcpy(result->actual, actual, resultSize);
+	result->resultSize = resultSize;
+}
+
+static void S3TConv_Verify_PrintBytes(const char *name, const uint8_t *bytes, unsigned int size) {
+	unsigned int byteIndex;
+	printf("  %-9s", name);
+	for (byteIndex = 0; byteIndex < size; ++byteIndex) {
+		printf(" %02X", bytes[byteIndex]);
+	}
+	printf("\n");
+}
+
+// Prints the totals and the first mismatch, returns whether everything matched.
+static int S3TConv_Verify_Report(const char *name, const S3TConv_Verify_Result *result) {
+	static const char * const formatNames[] = { "DXT1", "DXT3", "DXT5" };
+	printf("%-40s %12llu comparisons %10llu mismatches\n", name,
+			(unsigned long long) result->comparisonCount, (unsigned long long) result->mismatchCount);
+	if (result->mismatchCount == 0) {
+		return 1;
+	}
+	printf("  First mismatch in %s: %s, asDXT1 %d, remaining %ux%u.\n", result->function, formatNames[result->dxtFormat],
+			result->asDXT1, result->remainingWidth, result->remainingHeight);
+	S3TConv_Verify_PrintBytes("Source:", result->dxtBlock, S3TConv_Format_GetBlockSize(result->dxtFormat));
+	S3TConv_Verify_PrintBytes("Expected:", result->expected, result->resultSize);
+	S3TConv_Verify_PrintBytes("Actual:", result->actual, result->resultSize);
+	return 0;
+}
+
+// Compares every single-block function for a DXT1, DXT3 or DXT5 block.
+static void S3TConv_Verify_Block(S3TConv_Verify_Result *result, const uint8_t *dxtBlock, S3TConv_Format dxtFormat, int asDXT1,
+		unsigned int remainingWidth, unsigned int remainingHeight) {
+	const uint8_t *colorBlock = dxtBlock + (dxtFormat != S3TCONV_FORMAT_DXT1 ? 8 : 0);
+	int colorAsDXT1 = (dxtFormat == S3TCONV_FORMAT_DXT1 || asDXT1);
+	uint8_t expected[16], actual[16];
+	unsigned int targetIndex;
+
+	S3TConv_Reference_RGBBlockFromDXT(colorBlock, colorAsDXT1, expected, remainingWidth, remainingHeight);
+	S3TConv_ATITC_RGBBlockFromDXT(colorBlock, colorAsDXT1, actual, remainingWidth, remainingHeight);
+	S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlockFromDXT", dxtBlock, dxtFormat, asDXT1,
+			remainingWidth, remainingHeight, expected, actual, 8);
+	memcpy(actual, colorBlock, 8);
+	S3TConv_ATITC_RGBBlockFromDXTInPlace(actual, colorAsDXT1, remainingWidth, remainingHeight);
+	S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlockFromDXTInPlace", dxtBlock, dxtFormat, asDXT1,
+			remainingWidth, remainingHeight, expected, actual, 8);
+	S3TConv_ATITC_RGBBlockFromDXTWithPath(colorBlock, colorAsDXT1, actual, remainingWidth, remainingHeight);
+	S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlockFromDXTWithPath", dxtBlock, dxtFormat, asDXT1,
+			remainingWidth, remainingHeight, expected, actual, 8);
+	S3TConv_ATITC_RGBBlockFromDXTWithQuality(colorBlock, colorAsDXT1, S3TCONV_QUALITY_DEFAULT, actual,
+			remainingWidth, remainingHeight);
+	S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlockFromDXTWithQuality", dxtBlock, dxtFormat, asDXT1,
+			remainingWidth, remainingHeight, expected, actual, 8);
+	// The other levels are not bit-exact with the reference, but the high quality must never be worse than the default.
+	S3TConv_ATITC_RGBBlockFromDXTWithQuality(colorBlock, colorAsDXT1, S3TCONV_QUALITY_HIGH, actual,
+			remainingWidth, remainingHeight);
+	actual[8] = (uint8_t) (S3TConv_ATITC_GetRGBBlockError(colorBlock, colorAsDXT1, actual, remainingWidth, remainingHeight) <=
+			S3TConv_ATITC_GetRGBBlockError(colorBlock, colorAsDXT1, expected, remainingWidth, remainingHeight));
+	expected[8] = 1;
+	S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlockFromDXTWithQuality (high error)", dxtBlock, dxtFormat, asDXT1,
+			remainingWidth, remainingHeight, expected + 8, actual + 8, 1);
+
+	for (targetIndex = 0; targetIndex < S3TConv_Verify_TargetCounts[dxtFormat]; ++targetIndex) {
+		S3TConv_Format atitcFormat = S3TConv_Verify_Targets[dxtFormat][targetIndex];
+		if (atitcFormat == S3TCONV_FORMAT_ATITC_RGB) {
+			continue;
+		}
+		S3TConv_Reference_BlockFromDXT(dxtBlock, dxtFormat, asDXT1, expected, atitcFormat, remainingWidth, remainingHeight);
+		S3TConv_ATITC_RGBABlockFromDXT(dxtBlock, dxtFormat, asDXT1, actual, atitcFormat, remainingWidth, remainingHeight);
+		S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBABlockFromDXT", dxtBlock, dxtFormat, asDXT1,
+				remainingWidth, remainingHeight, expected, actual, 16);
+		if (dxtFormat != S3TCONV_FORMAT_DXT1) {
+			memcpy(actual, dxtBlock, 16);
+			S3TConv_ATITC_RGBABlockFromDXT(actual, dxtFormat, asDXT1, actual, atitcFormat, remainingWidth, remainingHeight);
+			S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBABlockFromDXT (in place)", dxtBlock, dxtFormat, asDXT1,
+					remainingWidth, remainingHeight, expected, actual, 16);
+		}
+	}
+
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		expected[0] = (uint8_t) S3TConv_Reference_BlockHasPunchthroughPixels(dxtBlock, remainingWidth, remainingHeight);
+		actual[0] = (uint8_t) (S3TConv_DXT1_BlockHasPunchthroughPixels(dxtBlock, remainingWidth, remainingHeight) != 0);
+		S3TConv_Verify_Compare(result, "S3TConv_DXT1_BlockHasPunchthroughPixels", dxtBlock, dxtFormat, asDXT1,
+				remainingWidth, remainingHeight, expected, actual, 1);
+		// Not depending on the remaining size.
+		if (remainingWidth >= 4 && remainingHeight >= 4) {
+			S3TConv_Reference_PunchthroughToExplicitAlpha(dxtBlock, expected);
+			S3TConv_DXT1_PunchthroughToExplicitAlpha(dxtBlock, actual);
+			S3TConv_Verify_Compare(result, "S3TConv_DXT1_PunchthroughToExplicitAlpha", dxtBlock, dxtFormat, asDXT1,
+					remainingWidth, remainingHeight, expected, actual, 8);
+			S3TConv_Reference_PunchthroughToInterpolatedAlpha(dxtBlock, expected);
+			S3TConv_DXT1_PunchthroughToInterpolatedAlpha(dxtBlock, actual);
+			S3TConv_Verify_Compare(result, "S3TConv_DXT1_PunchthroughToInterpolatedAlpha", dxtBlock, dxtFormat, asDXT1,
+					remainingWidth, remainingHeight, expected, actual, 8);
+		}
+	}
+}
+
+// Compares the functions converting runs of full blocks. The buffers must have space for 16 bytes per block.
+static void S3TConv_Verify_Blocks(S3TConv_Verify_Result *result, const uint8_t *dxtBlocks, S3TConv_Format dxtFormat,
+		int asDXT1, unsigned int blockCount, uint8_t *expected, uint8_t *actual) {
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat), colorOffset = dxtBlockSize - 8;
+	int colorAsDXT1 = (dxtFormat == S3TCONV_FORMAT_DXT1 || asDXT1);
+	unsigned int targetIndex, blockIndex;
+
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		S3TConv_Reference_RGBBlockFromDXT(dxtBlocks + blockIndex * dxtBlockSize + colorOffset, colorAsDXT1,
+				expected + blockIndex * 8, 4, 4);
+	}
+	S3TConv_ATITC_RGBBlocksFromDXT(dxtBlocks + colorOffset, dxtBlockSize, colorAsDXT1, actual, 8, blockCount);
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlocksFromDXT", dxtBlocks + blockIndex * dxtBlockSize,
+				dxtFormat, asDXT1, 4, 4, expected + blockIndex * 8, actual + blockIndex * 8, 8);
+	}
+	memcpy(actual, dxtBlocks, (size_t) blockCount * dxtBlockSize);
+	S3TConv_ATITC_RGBBlocksFromDXT(actual + colorOffset, dxtBlockSize, colorAsDXT1, actual + colorOffset, dxtBlockSize,
+			blockCount);
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBBlocksFromDXT (in place)", dxtBlocks + blockIndex * dxtBlockSize,
+				dxtFormat, asDXT1, 4, 4, expected + blockIndex * 8, actual + blockIndex * dxtBlockSize + colorOffset, 8);
+	}
+
+	for (targetIndex = 0; targetIndex < S3TConv_Verify_TargetCounts[dxtFormat]; ++targetIndex) {
+		S3TConv_Format atitcFormat = S3TConv_Verify_Targets[dxtFormat][targetIndex];
+		if (atitcFormat == S3TCONV_FORMAT_ATITC_RGB) {
+			continue;
+		}
+		for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+			S3TConv_Reference_BlockFromDXT(dxtBlocks + blockIndex * dxtBlockSize, dxtFormat, asDXT1,
+					expected + blockIndex * 16, atitcFormat, 4, 4);
+		}
+		if (dxtFormat != S3TCONV_FORMAT_DXT1) {
+			// In place.
+			memcpy(actual, dxtBlocks, (size_t) blockCount * 16);
+			S3TConv_ATITC_RGBABlocksFromDXT(actual, dxtFormat, asDXT1, actual, atitcFormat, blockCount);
+		} else {
+			S3TConv_ATITC_RGBABlocksFromDXT(dxtBlocks, dxtFormat, asDXT1, actual, atitcFormat, blockCount);
+		}
+		for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+			S3TConv_Verify_Compare(result, "S3TConv_ATITC_RGBABlocksFromDXT", dxtBlocks + blockIndex * dxtBlockSize,
+					dxtFormat, asDXT1, 4, 4, expected + blockIndex * 16, actual + blockIndex * 16, 16);
+		}
+	}
+}
+
+// Value of padding bytes that must not be overwritten.
+#define S3TCONV_VERIFY_PADDING 0xCD
+
+static void S3TConv_Verify_AnalyzeSurfacePart(S3TConv_Verify_Result *result, const uint8_t *data, size_t rowPitch,
+		unsigned int width, unsigned int height) {
+	S3TConv_DXT1_SurfaceInfo expectedInfo, actualInfo;
+	uint8_t expected[3], actual[3];
+	S3TConv_Reference_AnalyzeSurface(data, rowPitch, width, height, &expectedInfo);
+	S3TConv_DXT1_AnalyzeSurface(data, rowPitch, width, height, &actualInfo);
+	expected[0] = (uint8_t) expectedInfo.hasPunchthroughPixels;
+	expected[1] = (uint8_t) expectedInfo.hasThreeColorBlocks;
+	expected[2] = (uint8_t) expectedInfo.isOpaque;
+	actual[0] = (uint8_t) (actualInfo.hasPunchthroughPixels != 0);
+	actual[1] = (uint8_t) (actualInfo.hasThreeColorBlocks != 0);
+	actual[2] = (uint8_t) (actualInfo.isOpaque != 0);
+	S3TConv_Verify_Compare(result, "S3TConv_DXT1_AnalyzeSurface", data, S3TCONV_FORMAT_DXT1, 1,
+			width, height, expected, actual, 3);
+}
+
+// Compares the DXT1 surface analysis for the part of every block row starting at every block, so every block is
+// checked at every position within the groups of full blocks analyzed at once and with the stop at the first transparent
+// pixel further away, with a mismatch reported for the first block of the part, and for every bottom part of the
+// surface with the row pitch.
+static void S3TConv_Verify_AnalyzeSurface(S3TConv_Verify_Result *result, const uint8_t *dxtData, size_t dxtRowPitch,
+		unsigned int width, unsigned int height) {
+	unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2, blockX, blockY;
+	for (blockY = 0; blockY < heightInBlocks; ++blockY) {
+		const uint8_t *row = dxtData + blockY * (dxtRowPitch != 0 ? dxtRowPitch : widthInBlocks * 8);
+		unsigned int remainingHeight = height - (blockY << 2);
+		for (blockX = 0; blockX < widthInBlocks; ++blockX) {
+			S3TConv_Verify_AnalyzeSurfacePart(result, row + blockX * 8, 0, width - (blockX << 2),
+					remainingHeight < 4 ? remainingHeight : 4);
+		}
+		S3TConv_Verify_AnalyzeSurfacePart(result, row, dxtRowPitch, width, remainingHeight);
+	}
+}
+
+// Compares the surface converters for a surface with every target, including the block cache and in-place conversion.
+// The fast and the high quality levels are compared with the single-block conversion with the same level instead.
+// For DXT1, the surface analysis is compared as well.
+// The target buffer must be at least heightInBlocks * targetRowPitch, which must be at least widthInBlocks * 16.
+static void S3TConv_Verify_Surface(S3TConv_Verify_Result *result, const uint8_t *dxtData, S3TConv_Format dxtFormat,
+		int asDXT1, size_t dxtRowPitch, unsigned int width, unsigned int height, uint8_t *target, size_t targetRowPitch) {
+	static const char * const functionNames[] = {
+		"S3TConv_ATITC_SurfaceFromDXT",
+		"S3TConv_ConvertSurface (block cache)",
+		"S3TConv_ATITC_SurfaceFromDXTInPlace",
+		"S3TConv_ConvertSurface (fast quality)",
+		"S3TConv_ConvertSurface (high quality, block cache)"
+	};
+	static const S3TConv_Quality variantQualities[] = {
+		S3TCONV_QUALITY_DEFAULT, S3TCONV_QUALITY_DEFAULT, S3TCONV_QUALITY_DEFAULT, S3TCONV_QUALITY_FAST, S3TCONV_QUALITY_HIGH
+	};
+	unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2;
+	unsigned int targetIndex, variant, blockX, blockY;
+	uint8_t expected[16];
+
+	if (dxtFormat == S3TCONV_FORMAT_DXT1) {
+		S3TConv_Verify_AnalyzeSurface(result, dxtData, dxtRowPitch, width, height);
+	}
+
+	for (targetIndex = 0; targetIndex < S3TConv_Verify_TargetCounts[dxtFormat]; ++targetIndex) {
+		S3TConv_Format atitcFormat = S3TConv_Verify_Targets[dxtFormat][targetIndex];
+		unsigned int atitcBlockSize = S3TConv_Format_GetBlockSize(atitcFormat);
+		if (targetIndex != 0 && atitcFormat == S3TConv_Verify_Targets[dxtFormat][targetIndex - 1]) {
+			continue;
+		}
+		for (variant = 0; variant < 5; ++variant) {
+			size_t atitcRowPitch = targetRowPitch;
+			memset(target, S3TCONV_VERIFY_PADDING, heightInBlocks * targetRowPitch);
+			if (variant == 0) {
+				S3TConv_ATITC_SurfaceFromDXT(dxtData, dxtFormat, asDXT1, dxtRowPitch,
+						target, atitcFormat, targetRowPitch, width, height);
+			} else if (variant != 2) {
+				S3TConv_Surface surface;
+				memset(&surface, 0, sizeof(surface));
+				surface.sourceData = dxtData;
+				surface.sourceFormat = dxtFormat;
+				surface.asDXT1 = asDXT1;
+				surface.sourceRowPitch = dxtRowPitch;
+				surface.targetData = target;
+				surface.targetFormat = atitcFormat;
+				surface.targetRowPitch = targetRowPitch;
+				surface.width = width;
+				surface.height = height;
+				surface.useBlockCache = (variant != 3);
+				surface.quality = variantQualities[variant];
+				S3TConv_ConvertSurface(&surface);
+			} else {
+				if (targetIndex != 0) {
+					continue;
+				}
+				// The source pitch is kept for in-place conversion, with the source padding copied as well.
+				atitcRowPitch = (dxtRowPitch != 0 ? dxtRowPitch : widthInBlocks * dxtBlockSize);
+				memcpy(target, dxtData, (heightInBlocks - 1) * atitcRowPitch + widthInBlocks * dxtBlockSize);
+				S3TConv_ATITC_SurfaceFromDXTInPlace(target, dxtFormat, asDXT1, dxtRowPitch, width, height);
+			}
+			for (blockY = 0; blockY < heightInBlocks; ++blockY) {
+				const uint8_t *dxtRow = dxtData + blockY * (dxtRowPitch != 0 ? dxtRowPitch : widthInBlocks * dxtBlockSize);
+				const uint8_t *atitcRow = target + blockY * atitcRowPitch;
+				for (blockX = 0; blockX < widthInBlocks; ++blockX) {
+					S3TConv_Reference_BlockFromDXT(dxtRow + blockX * dxtBlockSize, dxtFormat, asDXT1, expected, atitcFormat,
+							width - (blockX << 2), height - (blockY << 2));
+					if (variantQualities[variant] != S3TCONV_QUALITY_DEFAULT) {
+						// Only the color part depends on the level.
+						S3TConv_ATITC_RGBBlockFromDXTWithQuality(dxtRow + blockX * dxtBlockSize + dxtBlockSize - 8,
+								dxtFormat == S3TCONV_FORMAT_DXT1 || asDXT1, variantQualities[variant],
+								expected + atitcBlockSize - 8, width - (blockX << 2), height - (blockY << 2));
+					}
+					S3TConv_Verify_Compare(result, functionNames[variant], dxtRow + blockX * dxtBlockSize, dxtFormat, asDXT1,
+							width - (blockX << 2), height - (blockY << 2), expected, atitcRow + blockX * atitcBlockSize,
+							atitcBlockSize);
+				}
+				if (variant != 2) {
+					// The padding between the rows must be untouched.
+					size_t paddingOffset;
+					uint8_t padding = S3TCONV_VERIFY_PADDING;
+					for (paddingOffset = widthInBlocks * atitcBlockSize; paddingOffset < targetRowPitch; ++paddingOffset) {
+						S3TConv_Verify_Compare(result, functionNames[variant], dxtRow, dxtFormat, asDXT1,
+								width, height - (blockY << 2), &padding, atitcRow + paddingOffset, 1);
+					}
+				}
+			}
+		}
+	}
+}
+
+#define S3TCONV_VERIFY_BATCH_SIZE 1024
+#define S3TCONV_VERIFY_MAX_SURFACE_SIZE 67
+
+#ifdef S3TCONV_VERIFY_FUZZER
+
+// Byte 0: format (bits 0-1) and asDXT1 (bit 2), bytes 1-2: surface size, the rest: blocks of the format, repeated over
+// the surface. Aborts on a mismatch.
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	S3TConv_Verify_Result result;
+	S3TConv_Format dxtFormat;
+	unsigned int dxtBlockSize, blockCount, blockIndex, remaining, width, height, widthInBlocks, heightInBlocks;
+	uint8_t *blocks, *expected, *actual, *source, *target;
+	int asDXT1;
+
+	if (size < 3 || (data[0] & 3) > 2) {
+		return 0;
+	}
+	dxtFormat = (S3TConv_Format) (data[0] & 3);
+	asDXT1 = (data[0] >> 2) & 1;
+	dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+	blockCount = (unsigned int) ((size - 3) / dxtBlockSize);
+	if (blockCount == 0) {
+		return 0;
+	}
+	if (blockCount > S3TCONV_VERIFY_BATCH_SIZE) {
+		blockCount = S3TCONV_VERIFY_BATCH_SIZE;
+	}
+	width = 1 + data[1] % S3TCONV_VERIFY_MAX_SURFACE_SIZE;
+	height = 1 + data[2] % S3TCONV_VERIFY_MAX_SURFACE_SIZE;
+	widthInBlocks = (width + 3) >> 2;
+	heightInBlocks = (height + 3) >> 2;
+
+	memset(&result, 0, sizeof(result));
+	blocks = (uint8_t *) malloc(blockCount * 16 * 3 + widthInBlocks * heightInBlocks * (dxtBlockSize + 16));
+	if (blocks == NULL) {
+		return 0;
+	}
+	expected = blocks + blockCount * 16;
+	actual = expected + blockCount * 16;
+	source = actual + blockCount * 16;
+	target = source + widthInBlocks * heightInBlocks * dxtBlockSize;
+	memcpy(blocks, data + 3, blockCount * dxtBlockSize);
+	for (blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+		for (remaining = 0; remaining < 16; ++remaining) {
+			S3TConv_Verify_Block(&result, blocks + blockIndex * dxtBlockSize, dxtFormat, asDXT1,
+					1 + (remaining & 3), 1 + (remaining >> 2));
+		}
+	}
+	S3TConv_Verify_Blocks(&result, blocks, dxtFormat, asDXT1, blockCount, expected, actual);
+	for (blockIndex = 0; blockIndex < widthInBlocks * heightInBlocks; ++blockIndex) {
+		memcpy(source + blockIndex * dxtBlockSize, blocks + (blockIndex % blockCount) * dxtBlockSize, dxtBlockSize);
+	}
+	S3TConv_Verify_Surface(&result, source, dxtFormat, asDXT1, 0, width, height, target, widthInBlocks * 16);
+	free(blocks);
+
+	if (result.mismatchCount != 0) {
+		S3TConv_Verify_Report("Fuzzer input", &result);
+		fflush(stdout);
+		abort();
+	}
+	return 0;
+}
+
+#else
+
+//
+// Generation of the inputs.
+//
+
+static uint64_t S3TConv_Verify_Random(uint64_t *state) {
+	// splitmix64, so every job can have an independent sequence.
+	uint64_t value = (*state += 0x9E3779B97F4A7C15ull);
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+// Index words reaching all the branches: random, with one of the indices unused, with only some of the indices used.
+static uint32_t S3TConv_Verify_GenerateIndices(uint64_t *randomState) {
+	uint64_t random = S3TConv_Verify_Random(randomState);
+	uint32_t indices = (uint32_t) random;
+	switch ((random >> 32) & 7) {
+	case 0: {
+		// Only two values.
+		uint32_t mask = (uint32_t) (random >> 35) | 0x55555555;
+		return indices & mask;
+	}
+	case 1:
+	case 2:
+	case 3: {
+		// One of the values is replaced with another one.
+		uint32_t removed = (uint32_t) ((random >> 35) & 3), replacement = (removed + 1 + (uint32_t) ((random >> 37) % 3)) & 3;
+		unsigned int pixelIndex;
+		for (pixelIndex = 0; pixelIndex < 16; ++pixelIndex) {
+			if (((indices >> (pixelIndex << 1)) & 3) == removed) {
+				indices ^= (removed ^ replacement) << (pixelIndex << 1);
+			}
+		}
+		return indices;
+	}
+	case 4:
+		// The same value everywhere.
+		return (uint32_t) ((random >> 35) & 3) * 0x55555555;
+	default:
+		return indices;
+	}
+}
+
+static void S3TConv_Verify_GenerateBlock(uint64_t *randomState, S3TConv_Format dxtFormat, uint8_t *dxtBlock) {
+	uint64_t random = S3TConv_Verify_Random(randomState);
+	uint8_t *colorBlock = dxtBlock + (dxtFormat != S3TCONV_FORMAT_DXT1 ? 8 : 0);
+	uint16_t color0 = (uint16_t) random, color1 = (uint16_t) (random >> 16);
+	uint32_t indices = S3TConv_Verify_GenerateIndices(randomState);
+	switch ((random >> 32) & 7) {
+	case 0:
+		color1 = color0;
+		break;
+	case 1:
+		// Close colors.
+		color1 = (uint16_t) (color0 ^ ((random >> 35) & 0x0841));
+		break;
+	case 2:
+		// Gray.
+		color0 = (uint16_t) (((color0 & 0x1F) << 11) | ((color0 & 0x1F) << 6) | (color0 & 0x1F));
+		color1 = (uint16_t) (((color1 & 0x1F) << 11) | ((color1 & 0x1F) << 6) | (color1 & 0x1F));
+		break;
+	}
+	if (dxtFormat != S3TCONV_FORMAT_DXT1) {
+		uint64_t alpha = S3TConv_Verify_Random(randomState);
+		memcpy(dxtBlock, &alpha, 8);
+	}
+	colorBlock[0] = (uint8_t) color0;
+	colorBlock[1] = (uint8_t) (color0 >> 8);
+	colorBlock[2] = (uint8_t) color1;
+	colorBlock[3] = (uint8_t) (color1 >> 8);
+	colorBlock[4] = (uint8_t) indices;
+	colorBlock[5] = (uint8_t) (indices >> 8);
+	colorBlock[6] = (uint8_t) (indices >> 16);
+	colorBlock[7] = (uint8_t) (indices >> 24);
+}
+
+//
+// Jobs.
+//
+
+static void S3TConv_Verify_AddResult(S3TConv_Verify_Result *result, const S3TConv_Verify_Result *addedResult) {
+	if (result->mismatchCount == 0 && addedResult->mismatchCount != 0) {
+		*result = *addedResult;
+		result->comparisonCount = 0;
+		result->mismatchCount = 0;
+	}
+	result->comparisonCount += addedResult->comparisonCount;
+	result->mismatchCount += addedResult->mismatchCount;
+}
+
+#define S3TCONV_VERIFY_SWEEP_INDEX_WORDS 4
+
+typedef struct {
+	unsigned int first, count;
+	unsigned int stride;
+	uint64_t seed;
+	S3TConv_Verify_Result result;
+} S3TConv_Verify_Job;
+
+// Every first color in the range (with the stride) with every second color, as DXT1 (both modes) and DXT5 (always four colors).
+static void S3TConv_Verify_Sweep(void *jobData) {
+	S3TConv_Verify_Job *job = (S3TConv_Verify_Job *) jobData;
+	uint8_t *batches, *expected, *actual;
+	uint64_t randomState = job->seed;
+	unsigned int color0Index, batchBlockCount = 0;
+
+	batches = (uint8_t *) malloc(S3TCONV_VERIFY_BATCH_SIZE * (8 + 16 + 16 + 16));
+	if (batches == NULL) {
+		return;
+	}
+	expected = batches + S3TCONV_VERIFY_BATCH_SIZE * (8 + 16);
+	actual = expected + S3TCONV_VERIFY_BATCH_SIZE * 16;
+	for (color0Index = job->first; color0Index < job->first + job->count; ++color0Index) {
+		unsigned int color0 = color0Index * job->stride, color1, indexWordIndex;
+		if (color0 > 0xFFFF) {
+			break;
+		}
+		for (color1 = 0; color1 <= 0xFFFF; ++color1) {
+			for (indexWordIndex = 0; indexWordIndex < S3TCONV_VERIFY_SWEEP_INDEX_WORDS; ++indexWordIndex) {
+				uint8_t *dxt1Block = batches + batchBlockCount * 8, *dxt5Block = batches + S3TCONV_VERIFY_BATCH_SIZE * 8 +
+						batchBlockCount * 16;
+				uint32_t indices = (indexWordIndex == 0 ? 0xE4E4E4E4 : S3TConv_Verify_GenerateIndices(&randomState));
+				uint64_t alpha = S3TConv_Verify_Random(&randomState);
+				dxt1Block[0] = (uint8_t) color0;
+				dxt1Block[1] = (uint8_t) (color0 >> 8);
+				dxt1Block[2] = (uint8_t) color1;
+				dxt1Block[3] = (uint8_t) (color1 >> 8);
+				dxt1Block[4] = (uint8_t) indices;
+				dxt1Block[5] = (uint8_t) (indices >> 8);
+				dxt1Block[6] = (uint8_t) (indices >> 16);
+				dxt1Block[7] = (uint8_t) (indices >> 24);
+				memcpy(dxt5Block, &alpha, 8);
+				memcpy(dxt5Block + 8, dxt1Block, 8);
+				S3TConv_Verify_Block(&job->result, dxt1Block, S3TCONV_FORMAT_DXT1, 1, 4, 4);
+				S3TConv_Verify_Block(&job->result, dxt5Block, S3TCONV_FORMAT_DXT5, 0, 4, 4);
+				if (++batchBlockCount == S3TCONV_VERIFY_BATCH_SIZE) {
+					S3TConv_Verify_Blocks(&job->result, batches, S3TCONV_FORMAT_DXT1, 1, batchBlockCount, expected, actual);
+					S3TConv_Verify_Blocks(&job->result, batches + S3TCONV_VERIFY_BATCH_SIZE * 8, S3TCONV_FORMAT_DXT5, 0,
+							batchBlockCount, expected, actual);
+					batchBlockCount = 0;
+				}
+			}
+		}
+	}
+	if (batchBlockCount != 0) {
+		S3TConv_Verify_Blocks(&job->result, batches, S3TCONV_FORMAT_DXT1, 1, batchBlockCount, expected, actual);
+		S3TConv_Verify_Blocks(&job->result, batches + S3TCONV_VERIFY_BATCH_SIZE * 8, S3TCONV_FORMAT_DXT5, 0,
+				batchBlockCount, expected, actual);
+	}
+	free(batches);
+}
+
+// Random blocks of all formats with all remaining sizes, and runs of them of random lengths.
+static void S3TConv_Verify_RandomBlocks(void *jobData) {
+	S3TConv_Verify_Job *job = (S3TConv_Verify_Job *) jobData;
+	uint8_t *blocks, *expected, *actual;
+	uint64_t randomState = job->seed;
+	unsigned int blockIndex, runLength;
+
+	blocks = (uint8_t *) malloc(S3TCONV_VERIFY_BATCH_SIZE * 16 * 3);
+	if (blocks == NULL) {
+		return;
+	}
+	expected = blocks + S3TCONV_VERIFY_BATCH_SIZE * 16;
+	actual = expected + S3TCONV_VERIFY_BATCH_SIZE * 16;
+	for (blockIndex = 0; blockIndex < job->count; blockIndex += runLength) {
+		S3TConv_Format dxtFormat = (S3TConv_Format) (S3TConv_Verify_Random(&randomState) % 3);
+		int asDXT1 = (int) (S3TConv_Verify_Random(&randomState) & 1);
+		unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat), runBlockIndex, remaining;
+		runLength = 1 + (unsigned int) (S3TConv_Verify_Random(&randomState) % S3TCONV_VERIFY_BATCH_SIZE);
+		for (runBlockIndex = 0; runBlockIndex < runLength; ++runBlockIndex) {
+			const uint8_t *block = blocks + runBlockIndex * dxtBlockSize;
+			S3TConv_Verify_GenerateBlock(&randomState, dxtFormat, blocks + runBlockIndex * dxtBlockSize);
+			// Fewer blocks in the run are checked with the remaining sizes to keep the run long enough for SIMD.
+			if ((runBlockIndex & 15) == 0) {
+				for (remaining = 0; remaining < 16; ++remaining) {
+					S3TConv_Verify_Block(&job->result, block, dxtFormat, asDXT1, 1 + (remaining & 3), 1 + (remaining >> 2));
+				}
+			}
+		}
+		S3TConv_Verify_Blocks(&job->result, blocks, dxtFormat, asDXT1, runLength, expected, actual);
+	}
+	free(blocks);
+}
+
+// Random surfaces with repeated blocks, random sizes and padding between the rows.
+static void S3TConv_Verify_RandomSurfaces(void *jobData) {
+	S3TConv_Verify_Job *job = (S3TConv_Verify_Job *) jobData;
+	size_t maxRowPitch = ((S3TCONV_VERIFY_MAX_SURFACE_SIZE + 3) >> 2) * 16 + 64;
+	size_t maxSurfaceSize = ((S3TCONV_VERIFY_MAX_SURFACE_SIZE + 3) >> 2) * maxRowPitch;
+	uint64_t randomState = job->seed;
+	uint8_t *source, *target;
+	unsigned int surfaceIndex;
+
+	source = (uint8_t *) malloc(maxSurfaceSize * 2);
+	if (source == NULL) {
+		return;
+	}
+	target = source + maxSurfaceSize;
+	for (surfaceIndex = 0; surfaceIndex < job->count; ++surfaceIndex) {
+		S3TConv_Format dxtFormat = (S3TConv_Format) (S3TConv_Verify_Random(&randomState) % 3);
+		int asDXT1 = (int) (S3TConv_Verify_Random(&randomState) & 1);
+		unsigned int dxtBlockSize = S3TConv_Format_GetBlockSize(dxtFormat);
+		unsigned int width = 1 + (unsigned int) (S3TConv_Verify_Random(&randomState) % S3TCONV_VERIFY_MAX_SURFACE_SIZE);
+		unsigned int height = 1 + (unsigned int) (S3TConv_Verify_Random(&randomState) % S3TCONV_VERIFY_MAX_SURFACE_SIZE);
+		unsigned int widthInBlocks = (width + 3) >> 2, heightInBlocks = (height + 3) >> 2, blockX, blockY;
+		size_t sourceRowPitch = 0, targetRowPitch = widthInBlocks * 16;
+		if (S3TConv_Verify_Random(&randomState) & 1) {
+			sourceRowPitch = widthInBlocks * dxtBlockSize + (size_t) (S3TConv_Verify_Random(&randomState) % 64);
+		}
+		if (S3TConv_Verify_Random(&randomState) & 1) {
+			targetRowPitch += (size_t) (S3TConv_Verify_Random(&randomState) % 64);
+		}
+		for (blockY = 0; blockY < heightInBlocks; ++blockY) {
+			uint8_t *row = source + blockY * (sourceRowPitch != 0 ? sourceRowPitch : widthInBlocks * dxtBlockSize);
+			for (blockX = 0; blockX < widthInBlocks; ++blockX) {
+				// Repeated blocks for the block cache.
+				if (blockX != 0 && S3TConv_Verify_Random(&randomState) % 3 == 0) {
+					memcpy(row + blockX * dxtBlockSize, row + (blockX - 1) * dxtBlockSize, dxtBlockSize);
+				} else {
+					S3TConv_Verify_GenerateBlock(&randomState, dxtFormat, row + blockX * dxtBlockSize);
+				}
+			}
+		}
+		S3TConv_Verify_Surface(&job->result, source, dxtFormat, asDXT1, sourceRowPitch, width, height, target, targetRowPitch);
+	}
+	free(source);
+}
+
+
+static int S3TConv_Verify_Run(const char *name, S3TConv_JobFunction function, unsigned int itemCount,
+		unsigned int itemsPerJob, unsigned int stride, uint64_t seed, const S3TConv_Scheduler *scheduler) {
+	S3TConv_Verify_Job *jobs;
+	S3TConv_Verify_Result result;
+	unsigned int jobCount = (itemCount + itemsPerJob - 1) / itemsPerJob, jobIndex;
+
+	memset(&result, 0, sizeof(result));
+	jobs = (S3TConv_Verify_Job *) calloc(jobCount != 0 ? jobCount : 1, sizeof(S3TConv_Verify_Job));
+	if (jobs == NULL) {
+		fprintf(stderr, "Out of memory.\n");
+		return 0;
+	}
+	for (jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+		S3TConv_Verify_Job *job = &jobs[jobIndex];
+		job->first = jobIndex * itemsPerJob;
+		job->count = (itemCount - job->first < itemsPerJob ? itemCount - job->first : itemsPerJob);
+		job->stride = stride;
+		job->seed = seed + (uint64_t) jobIndex * 0x100000001ull;
+		if (scheduler != NULL) {
+			scheduler->submit(scheduler->schedulerData, function, job);
+		} else {
+			function(job);
+		}
+	}
+	if (scheduler != NULL) {
+		scheduler->wait(scheduler->schedulerData);
+	}
+	for (jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+		S3TConv_Verify_AddResult(&result, &jobs[jobIndex].result);
+	}
+	free(jobs);
+	return S3TConv_Verify_Report(name, &result);
+}
+
+int main(int argc, char **argv) {
+	S3TConv_ThreadPool *pool;
+	S3TConv_Scheduler scheduler;
+	unsigned int stride = 4093, blockCount = 1 << 20, surfaceCount = 4096, threadCount = 0;
+	uint64_t seed = 1;
+	int argIndex, passed;
+
+	for (argIndex = 1; argIndex < argc; ++argIndex) {
+		if (strcmp(argv[argIndex], "-stride") == 0 && argIndex + 1 < argc) {
+			stride = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+			stride = (stride != 0 ? stride : 1);
+		} else if (strcmp(argv[argIndex], "-blocks") == 0 && argIndex + 1 < argc) {
+			blockCount = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+		} else if (strcmp(argv[argIndex], "-surfaces") == 0 && argIndex + 1 < argc) {
+			surfaceCount = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+		} else if (strcmp(argv[argIndex], "-seed") == 0 && argIndex + 1 < argc) {
+			seed = strtoull(argv[++argIndex], NULL, 0);
+		} else if (strcmp(argv[argIndex], "-threads") == 0 && argIndex + 1 < argc) {
+			threadCount = (unsigned int) strtoul(argv[++argIndex], NULL, 10);
+		} else {
+			fprintf(stderr, "Usage: %s [-stride count] [-blocks count] [-surfaces count] [-seed value] [-threads count]\n",
+					argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	S3TConv_InitLookupTables();
+	printf("Lookup tables: %s, SIMD: %s.\n", S3TCONV_LOOKUP_TABLES == 1 ? "small per-component" :
+			(S3TCONV_LOOKUP_TABLES == 2 ? "64K-entry" : "none (arithmetic)"),
+#if defined(S3TCONV_SSE2)
+			"SSE2"
+#elif defined(S3TCONV_NEON)
+			"NEON"
+#else
+			"none"
+#endif
+			);
+	printf("First color stride: %u, random blocks: %u, random surfaces: %u, seed: %llu.\n\n",
+			stride, blockCount, surfaceCount, (unsigned long long) seed);
+
+	pool = S3TConv_ThreadPool_Create(threadCount);
+	if (pool != NULL) {
+		S3TConv_ThreadPool_GetScheduler(pool, &scheduler);
+	}
+	passed = S3TConv_Verify_Run("Endpoint pair sweep", S3TConv_Verify_Sweep, (0xFFFF / stride) + 1, 1, stride, seed,
+			pool != NULL ? &scheduler : NULL);
+	passed = S3TConv_Verify_Run("Random blocks", S3TConv_Verify_RandomBlocks, blockCount, 1 << 14, 0, seed + 1,
+			pool != NULL ? &scheduler : NULL) && passed;
+	passed = S3TConv_Verify_Run("Random surfaces", S3TConv_Verify_RandomSurfaces, surfaceCount, 64, 0, seed + 2,
+			pool != NULL ? &scheduler : NULL) && passed;
+	S3TConv_ThreadPool_Destroy(pool);
+
+	printf("\n%s\n", passed ? "All outputs match the reference." : "Outputs differ from the reference.");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif